@@ -0,0 +1,139 @@
+// Reference decoder for the binary format of the streaming servers (see the programming guide, section "Streaming data").
+// The stream is read from stdin, e.g.:
+//   g++ -std=c++17 -O2 -o binary_stream_decoder binary_stream_decoder.cpp
+//   nc localhost 19000 | ./binary_stream_decoder
+
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+class BinaryStreamDecoder
+{
+public:
+    static constexpr uint32_t magic = 0x5453564C;
+    static constexpr uint8_t version = 1;
+    static constexpr size_t headerSize = 12;
+
+    enum class FrameType : uint8_t {
+        Layout = 0,
+        Data = 1,
+    };
+    enum class DataType : uint8_t {
+        VNA = 0,
+        SA = 1,
+    };
+
+    // Called once per received point. values contains one entry per column (see getColumns())
+    using Callback = void(*)(const BinaryStreamDecoder &decoder, const double *values);
+
+    BinaryStreamDecoder(Callback cb) : cb(cb), layoutValid(false), type(DataType::VNA) {}
+
+    void feed(const uint8_t *data, size_t len) {
+        buffer.insert(buffer.end(), data, data + len);
+        size_t used = 0;
+        while(buffer.size() - used >= headerSize) {
+            auto frame = buffer.data() + used;
+            if(get<uint32_t>(frame) != magic) {
+                throw std::runtime_error("Lost synchronization with the binary stream");
+            }
+            if(frame[4] != version) {
+                throw std::runtime_error("Unsupported binary stream version");
+            }
+            auto length = get<uint32_t>(frame + 8);
+            if(buffer.size() - used < headerSize + length) {
+                // frame not complete yet
+                break;
+            }
+            auto payload = frame + headerSize;
+            switch((FrameType) frame[5]) {
+            case FrameType::Layout: parseLayout(payload); break;
+            case FrameType::Data: parseData(payload, length); break;
+            }
+            used += headerSize + length;
+        }
+        buffer.erase(buffer.begin(), buffer.begin() + used);
+    }
+
+    DataType getType() const {return type;}
+    const std::vector<std::string>& getColumns() const {return columns;}
+
+private:
+    // all values are transmitted in little-endian byte order
+    template<typename T> static T get(const uint8_t *p) {
+        uint8_t bytes[sizeof(T)];
+        for(size_t i=0;i<sizeof(T);i++) {
+            bytes[i] = p[isLittleEndian() ? i : sizeof(T) - 1 - i];
+        }
+        T value;
+        memcpy(&value, bytes, sizeof(T));
+        return value;
+    }
+    static bool isLittleEndian() {
+        const uint16_t test = 1;
+        return *reinterpret_cast<const uint8_t*>(&test) == 1;
+    }
+
+    void parseLayout(const uint8_t *payload) {
+        type = (DataType) payload[0];
+        auto count = get<uint16_t>(payload + 2);
+        payload += 4;
+        columns.clear();
+        for(unsigned int i=0;i<count;i++) {
+            auto length = get<uint16_t>(payload);
+            columns.emplace_back(reinterpret_cast<const char*>(payload + 2), length);
+            payload += 2 + length;
+        }
+        layoutValid = true;
+    }
+    void parseData(const uint8_t *payload, uint32_t length) {
+        if(!layoutValid) {
+            return;
+        }
+        auto records = get<uint32_t>(payload);
+        if(4 + (uint64_t) records * columns.size() * 8 > length) {
+            throw std::runtime_error("Data frame too short");
+        }
+        payload += 4;
+        std::vector<double> values(columns.size());
+        for(unsigned int r=0;r<records;r++) {
+            if(isLittleEndian()) {
+                memcpy(values.data(), payload, values.size() * sizeof(double));
+            } else {
+                for(unsigned int i=0;i<values.size();i++) {
+                    values[i] = get<double>(payload + i * sizeof(double));
+                }
+            }
+            payload += values.size() * sizeof(double);
+            cb(*this, values.data());
+        }
+    }
+
+    Callback cb;
+    std::vector<uint8_t> buffer;
+    bool layoutValid;
+    DataType type;
+    std::vector<std::string> columns;
+};
+
+static void printPoint(const BinaryStreamDecoder &decoder, const double *values)
+{
+    auto &columns = decoder.getColumns();
+    for(unsigned int i=0;i<columns.size();i++) {
+        std::cout << columns[i] << "=" << values[i] << (i < columns.size() - 1 ? " " : "\n");
+    }
+}
+
+int main()
+{
+    BinaryStreamDecoder decoder(printPoint);
+    uint8_t chunk[65536];
+    size_t len;
+    while((len = fread(chunk, 1, sizeof(chunk), stdin)) > 0) {
+        decoder.feed(chunk, len);
+    }
+    return 0;
+}
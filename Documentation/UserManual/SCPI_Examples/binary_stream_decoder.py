@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+
+# Reference decoder for the binary format of the streaming servers (see the programming guide, section "Streaming data").
+# Usage: binary_stream_decoder.py [host] [port]
+# The streaming server on that port must be enabled with the format set to "Binary".
+
+import socket
+import struct
+import sys
+from array import array
+
+FRAME_MAGIC = 0x5453564C
+FRAME_VERSION = 1
+FRAME_HEADER = struct.Struct("<IBBHI")
+FRAME_LAYOUT = 0
+FRAME_DATA = 1
+
+DATATYPE_VNA = 0
+DATATYPE_SA = 1
+
+
+class BinaryStreamDecoder:
+    def __init__(self):
+        self.buffer = bytearray()
+        self.datatype = None
+        self.columns = None
+
+    def feed(self, data):
+        """Adds received bytes, returns a list of all completely received points.
+
+        Each point is a dictionary with the same content as the JSON format (VNA measurements are complex numbers)"""
+        self.buffer += data
+        points = []
+        while len(self.buffer) >= FRAME_HEADER.size:
+            magic, version, frametype, _, length = FRAME_HEADER.unpack_from(self.buffer)
+            if magic != FRAME_MAGIC:
+                raise Exception("Lost synchronization with the binary stream")
+            if version != FRAME_VERSION:
+                raise Exception("Unsupported binary stream version {}".format(version))
+            if len(self.buffer) < FRAME_HEADER.size + length:
+                # frame not complete yet
+                break
+            payload = memoryview(self.buffer)[FRAME_HEADER.size:FRAME_HEADER.size + length]
+            if frametype == FRAME_LAYOUT:
+                self.__parse_layout(payload)
+            elif frametype == FRAME_DATA and self.columns is not None:
+                points += self.__parse_data(payload)
+            payload.release()
+            del self.buffer[:FRAME_HEADER.size + length]
+        return points
+
+    def __parse_layout(self, payload):
+        self.datatype, _, count = struct.unpack_from("<BBH", payload)
+        offset = 4
+        self.columns = []
+        for i in range(count):
+            length, = struct.unpack_from("<H", payload, offset)
+            offset += 2
+            self.columns.append(bytes(payload[offset:offset + length]).decode())
+            offset += length
+
+    def __parse_data(self, payload):
+        records, = struct.unpack_from("<I", payload)
+        values = array("d")
+        values.frombytes(payload[4:4 + records * len(self.columns) * 8])
+        if sys.byteorder != "little":
+            values.byteswap()
+        points = []
+        n = len(self.columns)
+        for r in range(records):
+            record = values[r * n:(r + 1) * n]
+            if self.datatype == DATATYPE_VNA:
+                # pointNum, frequency, dBm, Z0, followed by real/imag pairs
+                point = {"pointNum": int(record[0]), "frequency": record[1], "dBm": record[2], "Z0": record[3],
+                         "measurements": {}}
+                for i in range(4, n, 2):
+                    name = self.columns[i].removesuffix("_real")
+                    point["measurements"][name] = complex(record[i], record[i + 1])
+            else:
+                # pointNum, frequency, followed by the measurements
+                point = {"pointNum": int(record[0]), "frequency": record[1], "measurements": {}}
+                for i in range(2, n):
+                    point["measurements"][self.columns[i]] = record[i]
+            points.append(point)
+        return points
+
+
+if __name__ == "__main__":
+    host = sys.argv[1] if len(sys.argv) > 1 else "localhost"
+    port = int(sys.argv[2]) if len(sys.argv) > 2 else 19000
+    sock = socket.create_connection((host, port))
+    decoder = BinaryStreamDecoder()
+    while True:
+        data = sock.recv(65536)
+        if not data:
+            break
+        for p in decoder.feed(data):
+            print(p)
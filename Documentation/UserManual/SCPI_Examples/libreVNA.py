@@ -4,6 +4,7 @@ from asyncio import IncompleteReadError  # only import the exception class
 import time
 import threading
 import json
+import struct
 
 class SocketStreamReader:
     def __init__(self, sock: socket.socket, default_timeout=1):
@@ -15,14 +16,33 @@ class SocketStreamReader:
     def read(self, num_bytes: int = -1) -> bytes:
         raise NotImplementedError
 
-    def readexactly(self, num_bytes: int) -> bytes:
+    def readexactly(self, num_bytes: int, timeout=None) -> bytes:
+        if timeout is None:
+            timeout = self.default_timeout
         buf = bytearray(num_bytes)
-        pos = 0
-        while pos < num_bytes:
-            n = self._recv_into(memoryview(buf)[pos:])
-            if n == 0:
-                raise IncompleteReadError(bytes(buf[:pos]), num_bytes)
-            pos += n
+        view = memoryview(buf)
+        # bytes that have already been received
+        pos = min(num_bytes, len(self._recv_buffer))
+        view[:pos] = self._recv_buffer[:pos]
+        self._recv_buffer = self._recv_buffer[pos:]
+        time_limit = time.time() + timeout
+        try:
+            while pos < num_bytes:
+                remaining = time_limit - time.time()
+                if remaining <= 0:
+                    raise IncompleteReadError(bytes(buf[:pos]), num_bytes)
+                # wait in a blocking receive until data is available instead of polling
+                self._sock.settimeout(remaining)
+                try:
+                    n = self._sock.recv_into(view[pos:])
+                except socket.timeout:
+                    raise IncompleteReadError(bytes(buf[:pos]), num_bytes)
+                if n == 0:
+                    # connection closed
+                    raise IncompleteReadError(bytes(buf[:pos]), num_bytes)
+                pos += n
+        finally:
+            self._sock.setblocking(0)
         return bytes(buf)
 
     def readline(self, timeout=None) -> bytes:
@@ -113,6 +133,21 @@ class libreVNA:
         self.sock.send(b"\n")
         return self.__read_response(timeout=timeout)
 
+    def query_binary(self, query, timeout=None):
+        # Queries data in the IEEE 488.2 definite length block format (see FORMat:DATA), returns the payload
+        self.sock.sendall(query.encode())
+        self.sock.send(b"\n")
+        start = self.reader.readexactly(2, timeout=timeout)
+        if start[0:1] != b"#":
+            # not a binary block
+            raise Exception("Expected binary block but got '{}'".format((start + self.reader.readline(timeout=timeout)).decode().rstrip()))
+        digits = int(start[1:2])
+        length = int(self.reader.readexactly(digits, timeout=timeout))
+        payload = self.reader.readexactly(length, timeout=timeout)
+        # skip the terminating newline
+        self.reader.readline(timeout=timeout)
+        return payload
+
     def get_status(self, timeout=None):
         resp = self.query("*ESR?", timeout=timeout)
         if not re.match(r'^\d+$', resp):
@@ -193,6 +228,14 @@ class libreVNA:
             ret.append((freq, complex(real, imag)))
         return ret
     
+    @staticmethod
+    def parse_VNA_trace_data_binary(data, swapped=False):
+        # data as returned by query_binary with FORMat:DATA REAL,64 (swapped: FORMat:BORDer SWAPped)
+        ret = []
+        for freq, real, imag in struct.iter_unpack("<3d" if swapped else ">3d", data):
+            ret.append((freq, complex(real, imag)))
+        return ret
+
     @staticmethod
     def parse_SA_trace_data(data):
         ret = []
@@ -208,3 +251,7 @@ class libreVNA:
             ret.append((freq, dBm))
         return ret
 
+    @staticmethod
+    def parse_SA_trace_data_binary(data, swapped=False):
+        # data as returned by query_binary with FORMat:DATA REAL,64 (swapped: FORMat:BORDer SWAPped)
+        return list(struct.iter_unpack("<2d" if swapped else ">2d", data))
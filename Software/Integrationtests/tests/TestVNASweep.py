@@ -83,3 +83,31 @@ class TestVNASweep(TestBase):
         
         S11 = self.vna.parse_VNA_trace_data(self.vna.query(":VNA:TRACE:DATA? S11"))
         self.assertEqual(len(S11), 10000)
+
+    def test_binary_data(self):
+        self.vna.cmd(":DEV:MODE VNA")
+        self.vna.cmd(":VNA:SWEEP FREQUENCY")
+        self.vna.cmd(":VNA:STIM:LVL -10")
+        self.vna.cmd(":VNA:ACQ:IFBW 10000")
+        self.vna.cmd(":VNA:ACQ:AVG 1")
+        self.vna.cmd(":VNA:ACQ:POINTS 501")
+        self.vna.cmd(":VNA:FREQuency:START 1000000")
+        self.vna.cmd(":VNA:FREQuency:STOP 6000000000")
+        self.waitSweepTimeout(2)
+        self.vna.cmd(":VNA:ACQ:STOP")
+
+        S11 = self.vna.parse_VNA_trace_data(self.vna.query(":VNA:TRACE:DATA? S11"))
+        self.vna.cmd(":FORM:DATA REAL,64")
+        self.assertEqual(self.vna.query(":FORM:DATA?"), "REAL,64")
+        binary = self.vna.parse_VNA_trace_data_binary(self.vna.query_binary(":VNA:TRACE:DATA? S11"))
+        self.vna.cmd(":FORM:BORD SWAP")
+        swapped = self.vna.parse_VNA_trace_data_binary(self.vna.query_binary(":VNA:TRACE:DATA? S11"), swapped=True)
+        self.vna.cmd(":FORM:DATA ASC")
+        self.assertEqual(self.vna.query(":FORM:DATA?"), "ASC")
+
+        self.assertEqual(len(binary), 501)
+        self.assertEqual(binary, swapped)
+        for ascii_point, binary_point in zip(S11, binary):
+            self.assertEqual(ascii_point[0], binary_point[0])
+            # ASCII data is rounded to 6 significant digits
+            self.assertAlmostEqual(ascii_point[1], binary_point[1], delta=abs(binary_point[1]) * 1e-5 + 1e-12)
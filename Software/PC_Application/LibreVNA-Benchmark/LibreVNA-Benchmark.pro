@@ -0,0 +1,20 @@
+QT += network
+QT -= gui
+
+CONFIG += console c++17
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+SOURCES += \
+    ../../VNA_embedded/Application/Communication/Protocol.cpp \
+    benchmark.cpp \
+    main.cpp \
+    virtualdevice.cpp
+
+HEADERS += \
+    ../../VNA_embedded/Application/Communication/Protocol.hpp \
+    benchmark.h \
+    virtualdevice.h
+
+QMAKE_CXXFLAGS += -Wno-deprecated -Wno-deprecated-declarations -Wno-deprecated-copy
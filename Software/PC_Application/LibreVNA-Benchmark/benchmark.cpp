@@ -0,0 +1,444 @@
+#include "benchmark.h"
+
+#include <QEventLoop>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QtEndian>
+#include <QDebug>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+// Binary streaming format, see StreamingServer of the GUI
+static constexpr quint32 streamMagic = 0x5453564C;
+static constexpr int streamHeaderSize = 12;
+static constexpr quint8 streamLayoutFrame = 0;
+static constexpr quint8 streamDataFrame = 1;
+
+Benchmark::Benchmark(Settings s, VirtualDevice &device)
+    : settings(s),
+      device(device),
+      streamColumns(0),
+      measuring(false),
+      scheduleValid(false),
+      schedule{},
+      lastPointNum(-1),
+      sweep(0),
+      received(0),
+      lastArrival(0)
+{
+    connect(&stream, &QTcpSocket::readyRead, this, &Benchmark::receivedStreamData);
+}
+
+Benchmark::~Benchmark()
+{
+    stopGUI();
+}
+
+bool Benchmark::run(Result &result)
+{
+    if(!startGUI()) {
+        return false;
+    }
+    if(!connectDevice() || !configureSweep()) {
+        return false;
+    }
+    // loading the setup replaces the de-embedding, the math has to go first
+    if(settings.math && !addMath()) {
+        return false;
+    }
+    if(settings.calibration && !calibrate()) {
+        return false;
+    }
+    if(settings.deembedding && !addDeembedding()) {
+        return false;
+    }
+    return measure(result);
+}
+
+void Benchmark::receivedStreamData()
+{
+    auto arrival = VirtualDevice::now();
+    streamBuffer.append(stream.readAll());
+    int offset = 0;
+    while(streamBuffer.size() - offset >= streamHeaderSize) {
+        auto header = streamBuffer.constData() + offset;
+        if(qFromLittleEndian<quint32>(header) != streamMagic) {
+            qWarning() << "Invalid frame in stream";
+            stream.close();
+            break;
+        }
+        quint8 type = header[5];
+        quint32 length = qFromLittleEndian<quint32>(header + 8);
+        if((quint32) (streamBuffer.size() - offset - streamHeaderSize) < length) {
+            // frame not complete yet
+            break;
+        }
+        auto payload = header + streamHeaderSize;
+        if(type == streamLayoutFrame) {
+            streamColumns = qFromLittleEndian<quint16>(payload + 2);
+        } else if(type == streamDataFrame && streamColumns > 0) {
+            quint32 records = qFromLittleEndian<quint32>(payload);
+            auto record = payload + 4;
+            for(quint32 i=0;i<records;i++) {
+                // the point number is the first column
+                quint64 raw = qFromLittleEndian<quint64>(record);
+                double pointNum;
+                memcpy(&pointNum, &raw, sizeof(pointNum));
+                handlePoint(pointNum, arrival);
+                record += streamColumns * sizeof(double);
+            }
+        }
+        offset += streamHeaderSize + length;
+    }
+    streamBuffer.remove(0, offset);
+}
+
+bool Benchmark::startGUI()
+{
+    if(!tempDir.isValid()) {
+        return fail("Unable to create temporary directory");
+    }
+    // keep the preferences of the GUI away from the ones of the user (only on systems which use XDG_CONFIG_HOME)
+    auto env = QProcessEnvironment::systemEnvironment();
+    env.insert("XDG_CONFIG_HOME", tempDir.path());
+    gui.setProcessEnvironment(env);
+    // the output is not read while the benchmark is running, it must not end up in a pipe
+    gui.setProcessChannelMode(QProcess::MergedChannels);
+    gui.setStandardOutputFile(settings.GUILog.isEmpty() ? QProcess::nullDevice() : settings.GUILog);
+    gui.start(settings.GUIPath, {"-p", QString::number(settings.SCPIPort), "--reset-preferences", "--no-gui", "-platform", "offscreen"});
+    if(!gui.waitForStarted(5000)) {
+        return fail("Unable to start the GUI at " + settings.GUIPath);
+    }
+    // wait for the SCPI server to become available
+    QElapsedTimer timer;
+    timer.start();
+    while(true) {
+        scpi.connectToHost("127.0.0.1", settings.SCPIPort);
+        if(scpi.waitForConnected(1000)) {
+            break;
+        }
+        scpi.abort();
+        if(gui.state() != QProcess::Running) {
+            return fail("The GUI terminated unexpectedly");
+        }
+        if(timer.elapsed() > 10000) {
+            return fail("Unable to connect to the SCPI server of the GUI");
+        }
+        wait(100);
+    }
+    return cmd("*CLS");
+}
+
+void Benchmark::stopGUI()
+{
+    if(gui.state() == QProcess::NotRunning) {
+        return;
+    }
+    scpi.close();
+    stream.close();
+    gui.terminate();
+    if(!gui.waitForFinished(3000)) {
+        gui.kill();
+        gui.waitForFinished(1000);
+    }
+}
+
+bool Benchmark::connectDevice()
+{
+    // enable streaming of the de-embedded data, these settings apply immediately
+    if(!cmd(":DEV:PREF StreamingServers.VNADeembeddedData.enabled true")
+            || !cmd(":DEV:PREF StreamingServers.VNADeembeddedData.port " + QString::number(settings.streamPort))
+            || !cmd(":DEV:PREF StreamingServers.VNADeembeddedData.binary true")
+            || !cmd(":DEV:APPLYPREF")) {
+        return false;
+    }
+    // the GUI searches for devices once per second
+    auto serial = device.getSerial();
+    QElapsedTimer timer;
+    timer.start();
+    while(!query(":DEV:LIST?").split(",").contains(serial)) {
+        if(timer.elapsed() > 5000) {
+            return fail("The GUI did not find the virtual device");
+        }
+        wait(100);
+    }
+    if(!cmd(":DEV:CONN " + serial) || query(":DEV:CONN?") != serial) {
+        return fail("Unable to connect to the virtual device");
+    }
+    return true;
+}
+
+bool Benchmark::configureSweep()
+{
+    return cmd(":DEV:MODE VNA")
+            && cmd(":VNA:SWEEP FREQUENCY")
+            && cmd(":VNA:STIM:LVL -10")
+            && cmd(":VNA:ACQ:IFBW 10000")
+            && cmd(":VNA:ACQ:AVG 1")
+            && cmd(":VNA:ACQ:POINTS " + QString::number(settings.points))
+            && cmd(":VNA:FREQ:START 1000000")
+            && cmd(":VNA:FREQ:STOP 6000000000");
+}
+
+bool Benchmark::addMath()
+{
+    // Math operations are not available through SCPI, add them to the setup and load it again
+    auto filename = tempDir.filePath("benchmark.setup");
+    if(!cmd(":DEV:SETUP:SAVE " + filename)) {
+        return false;
+    }
+    QFile file(filename);
+    if(!file.open(QIODevice::ReadOnly)) {
+        return fail("Unable to read the setup file");
+    }
+    auto setup = QJsonDocument::fromJson(file.readAll()).object();
+    file.close();
+    auto modes = setup["Modes"].toArray();
+    for(int i=0;i<modes.size();i++) {
+        auto mode = modes[i].toObject();
+        if(mode["type"].toString() != "Vector Network Analyzer") {
+            continue;
+        }
+        auto modeSettings = mode["settings"].toObject();
+        auto traces = modeSettings["traces"].toArray();
+        for(int j=0;j<traces.size();j++) {
+            auto trace = traces[j].toObject();
+            QJsonArray math;
+            math.append(QJsonObject{{"operation", "Median filter"}, {"enabled", true}, {"settings", QJsonObject{{"kernel", 5}}}});
+            math.append(QJsonObject{{"operation", "Custom Expression"}, {"enabled", true}, {"settings", QJsonObject{{"exp", "x*2"}}}});
+            if(j == 0) {
+                math.append(QJsonObject{{"operation", "TDR"}, {"enabled", true}, {"settings", QJsonObject()}});
+            }
+            trace["math"] = math;
+            trace["math_enabled"] = true;
+            traces[j] = trace;
+        }
+        modeSettings["traces"] = traces;
+        mode["settings"] = modeSettings;
+        modes[i] = mode;
+    }
+    setup["Modes"] = modes;
+    if(!file.open(QIODevice::WriteOnly)) {
+        return fail("Unable to write the setup file");
+    }
+    file.write(QJsonDocument(setup).toJson());
+    file.close();
+    if(query(":DEV:SETUP:LOAD? " + filename, 5000) != "TRUE") {
+        return fail("Unable to load the setup with math operations");
+    }
+    return true;
+}
+
+bool Benchmark::calibrate()
+{
+    auto ports = device.getPorts();
+    if(!cmd(":VNA:CAL:RESET")) {
+        return false;
+    }
+    // measurement numbers of every standard
+    QStringList opens, shorts, loads;
+    class Through {
+    public:
+        unsigned int port1, port2;
+        QString measurement;
+    };
+    std::vector<Through> throughs;
+    unsigned int number = 0;
+    for(unsigned int i=1;i<=ports;i++) {
+        for(auto type : {"OPEN", "SHORT", "LOAD"}) {
+            if(!cmd(QString(":VNA:CAL:ADD ") + type) || !cmd(":VNA:CAL:PORT " + QString::number(number) + " " + QString::number(i))) {
+                return false;
+            }
+        }
+        opens.append(QString::number(number++));
+        shorts.append(QString::number(number++));
+        loads.append(QString::number(number++));
+    }
+    for(unsigned int i=1;i<=ports;i++) {
+        for(unsigned int j=i+1;j<=ports;j++) {
+            if(!cmd(":VNA:CAL:ADD THROUGH") || !cmd(":VNA:CAL:PORT " + QString::number(number) + " " + QString::number(i) + " " + QString::number(j))) {
+                return false;
+            }
+            throughs.push_back({i, j, QString::number(number++)});
+        }
+    }
+
+    auto measureStandard = [=](VirtualDevice::Standard s, QStringList measurements, unsigned int port1 = 1, unsigned int port2 = 2) -> bool {
+        device.connectStandard(s, port1, port2);
+        if(!cmd(":VNA:CAL:MEAS " + measurements.join(" "))) {
+            return false;
+        }
+        // one sweep is required, allow a few more in case the first one was already running
+        auto timeout = 5000 + 3000.0 * settings.points / device.getPointsPerSecond();
+        QElapsedTimer timer;
+        timer.start();
+        while(query(":VNA:CAL:BUSY?") != "FALSE") {
+            if(timer.elapsed() > timeout) {
+                return fail("Calibration measurement timed out");
+            }
+            wait(20);
+        }
+        return true;
+    };
+    bool success = measureStandard(VirtualDevice::Standard::Open, opens)
+            && measureStandard(VirtualDevice::Standard::Short, shorts)
+            && measureStandard(VirtualDevice::Standard::Load, loads);
+    for(auto t : throughs) {
+        success = success && measureStandard(VirtualDevice::Standard::Through, {t.measurement}, t.port1, t.port2);
+    }
+    device.connectStandard(VirtualDevice::Standard::DUT);
+    if(!success) {
+        return false;
+    }
+    QString caltype = "SOLT_";
+    for(unsigned int i=1;i<=ports;i++) {
+        caltype += QString::number(i);
+    }
+    if(!cmd(":VNA:CAL:ACT " + caltype)) {
+        return fail("Unable to activate the calibration");
+    }
+    return true;
+}
+
+bool Benchmark::addDeembedding()
+{
+    if(!cmd(":VNA:DEEMB:NEW PORT_EXTENSION")) {
+        return false;
+    }
+    // use the de-embedded data for all traces
+    for(auto trace : query(":VNA:TRAC:LIST?").split(",")) {
+        if(!cmd(":VNA:TRAC:DEEMB:ACT " + trace + " TRUE")) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Benchmark::measure(Result &result)
+{
+    // the streaming server only sends points to connected clients, connect before the sweep starts
+    stream.connectToHost("127.0.0.1", settings.streamPort);
+    if(!stream.waitForConnected(1000)) {
+        return fail("Unable to connect to the streaming server");
+    }
+    // stop the sweep and restart it, the statistics of the device start from zero again
+    if(!cmd(":VNA:ACQ:STOP")) {
+        return false;
+    }
+    wait(500);
+    streamBuffer.clear();
+    streamColumns = 0;
+    lastPointNum = -1;
+    sweep = 0;
+    received = 0;
+    latencies.clear();
+    latencies.reserve(settings.duration * device.getPointsPerSecond() * 1.1);
+    scheduleValid = false;
+    measuring = true;
+
+    scpi.write(":VNA:ACQ:RUN\n");
+    wait(settings.duration * 1000);
+    // points that are already on their way still count, give them some time to arrive
+    scpi.write(":VNA:ACQ:STOP\n");
+    wait(1000);
+    measuring = false;
+
+    if(query("*ESR?") != "0") {
+        return fail("Failed to run the sweep");
+    }
+    auto stats = device.getStatistics();
+    if(!scheduleValid) {
+        return fail("No points received");
+    }
+    if(stats.settings != schedule.settings) {
+        return fail("The sweep was restarted during the measurement");
+    }
+
+    result.sent = stats.points;
+    result.received = received;
+    result.dropped = stats.points > received ? stats.points - received : 0;
+    auto elapsed = (double) (lastArrival - schedule.start) * 1e-9;
+    result.pointsPerSecond = elapsed > 0 ? received / elapsed : 0;
+    if(latencies.size() > 0) {
+        sort(latencies.begin(), latencies.end());
+        auto percentile = [=](double p) -> double {
+            auto index = min((size_t) (p * latencies.size()), latencies.size() - 1);
+            return latencies[index] * 1e-6;
+        };
+        result.latency50 = percentile(0.5);
+        result.latency90 = percentile(0.9);
+        result.latency99 = percentile(0.99);
+        result.latencyMax = latencies.back() * 1e-6;
+    } else {
+        result.latency50 = result.latency90 = result.latency99 = result.latencyMax = 0;
+    }
+    return true;
+}
+
+bool Benchmark::cmd(QString command)
+{
+    scpi.write(command.toUtf8() + "\n");
+    auto status = query("*ESR?");
+    if(status != "0") {
+        return fail("Command \"" + command + "\" failed (status: " + (status.isEmpty() ? "timeout" : status) + ")");
+    }
+    return true;
+}
+
+QString Benchmark::query(QString query, int timeout)
+{
+    scpi.write(query.toUtf8() + "\n");
+    QElapsedTimer timer;
+    timer.start();
+    while(!scpi.canReadLine()) {
+        auto remaining = timeout - timer.elapsed();
+        if(remaining <= 0 || !scpi.waitForReadyRead(remaining)) {
+            return QString();
+        }
+    }
+    return QString::fromUtf8(scpi.readLine()).trimmed();
+}
+
+void Benchmark::wait(int ms)
+{
+    QEventLoop loop;
+    QTimer::singleShot(ms, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+bool Benchmark::fail(QString message)
+{
+    if(error.isEmpty()) {
+        error = message;
+    }
+    return false;
+}
+
+void Benchmark::handlePoint(unsigned int pointNum, int64_t arrival)
+{
+    if(!measuring) {
+        return;
+    }
+    if(!scheduleValid) {
+        // the first point of the sweep has been created, the schedule of the device is valid
+        schedule = device.getStatistics();
+        scheduleValid = true;
+    }
+    if((int) pointNum <= lastPointNum) {
+        sweep++;
+    }
+    lastPointNum = pointNum;
+    lastArrival = arrival;
+    received++;
+    // point n of the device was created at start + n / pointsPerSecond
+    uint64_t n = sweep * schedule.sweepPoints + pointNum;
+    int64_t created = schedule.start + (int64_t) (n * 1e9 / schedule.pointsPerSecond);
+    latencies.push_back(arrival - created);
+}
@@ -0,0 +1,111 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "virtualdevice.h"
+
+#include <QObject>
+#include <QProcess>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QByteArray>
+
+#include <vector>
+
+/**
+ * @brief End-to-end throughput benchmark of the GUI
+ *
+ * Starts the GUI without graphical interface, connects it to the virtual device and configures the VNA through SCPI:
+ * - a SOLT calibration with all ports (the virtual device presents the required standards)
+ * - a port extension as de-embedding
+ * - median filter and custom expression math on every trace, TDR on the first trace
+ * - binary streaming of the de-embedded data
+ *
+ * The streamed points are then compared with the schedule of the virtual device, this gives the throughput, the
+ * latency of every point (from its creation in the device to its arrival at the streaming client) and the points that
+ * never arrived.
+ */
+class Benchmark : public QObject
+{
+    Q_OBJECT
+public:
+    class Settings {
+    public:
+        QString GUIPath;
+        // output of the GUI is written to this file (discarded if empty)
+        QString GUILog;
+        int SCPIPort;
+        int streamPort;
+        unsigned int points;
+        // duration of the measurement in seconds
+        double duration;
+        bool calibration;
+        bool deembedding;
+        bool math;
+    };
+
+    class Result {
+    public:
+        double pointsPerSecond;
+        uint64_t sent;
+        uint64_t received;
+        uint64_t dropped;
+        // latencies in ms
+        double latency50;
+        double latency90;
+        double latency99;
+        double latencyMax;
+    };
+
+    Benchmark(Settings s, VirtualDevice &device);
+    ~Benchmark();
+
+    // Returns false if the GUI could not be configured, the error is available through getError()
+    bool run(Result &result);
+    QString getError() const {return error;}
+
+private slots:
+    void receivedStreamData();
+
+private:
+    bool startGUI();
+    void stopGUI();
+    bool connectDevice();
+    bool configureSweep();
+    bool addMath();
+    bool calibrate();
+    bool addDeembedding();
+    bool measure(Result &result);
+
+    // sends a command and checks the status register for errors
+    bool cmd(QString command);
+    // returns an empty string after a timeout
+    QString query(QString query, int timeout = 1000);
+    // processes events for the given time in ms
+    void wait(int ms);
+    bool fail(QString message);
+
+    void handlePoint(unsigned int pointNum, int64_t arrival);
+
+    Settings settings;
+    VirtualDevice &device;
+    QString error;
+
+    QProcess gui;
+    QTemporaryDir tempDir;
+    QTcpSocket scpi;
+
+    // Streaming client, binary format
+    QTcpSocket stream;
+    QByteArray streamBuffer;
+    unsigned int streamColumns;
+    bool measuring;
+    bool scheduleValid;
+    VirtualDevice::Statistics schedule;
+    int lastPointNum;
+    uint64_t sweep;
+    uint64_t received;
+    int64_t lastArrival;
+    std::vector<int64_t> latencies;
+};
+
+#endif // BENCHMARK_H
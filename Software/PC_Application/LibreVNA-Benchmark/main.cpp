@@ -0,0 +1,109 @@
+#include "virtualdevice.h"
+#include "benchmark.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QThread>
+#include <QDebug>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("LibreVNA-Benchmark");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measures the throughput of the LibreVNA-GUI with a virtual device");
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("device-only", "Only run the virtual device (e.g. to use it with an interactive GUI)"));
+    parser.addOption(QCommandLineOption("serial", "Serial number of the virtual device", "serial", "VIRTUAL0001"));
+    parser.addOption(QCommandLineOption("ports", "Number of ports of the virtual device", "ports", "2"));
+    parser.addOption(QCommandLineOption("rate", "Points per second created by the virtual device", "rate", "10000"));
+    parser.addOption(QCommandLineOption("jitter", "Maximum delay of a transmission of the virtual device in ms", "jitter", "0"));
+    parser.addOption(QCommandLineOption("gui", "Path to the GUI executable", "gui", "../LibreVNA-GUI/LibreVNA-GUI"));
+    parser.addOption(QCommandLineOption("gui-log", "Writes the output of the GUI to this file", "gui-log"));
+    parser.addOption(QCommandLineOption("scpi-port", "SCPI port of the GUI", "scpi-port", "19543"));
+    parser.addOption(QCommandLineOption("stream-port", "Port of the streaming server for the de-embedded data", "stream-port", "19002"));
+    parser.addOption(QCommandLineOption("points", "Points per sweep", "points", "1001"));
+    parser.addOption(QCommandLineOption("duration", "Duration of the measurement in seconds", "duration", "10"));
+    parser.addOption(QCommandLineOption("no-calibration", "Skips the calibration"));
+    parser.addOption(QCommandLineOption("no-deembedding", "Skips the de-embedding"));
+    parser.addOption(QCommandLineOption("no-math", "Skips the math operations"));
+    parser.addOption(QCommandLineOption("min-rate", "Fails if less points per second are received", "min-rate", "0"));
+    parser.addOption(QCommandLineOption("max-dropped", "Fails if more points are dropped", "max-dropped", "-1"));
+    parser.addOption(QCommandLineOption("max-latency", "Fails if the 99th latency percentile is higher (in ms)", "max-latency", "0"));
+    parser.process(app);
+
+    VirtualDevice::Settings deviceSettings;
+    deviceSettings.serial = parser.value("serial");
+    deviceSettings.ports = parser.value("ports").toUInt();
+    deviceSettings.pointsPerSecond = parser.value("rate").toDouble();
+    deviceSettings.jitter = parser.value("jitter").toUInt();
+    if(deviceSettings.pointsPerSecond <= 0) {
+        qCritical() << "Invalid rate";
+        return 1;
+    }
+
+    // the device runs in its own thread, it has to keep up while the benchmark waits for SCPI responses
+    QThread deviceThread;
+    auto device = new VirtualDevice(deviceSettings);
+    device->moveToThread(&deviceThread);
+    QObject::connect(&deviceThread, &QThread::finished, device, &QObject::deleteLater);
+    deviceThread.start();
+    bool started = false;
+    QMetaObject::invokeMethod(device, "start", Qt::BlockingQueuedConnection, Q_RETURN_ARG(bool, started));
+    if(!started) {
+        deviceThread.quit();
+        deviceThread.wait();
+        return 1;
+    }
+
+    if(parser.isSet("device-only")) {
+        return app.exec();
+    }
+
+    Benchmark::Settings settings;
+    settings.GUIPath = parser.value("gui");
+    settings.GUILog = parser.value("gui-log");
+    settings.SCPIPort = parser.value("scpi-port").toInt();
+    settings.streamPort = parser.value("stream-port").toInt();
+    settings.points = parser.value("points").toUInt();
+    settings.duration = parser.value("duration").toDouble();
+    settings.calibration = !parser.isSet("no-calibration");
+    settings.deembedding = !parser.isSet("no-deembedding");
+    settings.math = !parser.isSet("no-math");
+
+    int ret = 0;
+    {
+        Benchmark benchmark(settings, *device);
+        Benchmark::Result result;
+        if(!benchmark.run(result)) {
+            qCritical() << "Benchmark failed:" << benchmark.getError();
+            ret = 1;
+        } else {
+            qInfo().noquote() << QString("Throughput: %1 points/s (device: %2 points/s)").arg(result.pointsPerSecond, 0, 'f', 0).arg(deviceSettings.pointsPerSecond, 0, 'f', 0);
+            qInfo().noquote() << QString("Points: %1 sent, %2 received, %3 dropped").arg(result.sent).arg(result.received).arg(result.dropped);
+            qInfo().noquote() << QString("Latency: %1ms (50%), %2ms (90%), %3ms (99%), %4ms (max)").arg(result.latency50, 0, 'f', 2)
+                                .arg(result.latency90, 0, 'f', 2).arg(result.latency99, 0, 'f', 2).arg(result.latencyMax, 0, 'f', 2);
+
+            auto minRate = parser.value("min-rate").toDouble();
+            auto maxDropped = parser.value("max-dropped").toLongLong();
+            auto maxLatency = parser.value("max-latency").toDouble();
+            if(result.pointsPerSecond < minRate) {
+                qCritical() << "Throughput below" << minRate << "points/s";
+                ret = 1;
+            }
+            if(maxDropped >= 0 && result.dropped > (uint64_t) maxDropped) {
+                qCritical() << "More than" << maxDropped << "points dropped";
+                ret = 1;
+            }
+            if(maxLatency > 0 && result.latency99 > maxLatency) {
+                qCritical() << "99th latency percentile above" << maxLatency << "ms";
+                ret = 1;
+            }
+        }
+    }
+
+    deviceThread.quit();
+    deviceThread.wait();
+    return ret;
+}
@@ -0,0 +1,457 @@
+#include "virtualdevice.h"
+
+#include <QNetworkInterface>
+#include <QDebug>
+
+#include <chrono>
+#include <cmath>
+
+using namespace std;
+
+static const QString service_name = "urn:schemas-upnp-org:device:LibreVNA:1";
+static auto SSDPaddress = QHostAddress("239.255.255.250");
+static constexpr int SSDPport = 1900;
+
+VirtualDevice::VirtualDevice(Settings s)
+    : settings(s),
+      dataServer(this),
+      logServer(this),
+      dataSocket(nullptr),
+      logSocket(nullptr),
+      ssdpSocket(this),
+      mode(Mode::Idle),
+      VNASettings{},
+      SASettings{},
+      sweepPoints(0),
+      pointTimer(this),
+      nextTransmission(0),
+      rng(0),
+      noise(0.0, 1.0),
+      delay(0, (int64_t) s.jitter * 1000000),
+      stats{},
+      standard(Standard::DUT),
+      throughPort1(0),
+      throughPort2(1)
+{
+    if(settings.ports < 1) {
+        settings.ports = 1;
+    } else if(settings.ports > 4) {
+        settings.ports = 4;
+    }
+    stats.pointsPerSecond = settings.pointsPerSecond;
+
+    pointTimer.setTimerType(Qt::PreciseTimer);
+    pointTimer.setInterval(1);
+    connect(&pointTimer, &QTimer::timeout, this, &VirtualDevice::createPoints);
+    connect(&dataServer, &QTcpServer::newConnection, this, &VirtualDevice::newDataConnection);
+    connect(&logServer, &QTcpServer::newConnection, this, &VirtualDevice::newLogConnection);
+    connect(&ssdpSocket, &QUdpSocket::readyRead, this, &VirtualDevice::SSDPreceived);
+}
+
+int64_t VirtualDevice::now()
+{
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+VirtualDevice::Statistics VirtualDevice::getStatistics()
+{
+    lock_guard<mutex> lock(mtx);
+    return stats;
+}
+
+void VirtualDevice::connectStandard(Standard s, unsigned int port1, unsigned int port2)
+{
+    lock_guard<mutex> lock(mtx);
+    standard = s;
+    throughPort1 = port1 - 1;
+    throughPort2 = port2 - 1;
+}
+
+bool VirtualDevice::start()
+{
+    if(!dataServer.listen(QHostAddress::LocalHost, DataPort) || !logServer.listen(QHostAddress::LocalHost, LogPort)) {
+        qWarning() << "Virtual device: unable to listen on ports" << DataPort << "and" << LogPort;
+        return false;
+    }
+    if(!ssdpSocket.bind(QHostAddress::AnyIPv4, SSDPport, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint)) {
+        qWarning() << "Virtual device: unable to bind to the SSDP port, the device can not be discovered";
+        return false;
+    }
+    // multicast requests are only received on interfaces that support multicast, requests from the loopback interface
+    // are sent directly to the SSDP port
+    for(auto i : QNetworkInterface::allInterfaces()) {
+        if(i.flags() & QNetworkInterface::CanMulticast) {
+            ssdpSocket.joinMulticastGroup(SSDPaddress, i);
+        }
+    }
+    qInfo() << "Virtual device" << settings.serial << "with" << settings.ports << "ports," << settings.pointsPerSecond
+            << "points/s and" << settings.jitter << "ms jitter";
+    return true;
+}
+
+void VirtualDevice::newDataConnection()
+{
+    auto socket = dataServer.nextPendingConnection();
+    if(dataSocket) {
+        // only one connection at a time
+        socket->close();
+        socket->deleteLater();
+        return;
+    }
+    dataSocket = socket;
+    receiveBuffer.clear();
+    connect(dataSocket, &QTcpSocket::readyRead, this, &VirtualDevice::receivedData);
+    connect(dataSocket, &QTcpSocket::disconnected, this, [=](){
+        mode = Mode::Idle;
+        pointTimer.stop();
+        pending.clear();
+        dataSocket->deleteLater();
+        dataSocket = nullptr;
+    });
+}
+
+void VirtualDevice::newLogConnection()
+{
+    auto socket = logServer.nextPendingConnection();
+    if(logSocket) {
+        socket->close();
+        socket->deleteLater();
+        return;
+    }
+    logSocket = socket;
+    connect(logSocket, &QTcpSocket::disconnected, this, [=](){
+        logSocket->deleteLater();
+        logSocket = nullptr;
+    });
+    log("Virtual device " + settings.serial);
+}
+
+void VirtualDevice::receivedData()
+{
+    receiveBuffer.append(dataSocket->readAll());
+    Protocol::PacketInfo packet;
+    uint16_t handled_len;
+    do {
+        uint16_t len = min((int) receiveBuffer.size(), (int) numeric_limits<uint16_t>::max());
+        handled_len = Protocol::DecodeBuffer((uint8_t*) receiveBuffer.data(), len, &packet);
+        receiveBuffer.remove(0, handled_len);
+        if(handled_len > 0 && packet.type != Protocol::PacketType::None) {
+            handlePacket(packet);
+        }
+    } while(handled_len > 0 && dataSocket);
+}
+
+void VirtualDevice::SSDPreceived()
+{
+    while(ssdpSocket.hasPendingDatagrams()) {
+        QHostAddress sender;
+        quint16 senderPort;
+        QByteArray buf(ssdpSocket.pendingDatagramSize(), Qt::Uninitialized);
+        ssdpSocket.readDatagram(buf.data(), buf.size(), &sender, &senderPort);
+
+        auto lines = QString(buf).split("\r\n");
+        if(!lines[0].startsWith("M-SEARCH") || !lines.contains("ST: " + service_name)) {
+            continue;
+        }
+        // the device only listens on the loopback interface, don't respond to requests from other hosts
+        bool local = sender.isLoopback();
+        for(auto a : QNetworkInterface::allAddresses()) {
+            if(a.isEqual(sender, QHostAddress::TolerantConversion)) {
+                local = true;
+            }
+        }
+        if(!local) {
+            continue;
+        }
+        QByteArray response;
+        response.append("HTTP/1.1 200 OK\r\n"
+                        "CACHE-CONTROL: max-age=5\r\n"
+                        "LOCATION: 127.0.0.1\r\n"
+                        "ST: ");
+        response.append(service_name.toUtf8());
+        response.append("\r\nLibreVNA-serial: ");
+        response.append(settings.serial.toUtf8());
+        response.append("\r\n\r\n");
+        ssdpSocket.writeDatagram(response, sender, senderPort);
+    }
+}
+
+void VirtualDevice::createPoints()
+{
+    auto time = now();
+    {
+        lock_guard<mutex> lock(mtx);
+        uint64_t due = (time - stats.start) * 1e-9 * stats.pointsPerSecond;
+        for(;stats.points < due;stats.points++) {
+            if(mode == Mode::VNA) {
+                createVNAPoint(stats.points);
+            } else {
+                createSAPoint(stats.points);
+            }
+        }
+    }
+    if(time >= nextTransmission && pending.size() > 0 && dataSocket) {
+        dataSocket->write(pending);
+        pending.clear();
+        nextTransmission = time + delay(rng);
+    }
+}
+
+void VirtualDevice::handlePacket(const Protocol::PacketInfo &p)
+{
+    switch(p.type) {
+    case Protocol::PacketType::SweepSettings:
+        mode = Mode::VNA;
+        VNASettings = p.settings;
+        sweepPoints = VNASettings.points;
+        sendWithoutPayload(Protocol::PacketType::Ack);
+        log("New VNA settings received");
+        startSweep();
+        break;
+    case Protocol::PacketType::SpectrumAnalyzerSettings:
+        mode = Mode::SA;
+        SASettings = p.spectrumSettings;
+        sweepPoints = SASettings.pointNum;
+        sendWithoutPayload(Protocol::PacketType::Ack);
+        log("New spectrum analyzer settings received");
+        startSweep();
+        break;
+    case Protocol::PacketType::RequestDeviceInfo: {
+        sendWithoutPayload(Protocol::PacketType::Ack);
+        Protocol::PacketInfo info = {};
+        info.type = Protocol::PacketType::DeviceInfo;
+        // same limits as the V1 hardware
+        info.info.ProtocolVersion = Protocol::Version;
+        info.info.hardware_version = 1;
+        info.info.HW_Revision = 'V';
+        info.info.limits_minFreq = 0;
+        info.info.limits_maxFreq = 6000000000;
+        info.info.limits_minIFBW = 7;
+        info.info.limits_maxIFBW = 50000;
+        info.info.limits_maxPoints = 4501;
+        info.info.limits_cdbm_min = -4000;
+        info.info.limits_cdbm_max = 0;
+        info.info.limits_minRBW = 14;
+        info.info.limits_maxRBW = 111500;
+        info.info.limits_maxAmplitudePoints = 64;
+        info.info.limits_maxFreqHarmonic = 18000000000;
+        info.info.num_ports = settings.ports;
+        send(info);
+    }
+        break;
+    case Protocol::PacketType::RequestDeviceStatus: {
+        sendWithoutPayload(Protocol::PacketType::Ack);
+        Protocol::PacketInfo status = {};
+        status.type = Protocol::PacketType::DeviceStatus;
+        status.status.V1.FPGA_configured = 1;
+        status.status.V1.source_locked = 1;
+        status.status.V1.LO1_locked = 1;
+        status.status.V1.temp_source = 40;
+        status.status.V1.temp_LO1 = 40;
+        status.status.V1.temp_MCU = 40;
+        send(status);
+    }
+        break;
+    case Protocol::PacketType::SetIdle:
+    case Protocol::PacketType::Generator:
+        // no data is produced in generator mode
+        mode = Mode::Idle;
+        pointTimer.stop();
+        sendWithoutPayload(Protocol::PacketType::Ack);
+        break;
+    case Protocol::PacketType::Reference:
+    case Protocol::PacketType::StopStatusUpdates:
+    case Protocol::PacketType::StartStatusUpdates:
+        sendWithoutPayload(Protocol::PacketType::Ack);
+        break;
+    default:
+        // this packet type is not supported
+        sendWithoutPayload(Protocol::PacketType::Nack);
+        break;
+    }
+}
+
+void VirtualDevice::send(const Protocol::PacketInfo &p)
+{
+    if(!dataSocket) {
+        return;
+    }
+    uint8_t buffer[1024];
+    auto length = Protocol::EncodePacket(p, buffer, sizeof(buffer));
+    if(!length) {
+        qWarning() << "Virtual device: failed to encode packet type" << (int) p.type;
+        return;
+    }
+    // answers are not held back, but must not overtake already created datapoints
+    pending.append((const char*) buffer, length);
+    dataSocket->write(pending);
+    pending.clear();
+}
+
+void VirtualDevice::sendWithoutPayload(Protocol::PacketType type)
+{
+    Protocol::PacketInfo p = {};
+    p.type = type;
+    send(p);
+}
+
+void VirtualDevice::log(QString line)
+{
+    if(logSocket) {
+        logSocket->write(("[INFO] " + line + "\r\n").toLatin1());
+    }
+}
+
+void VirtualDevice::startSweep()
+{
+    pending.clear();
+    {
+        lock_guard<mutex> lock(mtx);
+        stats.start = now();
+        stats.sweepPoints = sweepPoints;
+        stats.points = 0;
+        stats.settings++;
+    }
+    if(sweepPoints > 0) {
+        pointTimer.start();
+    } else {
+        pointTimer.stop();
+    }
+}
+
+void VirtualDevice::createVNAPoint(uint64_t n)
+{
+    auto &s = VNASettings;
+    unsigned int point = n % sweepPoints;
+    Protocol::VNADatapoint<32> d;
+    d.pointNum = point;
+    double frequency = pointFrequency(point, sweepPoints, s.f_start, s.f_stop, s.logSweep);
+    if(s.f_start == s.f_stop && s.cdbm_excitation_start == s.cdbm_excitation_stop) {
+        // zero span, time since the start of the first sweep
+        d.us = n * 1000000.0 / stats.pointsPerSecond;
+    } else {
+        d.frequency = frequency;
+        d.cdBm = s.cdbm_excitation_start;
+        if(sweepPoints > 1) {
+            d.cdBm += (s.cdbm_excitation_stop - s.cdbm_excitation_start) * (int) point / (int) (sweepPoints - 1);
+        }
+    }
+    unsigned int stagePorts[] = {s.port1Stage, s.port2Stage, s.port3Stage, s.port4Stage};
+    // the reference receiver applies to all ports, its value is added last (as on the real hardware)
+    int referenceMask = (int) Protocol::Source::Reference;
+    for(unsigned int i=0;i<settings.ports;i++) {
+        referenceMask |= 0x01 << i;
+    }
+    complex<double> ref = polar(1e5 * pow(10.0, d.cdBm / 2000.0), 2 * M_PI * frequency * 1e-9);
+    for(unsigned int stage=0;stage<=s.stages;stage++) {
+        // find the port with the stimulus in this stage
+        unsigned int excited = settings.ports;
+        for(unsigned int i=0;i<settings.ports;i++) {
+            if(stagePorts[i] == stage) {
+                excited = i;
+                break;
+            }
+        }
+        if(excited >= settings.ports) {
+            continue;
+        }
+        for(unsigned int i=0;i<settings.ports;i++) {
+            auto value = measuredSparam(i, excited, frequency) * ref;
+            value += complex<double>(noise(rng), noise(rng)) * abs(ref) * 1e-4;
+            d.addValue(value.real(), value.imag(), stage, 0x01 << i);
+        }
+        d.addValue(ref.real(), ref.imag(), stage, referenceMask);
+    }
+    Protocol::PacketInfo p;
+    p.type = Protocol::PacketType::VNADatapoint;
+    p.VNAdatapoint = &d;
+    uint8_t buffer[512];
+    auto length = Protocol::EncodePacket(p, buffer, sizeof(buffer));
+    pending.append((const char*) buffer, length);
+}
+
+void VirtualDevice::createSAPoint(uint64_t n)
+{
+    auto &s = SASettings;
+    unsigned int point = n % sweepPoints;
+    Protocol::PacketInfo p = {};
+    p.type = Protocol::PacketType::SpectrumAnalyzerResult;
+    p.spectrumResult.pointNum = point;
+    double frequency = pointFrequency(point, sweepPoints, s.f_start, s.f_stop, false);
+    if(s.f_start == s.f_stop) {
+        p.spectrumResult.us = n * 1000000.0 / stats.pointsPerSecond;
+    } else {
+        p.spectrumResult.frequency = frequency;
+    }
+    // noise floor at -100dBm with a -20dBm signal in the center of the span, amplitudes are linear
+    double center = (s.f_start + s.f_stop) / 2.0;
+    double rbw = s.RBW > 0 ? s.RBW : 1.0;
+    double offset = (frequency - center) / rbw;
+    float amplitude[4];
+    for(unsigned int i=0;i<4;i++) {
+        amplitude[i] = 1e-5 * abs(1.0 + 0.3 * noise(rng)) + 1e-1 * exp(-offset * offset);
+    }
+    p.spectrumResult.port1 = amplitude[0];
+    p.spectrumResult.port2 = amplitude[1];
+    p.spectrumResult.port3 = settings.ports > 2 ? amplitude[2] : 0.0f;
+    p.spectrumResult.port4 = settings.ports > 3 ? amplitude[3] : 0.0f;
+    uint8_t buffer[128];
+    auto length = Protocol::EncodePacket(p, buffer, sizeof(buffer));
+    pending.append((const char*) buffer, length);
+}
+
+complex<double> VirtualDevice::Sparam(unsigned int i, unsigned int j, double frequency)
+{
+    auto w = 2 * M_PI * frequency;
+    switch(standard) {
+    case Standard::Open:
+        return i == j ? 1.0 : 0.0;
+    case Standard::Short:
+        return i == j ? -1.0 : 0.0;
+    case Standard::Load:
+        return 0.0;
+    case Standard::Through:
+        if((i == throughPort1 && j == throughPort2) || (i == throughPort2 && j == throughPort1)) {
+            return 1.0;
+        }
+        return 0.0;
+    case Standard::DUT:
+    default:
+        if(i == j) {
+            // slightly mismatched line
+            return polar(0.05, -w * 2e-9);
+        } else if(i / 2 == j / 2 && i / 2 * 2 + 1 < settings.ports) {
+            // 1ns delay, loss increases with frequency
+            double dB = -0.5 - 2.0 * frequency / 1e9;
+            return polar(pow(10.0, dB / 20.0), -w * 1e-9);
+        }
+        return 0.0;
+    }
+}
+
+complex<double> VirtualDevice::measuredSparam(unsigned int i, unsigned int j, double frequency)
+{
+    auto w = 2 * M_PI * frequency;
+    auto directivity = polar(0.05, -w * 0.1e-9 * (i + 1));
+    auto sourceMatch = polar(0.1, -w * 0.2e-9);
+    auto reflectionTracking = polar(0.9, -w * 0.5e-9);
+    auto transmissionTracking = polar(0.95, -w * 0.25e-9);
+    auto S = Sparam(i, j, frequency);
+    if(i == j) {
+        return directivity + reflectionTracking * S / (1.0 - sourceMatch * S);
+    } else {
+        return transmissionTracking * transmissionTracking * S
+                / ((1.0 - sourceMatch * Sparam(j, j, frequency)) * (1.0 - sourceMatch * Sparam(i, i, frequency)));
+    }
+}
+
+double VirtualDevice::pointFrequency(unsigned int point, unsigned int points, uint64_t start, uint64_t stop, bool log)
+{
+    if(points <= 1) {
+        return start;
+    }
+    if(log && start > 0) {
+        return start * pow((double) stop / start, (double) point / (points - 1));
+    }
+    return start + ((double) stop - start) * point / (points - 1);
+}
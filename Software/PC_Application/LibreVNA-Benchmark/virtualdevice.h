@@ -0,0 +1,147 @@
+#ifndef VIRTUALDEVICE_H
+#define VIRTUALDEVICE_H
+
+#include "../../VNA_embedded/Application/Communication/Protocol.hpp"
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUdpSocket>
+#include <QTimer>
+#include <QByteArray>
+
+#include <complex>
+#include <cstdint>
+#include <mutex>
+#include <random>
+
+/**
+ * @brief Host-side stand-in for a LibreVNA connected via Ethernet
+ *
+ * Speaks the device protocol on the same TCP ports as the real hardware (data and log port) and answers SSDP requests,
+ * so it is found and used by the LibreVNATCPDriver of the GUI like any other device. Only the parts of the protocol
+ * that are required for measurements are implemented: device info/status, VNA sweeps and spectrum analyzer sweeps.
+ * Every other packet is answered with a Nack, just like an unsupported packet on the real hardware.
+ *
+ * Measurement data is synthetic: the ports see a simple error model (directivity, source match, tracking) in front of
+ * the selected standard or of a lossy transmission line connecting neighboring ports. Points are created at a fixed
+ * rate instead of depending on the IF bandwidth, the packets are held back by a random delay of up to the configured
+ * jitter before they are sent.
+ *
+ * Points are scheduled relative to the start of the sweep: point n (counted across sweeps) is created at
+ * start + n / pointsPerSecond. The statistics expose this schedule so a client can calculate the latency of every point.
+ *
+ * The device expects to run in its own thread, the statistics and the selected standard may be accessed from any thread.
+ */
+class VirtualDevice : public QObject
+{
+    Q_OBJECT
+public:
+    class Settings {
+    public:
+        QString serial;
+        unsigned int ports;
+        double pointsPerSecond;
+        // maximum delay of a transmission in ms
+        unsigned int jitter;
+    };
+
+    enum class Standard {
+        // lossy transmission line between port 1/2 and port 3/4
+        DUT,
+        Open,
+        Short,
+        Load,
+        // the ports given to connectStandard() are connected, all other ports are terminated
+        Through,
+    };
+
+    class Statistics {
+    public:
+        // start of the current sweep in ns (see now())
+        int64_t start;
+        double pointsPerSecond;
+        unsigned int sweepPoints;
+        // number of points created since the start
+        uint64_t points;
+        // number of received sweep settings
+        unsigned int settings;
+    };
+
+    VirtualDevice(Settings s);
+
+    // Returns the time in ns of a monotonic clock, the time base for the statistics
+    static int64_t now();
+
+    QString getSerial() const {return settings.serial;}
+    unsigned int getPorts() const {return settings.ports;}
+    double getPointsPerSecond() const {return settings.pointsPerSecond;}
+
+    Statistics getStatistics();
+    void connectStandard(Standard s, unsigned int port1 = 1, unsigned int port2 = 2);
+
+    static constexpr int DataPort = 19544;
+    static constexpr int LogPort = 19545;
+
+public slots:
+    // Starts to listen for connections and SSDP requests. Returns false if a port is not available
+    bool start();
+
+private slots:
+    void newDataConnection();
+    void newLogConnection();
+    void receivedData();
+    void SSDPreceived();
+    void createPoints();
+
+private:
+    void handlePacket(const Protocol::PacketInfo &p);
+    void send(const Protocol::PacketInfo &p);
+    void sendWithoutPayload(Protocol::PacketType type);
+    void log(QString line);
+    void startSweep();
+    // appends point n of the sweep to the pending data
+    void createVNAPoint(uint64_t n);
+    void createSAPoint(uint64_t n);
+    // S parameter of the connected DUT/standard (ports start at zero)
+    std::complex<double> Sparam(unsigned int i, unsigned int j, double frequency);
+    // raw receiver value of port i with port j excited, includes the error model
+    std::complex<double> measuredSparam(unsigned int i, unsigned int j, double frequency);
+    double pointFrequency(unsigned int point, unsigned int points, uint64_t start, uint64_t stop, bool log);
+
+    Settings settings;
+
+    QTcpServer dataServer;
+    QTcpServer logServer;
+    QTcpSocket *dataSocket;
+    QTcpSocket *logSocket;
+    QUdpSocket ssdpSocket;
+    QByteArray receiveBuffer;
+
+    enum class Mode {
+        Idle,
+        VNA,
+        SA,
+    };
+    Mode mode;
+    Protocol::SweepSettings VNASettings;
+    Protocol::SpectrumAnalyzerSettings SASettings;
+    unsigned int sweepPoints;
+
+    QTimer pointTimer;
+    // encoded packets that are waiting for the next transmission
+    QByteArray pending;
+    int64_t nextTransmission;
+
+    std::mt19937 rng;
+    std::normal_distribution<double> noise;
+    std::uniform_int_distribution<int64_t> delay;
+
+    // protects the statistics and the connected standard
+    std::mutex mtx;
+    Statistics stats;
+    Standard standard;
+    unsigned int throughPort1, throughPort2;
+};
+
+#endif // VIRTUALDEVICE_H
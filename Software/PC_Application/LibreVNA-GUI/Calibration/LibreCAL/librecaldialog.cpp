@@ -322,6 +322,14 @@ void LibreCALDialog::loadCoefficients()
     }
 }
 
+void LibreCALDialog::handleIncomingMeasurements(std::vector<DeviceDriver::VNAMeasurement> m)
+{
+    if(m.size() > 0) {
+        // single point sweep, only the first measurement is relevant
+        handleIncomingMeasurement(m.front());
+    }
+}
+
 void LibreCALDialog::handleIncomingMeasurement(DeviceDriver::VNAMeasurement m)
 {
     stopSweep();
@@ -406,13 +414,13 @@ void LibreCALDialog::startSweep()
         s.excitedPorts.push_back(i);
     }
     driver->setVNA(s, [=](bool){
-        connect(driver, &DeviceDriver::VNAmeasurementReceived, this, &LibreCALDialog::handleIncomingMeasurement, Qt::DirectConnection);
+        connect(driver, &DeviceDriver::VNAmeasurementsReceived, this, &LibreCALDialog::handleIncomingMeasurements, Qt::DirectConnection);
     });
 }
 
 void LibreCALDialog::stopSweep()
 {
-    disconnect(driver, &DeviceDriver::VNAmeasurementReceived, this, &LibreCALDialog::handleIncomingMeasurement);
+    disconnect(driver, &DeviceDriver::VNAmeasurementsReceived, this, &LibreCALDialog::handleIncomingMeasurements);
     driver->setIdle();
 }
 
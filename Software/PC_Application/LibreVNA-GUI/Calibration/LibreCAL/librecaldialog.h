@@ -35,6 +35,7 @@ private slots:
     void startCalibration();
 
     // auto port slots
+    void handleIncomingMeasurements(std::vector<DeviceDriver::VNAMeasurement> m);
     void handleIncomingMeasurement(DeviceDriver::VNAMeasurement m);
     void startSweep();
     void stopSweep();
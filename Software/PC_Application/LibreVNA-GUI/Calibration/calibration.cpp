@@ -7,10 +7,9 @@
 #include "LibreCAL/librecaldialog.h"
 #include "preferences.h"
 
-#include "Eigen/Dense"
-
 #include <fstream>
 #include <iomanip>
+#include <exception>
 
 #include <QDialog>
 #include <QMenu>
@@ -19,7 +18,9 @@
 #include <QFileDialog>
 
 using namespace std;
-using Eigen::MatrixXcd;
+
+// Points are only split across threads if every thread gets at least this number of points
+static constexpr unsigned int minimumChunk = 16;
 
 bool operator==(const Calibration::CalType &lhs, const Calibration::CalType &rhs) {
     if(lhs.type != rhs.type) {
@@ -326,84 +327,67 @@ void Calibration::correctMeasurement(DeviceDriver::VNAMeasurement &d)
         // no calibration active, nothing to do
         return;
     }
-    // formulas from "Multi-Port Calibration Techniques for Differential Parameter Measurements with Network Analyzers", variable names also losely follow this document
-    MatrixXcd S(caltype.usedPorts.size(), caltype.usedPorts.size());
-    MatrixXcd a(caltype.usedPorts.size(), caltype.usedPorts.size());
-    MatrixXcd b(caltype.usedPorts.size(), caltype.usedPorts.size());
-
-    // gab point and interpolate
-    Point p;
-    if(d.frequency <= points.front().frequency) {
-        p = points.front();
-    } else if(d.frequency >= points.back().frequency) {
-        p = points.back();
-    } else {
-        // needs to interpolate
-        auto lower = lower_bound(points.begin(), points.end(), d.frequency, [](const Point &lhs, double rhs) -> bool {
-            return lhs.frequency < rhs;
-        });
-        auto highPoint = *lower;
-        auto lowPoint = *prev(lower);
-        double alpha = (d.frequency - lowPoint.frequency) / (highPoint.frequency - lowPoint.frequency);
+    kernel.correct(d);
+}
 
-        p = lowPoint.interpolate(highPoint, alpha);
+void Calibration::correctMeasurements(std::vector<DeviceDriver::VNAMeasurement> &block)
+{
+    lock_guard<recursive_mutex> guard(access);
+    if(caltype.type == Type::None) {
+        // no calibration active, nothing to do
+        return;
     }
+    kernel.correct(block);
+}
 
-    // Grab measurements (easier to access by index later)
-    for(unsigned int i=0;i<caltype.usedPorts.size();i++) {
-        for(unsigned int j=0;j<caltype.usedPorts.size();j++) {
-            auto pSrc = caltype.usedPorts[i];
-            auto pRcv = caltype.usedPorts[j];
-            auto name = "S"+QString::number(pRcv)+QString::number(pSrc);
-            if(d.measurements.count(name) == 0) {
+void Calibration::correctTraces(std::map<QString, Trace *> traceSet)
+{
+    lock_guard<recursive_mutex> guard(access);
+    if(caltype.type == Type::None || traceSet.empty()) {
+        return;
+    }
+    auto frequencies = Trace::commonFrequencies(traceSet);
+    if(frequencies.empty()) {
+        return;
+    }
+    // copy the traces into one contiguous array per S parameter, the whole sweep is corrected at once
+    auto ports = caltype.usedPorts.size();
+    vector<vector<complex<double>>> values(ports * ports);
+    vector<complex<double>*> parameters(ports * ports, nullptr);
+    vector<Trace*> traces(ports * ports, nullptr);
+    for(unsigned int i=0;i<ports;i++) {
+        for(unsigned int j=0;j<ports;j++) {
+            auto name = "S"+QString::number(caltype.usedPorts[j])+QString::number(caltype.usedPorts[i]);
+            if(!traceSet.count(name)) {
                 qWarning() << "Missing measurement for calibration:" << name;
-                S(j,i) = 0.0;
-            } else {
-                // grab measurement and remove isolation here
-                S(j,i) = d.measurements[name];
-                if(j != i) {
-                    S(j,i) -= p.I[i][j];
-                }
+                continue;
             }
-        }
-    }
-
-    // assemble a (L) and b (K) matrices
-    for(unsigned int i=0;i<caltype.usedPorts.size();i++) {
-        for(unsigned int j=0;j<caltype.usedPorts.size();j++) {
-            if(i == j) {
-                // calculate incident and reflected wave at the exciting port
-                a(j,i) = 1.0 + p.S[i]/p.R[i]*(S(j,i) - p.D[i]*1.0);
-                b(j,i) = (1.0 / p.R[i]) * (S(j,i) - p.D[i]*1.0);
-            } else {
-                // calculate incident and reflected wave at the receiving port
-                a(j,i) = p.L[i][j]*S(j,i) / p.T[i][j];
-                b(j,i) = S(j,i) / p.T[i][j];
+            auto t = traceSet[name];
+            auto &v = values[i*ports+j];
+            v.resize(frequencies.size());
+            for(unsigned int k=0;k<frequencies.size();k++) {
+                v[k] = t->sample(k).y;
             }
+            parameters[i*ports+j] = v.data();
+            traces[i*ports+j] = t;
         }
     }
-    S = b * a.inverse();
-
-    // extract measurement from matrix and store back into VNAMeasurement
-    for(unsigned int i=0;i<caltype.usedPorts.size();i++) {
-        for(unsigned int j=0;j<caltype.usedPorts.size();j++) {
-            auto pSrc = caltype.usedPorts[i];
-            auto pRcv = caltype.usedPorts[j];
-            auto name = "S"+QString::number(pRcv)+QString::number(pSrc);
-            d.measurements[name] = S(j,i);
+    kernel.correctSweep(frequencies.data(), frequencies.size(), parameters);
+    for(unsigned int p=0;p<traces.size();p++) {
+        auto t = traces[p];
+        if(!t) {
+            continue;
         }
-    }
-}
-
-void Calibration::correctTraces(std::map<QString, Trace *> traceSet)
-{
-    auto points = Trace::assembleDatapoints(traceSet);
-    if(points.size()) {
-        // succeeded in assembling datapoints
-        for(auto &p : points) {
-            correctMeasurement(p);
+        t->clear();
+        t->beginUpdate();
+        Trace::Data d;
+        for(unsigned int k=0;k<frequencies.size();k++) {
+            d.x = frequencies[k];
+            d.y = values[p][k];
+            // samples are already sorted, no need to search for the insert position
+            t->addData(d, Trace::DataType::Frequency, 50.0, k);
         }
-        Trace::fillFromDatapoints(traceSet, points);
+        t->endUpdate();
     }
 }
 
@@ -703,6 +687,81 @@ CalibrationMeasurement::Base *Calibration::newMeasurement(CalibrationMeasurement
     return m;
 }
 
+void Calibration::updateKernel()
+{
+    kernel.reset(caltype.usedPorts, points.size());
+    for(unsigned int i=0;i<points.size();i++) {
+        auto &p = points[i];
+        kernel.setPoint(i, p.frequency, p.D, p.R, p.S, p.L, p.T, p.I);
+    }
+}
+
+Calibration::UsedMeasurements Calibration::findUsedMeasurements()
+{
+    UsedMeasurements m;
+    auto ports = caltype.usedPorts.size();
+    m.ports.resize(ports);
+    m.paths.resize(ports, vector<UsedMeasurements::Path>(ports));
+    for(unsigned int i=0;i<ports;i++) {
+        auto p = caltype.usedPorts[i];
+        auto &port = m.ports[i];
+        port._short = static_cast<CalibrationMeasurement::Short*>(findMeasurement(CalibrationMeasurement::Base::Type::Short, p));
+        port.open = static_cast<CalibrationMeasurement::Open*>(findMeasurement(CalibrationMeasurement::Base::Type::Open, p));
+        port.load = static_cast<CalibrationMeasurement::Load*>(findMeasurement(CalibrationMeasurement::Base::Type::Load, p));
+        auto slidingMeasurements = findMeasurements(CalibrationMeasurement::Base::Type::SlidingLoad, p);
+        if(slidingMeasurements.size() >= 3) {
+            for(auto s : slidingMeasurements) {
+                port.slidingLoads.push_back(static_cast<CalibrationMeasurement::SlidingLoad*>(s));
+            }
+        }
+        port.reflect = static_cast<CalibrationMeasurement::Reflect*>(findMeasurement(CalibrationMeasurement::Base::Type::Reflect, p));
+        port.reflectIsShort = false;
+        if(caltype.type == Type::TRL) {
+            auto shortStandard = dynamic_cast<CalStandard::Short*>(port.reflect->getStandard());
+            auto openStandard = dynamic_cast<CalStandard::Open*>(port.reflect->getStandard());
+            auto reflectStandard = dynamic_cast<CalStandard::Reflect*>(port.reflect->getStandard());
+            if(shortStandard) {
+                port.reflectIsShort = true;
+            } else if(openStandard) {
+                port.reflectIsShort = false;
+            } else if(reflectStandard) {
+                port.reflectIsShort = reflectStandard->getIsShort();
+            } else {
+                // invalid standard
+                throw runtime_error("Invalid standard defined for reflection measurement");
+            }
+        }
+    }
+    for(unsigned int i=0;i<ports;i++) {
+        for(unsigned int j=0;j<ports;j++) {
+            if(i == j) {
+                continue;
+            }
+            auto p1 = caltype.usedPorts[i];
+            auto p2 = caltype.usedPorts[j];
+            auto &path = m.paths[i][j];
+            // prefer the through measurement in forward direction
+            path.through = static_cast<CalibrationMeasurement::Through*>(findMeasurement(CalibrationMeasurement::Base::Type::Through, p1, p2));
+            path.throughReversed = false;
+            if(!path.through) {
+                path.through = static_cast<CalibrationMeasurement::Through*>(findMeasurement(CalibrationMeasurement::Base::Type::Through, p2, p1));
+                path.throughReversed = true;
+            }
+            // all line measurements, forward direction first
+            for(int reversed=0;reversed<2;reversed++) {
+                auto lines = reversed ? findMeasurements(CalibrationMeasurement::Base::Type::Line, p2, p1)
+                                      : findMeasurements(CalibrationMeasurement::Base::Type::Line, p1, p2);
+                for(auto l : lines) {
+                    path.lines.push_back(static_cast<CalibrationMeasurement::Line*>(l));
+                    path.linesReversed.push_back(reversed > 0);
+                }
+            }
+        }
+    }
+    m.isolation = static_cast<CalibrationMeasurement::Isolation*>(findMeasurement(CalibrationMeasurement::Base::Type::Isolation));
+    return m;
+}
+
 Calibration::Point Calibration::createInitializedPoint(double f) {
     Point point;
     point.frequency = f;
@@ -720,26 +779,24 @@ Calibration::Point Calibration::createInitializedPoint(double f) {
     return point;
 }
 
-Calibration::Point Calibration::computeSOLT(double f)
+Calibration::Point Calibration::computeSOLT(double f, const UsedMeasurements &m)
 {
     Point point = createInitializedPoint(f);
 
     // Calculate SOL coefficients
     for(unsigned int i=0;i<caltype.usedPorts.size();i++) {
-        auto p = caltype.usedPorts[i];
-        auto _short = static_cast<CalibrationMeasurement::Short*>(findMeasurement(CalibrationMeasurement::Base::Type::Short, p));
-        auto open = static_cast<CalibrationMeasurement::Open*>(findMeasurement(CalibrationMeasurement::Base::Type::Open, p));
+        auto &port = m.ports[i];
+        auto _short = port._short;
+        auto open = port.open;
         auto s_m = _short->getMeasured(f);
         auto o_m = open->getMeasured(f);
         auto s_c = _short->getActual(f);
         auto o_c = open->getActual(f);
         complex<double> l_c, l_m;
-        auto slidingMeasurements = findMeasurements(CalibrationMeasurement::Base::Type::SlidingLoad, p);
-        if(slidingMeasurements.size() >= 3) {
+        if(port.slidingLoads.size() >= 3) {
             // use sliding load
             vector<complex<double>> slidingMeasured;
-            for(auto m : slidingMeasurements) {
-                auto slidingLoad = static_cast<CalibrationMeasurement::SlidingLoad*>(m);
+            for(auto slidingLoad : port.slidingLoads) {
                 auto value = slidingLoad->getMeasured(f);
                 if(isnan(abs(value))) {
                     throw runtime_error("missing sliding load measurement");
@@ -752,7 +809,7 @@ Calibration::Point Calibration::computeSOLT(double f)
             l_c = 0.0;
         } else {
             // use normal load standard
-            auto load = static_cast<CalibrationMeasurement::Load*>(findMeasurement(CalibrationMeasurement::Base::Type::Load, p));
+            auto load = port.load;
             l_c = load->getActual(f);
             l_m = load->getMeasured(f);
         }
@@ -772,25 +829,25 @@ Calibration::Point Calibration::computeSOLT(double f)
             auto p1 = caltype.usedPorts[i];
             auto p2 = caltype.usedPorts[j];
             // grab measurement and calkit through definitions
-            auto throughForward = static_cast<CalibrationMeasurement::Through*>(findMeasurement(CalibrationMeasurement::Base::Type::Through, p1, p2));
-            auto throughReverse = static_cast<CalibrationMeasurement::Through*>(findMeasurement(CalibrationMeasurement::Base::Type::Through, p2, p1));
+            auto &path = m.paths[i][j];
             complex<double> S11, S21;
             Sparam Sideal;
-            if(throughForward) {
-                S11 = throughForward->getMeasured(f).m11;
-                S21 = throughForward->getMeasured(f).m21;
-                Sideal = throughForward->getActual(f);
-            } else if(throughReverse) {
-                S11 = throughReverse->getMeasured(f).m22;
-                S21 = throughReverse->getMeasured(f).m12;
-                Sideal = throughReverse->getActual(f);
-                swap(Sideal.m11, Sideal.m22);
-                swap(Sideal.m12, Sideal.m21);
-            }
-            auto isoMeas = static_cast<CalibrationMeasurement::Isolation*>(findMeasurement(CalibrationMeasurement::Base::Type::Isolation));
+            if(path.through) {
+                auto measured = path.through->getMeasured(f);
+                Sideal = path.through->getActual(f);
+                if(!path.throughReversed) {
+                    S11 = measured.m11;
+                    S21 = measured.m21;
+                } else {
+                    S11 = measured.m22;
+                    S21 = measured.m12;
+                    swap(Sideal.m11, Sideal.m22);
+                    swap(Sideal.m12, Sideal.m21);
+                }
+            }
             auto isolation = complex<double>(0.0,0.0);
-            if(isoMeas) {
-                isolation = isoMeas->getMeasured(f, p2, p1);
+            if(m.isolation) {
+                isolation = m.isolation->getMeasured(f, p2, p1);
             }
             auto deltaS = Sideal.m11*Sideal.m22 - Sideal.m21 * Sideal.m12;
             point.L[i][j] = ((S11 - point.D[i])*(1.0 - point.S[i] * Sideal.m11)-Sideal.m11*point.R[i])
@@ -802,7 +859,7 @@ Calibration::Point Calibration::computeSOLT(double f)
     return point;
 }
 
-Calibration::Point Calibration::computeThroughNormalization(double f)
+Calibration::Point Calibration::computeThroughNormalization(double f, const UsedMeasurements &m)
 {
     Point point = createInitializedPoint(f);
 
@@ -820,20 +877,18 @@ Calibration::Point Calibration::computeThroughNormalization(double f)
                 // this is the exciting port, SOL error box used here
                 continue;
             }
-            auto p1 = caltype.usedPorts[i];
-            auto p2 = caltype.usedPorts[j];
             // grab measurement and calkit through definitions
-            auto throughForward = static_cast<CalibrationMeasurement::Through*>(findMeasurement(CalibrationMeasurement::Base::Type::Through, p1, p2));
-            auto throughReverse = static_cast<CalibrationMeasurement::Through*>(findMeasurement(CalibrationMeasurement::Base::Type::Through, p2, p1));
+            auto &path = m.paths[i][j];
             complex<double> S21 = 0.0;
             Sparam Sideal;
-            if(throughForward) {
-                S21 = throughForward->getMeasured(f).m21;
-                Sideal = throughForward->getActual(f);
-            } else if(throughReverse) {
-                S21 = throughReverse->getMeasured(f).m12;
-                Sideal = throughReverse->getActual(f);
-                swap(Sideal.m12, Sideal.m21);
+            if(path.through) {
+                Sideal = path.through->getActual(f);
+                if(!path.throughReversed) {
+                    S21 = path.through->getMeasured(f).m21;
+                } else {
+                    S21 = path.through->getMeasured(f).m12;
+                    swap(Sideal.m12, Sideal.m21);
+                }
             }
             point.L[i][j] = 0.0;
             point.T[i][j] = S21 / Sideal.m21;
@@ -843,7 +898,7 @@ Calibration::Point Calibration::computeThroughNormalization(double f)
     return point;
 }
 
-Calibration::Point Calibration::computeTRL(double freq)
+Calibration::Point Calibration::computeTRL(double freq, const UsedMeasurements &m)
 {
     Point point = createInitializedPoint(freq);
 
@@ -854,83 +909,45 @@ Calibration::Point Calibration::computeTRL(double freq)
                 // calculation only possible with through measurements
                 continue;
             }
-            auto p1 = caltype.usedPorts[i];
-            auto p2 = caltype.usedPorts[j];
             // grab reflection measurements
-            auto S11_reflection = static_cast<CalibrationMeasurement::Reflect*>(findMeasurement(CalibrationMeasurement::Base::Type::Reflect, p1));
-            auto S22_reflection = static_cast<CalibrationMeasurement::Reflect*>(findMeasurement(CalibrationMeasurement::Base::Type::Reflect, p2));
-            bool S11_short, S22_short;
-            {
-                auto S11_short_standard = dynamic_cast<CalStandard::Short*>(S11_reflection->getStandard());
-                auto S11_open_standard = dynamic_cast<CalStandard::Open*>(S11_reflection->getStandard());
-                auto S11_reflect_standard = dynamic_cast<CalStandard::Reflect*>(S11_reflection->getStandard());
-                if(S11_short_standard) {
-                    S11_short = true;
-                } else if(S11_open_standard) {
-                    S11_short = false;
-                } else if(S11_reflect_standard) {
-                    S11_short = S11_reflect_standard->getIsShort();
-                } else {
-                    // invalid standard
-                    throw runtime_error("Invalid standard defined for reflection measurement");
-                }
-                auto S22_short_standard = dynamic_cast<CalStandard::Short*>(S22_reflection->getStandard());
-                auto S22_open_standard = dynamic_cast<CalStandard::Open*>(S22_reflection->getStandard());
-                auto S22_reflect_standard = dynamic_cast<CalStandard::Reflect*>(S22_reflection->getStandard());
-                if(S22_short_standard) {
-                    S22_short = true;
-                } else if(S22_open_standard) {
-                    S22_short = false;
-                } else if(S22_reflect_standard) {
-                    S22_short = S22_reflect_standard->getIsShort();
-                } else {
-                    // invalid standard
-                    throw runtime_error("Invalid standard defined for reflection measurement");
-                }
-            }
+            auto S11_reflection = m.ports[i].reflect;
+            auto S22_reflection = m.ports[j].reflect;
             bool reflectionIsNegative;
-            if(S11_short && S22_short) {
+            if(m.ports[i].reflectIsShort && m.ports[j].reflectIsShort) {
                 reflectionIsNegative = true;
-            } else if(!S11_short && !S22_short) {
+            } else if(!m.ports[i].reflectIsShort && !m.ports[j].reflectIsShort) {
                 reflectionIsNegative = false;
             } else {
                 throw runtime_error("Reflection measurements must all use the same standard (either open or short)");
             }
             // grab through measurement
-            auto throughForward = static_cast<CalibrationMeasurement::Through*>(findMeasurement(CalibrationMeasurement::Base::Type::Through, p1, p2));
-            auto throughReverse = static_cast<CalibrationMeasurement::Through*>(findMeasurement(CalibrationMeasurement::Base::Type::Through, p2, p1));
+            auto &path = m.paths[i][j];
             Sparam Sthrough;
-            if(throughForward) {
-                Sthrough = throughForward->getMeasured(freq);
-            } else if(throughReverse) {
-                Sthrough = throughReverse->getMeasured(freq);
-                swap(Sthrough.m11, Sthrough.m22);
-                swap(Sthrough.m12, Sthrough.m21);
-            }
-            // grab line measurement
-            auto forwardLines = findMeasurements(CalibrationMeasurement::Base::Type::Line, p1, p2);
-            auto reverseLines = findMeasurements(CalibrationMeasurement::Base::Type::Line, p2, p1);
-            // find the closest (geometric) match for the current frequency
+            if(path.through) {
+                Sthrough = path.through->getMeasured(freq);
+                if(path.throughReversed) {
+                    swap(Sthrough.m11, Sthrough.m22);
+                    swap(Sthrough.m12, Sthrough.m21);
+                }
+            }
+            // find the line measurement with the closest (geometric) match for the current frequency
             double closestIdealFreqRatio = numeric_limits<double>::max();
             bool closestLineIsReversed = false;
             CalibrationMeasurement::Line* closestLine = nullptr;
             CalStandard::Line* closestStandard = nullptr;
-            for(int i=0;i<2;i++) {
-                auto list = i ? reverseLines : forwardLines;
-                for(auto l : list) {
-                    auto line = static_cast<CalibrationMeasurement::Line*>(l);
-                    auto standard = static_cast<CalStandard::Line*>(line->getStandard());
-                    double idealFreq = (standard->minFrequency() + standard->maxFrequency()) / 2;
-                    double mismatch = idealFreq / freq;
-                    if(mismatch < 0) {
-                        mismatch = 1.0 / mismatch;
-                    }
-                    if(mismatch < closestIdealFreqRatio) {
-                        closestIdealFreqRatio = mismatch;
-                        closestLineIsReversed = i > 0;
-                        closestLine = line;
-                        closestStandard = standard;
-                    }
+            for(unsigned int k=0;k<path.lines.size();k++) {
+                auto line = path.lines[k];
+                auto standard = static_cast<CalStandard::Line*>(line->getStandard());
+                double idealFreq = (standard->minFrequency() + standard->maxFrequency()) / 2;
+                double mismatch = idealFreq / freq;
+                if(mismatch < 0) {
+                    mismatch = 1.0 / mismatch;
+                }
+                if(mismatch < closestIdealFreqRatio) {
+                    closestIdealFreqRatio = mismatch;
+                    closestLineIsReversed = path.linesReversed[k];
+                    closestLine = line;
+                    closestStandard = standard;
                 }
             }
             if(!closestLine) {
@@ -1317,6 +1334,11 @@ nlohmann::json Calibration::toJSON()
 }
 
 void Calibration::fromJSON(nlohmann::json j)
+{
+    fromJSON(j, nullptr);
+}
+
+void Calibration::fromJSON(nlohmann::json j, const BinaryContainer *container)
 {
     reset();
     lock_guard<recursive_mutex> guard(access);
@@ -1355,7 +1377,10 @@ void Calibration::fromJSON(nlohmann::json j)
             }
         }
         if(ct.type != Type::None) {
-            compute(ct);
+            // computing the coefficients takes a while for large calibrations, use the stored ones if available
+            if(!container || !j.contains("coefficients") || !coefficientsFromBinary(ct, j["coefficients"], *container)) {
+                compute(ct);
+            }
         }
         validDevice = QString::fromStdString(j.value("device", ""));
     }
@@ -1486,15 +1511,119 @@ void Calibration::fromJSON(nlohmann::json j)
     }
 }
 
+nlohmann::json Calibration::coefficientsToBinary(BinaryContainer &container)
+{
+    // complex values are stored as real and imaginary part, in the same order as in the calibration kernel
+    vector<double> frequency, D, R, S, L, T, I;
+    auto add = [](vector<double> &v, complex<double> value) {
+        v.push_back(value.real());
+        v.push_back(value.imag());
+    };
+    for(auto &p : points) {
+        frequency.push_back(p.frequency);
+        for(unsigned int i=0;i<caltype.usedPorts.size();i++) {
+            add(D, p.D[i]);
+            add(R, p.R[i]);
+            add(S, p.S[i]);
+            for(unsigned int j=0;j<caltype.usedPorts.size();j++) {
+                add(L, p.L[i][j]);
+                add(T, p.T[i][j]);
+                add(I, p.I[i][j]);
+            }
+        }
+    }
+    nlohmann::json j;
+    j["frequency"] = container.addArray(std::move(frequency));
+    j["D"] = container.addArray(std::move(D));
+    j["R"] = container.addArray(std::move(R));
+    j["S"] = container.addArray(std::move(S));
+    j["L"] = container.addArray(std::move(L));
+    j["T"] = container.addArray(std::move(T));
+    j["I"] = container.addArray(std::move(I));
+    return j;
+}
+
+bool Calibration::coefficientsFromBinary(Calibration::CalType type, const nlohmann::json &coefficients, const BinaryContainer &container)
+{
+    double start, stop;
+    int numPoints;
+    if(!canCompute(type, &start, &stop, &numPoints)) {
+        return false;
+    }
+    unsigned int ports = type.usedPorts.size();
+    // returns the array if it has the expected size
+    auto getArray = [&](string name, unsigned long long size) -> const double* {
+        if(!coefficients.contains(name) || !coefficients[name].is_number_unsigned()) {
+            return nullptr;
+        }
+        unsigned int index = coefficients[name];
+        if(container.getArraySize(index) != size) {
+            return nullptr;
+        }
+        return container.getArray(index);
+    };
+    auto frequency = getArray("frequency", numPoints);
+    auto D = getArray("D", numPoints * ports * 2);
+    auto R = getArray("R", numPoints * ports * 2);
+    auto S = getArray("S", numPoints * ports * 2);
+    auto L = getArray("L", numPoints * ports * ports * 2);
+    auto T = getArray("T", numPoints * ports * ports * 2);
+    auto I = getArray("I", numPoints * ports * ports * 2);
+    if(!frequency || !D || !R || !S || !L || !T || !I) {
+        return false;
+    }
+    caltype = type;
+    points.clear();
+    for(int k=0;k<numPoints;k++) {
+        auto p = createInitializedPoint(frequency[k]);
+        for(unsigned int i=0;i<ports;i++) {
+            auto n = k*ports+i;
+            p.D[i] = complex<double>(D[2*n], D[2*n+1]);
+            p.R[i] = complex<double>(R[2*n], R[2*n+1]);
+            p.S[i] = complex<double>(S[2*n], S[2*n+1]);
+            for(unsigned int j=0;j<ports;j++) {
+                auto m = n*ports+j;
+                p.L[i][j] = complex<double>(L[2*m], L[2*m+1]);
+                p.T[i][j] = complex<double>(T[2*m], T[2*m+1]);
+                p.I[i][j] = complex<double>(I[2*m], I[2*m+1]);
+            }
+        }
+        points.push_back(p);
+    }
+    updateKernel();
+    emit activated(caltype);
+    return true;
+}
+
 bool Calibration::toFile(QString filename)
 {
     if(filename.isEmpty()) {
         QString fn = descriptiveCalName();
-        filename = QFileDialog::getSaveFileName(nullptr, "Save calibration data", fn, "Calibration files (*.cal)", nullptr, Preferences::QFileDialogOptions());
+        QString filter;
+        filename = QFileDialog::getSaveFileName(nullptr, "Save calibration data", fn, "Calibration files (*.cal);;Binary calibration files (*.calbin)", &filter, Preferences::QFileDialogOptions());
         if(filename.isEmpty()) {
             // aborted selection
             return false;
         }
+        if(filter.contains("*.calbin") && !filename.toLower().endsWith(".calbin")) {
+            filename += ".calbin";
+        }
+    }
+
+    if(filename.toLower().endsWith(".calbin")) {
+        // compact binary format, also contains the calculated coefficients
+        BinaryContainer container;
+        auto j = container.pack(toJSON());
+        if(caltype.type != Type::None) {
+            j["coefficients"] = coefficientsToBinary(container);
+        }
+        if(!container.save(filename, j)) {
+            qWarning() << "Unable to write calibration file" << filename;
+            return false;
+        }
+        this->currentCalFile = filename;
+        unsavedChanges = false;
+        return true;
     }
 
     if(filename.toLower().endsWith(".cal")) {
@@ -1514,7 +1643,7 @@ bool Calibration::toFile(QString filename)
 bool Calibration::fromFile(QString filename)
 {
     if(filename.isEmpty()) {
-        filename = QFileDialog::getOpenFileName(nullptr, "Load calibration data", "", "Calibration files (*.cal)", nullptr, Preferences::QFileDialogOptions());
+        filename = QFileDialog::getOpenFileName(nullptr, "Load calibration data", "", "Calibration files (*.cal *.calbin)", nullptr, Preferences::QFileDialogOptions());
         if(filename.isEmpty()) {
             // aborted selection
             return false;
@@ -1544,6 +1673,22 @@ bool Calibration::fromFile(QString filename)
         qDebug() << "Parsing of calibration kit failed while opening calibration file: " << e.what() << " (ignore for calibration format >= 3)";
     }
 
+    if(BinaryContainer::isBinary(filename)) {
+        try {
+            BinaryContainer container;
+            container.open(filename);
+            currentCalFile = filename;    // if all ok, remember this
+            fromJSON(container.unpack(container.getDocument()), &container);
+        } catch(exception &e) {
+            currentCalFile.clear();
+            InformationBox::ShowError("File parsing error", e.what());
+            qWarning() << "Calibration file parsing failed: " << e.what();
+            return false;
+        }
+        unsavedChanges = false;
+        return true;
+    }
+
     ifstream file;
 
     file.open(filename.toStdString());
@@ -1696,25 +1841,43 @@ bool Calibration::compute(Calibration::CalType type)
     }
     caltype = type;
     try {
+        auto used = findUsedMeasurements();
         points.clear();
-        for(int i=0;i<numPoints;i++) {
-            double f = start + (stop - start) * i / (numPoints - 1);
-            Point p;
-            switch(type.type) {
-            case Type::SOLT: p = computeSOLT(f); break;
-            case Type::ThroughNormalization: p = computeThroughNormalization(f); break;
-            case Type::TRL: p = computeTRL(f); break;
-            case Type::None:
-            case Type::Last:
-                // nothing to do, should never get here
-                break;
-            }
-            points.push_back(p);
+        points.resize(numPoints);
+        // the points are independent of each other, compute them in parallel
+        exception_ptr error;
+        mutex errorMutex;
+        Util::parallelFor(numPoints, minimumChunk, [&](unsigned int begin, unsigned int end) {
+            try {
+                for(unsigned int i=begin;i<end;i++) {
+                    double f = start + (stop - start) * i / (numPoints - 1);
+                    Point p;
+                    switch(type.type) {
+                    case Type::SOLT: p = computeSOLT(f, used); break;
+                    case Type::ThroughNormalization: p = computeThroughNormalization(f, used); break;
+                    case Type::TRL: p = computeTRL(f, used); break;
+                    case Type::None:
+                    case Type::Last:
+                        // nothing to do, should never get here
+                        break;
+                    }
+                    points[i] = std::move(p);
+                }
+            } catch (...) {
+                lock_guard<mutex> lock(errorMutex);
+                if(!error) {
+                    error = current_exception();
+                }
+            }
+        });
+        if(error) {
+            rethrow_exception(error);
         }
     } catch (exception &e) {
         points.clear();
         caltype.usedPorts.clear();
     }
+    updateKernel();
     emit activated(caltype);
     unsavedChanges = true;
     return true;
@@ -1774,6 +1937,7 @@ void Calibration::deactivate()
     points.clear();
     caltype.type = Type::None;
     caltype.usedPorts.clear();
+    updateKernel();
     unsavedChanges = true;
     emit deactivated();
 }
@@ -1967,43 +2131,3 @@ Calibration::CalType Calibration::CalType::fromShortString(QString s)
     }
     return ret;
 }
-
-Calibration::Point Calibration::Point::interpolate(const Calibration::Point &to, double alpha)
-{
-    Point ret;
-    ret.frequency = frequency * (1.0-alpha) + to.frequency * alpha;
-    ret.D.resize(D.size(), 0.0);
-    for(unsigned int i=0;i<D.size();i++) {
-        ret.D[i] = D[i] * (1.0-alpha) + to.D[i] * alpha;
-    }
-    ret.R.resize(R.size(), 0.0);
-    for(unsigned int i=0;i<R.size();i++) {
-        ret.R[i] = R[i] * (1.0-alpha) + to.R[i] * alpha;
-    }
-    ret.S.resize(S.size(), 0.0);
-    for(unsigned int i=0;i<S.size();i++) {
-        ret.S[i] = S[i] * (1.0-alpha) + to.S[i] * alpha;
-    }
-    ret.T.resize(T.size());
-    for(unsigned int i=0;i<T.size();i++) {
-        ret.T[i].resize(T[i].size(), 0.0);
-        for(unsigned int j=0;j<T[i].size();j++) {
-            ret.T[i][j] = T[i][j] * (1.0 - alpha) + to.T[i][j] * alpha;
-        }
-    }
-    ret.L.resize(L.size());
-    for(unsigned int i=0;i<L.size();i++) {
-        ret.L[i].resize(L[i].size(), 0.0);
-        for(unsigned int j=0;j<L[i].size();j++) {
-            ret.L[i][j] = L[i][j] * (1.0 - alpha) + to.L[i][j] * alpha;
-        }
-    }
-    ret.I.resize(I.size());
-    for(unsigned int i=0;i<I.size();i++) {
-        ret.I[i].resize(I[i].size(), 0.0);
-        for(unsigned int j=0;j<I[i].size();j++) {
-            ret.I[i][j] = I[i][j] * (1.0 - alpha) + to.I[i][j] * alpha;
-        }
-    }
-    return ret;
-}
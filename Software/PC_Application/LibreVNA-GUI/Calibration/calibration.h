@@ -4,8 +4,10 @@
 #include "savable.h"
 #include "calibrationmeasurement.h"
 #include "calkit.h"
+#include "calibrationkernel.h"
 #include "Traces/trace.h"
 #include "scpi.h"
+#include "binarycontainer.h"
 
 #include <mutex>
 
@@ -41,6 +43,8 @@ public:
 
     // Applies calculated calibration coefficients to measurement data
     void correctMeasurement(DeviceDriver::VNAMeasurement &d);
+    // Applies the calibration to a block of measurements, larger blocks are corrected in parallel
+    void correctMeasurements(std::vector<DeviceDriver::VNAMeasurement> &block);
     void correctTraces(std::map<QString, Trace*> traceSet);
 
     // Starts the calibration edit dialog, allowing the user to make/delete measurements
@@ -146,20 +150,60 @@ private:
         std::vector<std::vector<std::complex<double>>> L; // Receiver Match
         std::vector<std::vector<std::complex<double>>> T; // Transmission tracking
         std::vector<std::vector<std::complex<double>>> I; // Transmission isolation
-        Point interpolate(const Point &to, double alpha);
     };
     std::vector<Point> points;
+    // Error terms of all points, prepared for correcting measurements. Has to be updated whenever points change
+    CalibrationKernel kernel;
+    void updateKernel();
+
+    // Measurements required for computing the coefficients, looked up once instead of for every point
+    class UsedMeasurements {
+    public:
+        class Port {
+        public:
+            CalibrationMeasurement::Short *_short;
+            CalibrationMeasurement::Open *open;
+            CalibrationMeasurement::Load *load;
+            // only filled if there are enough measurements to use the sliding load instead of the load
+            std::vector<CalibrationMeasurement::SlidingLoad*> slidingLoads;
+            CalibrationMeasurement::Reflect *reflect;
+            bool reflectIsShort;
+        };
+        // measurements between two ports
+        class Path {
+        public:
+            CalibrationMeasurement::Through *through;
+            // through was measured from the second to the first port
+            bool throughReversed;
+            std::vector<CalibrationMeasurement::Line*> lines;
+            std::vector<bool> linesReversed;
+        };
+        // indices match caltype.usedPorts
+        std::vector<Port> ports;
+        // paths[i][j] contains the measurements from usedPorts[i] to usedPorts[j]
+        std::vector<std::vector<Path>> paths;
+        CalibrationMeasurement::Isolation *isolation;
+    };
+    // throws if the measurements can not be used for the current caltype
+    UsedMeasurements findUsedMeasurements();
 
     Point createInitializedPoint(double f);
-    Point computeSOLT(double f);
-    Point computeThroughNormalization(double f);
-    Point computeTRL(double f);
+    Point computeSOLT(double f, const UsedMeasurements &m);
+    Point computeThroughNormalization(double f, const UsedMeasurements &m);
+    Point computeTRL(double f, const UsedMeasurements &m);
 
     std::vector<CalibrationMeasurement::Base*> measurements;
 
     Calkit kit;
     CalType caltype;
 
+    // loads the calibration, uses the stored coefficients instead of computing them if a binary container is given
+    void fromJSON(nlohmann::json j, const BinaryContainer *container);
+    // adds the calculated coefficients to the container, returns the references to the arrays
+    nlohmann::json coefficientsToBinary(BinaryContainer &container);
+    // activates the calibration with coefficients stored by coefficientsToBinary(). Returns false if the coefficients are missing or do not match the measurements
+    bool coefficientsFromBinary(CalType type, const nlohmann::json &coefficients, const BinaryContainer &container);
+
     QString descriptiveCalName();
     QString currentCalFile;
 
@@ -0,0 +1,274 @@
+#include "calibrationkernel.h"
+
+#include "Util/util.h"
+#include "Eigen/Dense"
+
+#include <algorithm>
+#include <limits>
+
+#include <QDebug>
+
+using namespace std;
+
+// Resolved interpolation is cached for sweeps up to this number of points
+static constexpr unsigned int maxCachedPoints = 1 << 20;
+// Blocks are only split across threads if every thread gets at least this number of points
+static constexpr unsigned int minimumChunk = 256;
+
+CalibrationKernel::CalibrationKernel()
+    : numPorts(0)
+{
+
+}
+
+void CalibrationKernel::reset(const std::vector<unsigned int> &usedPorts, unsigned int numPoints)
+{
+    this->usedPorts = usedPorts;
+    numPorts = usedPorts.size();
+    frequencies.assign(numPoints, 0.0);
+    D.assign(numPoints * numPorts, 0.0);
+    R.assign(numPoints * numPorts, 0.0);
+    S.assign(numPoints * numPorts, 0.0);
+    L.assign(numPoints * numPorts * numPorts, 0.0);
+    T.assign(numPoints * numPorts * numPorts, 0.0);
+    I.assign(numPoints * numPorts * numPorts, 0.0);
+    sweep.clear();
+}
+
+void CalibrationKernel::setPoint(unsigned int index, double frequency, const std::vector<cd> &D, const std::vector<cd> &R, const std::vector<cd> &S,
+                                 const std::vector<std::vector<cd>> &L, const std::vector<std::vector<cd>> &T, const std::vector<std::vector<cd>> &I)
+{
+    frequencies[index] = frequency;
+    for(unsigned int i=0;i<numPorts;i++) {
+        this->D[index*numPorts+i] = D[i];
+        this->R[index*numPorts+i] = R[i];
+        this->S[index*numPorts+i] = S[i];
+        for(unsigned int j=0;j<numPorts;j++) {
+            this->L[(index*numPorts+i)*numPorts+j] = L[i][j];
+            this->T[(index*numPorts+i)*numPorts+j] = T[i][j];
+            this->I[(index*numPorts+i)*numPorts+j] = I[i][j];
+        }
+    }
+    sweep.clear();
+}
+
+void CalibrationKernel::correct(DeviceDriver::VNAMeasurement &d)
+{
+    if(frequencies.empty()) {
+        return;
+    }
+    correctPoint(d, resolve(d));
+}
+
+void CalibrationKernel::correct(std::vector<DeviceDriver::VNAMeasurement> &block)
+{
+    if(frequencies.empty() || block.empty()) {
+        return;
+    }
+    // resolving uses the sweep cache and has to happen in this thread
+    vector<Resolved> resolved;
+    resolved.reserve(block.size());
+    for(auto &d : block) {
+        resolved.push_back(resolve(d));
+    }
+    Util::parallelFor(block.size(), minimumChunk, [&](unsigned int begin, unsigned int end) {
+        for(unsigned int i=begin;i<end;i++) {
+            correctPoint(block[i], resolved[i]);
+        }
+    });
+}
+
+void CalibrationKernel::correctSweep(const double *frequencies, unsigned int points, const std::vector<cd *> &parameters)
+{
+    if(this->frequencies.empty() || points == 0 || parameters.size() != numPorts * numPorts) {
+        return;
+    }
+    Util::parallelFor(points, minimumChunk, [&](unsigned int begin, unsigned int end) {
+        switch(numPorts) {
+        case 1: correctRange<1>(frequencies, parameters, begin, end); break;
+        case 2: correctRange<2>(frequencies, parameters, begin, end); break;
+        case 3: correctRange<3>(frequencies, parameters, begin, end); break;
+        case 4: correctRange<4>(frequencies, parameters, begin, end); break;
+        default: correctRange<Eigen::Dynamic>(frequencies, parameters, begin, end); break;
+        }
+    });
+}
+
+CalibrationKernel::Resolved CalibrationKernel::resolve(const DeviceDriver::VNAMeasurement &d)
+{
+    if(d.pointNum < sweep.size() && sweep[d.pointNum].frequency == d.frequency) {
+        // already resolved for this sweep
+        return sweep[d.pointNum];
+    }
+    auto r = resolve(d.frequency);
+    if(d.pointNum < maxCachedPoints) {
+        if(d.pointNum >= sweep.size()) {
+            sweep.resize(d.pointNum + 1, {numeric_limits<double>::quiet_NaN(), 0, 0.0});
+        }
+        sweep[d.pointNum] = r;
+    }
+    return r;
+}
+
+CalibrationKernel::Resolved CalibrationKernel::resolve(double frequency) const
+{
+    Resolved r;
+    r.frequency = frequency;
+    r.alpha = 0.0;
+    if(frequency <= frequencies.front()) {
+        r.index = 0;
+    } else if(frequency >= frequencies.back()) {
+        r.index = frequencies.size() - 1;
+    } else {
+        // needs to interpolate
+        auto upper = lower_bound(frequencies.begin(), frequencies.end(), frequency);
+        r.index = upper - frequencies.begin() - 1;
+        r.alpha = (frequency - frequencies[r.index]) / (frequencies[r.index + 1] - frequencies[r.index]);
+    }
+    return r;
+}
+
+void CalibrationKernel::correctPoint(DeviceDriver::VNAMeasurement &d, const Resolved &r) const
+{
+    switch(numPorts) {
+    case 1: correctFixed<1>(d, r); break;
+    case 2: correctFixed<2>(d, r); break;
+    case 3: correctFixed<3>(d, r); break;
+    case 4: correctFixed<4>(d, r); break;
+    default: correctFixed<Eigen::Dynamic>(d, r); break;
+    }
+}
+
+template<int N>
+void CalibrationKernel::interpolate(const Resolved &r, Terms<N> &t, unsigned int n) const
+{
+    auto lo = r.index;
+    // the upper point is only valid if the point actually needs to be interpolated
+    auto hi = r.alpha > 0.0 ? lo + 1 : lo;
+    const double a = r.alpha;
+    for(unsigned int i=0;i<n;i++) {
+        t.D[i] = D[lo*n+i] * (1.0 - a) + D[hi*n+i] * a;
+        t.R[i] = R[lo*n+i] * (1.0 - a) + R[hi*n+i] * a;
+        t.S[i] = S[lo*n+i] * (1.0 - a) + S[hi*n+i] * a;
+    }
+    for(unsigned int k=0;k<n*n;k++) {
+        t.L[k] = L[lo*n*n+k] * (1.0 - a) + L[hi*n*n+k] * a;
+        t.T[k] = T[lo*n*n+k] * (1.0 - a) + T[hi*n*n+k] * a;
+        t.I[k] = I[lo*n*n+k] * (1.0 - a) + I[hi*n*n+k] * a;
+    }
+}
+
+// storage size of the matrices and error terms, runtime sized matrices use the largest supported port count and still don't allocate
+template<int N> static constexpr int storageSize() {
+    return N == Eigen::Dynamic ? MeasurementLayout::maxPorts : N;
+}
+template<int N> using SMatrix = Eigen::Matrix<complex<double>, N, N, 0, storageSize<N>(), storageSize<N>()>;
+
+template<int N, class Matrix>
+void CalibrationKernel::applyTerms(const Terms<N> &p, Matrix &S, unsigned int n) const
+{
+    // formulas from "Multi-Port Calibration Techniques for Differential Parameter Measurements with Network Analyzers", variable names also losely follow this document
+    Matrix a(n, n), b(n, n);
+
+    // assemble a (L) and b (K) matrices
+    for(unsigned int i=0;i<n;i++) {
+        for(unsigned int j=0;j<n;j++) {
+            if(i == j) {
+                // calculate incident and reflected wave at the exciting port
+                a(j,i) = 1.0 + p.S[i]/p.R[i]*(S(j,i) - p.D[i]*1.0);
+                b(j,i) = (1.0 / p.R[i]) * (S(j,i) - p.D[i]*1.0);
+            } else {
+                // calculate incident and reflected wave at the receiving port
+                a(j,i) = p.L[i*n+j]*S(j,i) / p.T[i*n+j];
+                b(j,i) = S(j,i) / p.T[i*n+j];
+            }
+        }
+    }
+    S = b * a.inverse();
+}
+
+template<int N>
+void CalibrationKernel::correctFixed(DeviceDriver::VNAMeasurement &d, const Resolved &r) const
+{
+    constexpr int C = storageSize<N>();
+    // known at compile time for the fixed-size variants
+    const unsigned int n = N == Eigen::Dynamic ? numPorts : N;
+
+    Terms<C> p;
+    interpolate<C>(r, p, n);
+
+    SMatrix<N> S(n, n);
+    int index[C*C];
+
+    // Grab measurements (easier to access by index later)
+    for(unsigned int i=0;i<n;i++) {
+        for(unsigned int j=0;j<n;j++) {
+            auto pSrc = usedPorts[i];
+            auto pRcv = usedPorts[j];
+            index[i*n+j] = d.measurements.indexS(pRcv, pSrc);
+            if(index[i*n+j] < 0) {
+                qWarning() << "Missing measurement for calibration:" << "S"+QString::number(pRcv)+QString::number(pSrc);
+                S(j,i) = 0.0;
+            } else {
+                // grab measurement and remove isolation here
+                S(j,i) = d.measurements.value(index[i*n+j]);
+                if(j != i) {
+                    S(j,i) -= p.I[i*n+j];
+                }
+            }
+        }
+    }
+
+    applyTerms<C>(p, S, n);
+
+    // extract measurement from matrix and store back into VNAMeasurement
+    for(unsigned int i=0;i<n;i++) {
+        for(unsigned int j=0;j<n;j++) {
+            if(index[i*n+j] >= 0) {
+                d.measurements.value(index[i*n+j]) = S(j,i);
+            } else {
+                addMissing(d, usedPorts[j], usedPorts[i], S(j,i));
+            }
+        }
+    }
+}
+
+template<int N>
+void CalibrationKernel::correctRange(const double *frequencies, const std::vector<cd *> &parameters, unsigned int begin, unsigned int end) const
+{
+    constexpr int C = storageSize<N>();
+    const unsigned int n = N == Eigen::Dynamic ? numPorts : N;
+
+    Terms<C> p;
+    SMatrix<N> S(n, n);
+    for(unsigned int k=begin;k<end;k++) {
+        interpolate<C>(resolve(frequencies[k]), p, n);
+        for(unsigned int i=0;i<n;i++) {
+            for(unsigned int j=0;j<n;j++) {
+                auto values = parameters[i*n+j];
+                if(!values) {
+                    S(j,i) = 0.0;
+                } else {
+                    S(j,i) = values[k];
+                    if(j != i) {
+                        S(j,i) -= p.I[i*n+j];
+                    }
+                }
+            }
+        }
+        applyTerms<C>(p, S, n);
+        for(unsigned int i=0;i<n;i++) {
+            for(unsigned int j=0;j<n;j++) {
+                if(parameters[i*n+j]) {
+                    parameters[i*n+j][k] = S(j,i);
+                }
+            }
+        }
+    }
+}
+
+void CalibrationKernel::addMissing(DeviceDriver::VNAMeasurement &d, unsigned int rcv, unsigned int src, cd value)
+{
+    // switches the measurement to a new layout, indices of the existing parameters are not changed by this
+    d.measurements["S"+QString::number(rcv)+QString::number(src)] = value;
+}
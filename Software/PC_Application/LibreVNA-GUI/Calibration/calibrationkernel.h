@@ -0,0 +1,92 @@
+#ifndef CALIBRATIONKERNEL_H
+#define CALIBRATIONKERNEL_H
+
+#include "Device/devicedriver.h"
+
+#include <complex>
+#include <vector>
+
+/**
+ * @brief Applies the calculated error terms of a calibration to measurement points
+ *
+ * The error terms of all calibration points are stored in flat arrays (one array per error term type) which are
+ * filled once after the calibration has been computed. Interpolation indices and weights for the points of a sweep
+ * are resolved on the first use of each point and reused as long as the sweep does not change.
+ *
+ * The correction is done with fixed-size matrices for up to four ports, correcting a point does not allocate memory
+ * unless the measurement is missing some of the corrected parameters. Blocks of measurements and whole sweeps are
+ * split into frequency ranges which are corrected in parallel.
+ *
+ * This class is not thread-safe, the Calibration serializes the access.
+ */
+class CalibrationKernel
+{
+public:
+    using cd = std::complex<double>;
+
+    CalibrationKernel();
+
+    // Removes all error terms and selects the ports that are corrected. Port count starts at 1
+    void reset(const std::vector<unsigned int> &usedPorts, unsigned int numPoints);
+    // Stores the error terms of a calibration point. Points have to be added in ascending frequency order.
+    // The one-dimensional terms are indexed by port, the two-dimensional ones by [source][receiver]. Ports are indexed
+    // by their position in usedPorts
+    void setPoint(unsigned int index, double frequency, const std::vector<cd> &D, const std::vector<cd> &R, const std::vector<cd> &S,
+                  const std::vector<std::vector<cd>> &L, const std::vector<std::vector<cd>> &T, const std::vector<std::vector<cd>> &I);
+
+    bool isEmpty() const {return frequencies.empty();}
+
+    // Corrects the S parameters of the measurement in place
+    void correct(DeviceDriver::VNAMeasurement &d);
+    // Corrects the S parameters of all measurements in place
+    void correct(std::vector<DeviceDriver::VNAMeasurement> &block);
+    // Corrects a sweep stored as one array per S parameter. parameters[src*ports+rcv] contains the values of the S parameter from
+    // the src-th to the rcv-th used port (e.g. for used ports {1,2}: S11, S21, S12, S22), each array holds one value per frequency.
+    // Parameters which are not available may be nullptr, they are assumed to be zero and not written back
+    void correctSweep(const double *frequencies, unsigned int points, const std::vector<cd*> &parameters);
+
+private:
+    // index of the lower calibration point and weight of the upper calibration point for one sweep point
+    class Resolved {
+    public:
+        double frequency;
+        unsigned int index;
+        double alpha;
+    };
+    // uses the cached interpolation of the sweep if possible
+    Resolved resolve(const DeviceDriver::VNAMeasurement &d);
+    Resolved resolve(double frequency) const;
+
+    // Interpolated error terms for one measurement point, 1D terms at [port], 2D terms at [src*N+rcv]
+    template<int N> class Terms {
+    public:
+        cd D[N], R[N], S[N];
+        cd L[N*N], T[N*N], I[N*N];
+    };
+    template<int N> void interpolate(const Resolved &r, Terms<N> &t, unsigned int n) const;
+    // Template parameter N is the matrix size (1-4) or Eigen::Dynamic for larger port counts
+    void correctPoint(DeviceDriver::VNAMeasurement &d, const Resolved &r) const;
+    template<int N> void correctFixed(DeviceDriver::VNAMeasurement &d, const Resolved &r) const;
+    template<int N> void correctRange(const double *frequencies, const std::vector<cd*> &parameters, unsigned int begin, unsigned int end) const;
+    // removes the error terms from the measured matrix (isolation has to be removed already)
+    template<int N, class Matrix> void applyTerms(const Terms<N> &p, Matrix &S, unsigned int n) const;
+    // writes a corrected parameter which is not included in the measurement yet
+    static void addMissing(DeviceDriver::VNAMeasurement &d, unsigned int rcv, unsigned int src, cd value);
+
+    std::vector<unsigned int> usedPorts;
+    unsigned int numPorts;
+
+    std::vector<double> frequencies;
+    // Error terms, 1D terms at [point*numPorts+port], 2D terms at [(point*numPorts+src)*numPorts+rcv]
+    std::vector<cd> D; // Directivity
+    std::vector<cd> R; // Reflection tracking
+    std::vector<cd> S; // Source Match
+    std::vector<cd> L; // Receiver Match
+    std::vector<cd> T; // Transmission tracking
+    std::vector<cd> I; // Transmission isolation
+
+    // interpolation of the last seen sweep, indexed by pointNum
+    std::vector<Resolved> sweep;
+};
+
+#endif // CALIBRATIONKERNEL_H
@@ -268,11 +268,11 @@ void CalibrationMeasurement::OnePort::clearPoints()
 
 void CalibrationMeasurement::OnePort::addPoint(const DeviceDriver::VNAMeasurement &m)
 {
-    QString measurementName = "S"+QString::number(port)+QString::number(port);
-    if(m.measurements.count(measurementName) > 0) {
+    auto index = m.measurements.indexS(port, port);
+    if(index >= 0) {
         Point p;
         p.frequency = m.frequency;
-        p.S = m.measurements.at(measurementName);
+        p.S = m.measurements.value(index);
         points.push_back(p);
         timestamp = QDateTime::currentDateTimeUtc();
     }
@@ -624,17 +624,20 @@ void CalibrationMeasurement::Isolation::addPoint(const DeviceDriver::VNAMeasurem
 {
     Point p;
     p.frequency = m.frequency;
-    for(auto &meas : m.measurements) {
-        QString name = meas.first;
-        unsigned int rcv = name.mid(1, 1).toInt() - 1;
-        unsigned int src = name.mid(2, 1).toInt() - 1;
+    for(unsigned int i=0;i<m.measurements.size();i++) {
+        if(!m.measurements.getLayout()->sourcePort(i)) {
+            // not an S parameter
+            continue;
+        }
+        unsigned int rcv = m.measurements.getLayout()->receivingPort(i) - 1;
+        unsigned int src = m.measurements.getLayout()->sourcePort(i) - 1;
         if(rcv >= p.S.size()) {
             p.S.resize(rcv + 1);
         }
         if(src >= p.S[rcv].size()) {
             p.S[rcv].resize(src + 1);
         }
-        p.S[rcv][src] = meas.second;
+        p.S[rcv][src] = m.measurements.value(i);
     }
     points.push_back(p);
     timestamp = QDateTime::currentDateTimeUtc();
@@ -704,15 +707,23 @@ std::complex<double> CalibrationMeasurement::Isolation::getMeasured(double frequ
     }
     portRcv--;
     portSrc--;
-    // find correct point, interpolate
-    Point interp = Util::interpolate<Point, double>(points, frequency, [](const Point &p)->double{
-        return p.frequency;
+    auto element = [=](const Point &p) -> complex<double> {
+        if(portRcv >= p.S.size() || portSrc >= p.S[portRcv].size()) {
+            return numeric_limits<complex<double>>::quiet_NaN();
+        } else {
+            return p.S[portRcv][portSrc];
+        }
+    };
+    // find correct point, only interpolate the requested element instead of the whole matrix
+    auto high = lower_bound(points.begin(), points.end(), frequency, [](const Point &p, double f)->bool{
+        return p.frequency < f;
     });
-    if(portRcv >= interp.S.size() || portSrc >= interp.S[portRcv].size()) {
-        return numeric_limits<complex<double>>::quiet_NaN();
-    } else {
-        return interp.S[portRcv][portSrc];
+    if(high == points.begin()) {
+        return element(*high);
     }
+    auto low = prev(high);
+    double alpha = (frequency - low->frequency) / (high->frequency - low->frequency);
+    return element(*low) * (1.0 - alpha) + element(*high) * alpha;
 }
 
 std::vector<CalibrationMeasurement::Isolation::Point> CalibrationMeasurement::Isolation::getPoints() const
@@ -9,10 +9,13 @@
 #include "Device/LibreVNA/devicepacketlogview.h"
 
 #include <exception>
+#include <algorithm>
 
 CompoundDriver::CompoundDriver()
 {
     connected = false;
+    VNALayoutRaw = false;
+    VNALayoutPreservePhase = false;
 
     drivers.push_back(new LibreVNAUSBDriver);
     drivers.push_back(new LibreVNATCPDriver);
@@ -154,8 +157,8 @@ void CompoundDriver::disconnect()
     devices.clear();
     deviceInfos.clear();
     deviceStatus.clear();
-    compoundSABuffer.clear();
-    compoundVNABuffer.clear();
+    compoundSABuffer.reset(0, 0);
+    compoundVNABuffer.reset(0, 0);
     connected = false;
 }
 
@@ -300,9 +303,12 @@ bool CompoundDriver::setVNA(const DeviceDriver::VNASettings &s, std::function<vo
     for(unsigned int i=0;i<s.excitedPorts.size();i++) {
         portStageMapping[s.excitedPorts[i]] = i;
     }
+    // measurement layout depends on the excited ports, needs to be recreated
+    VNALayout = nullptr;
 
     zerospan = (s.freqStart == s.freqStop) && (s.dBmStart == s.dBmStop);
     VNApoints = s.points;
+    compoundVNABuffer.reset(devices.size(), VNApoints);
     // create vector of currently used stimulus ports
     std::vector<CompoundDevice::PortMapping> activeMapping;
     for(auto p : s.excitedPorts) {
@@ -384,6 +390,7 @@ bool CompoundDriver::setSA(const DeviceDriver::SASettings &s, std::function<void
             break;
         }
     }
+    compoundSABuffer.reset(devices.size(), SApoints);
     return success;
 }
 
@@ -606,12 +613,7 @@ void CompoundDriver::updatedStatus(LibreVNADriver *device, const Protocol::Devic
 
 void CompoundDriver::spectrumResultReceived(LibreVNADriver *dev, Protocol::SpectrumAnalyzerResult res)
 {
-    if(!compoundSABuffer.count(res.pointNum)) {
-        compoundSABuffer[res.pointNum] = std::map<LibreVNADriver*, Protocol::SpectrumAnalyzerResult>();
-    }
-    auto &buf = compoundSABuffer[res.pointNum];
-    buf[dev] = res;
-    if(buf.size() == devices.size()) {
+    if(compoundSABuffer.add(deviceIndex(dev), res.pointNum, res) == CompoundMergeBuffer<Protocol::SpectrumAnalyzerResult>::Result::Complete) {
         // Got datapoints from all devices, can create merged VNA result
         SAMeasurement m;
         m.pointNum = res.pointNum;
@@ -622,40 +624,25 @@ void CompoundDriver::spectrumResultReceived(LibreVNADriver *dev, Protocol::Spect
         }
         // assemble data
         for(unsigned int port=0;port<activeDevice.portMapping.size();port++) {
-            auto device = devices[activeDevice.portMapping[port].device];
+            auto &result = compoundSABuffer.get(activeDevice.portMapping[port].device);
             auto devicePort = activeDevice.portMapping[port].port;
 
             QString name = "PORT"+QString::number(port+1);
             if(devicePort == 0) {
-                m.measurements[name] = buf[device].port1;
+                m.measurements[name] = result.port1;
             } else {
-                m.measurements[name] = buf[device].port2;
+                m.measurements[name] = result.port2;
             }
         }
 
         emit SAmeasurementReceived(m);
-
-        // Clear this and all (incomplete) older datapoint buffers
-        auto it = compoundSABuffer.begin();
-        while(it != compoundSABuffer.end()) {
-            if(it->first <= res.pointNum) {
-                it = compoundSABuffer.erase(it);
-            } else {
-                it++;
-            }
-        }
     }
 }
 
 void CompoundDriver::datapointReceivecd(LibreVNADriver *dev, Protocol::VNADatapoint<32> *data)
 {
-    if(!compoundVNABuffer.count(data->pointNum)) {
-        compoundVNABuffer[data->pointNum] = std::map<LibreVNADriver*, Protocol::VNADatapoint<32>*>();
-    }
-    auto &buf = compoundVNABuffer[data->pointNum];
-    // create copy of datapoint as it will be deleted by the device driver
-    buf[dev] = new Protocol::VNADatapoint<32>(*data);
-    if(buf.size() == devices.size()) {
+    // the datapoint is copied into the buffer, it will be returned to the pool by the device driver
+    if(compoundVNABuffer.add(deviceIndex(dev), data->pointNum, *data) == CompoundMergeBuffer<Protocol::VNADatapoint<32>>::Result::Complete) {
         // Got datapoints from all devices, can create merged VNA result
         VNAMeasurement m;
         m.pointNum = data->pointNum;
@@ -667,62 +654,83 @@ void CompoundDriver::datapointReceivecd(LibreVNADriver *dev, Protocol::VNADatapo
             m.dBm = (double) data->cdBm / 100;
         }
         // assemble data
-        for(auto map : portStageMapping) {
-            // map.first is the port (starts at one)
-            // map.second is the stage at which this port had the stimulus (starts at zero)
-
-            // figure out which device had the stimulus for the port...
-            auto stimulusDev = devices[activeDevice.portMapping[map.first-1].device];
-            // ...and which device port was used for the stimulus...
-            auto stimulusDevPort = activeDevice.portMapping[map.first-1].port;
-            // ...grab the reference receiver data
-            std::complex<double> ref = buf[stimulusDev]->getValue(map.second, stimulusDevPort, true);
-
-            // for all ports of the compound device...
-            for(unsigned int i=0;i<activeDevice.portMapping.size();i++) {
-                // ...figure out which physical device and port was used for this input...
-                auto inputDevice = devices[activeDevice.portMapping[i].device];
-                // ...and grab the data
-                auto inputPort = activeDevice.portMapping[i].port;
-                std::complex<double> input = buf[inputDevice]->getValue(map.second, inputPort, false);
-                if(!std::isnan(ref.real()) && !std::isnan(input.real())) {
-                    // got both required measurements
-                    QString name = "S"+QString::number(i+1)+QString::number(map.first);
-                    auto S = input / ref;
-                    if(!preservePhase && (inputDevice != stimulusDev)) {
-                        // can't use phase information when measuring across devices
-                        S = abs(S);
-                    }
-                    m.measurements[name] = S;
-                }
+        updateVNALayout();
+        m.measurements.setLayout(VNALayout);
+        // the datapoints of the devices are the sources of the decoder (see updateVNALayout())
+        VNADecoderSources.resize(devices.size());
+        for(unsigned int i=0;i<devices.size();i++) {
+            VNADecoderSources[i] = &compoundVNABuffer.get(i);
+        }
+        if(!VNADecoder.decode(VNADecoderSources.data(), m.measurements.data())) {
+            // not all required measurements are included in this datapoint, remove the missing S parameters
+            LibreVNADriver::removeIncompleteMeasurements(m);
+        }
 
-                if(captureRawReceiverValues) {
-                    QString name = "RawPort"+QString::number(inputPort+1)+"Stage"+QString::number(map.second);
-                    m.measurements[name] = input;
-                    name = "RawPort"+QString::number(inputPort+1)+"Stage"+QString::number(map.second)+"Ref";
-                    m.measurements[name] = buf[inputDevice]->getValue(map.second, inputPort, true);
-                }
-            }
+        // The devices pass on their datapoints in blocks. Collect all merged measurements and emit them together
+        // once the event loop is reached again
+        if(mergedVNAMeasurements.empty()) {
+            QMetaObject::invokeMethod(this, [=](){
+                auto block = std::move(mergedVNAMeasurements);
+                mergedVNAMeasurements.clear();
+                emit VNAmeasurementsReceived(block);
+            }, Qt::QueuedConnection);
         }
+        mergedVNAMeasurements.push_back(m);
+    }
+}
 
-        emit VNAmeasurementReceived(m);
+unsigned int CompoundDriver::deviceIndex(LibreVNADriver *device)
+{
+    return std::find(devices.begin(), devices.end(), device) - devices.begin();
+}
 
-        // Clear this and all (incomplete) older datapoint buffers
-        int pointNum = data->pointNum;
-        while(compoundVNABuffer.count(pointNum)) {
-            auto &buf = compoundVNABuffer[pointNum];
-            for(auto d : buf) {
-                delete d.second;
-            }
-            compoundVNABuffer.erase(pointNum);
-            // move on to previous point
-            if(pointNum > 0) {
-                pointNum--;
-            } else {
-                pointNum = VNApoints - 1;
+void CompoundDriver::updateVNALayout()
+{
+    if(VNALayout && VNALayoutRaw == captureRawReceiverValues && VNALayoutPreservePhase == preservePhase) {
+        // still up to date
+        return;
+    }
+    // Create one slot for every value that the decoder extracts. Raw receiver values are named after the physical
+    // port, so several entries may end up in the same slot (the last one wins)
+    QStringList names;
+    auto slot = [&](QString name) -> unsigned int {
+        auto index = names.indexOf(name);
+        if(index < 0) {
+            index = names.size();
+            names.append(name);
+        }
+        return index;
+    };
+    VNADecoder.clear();
+    for(auto map : portStageMapping) {
+        // map.first is the port (starts at one)
+        // map.second is the stage at which this port had the stimulus (starts at zero)
+
+        // figure out which device had the stimulus for the port...
+        auto stimulusDev = activeDevice.portMapping[map.first-1].device;
+        // ...and which device port was used for the stimulus
+        auto stimulusDevPort = activeDevice.portMapping[map.first-1].port;
+
+        // for all ports of the compound device...
+        for(unsigned int i=0;i<activeDevice.portMapping.size();i++) {
+            // ...figure out which physical device and port was used for this input
+            auto inputDevice = activeDevice.portMapping[i].device;
+            auto inputPort = activeDevice.portMapping[i].port;
+            // can't use phase information when measuring across devices
+            bool magnitudeOnly = !preservePhase && (inputDevice != stimulusDev);
+            VNADecoder.addRatio(slot("S"+QString::number(i+1)+QString::number(map.first)), inputDevice, map.second, inputPort,
+                                stimulusDev, map.second, stimulusDevPort, magnitudeOnly);
+            if(captureRawReceiverValues) {
+                VNADecoder.addValue(slot("RawPort"+QString::number(inputPort+1)+"Stage"+QString::number(map.second)),
+                                    inputDevice, map.second, inputPort, false);
+                VNADecoder.addValue(slot("RawPort"+QString::number(inputPort+1)+"Stage"+QString::number(map.second)+"Ref"),
+                                    inputDevice, map.second, inputPort, true);
             }
         }
     }
+    VNALayout = MeasurementLayout::get(names);
+    VNALayoutRaw = captureRawReceiverValues;
+    VNALayoutPreservePhase = preservePhase;
 }
 
 void CompoundDriver::checkIfAllTransmissionsComplete(std::function<void (bool)> cb)
@@ -3,6 +3,7 @@
 
 #include "../../devicedriver.h"
 #include "compounddevice.h"
+#include "compoundmergebuffer.h"
 
 class CompoundDriver : public DeviceDriver
 {
@@ -177,12 +178,19 @@ private:
     void updatedStatus(LibreVNADriver *device, const Protocol::DeviceStatus &status);
     void datapointReceivecd(LibreVNADriver *dev, Protocol::VNADatapoint<32> *data);
     void spectrumResultReceived(LibreVNADriver *dev, Protocol::SpectrumAnalyzerResult res);
+    // (Re-)creates the measurement layout for the configured sweep if required
+    void updateVNALayout();
+    // Returns the position of a device in devices
+    unsigned int deviceIndex(LibreVNADriver *device);
 
     Info info;
     std::map<LibreVNADriver*, Info> deviceInfos;
     std::map<LibreVNADriver*, Protocol::DeviceStatus> deviceStatus;
-    std::map<int, std::map<LibreVNADriver*, Protocol::VNADatapoint<32>*>> compoundVNABuffer;
-    std::map<int, std::map<LibreVNADriver*, Protocol::SpectrumAnalyzerResult>> compoundSABuffer;
+    // Datapoints of the individual devices (indexed by their position in devices) until all devices delivered a point
+    CompoundMergeBuffer<Protocol::VNADatapoint<32>> compoundVNABuffer;
+    CompoundMergeBuffer<Protocol::SpectrumAnalyzerResult> compoundSABuffer;
+    // Merged measurements that have not been passed on yet
+    std::vector<VNAMeasurement> mergedVNAMeasurements;
     Protocol::DeviceStatus lastStatus;
 
     // Parsed configuration of compound devices (as extracted from compoundJSONString
@@ -190,6 +198,14 @@ private:
 
     std::map<int, int> portStageMapping; // maps from excitedPort (count starts at one) to stage (count starts at zero)
 
+    // Layout of the VNA measurements for the current sweep configuration
+    std::shared_ptr<const MeasurementLayout> VNALayout;
+    bool VNALayoutRaw;
+    bool VNALayoutPreservePhase;
+    // Extracts the measurements of the layout from the datapoints of all devices (one source per device)
+    DatapointDecoder VNADecoder;
+    std::vector<Protocol::VNADatapoint<32>*> VNADecoderSources;
+
     // All possible drivers to interact with a LibreVNA
     std::vector<LibreVNADriver*> drivers;
 
@@ -0,0 +1,159 @@
+#ifndef COMPOUNDMERGEBUFFER_H
+#define COMPOUNDMERGEBUFFER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Collects the datapoints of the individual devices of a compound device until a point is complete
+ *
+ * The buffer is a ring of slots, each holding the datapoints of all devices for one point. Points are identified by a
+ * running index across sweeps, the slot of a point is selected by index % window and a bitmask records which devices
+ * already delivered the point. Datapoints are copied into preallocated storage, adding a datapoint does not allocate and
+ * takes constant time.
+ *
+ * The devices only send the point number within the sweep. There is no per-device sweep count that could get out of
+ * step when a device misses points, instead the running index of a point is derived from the last completed point: the
+ * point number is assumed to be in the sweep that places it closest ahead of the last completed point. A device that
+ * delivers an index which it already delivered into the same slot has started a new sweep while the point never
+ * completed (another device missed it), the stale datapoints are discarded and the point starts over. The same happens
+ * if the slot is needed by a different index. Every datapoint is classified:
+ * - Duplicate: the device sent the same point number twice in a row
+ * - Late: the point is slightly behind the last completed point (it was discarded in favor of a newer complete point)
+ *   or arrives after reset() before the device started the new sweep with point 0
+ * - Incomplete/Complete: stored
+ *
+ * The devices must not drift apart by more than the window or half a sweep, otherwise points are discarded before the
+ * slowest device delivers them.
+ */
+template<typename T> class CompoundMergeBuffer
+{
+public:
+    enum class Result {
+        // stored, still waiting for other devices
+        Incomplete,
+        // stored, all devices have delivered this point. It is available through get() until the next call to add()
+        Complete,
+        // ignored, the point has already been completed or discarded, or it belongs to the previous sweep configuration
+        Late,
+        // ignored, the device sent this point twice
+        Duplicate,
+    };
+
+    CompoundMergeBuffer(unsigned int window = 256)
+        : window(window), devices(0), allDevices(0), sweepPoints(0), lateLimit(0), completed(0), discarded(0),
+          completedSlot(0), lastCompleted(0), anyCompleted(false) {}
+
+    // Removes all points and prepares the buffer for a new sweep. Datapoints are ignored until each device delivers point 0
+    void reset(unsigned int devices, unsigned int sweepPoints) {
+        this->devices = devices;
+        allDevices = ((uint64_t) 1 << devices) - 1;
+        this->sweepPoints = sweepPoints;
+        lateLimit = std::min(window, (sweepPoints + 1) / 2);
+        ring.assign(window, Slot());
+        data.resize(window * devices);
+        lastPoint.assign(devices, -1);
+        completed = 0;
+        discarded = 0;
+        completedSlot = 0;
+        lastCompleted = 0;
+        anyCompleted = false;
+    }
+
+    /**
+     * @brief Adds the datapoint of a device
+     * @param device Index of the device (0 to devices-1)
+     * @param pointNum Point number within the sweep
+     * @param d Datapoint, copied into the buffer
+     * @return Classification of the datapoint, see Result
+     */
+    Result add(unsigned int device, unsigned int pointNum, const T &d) {
+        if(device >= devices || pointNum >= sweepPoints) {
+            return Result::Late;
+        }
+        if(lastPoint[device] < 0 && pointNum != 0) {
+            // still from the sweep before reset()
+            return Result::Late;
+        }
+        if(lastPoint[device] == pointNum && sweepPoints > 1) {
+            return Result::Duplicate;
+        }
+        lastPoint[device] = pointNum;
+        uint64_t index = pointNum;
+        if(anyCompleted) {
+            auto ahead = (pointNum + sweepPoints - lastCompleted % sweepPoints) % sweepPoints;
+            if(ahead > 0 && sweepPoints - ahead < lateLimit) {
+                return Result::Late;
+            }
+            index = lastCompleted + (ahead == 0 ? sweepPoints : ahead);
+        }
+
+        auto slotIndex = index % window;
+        auto &slot = ring[slotIndex];
+        uint32_t mask = (uint32_t) 1 << device;
+        if(!slot.used || slot.index != index || (slot.devices & mask)) {
+            if(slot.used && slot.devices != 0) {
+                // an older point has never been completed
+                discarded++;
+            }
+            slot.used = true;
+            slot.index = index;
+            slot.devices = 0;
+        }
+        data[slotIndex * devices + device] = d;
+        slot.devices |= mask;
+        if(slot.devices != allDevices) {
+            return Result::Incomplete;
+        }
+        // older incomplete points can not be passed on anymore, they are discarded when their slot is reused
+        completed++;
+        completedSlot = slotIndex;
+        lastCompleted = index;
+        anyCompleted = true;
+        slot.devices = 0;
+        slot.used = false;
+        return Result::Complete;
+    }
+
+    // Returns the datapoint of a device for the last completed point
+    T& get(unsigned int device) {return data[completedSlot * devices + device];}
+
+    // Number of completed points since reset()
+    uint64_t getCompleted() const {return completed;}
+    // Number of incomplete points that had to be discarded since reset()
+    uint64_t getDiscarded() const {return discarded;}
+    unsigned int getWindow() const {return window;}
+
+private:
+    class Slot {
+    public:
+        Slot() : used(false), index(0), devices(0) {}
+        bool used;
+        // running index of the point
+        uint64_t index;
+        // bitmask of the devices that delivered this point
+        uint32_t devices;
+    };
+
+    const unsigned int window;
+    // at most 32 devices
+    unsigned int devices;
+    uint32_t allDevices;
+    unsigned int sweepPoints;
+    // points that are less than this behind the last completed point are late
+    unsigned int lateLimit;
+    std::vector<Slot> ring;
+    // datapoints of all slots, devices of one slot are stored next to each other
+    std::vector<T> data;
+    // last point number of every device (-1 if the device has not started the sweep yet)
+    std::vector<int64_t> lastPoint;
+    uint64_t completed;
+    uint64_t discarded;
+    unsigned int completedSlot;
+    // running index of the last completed point
+    uint64_t lastCompleted;
+    bool anyCompleted;
+};
+
+#endif // COMPOUNDMERGEBUFFER_H
@@ -0,0 +1,124 @@
+#include "datapointdecoder.h"
+
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+DatapointDecoder::DatapointDecoder()
+    : complete(true)
+{
+
+}
+
+void DatapointDecoder::clear()
+{
+    lookups.clear();
+    entries.clear();
+    resolved.clear();
+    resolvedValid.clear();
+    complete = true;
+}
+
+void DatapointDecoder::addRatio(unsigned int out, unsigned int source, uint8_t stage, uint8_t port, unsigned int refSource, uint8_t refStage, uint8_t refPort, bool magnitudeOnly)
+{
+    Entry e;
+    e.out = out;
+    e.value = addLookup(source, stage, port, false);
+    e.reference = addLookup(refSource, refStage, refPort, true);
+    e.magnitudeOnly = magnitudeOnly;
+    entries.push_back(e);
+}
+
+void DatapointDecoder::addValue(unsigned int out, unsigned int source, uint8_t stage, uint8_t port, bool reference)
+{
+    Entry e;
+    e.out = out;
+    e.value = addLookup(source, stage, port, reference);
+    e.reference = -1;
+    e.magnitudeOnly = false;
+    entries.push_back(e);
+}
+
+bool DatapointDecoder::decode(Datapoint * const *datapoints, complex<double> *out)
+{
+    for(unsigned int i=0;i<resolved.size();i++) {
+        if(!resolvedValid[i] || !datapoints[i]->sameDescriptors(resolved[i])) {
+            resolve(i, *datapoints[i]);
+        }
+    }
+    // gather the values, every value is only converted once even if it is used by several entries (e.g. the reference)
+    for(unsigned int i=0;i<lookups.size();i++) {
+        auto &l = lookups[i];
+        if(l.position >= 0) {
+            real[i] = datapoints[l.source]->getReal(l.position);
+            imag[i] = datapoints[l.source]->getImag(l.position);
+        } else {
+            real[i] = imag[i] = numeric_limits<double>::quiet_NaN();
+        }
+    }
+    for(auto &e : entries) {
+        double re = real[e.value];
+        double im = imag[e.value];
+        if(e.reference >= 0) {
+            // plain complex division, the special cases of std::complex (infinite values) are not needed here
+            double refRe = real[e.reference];
+            double refIm = imag[e.reference];
+            double norm = refRe * refRe + refIm * refIm;
+            double divRe = (re * refRe + im * refIm) / norm;
+            double divIm = (im * refRe - re * refIm) / norm;
+            re = divRe;
+            im = divIm;
+        }
+        if(e.magnitudeOnly) {
+            re = sqrt(re * re + im * im);
+            im = 0.0;
+        }
+        out[e.out] = complex<double>(re, im);
+    }
+    return complete;
+}
+
+int DatapointDecoder::addLookup(unsigned int source, uint8_t stage, uint8_t port, bool reference)
+{
+    for(unsigned int i=0;i<lookups.size();i++) {
+        auto &l = lookups[i];
+        if(l.source == source && l.stage == stage && l.port == port && l.reference == reference) {
+            return i;
+        }
+    }
+    Lookup l;
+    l.source = source;
+    l.stage = stage;
+    l.port = port;
+    l.reference = reference;
+    l.position = -1;
+    lookups.push_back(l);
+    real.resize(lookups.size());
+    imag.resize(lookups.size());
+    if(source >= resolved.size()) {
+        resolved.resize(source + 1);
+        resolvedValid.resize(source + 1);
+    }
+    // the positions have to be resolved again
+    resolvedValid[source] = false;
+    return lookups.size() - 1;
+}
+
+void DatapointDecoder::resolve(unsigned int source, const Datapoint &d)
+{
+    for(auto &l : lookups) {
+        if(l.source == source) {
+            l.position = d.findValue(l.stage, l.port, l.reference);
+        }
+    }
+    resolved[source] = d;
+    resolvedValid[source] = true;
+    complete = true;
+    for(auto &l : lookups) {
+        if(l.position < 0) {
+            complete = false;
+            break;
+        }
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef DATAPOINTDECODER_H
+#define DATAPOINTDECODER_H
+
+#include "../../VNA_embedded/Application/Communication/Protocol.hpp"
+
+#include <complex>
+#include <vector>
+
+/**
+ * @brief Extracts the measurements of a sweep configuration from VNA datapoints
+ *
+ * A datapoint holds its receiver values as a list, each value is tagged with a descriptor (stage and source mask).
+ * Looking up a value by stage and port (VNADatapoint::getValue()) scans all descriptors, which adds up to dozens of
+ * scans per point. The firmware sends the values in the same order for every point of a sweep, so the decoder resolves
+ * the position of every required value once. Later datapoints only need a comparison of their descriptors with the
+ * ones the positions were resolved for, the positions are resolved again if the descriptors change.
+ *
+ * The measurements are added as entries, either as the ratio of two values (S parameters) or as a single value (raw
+ * receiver values). The values of an entry may come from different datapoints (e.g. a compound device combines the
+ * datapoints of several devices), each datapoint is a source and they are passed to decode() in the order of their
+ * source numbers.
+ */
+class DatapointDecoder
+{
+public:
+    using Datapoint = Protocol::VNADatapoint<32>;
+
+    DatapointDecoder();
+
+    // Removes all entries
+    void clear();
+    bool empty() const {return entries.empty();}
+
+    /**
+     * @brief Adds the ratio of a receiver value and a reference value
+     * @param out Position of the result in the output of decode()
+     * @param source Datapoint of the receiver value
+     * @param stage Stage of the receiver value
+     * @param port Port of the receiver value (starts at zero)
+     * @param refSource Datapoint of the reference value
+     * @param refStage Stage of the reference value
+     * @param refPort Port of the reference value (starts at zero)
+     * @param magnitudeOnly If set, the phase of the ratio is discarded
+     */
+    void addRatio(unsigned int out, unsigned int source, uint8_t stage, uint8_t port,
+                  unsigned int refSource, uint8_t refStage, uint8_t refPort, bool magnitudeOnly = false);
+    // Adds a single value, see addRatio() for the parameters
+    void addValue(unsigned int out, unsigned int source, uint8_t stage, uint8_t port, bool reference);
+
+    /**
+     * @brief Extracts all entries
+     *
+     * Entries are written in the order they have been added, if several entries use the same output the last one wins.
+     *
+     * @param datapoints One datapoint for every source
+     * @param out Destination for the entries
+     * @return true if all values were contained in the datapoints. If not, the affected outputs are set to NaN
+     */
+    bool decode(Datapoint * const *datapoints, std::complex<double> *out);
+
+private:
+    // Returns the index of the value in values (adds it if it is not used by any entry yet)
+    int addLookup(unsigned int source, uint8_t stage, uint8_t port, bool reference);
+    // Finds the positions of all values of a source within its datapoint
+    void resolve(unsigned int source, const Datapoint &d);
+
+    class Lookup {
+    public:
+        unsigned int source;
+        uint8_t stage;
+        uint8_t port;
+        bool reference;
+        // position of the value within the datapoint of the source (-1 if not contained)
+        int position;
+    };
+    class Entry {
+    public:
+        unsigned int out;
+        // indices in lookups, reference is -1 for single values
+        int value;
+        int reference;
+        bool magnitudeOnly;
+    };
+    std::vector<Lookup> lookups;
+    std::vector<Entry> entries;
+    // For every source: the descriptors the positions were resolved for (only the descriptors of the datapoint are used)
+    std::vector<Datapoint> resolved;
+    std::vector<bool> resolvedValid;
+    // true if all values are contained in the datapoints
+    bool complete;
+    // values of the current datapoints in the order of lookups
+    std::vector<double> real, imag;
+};
+
+#endif // DATAPOINTDECODER_H
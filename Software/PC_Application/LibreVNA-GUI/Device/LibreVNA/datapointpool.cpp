@@ -0,0 +1,46 @@
+#include "datapointpool.h"
+
+using namespace std;
+
+mutex DatapointPool::access;
+vector<DatapointPool::Datapoint*> DatapointPool::unused;
+
+void DatapointPool::Deleter::operator()(Datapoint *d) const
+{
+    if(!d) {
+        return;
+    }
+    lock_guard<mutex> guard(access);
+    if(unused.size() < maxAvailable) {
+        unused.push_back(d);
+    } else {
+        delete d;
+    }
+}
+
+DatapointPool::Handle DatapointPool::get()
+{
+    {
+        lock_guard<mutex> guard(access);
+        if(unused.size() > 0) {
+            auto d = unused.back();
+            unused.pop_back();
+            return Handle(d);
+        }
+    }
+    // pool is empty, create new datapoint
+    return Handle(new Datapoint);
+}
+
+DatapointPool::Handle DatapointPool::copy(const Datapoint &d)
+{
+    auto h = get();
+    *h = d;
+    return h;
+}
+
+unsigned int DatapointPool::available()
+{
+    lock_guard<mutex> guard(access);
+    return unused.size();
+}
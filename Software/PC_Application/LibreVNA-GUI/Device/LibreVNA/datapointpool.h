@@ -0,0 +1,52 @@
+#ifndef DATAPOINTPOOL_H
+#define DATAPOINTPOOL_H
+
+#include "../../VNA_embedded/Application/Communication/Protocol.hpp"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Recycling storage for decoded VNA datapoints
+ *
+ * Every received VNADatapoint packet used to be decoded into a new heap allocation, which was then copied again by
+ * the compound driver and the packet log. The pool keeps released datapoints and hands them out again, so the receive
+ * path does not allocate once the pool has grown to the number of datapoints that are in flight at the same time.
+ *
+ * Datapoints are owned by a Handle, they are returned to the pool when the handle goes out of scope. A
+ * Protocol::PacketInfo can only hold a raw pointer: release() the handle before passing on the packet and adopt() the
+ * pointer again where the packet is consumed.
+ *
+ * All functions are thread safe.
+ */
+class DatapointPool
+{
+public:
+    using Datapoint = Protocol::VNADatapoint<32>;
+
+    class Deleter {
+    public:
+        void operator()(Datapoint *d) const;
+    };
+    using Handle = std::unique_ptr<Datapoint, Deleter>;
+
+    // Returns an unused datapoint (its content is undefined)
+    static Handle get();
+    // Returns a datapoint with the same content as d
+    static Handle copy(const Datapoint &d);
+    // Takes over ownership of a datapoint that has been released from a handle
+    static Handle adopt(Datapoint *d) {return Handle(d);}
+
+    // Number of datapoints currently available for reuse
+    static unsigned int available();
+
+private:
+    // Released datapoints above this number are deleted instead of kept for reuse
+    static constexpr unsigned int maxAvailable = 4096;
+
+    static std::mutex access;
+    static std::vector<Datapoint*> unused;
+};
+
+#endif // DATAPOINTPOOL_H
@@ -3,16 +3,31 @@
 #include "preferences.h"
 
 #include <exception>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <limits>
 
 #include <QDateTime>
 
 using namespace std;
 
 DevicePacketLog::DevicePacketLog()
-    : usedStorageSize(0)
+    : next(0),
+      first(0),
+      enabledTypes(~0ULL)
 {
     auto &pref = Preferences::getInstance();
-    maxStorageSize = pref.Debug.USBlogSizeLimit;
+    // the ring always holds at least a few entries
+    capacity = max(16UL, (unsigned long) pref.Debug.USBlogSizeLimit / sizeof(Slot));
+    ring.reset(new Slot[capacity]);
+    for(unsigned long i=0;i<capacity;i++) {
+        ring[i].sequence.store(0, memory_order_relaxed);
+    }
+    steadyReference = now();
+    epochReference = QDateTime::currentMSecsSinceEpoch();
+    // source 0 is the GUI
+    sources.push_back("");
 }
 
 DevicePacketLog::~DevicePacketLog()
@@ -22,43 +37,67 @@ DevicePacketLog::~DevicePacketLog()
 
 void DevicePacketLog::reset()
 {
-    std::lock_guard<mutex> guard(access);
-    entries.clear();
-    usedStorageSize = 0;
+    // entries before this point are ignored, they are overwritten eventually
+    first.store(next.load());
 }
 
-void DevicePacketLog::addPacket(Protocol::PacketInfo &p, QString serial)
+unsigned int DevicePacketLog::registerSource(QString serial)
 {
-    LogEntry e;
-    e.timestamp = QDateTime::currentDateTimeUtc();
-    e.serial = serial;
-    e.type = LogEntry::Type::Packet;
-    e.p = new Protocol::PacketInfo;
-    *e.p = p;
-    if(p.type == Protocol::PacketType::VNADatapoint) {
-        e.datapoint = new Protocol::VNADatapoint<32>(*p.VNAdatapoint);
-    } else {
-        e.datapoint = nullptr;
+    lock_guard<mutex> guard(sourcesAccess);
+    auto it = find(sources.begin(), sources.end(), serial);
+    if(it != sources.end()) {
+        return it - sources.begin();
+    }
+    if(sources.size() > numeric_limits<uint8_t>::max()) {
+        // out of IDs, log as unknown source
+        return 0;
+    }
+    sources.push_back(serial);
+    return sources.size() - 1;
+}
+
+void DevicePacketLog::addPacket(Protocol::PacketType type, const uint8_t *bytes, uint16_t len, unsigned int source)
+{
+    if(!isLogged(type)) {
+        return;
+    }
+    // skip any bytes in front of the frame, the same way DecodeBuffer does
+    auto frame = (const uint8_t*) memchr(bytes, PCKT_HEADER_DATA, len);
+    if(!frame) {
+        return;
+    }
+    len -= frame - bytes;
+    addEntry(LogEntry::Type::Packet, frame, min(len, (uint16_t) maxFrameSize), source, now());
+}
+
+void DevicePacketLog::addInvalidBytes(const uint8_t *bytes, uint16_t len, unsigned int source)
+{
+    if(!isLogged(Protocol::PacketType::None)) {
+        return;
+    }
+    auto timestamp = now();
+    // split into several entries if required
+    while(len > 0) {
+        uint16_t chunk = min(len, (uint16_t) maxFrameSize);
+        addEntry(LogEntry::Type::InvalidBytes, bytes, chunk, source, timestamp);
+        bytes += chunk;
+        len -= chunk;
     }
-    addEntry(e);
 }
 
-void DevicePacketLog::addInvalidBytes(const uint8_t *bytes, uint16_t len, QString serial)
+void DevicePacketLog::setLogging(Protocol::PacketType type, bool enabled)
 {
-    LogEntry e;
-    e.timestamp = QDateTime::currentDateTimeUtc();
-    e.serial = serial;
-    e.type = LogEntry::Type::InvalidBytes;
-    while(len--) {
-        e.bytes.push_back(*bytes++);
+    if(enabled) {
+        enabledTypes.fetch_or(typeMask(type));
+    } else {
+        enabledTypes.fetch_and(~typeMask(type));
     }
-    addEntry(e);
 }
 
 nlohmann::json DevicePacketLog::toJSON()
 {
     nlohmann::json j;
-    for(auto &e : entries) {
+    for(auto &e : getEntries()) {
         j.push_back(e.toJSON());
     }
     return j;
@@ -70,40 +109,122 @@ void DevicePacketLog::fromJSON(nlohmann::json j)
     for(auto jd : j) {
         LogEntry e;
         e.fromJSON(jd);
-        addEntry(e);
+        // store the entry as a frame again
+        auto timestamp = steadyReference + (e.timestamp.toMSecsSinceEpoch() - epochReference) * 1000000;
+        auto source = registerSource(e.serial);
+        if(e.type == LogEntry::Type::Packet) {
+            uint8_t frame[maxFrameSize];
+            auto packet = *e.p;
+            if(packet.type == Protocol::PacketType::VNADatapoint) {
+                if(!e.datapoint) {
+                    continue;
+                }
+                packet.VNAdatapoint = e.datapoint;
+            }
+            auto len = Protocol::EncodePacket(packet, frame, sizeof(frame));
+            if(len) {
+                addEntry(LogEntry::Type::Packet, frame, len, source, timestamp);
+            }
+        } else {
+            for(unsigned int i=0;i<e.bytes.size();i+=maxFrameSize) {
+                addEntry(LogEntry::Type::InvalidBytes, &e.bytes[i], min((size_t) maxFrameSize, e.bytes.size() - i), source, timestamp);
+            }
+        }
     }
 }
 
-DevicePacketLog::LogEntry DevicePacketLog::getEntry(unsigned int index)
+std::vector<DevicePacketLog::LogEntry> DevicePacketLog::getEntries()
 {
-    std::lock_guard<mutex> guard(access);
-    if(index < entries.size()) {
-        return entries[index];
-    } else {
-        throw std::runtime_error("Index too high");
+    vector<QString> sourceNames;
+    {
+        lock_guard<mutex> guard(sourcesAccess);
+        sourceNames = sources;
     }
-}
-
-void DevicePacketLog::addEntry(const DevicePacketLog::LogEntry &e)
-{
-    std::lock_guard<mutex> guard(access);
-    usedStorageSize += e.storageSize();
-    while(usedStorageSize > maxStorageSize) {
-        usedStorageSize -= entries.front().storageSize();
-        entries.pop_front();
+    auto end = next.load();
+    auto begin = max(first.load(), end > capacity ? end - capacity : 0);
+    vector<LogEntry> ret;
+    ret.reserve(end - begin);
+    Entry e;
+    for(auto n=begin;n<end;n++) {
+        if(readEntry(n, e)) {
+            ret.push_back(decode(e, sourceNames));
+        }
     }
-    entries.push_back(e);
-    emit entryAdded(e);
+    return ret;
 }
 
 unsigned long DevicePacketLog::getMaxStorageSize() const
 {
-    return maxStorageSize;
+    return capacity * sizeof(Slot);
 }
 
 unsigned long DevicePacketLog::getUsedStorageSize() const
 {
-    return usedStorageSize;
+    return min(next.load() - first.load(), (uint64_t) capacity) * sizeof(Slot);
+}
+
+int64_t DevicePacketLog::now()
+{
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void DevicePacketLog::addEntry(LogEntry::Type type, const uint8_t *bytes, uint16_t len, unsigned int source, int64_t timestamp)
+{
+    auto n = next.fetch_add(1, memory_order_relaxed);
+    auto &slot = ring[n % capacity];
+    slot.sequence.store(2 * n + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot.entry.type = type;
+    slot.entry.source = source;
+    slot.entry.length = len;
+    slot.entry.timestamp = timestamp;
+    memcpy(slot.entry.data, bytes, len);
+    slot.sequence.store(2 * n + 2, memory_order_release);
+}
+
+bool DevicePacketLog::readEntry(uint64_t n, Entry &e) const
+{
+    auto &slot = ring[n % capacity];
+    auto sequence = slot.sequence.load(memory_order_acquire);
+    if(sequence != 2 * n + 2) {
+        return false;
+    }
+    e.type = slot.entry.type;
+    e.source = slot.entry.source;
+    e.length = min(slot.entry.length, (uint16_t) maxFrameSize);
+    e.timestamp = slot.entry.timestamp;
+    memcpy(e.data, slot.entry.data, e.length);
+    atomic_thread_fence(memory_order_acquire);
+    // the entry is only valid if no writer started to overwrite the slot in the meantime
+    return slot.sequence.load(memory_order_relaxed) == sequence;
+}
+
+DevicePacketLog::LogEntry DevicePacketLog::decode(const Entry &e, const std::vector<QString> &sources) const
+{
+    LogEntry ret;
+    ret.timestamp = QDateTime::fromMSecsSinceEpoch(epochReference + (e.timestamp - steadyReference) / 1000000, Qt::TimeSpec::UTC);
+    ret.serial = e.source < sources.size() ? sources[e.source] : "";
+    ret.type = e.type;
+    if(e.type == LogEntry::Type::Packet) {
+        Protocol::PacketInfo p;
+        // only the payload is decoded, keep the rest of the exported packet deterministic
+        memset(&p, 0, sizeof(p));
+        auto storage = DatapointPool::get();
+        uint8_t frame[maxFrameSize];
+        memcpy(frame, e.data, e.length);
+        Protocol::DecodeBuffer(frame, e.length, &p, storage.get());
+        if(p.type != Protocol::PacketType::None) {
+            ret.p = new Protocol::PacketInfo(p);
+            if(p.type == Protocol::PacketType::VNADatapoint) {
+                ret.datapoint = storage.release();
+            }
+            return ret;
+        }
+        // failed to decode, show the raw bytes instead
+        ret.type = LogEntry::Type::InvalidBytes;
+    }
+    ret.bytes.assign(e.data, e.data + e.length);
+    return ret;
 }
 
 DevicePacketLog::LogEntry::LogEntry(const DevicePacketLog::LogEntry &e)
@@ -116,7 +237,7 @@ DevicePacketLog::LogEntry::LogEntry(const DevicePacketLog::LogEntry &e)
         p = new Protocol::PacketInfo;
         *p = *e.p;
         if(p->type == Protocol::PacketType::VNADatapoint) {
-            datapoint = new Protocol::VNADatapoint<32>(*e.datapoint);
+            datapoint = DatapointPool::copy(*e.datapoint).release();
         } else {
             datapoint = nullptr;
         }
@@ -167,7 +288,7 @@ void DevicePacketLog::LogEntry::fromJSON(nlohmann::json j)
             *(((uint8_t*) p) + i) = jdata[i];
         }
         if(j.contains("datapoint")) {
-            datapoint = new Protocol::VNADatapoint<32>();
+            datapoint = DatapointPool::get().release();
             auto jdatapoint = j["datapoint"];
             for(unsigned int i=0;i<sizeof(*datapoint);i++) {
                 *(((uint8_t*) datapoint) + i) = jdatapoint[i];
@@ -2,15 +2,29 @@
 #define DEVICEUSBLOG_H
 
 #include "../../VNA_embedded/Application/Communication/Protocol.hpp"
+#include "datapointpool.h"
 
 #include "savable.h"
 
-#include <deque>
+#include <atomic>
+#include <memory>
+#include <vector>
 #include <cstdint>
 #include <QDateTime>
 #include <QObject>
 #include <mutex>
 
+/**
+ * @brief Log of all packets exchanged with the devices
+ *
+ * Packets are logged for every device, whether or not the log is ever looked at. To keep this cheap, only the raw
+ * frames are stored in a preallocated ring buffer of fixed size slots, together with a monotonic timestamp. Adding
+ * an entry neither allocates nor locks: writers reserve a slot with an atomic counter and mark it as complete with a
+ * sequence number. The oldest entries are overwritten once the ring is full.
+ *
+ * Frames are only decoded when the entries are requested (log view, export). Readers detect slots that are
+ * overwritten while they are copied and skip them.
+ */
 class DevicePacketLog : public QObject, public Savable
 {
     Q_OBJECT
@@ -24,8 +38,18 @@ public:
 
     void reset();
 
-    void addPacket(Protocol::PacketInfo &p, QString serial = "");
-    void addInvalidBytes(const uint8_t *bytes, uint16_t len, QString serial = "");
+    // Returns the ID under which packets of the device with this serial should be logged. Source 0 is the GUI itself
+    unsigned int registerSource(QString serial);
+
+    // Logs a packet. The bytes have to contain the encoded frame, anything in front of the frame header is ignored
+    void addPacket(Protocol::PacketType type, const uint8_t *bytes, uint16_t len, unsigned int source = 0);
+    void addInvalidBytes(const uint8_t *bytes, uint16_t len, unsigned int source = 0);
+
+    // Enables/disables logging of a packet type, PacketType::None selects invalid bytes. All types are logged by default
+    void setLogging(Protocol::PacketType type, bool enabled);
+    bool isLogged(Protocol::PacketType type) const {
+        return enabledTypes.load(std::memory_order_relaxed) & typeMask(type);
+    }
 
     virtual nlohmann::json toJSON() override;
     virtual void fromJSON(nlohmann::json j) override;
@@ -37,7 +61,8 @@ public:
             : type(Type::InvalidBytes), timestamp(QDateTime()), serial(""), p(nullptr), datapoint(nullptr) {}
         ~LogEntry() {
             delete p;
-            delete datapoint;
+            // return datapoint to the pool
+            DatapointPool::adopt(datapoint);
         }
 
         LogEntry(const LogEntry &e);
@@ -51,43 +76,65 @@ public:
         QString serial;
         std::vector<uint8_t> bytes;
         Protocol::PacketInfo *p;
-        Protocol::VNADatapoint<32> *datapoint;
-        unsigned int storageSize() const {
-            unsigned long size = sizeof(type) + sizeof(timestamp) + serial.size();
-            switch(type) {
-            case Type::InvalidBytes: size += bytes.size(); break;
-            case Type::Packet:
-                size += sizeof(Protocol::PacketInfo);
-                if(p && p->type == Protocol::PacketType::VNADatapoint) {
-                    size += sizeof(Protocol::VNADatapoint<32>);
-                }
-                break;
-            }
-            return size;
-        }
+        Protocol::VNADatapoint<32> *datapoint; // taken from the DatapointPool
 
         virtual nlohmann::json toJSON() override;
         virtual void fromJSON(nlohmann::json j) override;
     };
 
-    LogEntry getEntry(unsigned int index);
+    // Decodes all entries that are currently in the log, oldest first
+    std::vector<LogEntry> getEntries();
 
     unsigned long getUsedStorageSize() const;
     unsigned long getMaxStorageSize() const;
-
-signals:
-    void entryAdded(const LogEntry &e);
+    // Maximum number of entries
+    unsigned long getCapacity() const {return capacity;}
 
 private:
     DevicePacketLog();
 
-    void addEntry(const LogEntry &e);
+    // frames larger than this are rejected by Protocol::DecodeBuffer
+    static constexpr unsigned int maxFrameSize = 2 * sizeof(Protocol::PacketInfo);
 
-    unsigned long maxStorageSize;
-    unsigned long usedStorageSize;
-    std::deque<LogEntry> entries;
+    class Entry {
+    public:
+        LogEntry::Type type;
+        uint8_t source;
+        uint16_t length;
+        // steady clock, in ns
+        int64_t timestamp;
+        uint8_t data[maxFrameSize];
+    };
+    class Slot {
+    public:
+        // 2n+1 while entry n is written, 2n+2 once it is complete
+        std::atomic<uint64_t> sequence;
+        Entry entry;
+    };
 
-    std::mutex access;
+    static uint64_t typeMask(Protocol::PacketType type) {
+        return 1ULL << ((unsigned int) type % 64);
+    }
+    static int64_t now();
+    void addEntry(LogEntry::Type type, const uint8_t *bytes, uint16_t len, unsigned int source, int64_t timestamp);
+    // Copies entry n, returns false if it is not available (not written yet, overwritten)
+    bool readEntry(uint64_t n, Entry &e) const;
+    LogEntry decode(const Entry &e, const std::vector<QString> &sources) const;
+
+    unsigned long capacity;
+    std::unique_ptr<Slot[]> ring;
+    // number of the next entry
+    std::atomic<uint64_t> next;
+    // number of the first entry after the last reset
+    std::atomic<uint64_t> first;
+    std::atomic<uint64_t> enabledTypes;
+
+    // converts timestamps from the steady clock to the wall clock
+    int64_t steadyReference;
+    qint64 epochReference;
+
+    std::mutex sourcesAccess;
+    std::vector<QString> sources;
 };
 
 #endif // DEVICEUSBLOG_H
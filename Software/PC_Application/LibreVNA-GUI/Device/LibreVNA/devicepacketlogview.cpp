@@ -9,6 +9,7 @@
 #include <iomanip>
 
 #include <QPushButton>
+#include <QMenu>
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QHostAddress>
@@ -16,6 +17,13 @@
 
 using namespace std;
 
+static const QStringList packetNames = {"None", "Datapoint", "SweepSettings", "ManualStatus", "ManualControl", "DeviceInfo", "FirmwarePacket", "Ack",
+                                       "ClearFlash", "PerformFirmwareUpdate", "Nack", "Reference", "Generator", "SpectrumAnalyzerSettings",
+                                       "SpectrumAnalyzerResult", "RequestDeviceInfo", "RequestSourceCal", "RequestReceiverCal", "SourceCalPoint",
+                                       "ReceiverCalPoint", "SetIdle", "RequestFrequencyCorrection", "FrequencyCorrection", "RequestDeviceConfiguration",
+                                       "DeviceConfiguration", "DeviceStatus", "RequestDeviceStatus", "VNADatapoint", "SetTrigger", "ClearTrigger",
+                                       "StopStatusUpdates", "StartStatusUpdates", "InitiateSweep", "FirmwareTransfer", "FirmwareAck", "FirmwareNack"};
+
 DevicePacketLogView::DevicePacketLogView(QWidget *parent) :
     QDialog(parent),
     ui(new Ui::DevicePacketLogView)
@@ -23,11 +31,29 @@ DevicePacketLogView::DevicePacketLogView(QWidget *parent) :
     setAttribute(Qt::WA_DeleteOnClose);
     ui->setupUi(this);
 
-//    connect(&log, &DeviceUSBLog::entryAdded, this, &DeviceUSBLogView::addEntry);
     connect(ui->buttonBox->button(QDialogButtonBox::Reset), &QPushButton::clicked, [=](){
         DevicePacketLog::getInstance().reset();
         updateTree();
     });
+    // select the logged packet types
+    auto typeMenu = new QMenu(this);
+    auto addTypeAction = [=](QString name, Protocol::PacketType type) {
+        auto action = typeMenu->addAction(name);
+        action->setCheckable(true);
+        action->setChecked(DevicePacketLog::getInstance().isLogged(type));
+        connect(action, &QAction::toggled, [=](bool checked){
+            DevicePacketLog::getInstance().setLogging(type, checked);
+        });
+    };
+    addTypeAction("Invalid bytes", Protocol::PacketType::None);
+    typeMenu->addSeparator();
+    // skip "None" and the deprecated "Datapoint"
+    for(int i=2;i<packetNames.size();i++) {
+        addTypeAction(packetNames[i], (Protocol::PacketType) i);
+    }
+    auto typeButton = new QPushButton("Logged packets");
+    typeButton->setMenu(typeMenu);
+    ui->buttonBox->addButton(typeButton, QDialogButtonBox::ActionRole);
     connect(ui->buttonBox->button(QDialogButtonBox::Save), &QPushButton::clicked, [=](){
         QString filename = QFileDialog::getSaveFileName(nullptr, "Load LibreVNA log data", "", "LibreVNA log files (*.vnalog)", nullptr, Preferences::QFileDialogOptions());
         if(filename.isEmpty()) {
@@ -85,16 +111,12 @@ void DevicePacketLogView::updateTree()
     ui->tree->setColumnCount(4);
     ui->tree->setHeaderLabels({"Timestamp","Source","Type","Content"});
 
-    unsigned int i=0;
-    try {
-        // will throw once all entries have been added (number of entries may change while the loop is running)
-        for(i=0;;i++) {
-            addEntry(log.getEntry(i));
-        }
-    } catch (...) {
+    auto entries = log.getEntries();
+    for(auto &e : entries) {
+        addEntry(e);
     }
 
-    QString status = "Log contains "+QString::number(i) + " entries, using ";
+    QString status = "Log contains "+QString::number(entries.size()) + " entries, using ";
     status += Unit::ToString(log.getUsedStorageSize(), "B", " kMG") + " (maximum: "+Unit::ToString(log.getMaxStorageSize(), "B", " kMG")+")";
     ui->status->setText(status);
 }
@@ -108,13 +130,8 @@ void DevicePacketLogView::addEntry(const DevicePacketLog::LogEntry &e)
     if(e.type == DevicePacketLog::LogEntry::Type::Packet) {
         item->setData(2, Qt::DisplayRole, "Packet");
 
-        static const QStringList packetNames = {"None", "Datapoint", "SweepSettings", "ManualStatus", "ManualControl", "DeviceInfo", "FirmwarePacket", "Ack",
-                                               "ClearFlash", "PerformFirmwareUpdate", "Nack", "Reference", "Generator", "SpectrumAnalyzerSettings",
-                                               "SpectrumAnalyzerResult", "RequestDeviceInfo", "RequestSourceCal", "RequestReceiverCal", "SourceCalPoint",
-                                               "ReceiverCalPoint", "SetIdle", "RequestFrequencyCorrection", "FrequencyCorrection", "RequestDeviceConfiguration",
-                                               "DeviceConfiguration", "DeviceStatus", "RequestDeviceStatus", "VNADatapoint", "SetTrigger", "ClearTrigger"};
-
-        item->setData(3, Qt::DisplayRole, "Type "+QString::number((int)e.p->type)+"("+packetNames[(int)e.p->type]+")");
+        auto typeIndex = (int) e.p->type;
+        item->setData(3, Qt::DisplayRole, "Type "+QString::number(typeIndex)+"("+(typeIndex < packetNames.size() ? packetNames[typeIndex] : "Unknown")+")");
         auto addDouble = [=](QTreeWidgetItem *parent, QString name, double value, QString unit = "", int precision = 8) {
             auto subitem = new QTreeWidgetItem;
             subitem->setData(2, Qt::DisplayRole, name);
@@ -443,6 +460,13 @@ void DevicePacketLogView::addEntry(const DevicePacketLog::LogEntry &e)
             addDouble(item, "ppm", s.ppm, "");
         }
             break;
+        case Protocol::PacketType::FirmwareTransfer:
+            addInteger(item, "Window", e.p->firmwareTransfer.window);
+            break;
+        case Protocol::PacketType::FirmwareAck:
+        case Protocol::PacketType::FirmwareNack:
+            addInteger(item, "Next address", e.p->firmwareAck.nextAddress);
+            break;
         case Protocol::PacketType::DeviceConfiguration: {
             auto s1 = e.p->deviceConfig.V1;
             auto V1 = new QTreeWidgetItem();
@@ -7,15 +7,16 @@
 
 #include <QFileDialog>
 #include <QStyle>
+#include <QDebug>
 
 FirmwareUpdateDialog::FirmwareUpdateDialog(LibreVNADriver *dev, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::FirmwareUpdateDialog),
     dev(dev),
     file(),
+    uploader(nullptr),
     timer(),
     state(State::Idle),
-    transferredBytes(0),
     success(false),
     deleteAfterUpdate(true)
 {
@@ -31,6 +32,7 @@ FirmwareUpdateDialog::FirmwareUpdateDialog(LibreVNADriver *dev, QWidget *parent)
 FirmwareUpdateDialog::~FirmwareUpdateDialog()
 {
     dev->releaseControl();
+    delete uploader;
     delete ui;
 }
 
@@ -107,6 +109,19 @@ void FirmwareUpdateDialog::on_bStart_clicked()
 
     }
     file->seek(0);
+    delete uploader;
+    uploader = new FirmwareUploader(file);
+    connect(uploader, &FirmwareUploader::sendPacket, this, [=](const Protocol::PacketInfo &p, bool answered) {
+        // packets that are not answered with Ack/Nack do not have to wait for the previous answer
+        dev->SendPacket(p, nullptr, answered ? 500 : 0);
+    });
+    connect(uploader, &FirmwareUploader::startTimer, this, [=](unsigned int ms) {
+        timer.start(ms);
+    });
+    connect(uploader, &FirmwareUploader::status, this, &FirmwareUpdateDialog::addStatus);
+    connect(uploader, &FirmwareUploader::progress, ui->progress, &QProgressBar::setValue);
+    connect(uploader, &FirmwareUploader::completed, this, &FirmwareUpdateDialog::transferComplete);
+    connect(uploader, &FirmwareUploader::failed, this, &FirmwareUpdateDialog::abortWithError);
     state = State::ErasingFLASH;
     disconnect(dev, nullptr, this, nullptr);
     connect(dev, &LibreVNADriver::receivedAnswer, this, [=](const LibreVNADriver::TransmissionResult &res) {
@@ -116,6 +131,7 @@ void FirmwareUpdateDialog::on_bStart_clicked()
             receivedNack();
         }
     }, Qt::QueuedConnection);
+    connect(dev, &LibreVNADriver::receivedPacket, this, &FirmwareUpdateDialog::receivedFirmwarePacket, Qt::QueuedConnection);
     addStatus("Erasing device memory...");
     dev->sendWithoutPayload(Protocol::PacketType::ClearFlash);
     timer.setSingleShot(true);
@@ -130,6 +146,9 @@ void FirmwareUpdateDialog::addStatus(QString line)
 void FirmwareUpdateDialog::abortWithError(QString error)
 {
     timer.stop();
+    if(uploader) {
+        uploader->stop();
+    }
 
     QTextCharFormat tf;
     tf = ui->status->currentCharFormat();
@@ -170,6 +189,9 @@ void FirmwareUpdateDialog::timerCallback()
         }
         state = State::Idle;
         break;
+    case State::TransferringData:
+        uploader->timeout();
+        break;
     default:
         abortWithError("Response timed out");
         break;
@@ -183,26 +205,12 @@ void FirmwareUpdateDialog::receivedAck()
         // no firmware update in progress, ignore
         break;
     case State::ErasingFLASH:
-        // FLASH erased, begin transferring firmware
+        // FLASH erased, transfer the firmware
         state = State::TransferringData;
-        transferredBytes = 0;
-        addStatus("Transferring firmware...");
-        sendNextFirmwareChunk();
-        timer.start(1000);
+        uploader->start();
         break;
     case State::TransferringData:
-        transferredBytes += PacketConstants::FW_CHUNK_SIZE;
-        ui->progress->setValue(100 * transferredBytes / file->size());
-        if(transferredBytes >= file->size()) {
-            // complete file transferred
-            addStatus("Triggering device update...");
-            state = State::TriggeringUpdate;
-            dev->sendWithoutPayload(Protocol::PacketType::PerformFirmwareUpdate);
-            timer.start(5000);
-        } else {
-            sendNextFirmwareChunk();
-            timer.start(1000);
-        }
+        uploader->receivedAck();
         break;
     case State::TriggeringUpdate:
         addStatus("Rebooting device...");
@@ -223,6 +231,9 @@ void FirmwareUpdateDialog::receivedNack()
     case State::ErasingFLASH:
         abortWithError("Nack received, device does not support firmware update");
         break;
+    case State::TransferringData:
+        uploader->receivedNack();
+        break;
     default:
         abortWithError("Nack received, something went wrong");
         break;
@@ -230,11 +241,17 @@ void FirmwareUpdateDialog::receivedNack()
 
 }
 
-void FirmwareUpdateDialog::sendNextFirmwareChunk()
+void FirmwareUpdateDialog::receivedFirmwarePacket(const Protocol::PacketInfo &packet)
+{
+    if(state == State::TransferringData) {
+        uploader->receivedPacket(packet);
+    }
+}
+
+void FirmwareUpdateDialog::transferComplete()
 {
-    Protocol::PacketInfo p;
-    p.type = Protocol::PacketType::FirmwarePacket;
-    p.firmware.address = transferredBytes;
-    file->read((char*) &p.firmware.data, PacketConstants::FW_CHUNK_SIZE);
-    dev->SendPacket(p);
+    addStatus("Triggering device update...");
+    state = State::TriggeringUpdate;
+    dev->sendWithoutPayload(Protocol::PacketType::PerformFirmwareUpdate);
+    timer.start(5000);
 }
@@ -2,6 +2,7 @@
 #define FIRMWAREUPDATEDIALOG_H
 
 #include "librevnadriver.h"
+#include "firmwareuploader.h"
 
 #include <QDialog>
 #include <QFile>
@@ -39,14 +40,16 @@ private slots:
     void timerCallback();
     void receivedAck();
     void receivedNack();
+    void receivedFirmwarePacket(const Protocol::PacketInfo &packet);
 
 private:
     void addStatus(QString line);
     void abortWithError(QString error);
-    void sendNextFirmwareChunk();
+    void transferComplete();
     Ui::FirmwareUpdateDialog *ui;
     LibreVNADriver *dev;
     QFile *file;
+    FirmwareUploader *uploader;
     QTimer timer;
 
     enum class State {
@@ -58,7 +61,6 @@ private:
         WaitBeforeInitializing,
     };
     State state;
-    unsigned int transferredBytes;
     QString serialnumber;
     bool success;
     bool deleteAfterUpdate;
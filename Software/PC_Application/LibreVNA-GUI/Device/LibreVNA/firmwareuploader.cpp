@@ -0,0 +1,216 @@
+#include "firmwareuploader.h"
+
+#include "../../VNA_embedded/Application/Communication/PacketConstants.h"
+
+#include <QDebug>
+
+FirmwareUploader::FirmwareUploader(QIODevice *image, unsigned int requestedWindow)
+    : image(image),
+      requestedWindow(requestedWindow),
+      state(State::Idle),
+      window(1),
+      windowed(false),
+      transferredBytes(0),
+      sentBytes(0),
+      retries(0),
+      retransmissions(0)
+{
+
+}
+
+void FirmwareUploader::start()
+{
+    state = State::Negotiating;
+    windowed = false;
+    window = 1;
+    transferredBytes = 0;
+    sentBytes = 0;
+    retries = 0;
+    retransmissions = 0;
+    negotiate();
+}
+
+void FirmwareUploader::stop()
+{
+    state = State::Idle;
+}
+
+void FirmwareUploader::receivedAck()
+{
+    switch(state) {
+    case State::Negotiating:
+        // supported, the FirmwareTransfer answer follows
+        break;
+    case State::Transferring:
+        if(windowed || sentBytes == transferredBytes) {
+            // chunks are answered with FirmwareAck/FirmwareNack or no chunk is waiting for its Ack
+            break;
+        }
+        acknowledged(sentBytes);
+        if(state == State::Transferring) {
+            sendNextChunk();
+            emit startTimer(timeoutMs);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void FirmwareUploader::receivedNack()
+{
+    switch(state) {
+    case State::Negotiating:
+        // older firmware, transfer one chunk at a time
+        startTransfer(false, 1);
+        break;
+    case State::Transferring:
+        abort("Nack received, something went wrong");
+        break;
+    default:
+        break;
+    }
+}
+
+void FirmwareUploader::receivedPacket(const Protocol::PacketInfo &packet)
+{
+    switch(packet.type) {
+    case Protocol::PacketType::FirmwareTransfer:
+        if(state == State::Negotiating) {
+            startTransfer(true, packet.firmwareTransfer.window);
+        }
+        break;
+    case Protocol::PacketType::FirmwareAck:
+    case Protocol::PacketType::FirmwareNack: {
+        if(state != State::Transferring) {
+            break;
+        }
+        if(!windowed) {
+            // The device switched to the windowed transfer but its answer to the negotiation got lost. Continue with the
+            // windowed transfer, keeping only one chunk in flight
+            qWarning() << "Received" << (packet.type == Protocol::PacketType::FirmwareAck ? "FirmwareAck" : "FirmwareNack")
+                       << "in transfer of one chunk at a time, switching to windowed transfer";
+            windowed = true;
+        }
+        // acknowledgements are cumulative, all data up to this address has been written
+        auto address = packet.firmwareAck.nextAddress;
+        if(address > transferredBytes && address <= sentBytes) {
+            acknowledged(address);
+            if(state != State::Transferring) {
+                break;
+            }
+            emit startTimer(timeoutMs);
+        }
+        if(packet.type == Protocol::PacketType::FirmwareNack) {
+            retransmit("Device requested retransmission from address "+QString::number(address));
+        } else {
+            fillWindow();
+        }
+    }
+        break;
+    default:
+        break;
+    }
+}
+
+void FirmwareUploader::timeout()
+{
+    switch(state) {
+    case State::Negotiating:
+        if(retries < maxNegotiations) {
+            // the request or its answer may have been lost
+            negotiate();
+        } else {
+            // Transfer one chunk at a time. Should the device have switched to the windowed transfer nevertheless, its
+            // FirmwareAck is accepted as well
+            startTransfer(false, 1);
+        }
+        break;
+    case State::Transferring:
+        if(windowed) {
+            retransmit("Response timed out");
+        } else {
+            abort("Response timed out");
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void FirmwareUploader::negotiate()
+{
+    retries++;
+    Protocol::PacketInfo p;
+    p.type = Protocol::PacketType::FirmwareTransfer;
+    p.firmwareTransfer.window = requestedWindow;
+    emit sendPacket(p, true);
+    emit startTimer(timeoutMs);
+}
+
+void FirmwareUploader::startTransfer(bool windowed, unsigned int window)
+{
+    this->windowed = windowed;
+    this->window = window > 0 ? window : 1;
+    state = State::Transferring;
+    transferredBytes = 0;
+    sentBytes = 0;
+    retries = 0;
+    if(windowed) {
+        emit status("Transferring firmware ("+QString::number(this->window)+" chunks in flight)...");
+        fillWindow();
+    } else {
+        emit status("Transferring firmware...");
+        sendNextChunk();
+    }
+    emit startTimer(timeoutMs);
+}
+
+void FirmwareUploader::sendNextChunk()
+{
+    Protocol::PacketInfo p;
+    p.type = Protocol::PacketType::FirmwarePacket;
+    p.firmware.address = sentBytes;
+    image->seek(sentBytes);
+    image->read((char*) &p.firmware.data, PacketConstants::FW_CHUNK_SIZE);
+    // chunks of the windowed transfer are not answered with Ack/Nack, the next chunk can be sent right away
+    emit sendPacket(p, !windowed);
+    sentBytes += PacketConstants::FW_CHUNK_SIZE;
+}
+
+void FirmwareUploader::acknowledged(unsigned int address)
+{
+    transferredBytes = address;
+    retries = 0;
+    emit progress(100 * transferredBytes / image->size());
+    if(transferredBytes >= image->size()) {
+        state = State::Idle;
+        emit completed();
+    }
+}
+
+void FirmwareUploader::fillWindow()
+{
+    while(sentBytes < image->size() && sentBytes - transferredBytes < window * PacketConstants::FW_CHUNK_SIZE) {
+        sendNextChunk();
+    }
+}
+
+void FirmwareUploader::retransmit(QString reason)
+{
+    if(++retries > maxRetries) {
+        abort(reason);
+        return;
+    }
+    qWarning() << reason << ", retransmitting firmware from address" << transferredBytes;
+    retransmissions++;
+    sentBytes = transferredBytes;
+    fillWindow();
+    emit startTimer(timeoutMs);
+}
+
+void FirmwareUploader::abort(QString error)
+{
+    state = State::Idle;
+    emit failed(error);
+}
@@ -0,0 +1,97 @@
+#ifndef FIRMWAREUPLOADER_H
+#define FIRMWAREUPLOADER_H
+
+#include "../../VNA_embedded/Application/Communication/Protocol.hpp"
+
+#include <QIODevice>
+#include <QObject>
+
+/**
+ * @brief Host side of the firmware data transfer
+ *
+ * Transfers the firmware image once the flash of the device has been erased. The windowed transfer is requested with a
+ * FirmwareTransfer packet. If the device answers it, up to a window of chunks is kept in flight and the device answers
+ * with cumulative FirmwareAck/FirmwareNack packets. Firmware without support answers with a Nack, then every chunk is
+ * sent after the previous one has been answered with an Ack.
+ *
+ * The uploader does not know the device driver or the timer: packets are passed out through sendPacket(), answers from
+ * the device and expired timeouts are passed in. This allows running it against a simulated device.
+ */
+class FirmwareUploader : public QObject
+{
+    Q_OBJECT
+public:
+    // The image must be opened for reading and stay valid during the transfer
+    FirmwareUploader(QIODevice *image, unsigned int requestedWindow = 16);
+
+    // Starts the transfer, the flash of the device must have been erased already
+    void start();
+    // Stops the transfer, later answers are ignored
+    void stop();
+    bool isActive() const {return state != State::Idle;}
+
+    bool isWindowed() const {return windowed;}
+    // Number of chunks in flight
+    unsigned int getWindow() const {return window;}
+    unsigned int getSentBytes() const {return sentBytes;}
+    unsigned int getTransferredBytes() const {return transferredBytes;}
+    // Number of retransmissions in the windowed transfer since start()
+    unsigned int getRetransmissions() const {return retransmissions;}
+
+public slots:
+    void receivedAck();
+    void receivedNack();
+    // Handles FirmwareTransfer, FirmwareAck and FirmwareNack, all other packets are ignored
+    void receivedPacket(const Protocol::PacketInfo &packet);
+    // Has to be called when the time passed to startTimer() has expired
+    void timeout();
+
+signals:
+    // The packet has to be sent to the device. If answered is set, the device answers it with Ack/Nack
+    void sendPacket(const Protocol::PacketInfo &packet, bool answered);
+    // (Re)starts the timeout, a running timeout is cancelled
+    void startTimer(unsigned int ms);
+    void status(QString line);
+    // in percent
+    void progress(int value);
+    void completed();
+    void failed(QString error);
+
+private:
+    void negotiate();
+    void startTransfer(bool windowed, unsigned int window);
+    void sendNextChunk();
+    void acknowledged(unsigned int address);
+    // windowed transfer: sends chunks until the window is full
+    void fillWindow();
+    // windowed transfer: sends all chunks again, starting with the first one that has not been acknowledged
+    void retransmit(QString reason);
+    void abort(QString error);
+
+    enum class State {
+        Idle,
+        Negotiating,
+        Transferring,
+    };
+
+    // Number of FirmwareTransfer requests before falling back to the transfer of one chunk at a time
+    static constexpr unsigned int maxNegotiations = 3;
+    // Number of retransmissions without progress before the update is aborted
+    static constexpr unsigned int maxRetries = 5;
+    static constexpr unsigned int timeoutMs = 1000;
+
+    QIODevice *image;
+    unsigned int requestedWindow;
+    State state;
+    // Number of chunks in flight, 1 when the device only supports the transfer of one chunk at a time
+    unsigned int window;
+    bool windowed;
+    // acknowledged bytes
+    unsigned int transferredBytes;
+    unsigned int sentBytes;
+    // negotiation attempts or retransmissions without progress
+    unsigned int retries;
+    unsigned int retransmissions;
+};
+
+#endif // FIRMWAREUPLOADER_H
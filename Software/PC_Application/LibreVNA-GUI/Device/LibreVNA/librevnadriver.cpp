@@ -111,10 +111,13 @@ public:
 LibreVNADriver::LibreVNADriver()
 {
     connected = false;
+    logSource = 0;
     skipOwnPacketHandling = false;
     SApoints = 0;
     hardwareVersion = 0;
     protocolVersion = 0;
+    VNALayoutPorts = 0;
+    VNALayoutRaw = false;
     setSynchronization(Synchronization::Disabled, false);
     manualControlDialog = nullptr;
 
@@ -418,6 +421,8 @@ bool LibreVNADriver::setVNA(const DeviceDriver::VNASettings &s, std::function<vo
     for(unsigned int i=0;i<s.excitedPorts.size();i++) {
         portStageMapping[s.excitedPorts[i]] = i;
     }
+    // measurement layout depends on the excited ports, needs to be recreated
+    VNALayout = nullptr;
 
     Protocol::PacketInfo p = {};
     p.type = Protocol::PacketType::SweepSettings;
@@ -627,6 +632,7 @@ bool LibreVNADriver::setExtRef(QString option_in, QString option_out)
 void LibreVNADriver::registerTypes()
 {
     qRegisterMetaType<Protocol::PacketInfo>();
+    qRegisterMetaType<std::vector<Protocol::PacketInfo>>();
     qRegisterMetaType<TransmissionResult>();
     qRegisterMetaType<Protocol::AmplitudeCorrectionPoint>();
 }
@@ -702,37 +708,8 @@ void LibreVNADriver::handleReceivedPacket(const Protocol::PacketInfo &packet)
         emit FlagsUpdated();
         break;
     case Protocol::PacketType::VNADatapoint: {
-        VNAMeasurement m;
-        Protocol::VNADatapoint<32> *res = packet.VNAdatapoint;
-        m.pointNum = res->pointNum;
-        m.Z0 = 50.0;
-        if(zerospan) {
-            m.us = res->us;
-        } else {
-            m.frequency = res->frequency;
-            m.dBm = (double) res->cdBm / 100;
-        }
-        for(auto map : portStageMapping) {
-            // map.first is the port (starts at one)
-            // map.second is the stage at which this port had the stimulus (starts at zero)
-            complex<double> ref = res->getValue(map.second, map.first-1, true);
-            for(unsigned int i=1;i<=info.Limits.VNA.ports;i++) {
-                complex<double> input = res->getValue(map.second, i-1, false);
-                if(!std::isnan(ref.real()) && !std::isnan(input.real())) {
-                    // got both required measurements
-                    QString name = "S"+QString::number(i)+QString::number(map.first);
-                    m.measurements[name] = input / ref;
-                }
-                if(captureRawReceiverValues) {
-                    QString name = "RawPort"+QString::number(i)+"Stage"+QString::number(map.second);
-                    m.measurements[name] = input;
-                    name = "RawPort"+QString::number(i)+"Stage"+QString::number(map.second)+"Ref";
-                    m.measurements[name] = res->getValue(map.second, i-1, true);
-                }
-            }
-        }
-        delete res;
-        emit VNAmeasurementReceived(m);
+        auto datapoint = DatapointPool::adopt(packet.VNAdatapoint);
+        emit VNAmeasurementReceived(convertDatapoint(datapoint.get()));
     }
         break;
     case Protocol::PacketType::SpectrumAnalyzerResult: {
@@ -753,6 +730,86 @@ void LibreVNADriver::handleReceivedPacket(const Protocol::PacketInfo &packet)
     }
 }
 
+DeviceDriver::VNAMeasurement LibreVNADriver::convertDatapoint(Protocol::VNADatapoint<32> *res)
+{
+    updateVNALayout();
+    VNAMeasurement m;
+    m.pointNum = res->pointNum;
+    m.Z0 = 50.0;
+    if(zerospan) {
+        m.us = res->us;
+    } else {
+        m.frequency = res->frequency;
+        m.dBm = (double) res->cdBm / 100;
+    }
+    // the decoder fills in the values in the order of the names in the layout (see updateVNALayout())
+    m.measurements.setLayout(VNALayout);
+    if(!VNADecoder.decode(&res, m.measurements.data())) {
+        // not all required measurements are included in this datapoint, remove the missing S parameters
+        removeIncompleteMeasurements(m);
+    }
+    return m;
+}
+
+void LibreVNADriver::handleReceivedDatapoints(const std::vector<Protocol::PacketInfo> &packets)
+{
+    std::vector<VNAMeasurement> measurements;
+    measurements.reserve(packets.size());
+    for(auto &packet : packets) {
+        // returns the datapoint to the pool after it has been handled
+        auto datapoint = DatapointPool::adopt(packet.VNAdatapoint);
+        emit passOnReceivedPacket(packet);
+        if(skipOwnPacketHandling) {
+            continue;
+        }
+        measurements.push_back(convertDatapoint(datapoint.get()));
+    }
+    if(measurements.size() > 0) {
+        emit VNAmeasurementsReceived(measurements);
+    }
+}
+
+void LibreVNADriver::updateVNALayout()
+{
+    if(VNALayout && VNALayoutPorts == info.Limits.VNA.ports && VNALayoutRaw == captureRawReceiverValues) {
+        // still up to date
+        return;
+    }
+    // Every name gets an entry in the decoder at the same position
+    QStringList names;
+    VNADecoder.clear();
+    for(auto map : portStageMapping) {
+        // map.first is the port (starts at one)
+        // map.second is the stage at which this port had the stimulus (starts at zero)
+        for(unsigned int i=1;i<=info.Limits.VNA.ports;i++) {
+            VNADecoder.addRatio(names.size(), 0, map.second, i-1, 0, map.second, map.first-1);
+            names.append("S"+QString::number(i)+QString::number(map.first));
+            if(captureRawReceiverValues) {
+                VNADecoder.addValue(names.size(), 0, map.second, i-1, false);
+                names.append("RawPort"+QString::number(i)+"Stage"+QString::number(map.second));
+                VNADecoder.addValue(names.size(), 0, map.second, i-1, true);
+                names.append("RawPort"+QString::number(i)+"Stage"+QString::number(map.second)+"Ref");
+            }
+        }
+    }
+    VNALayout = MeasurementLayout::get(names);
+    VNALayoutPorts = info.Limits.VNA.ports;
+    VNALayoutRaw = captureRawReceiverValues;
+}
+
+void LibreVNADriver::removeIncompleteMeasurements(DeviceDriver::VNAMeasurement &m)
+{
+    QStringList missing;
+    for(unsigned int i=0;i<m.measurements.size();i++) {
+        if(m.measurements.getLayout()->sourcePort(i) && std::isnan(m.measurements.value(i).real())) {
+            missing.append(m.measurements.name(i));
+        }
+    }
+    for(auto &name : missing) {
+        m.measurements.erase(name);
+    }
+}
+
 QString LibreVNADriver::hardwareVersionToString(uint8_t version)
 {
     switch(version) {
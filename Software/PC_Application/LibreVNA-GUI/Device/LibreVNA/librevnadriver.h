@@ -4,6 +4,8 @@
 #include "../devicedriver.h"
 
 #include "../../VNA_embedded/Application/Communication/Protocol.hpp"
+#include "datapointpool.h"
+#include "datapointdecoder.h"
 
 #include <functional>
 
@@ -177,6 +179,9 @@ signals:
     // Required for the compound device driver
     void passOnReceivedPacket(const Protocol::PacketInfo& packet);
 public:
+    // Queues a packet for transmission. The next packet is sent once the device answered with Ack/Nack or after the timeout (in ms).
+    // A timeout of 0 is used for packets that the device does not answer, the next packet is sent right away and the callback
+    // is called with Ack once the packet has been sent
     virtual bool SendPacket(const Protocol::PacketInfo& packet, std::function<void(TransmissionResult)> cb = nullptr, unsigned int timeout = 500) = 0;
     bool sendWithoutPayload(Protocol::PacketType type, std::function<void(TransmissionResult)> cb = nullptr);
     virtual bool updateFirmware(QString file) override;
@@ -190,15 +195,27 @@ public:
 signals:
     void receivedAnswer(const LibreVNADriver::TransmissionResult &result);
     void receivedPacket(const Protocol::PacketInfo& packet);
+    // All VNA datapoints that have been decoded from the same USB transfer/TCP read. They are passed on
+    // together instead of emitting receivedPacket() for each one
+    void receivedDatapoints(const std::vector<Protocol::PacketInfo>& packets);
 
 protected slots:
     void handleReceivedPacket(const Protocol::PacketInfo& packet);
+    void handleReceivedDatapoints(const std::vector<Protocol::PacketInfo>& packets);
 protected:
     QString hardwareVersionToString(uint8_t version);
+    // Converts a received datapoint into a VNA measurement with the layout of the current sweep configuration
+    VNAMeasurement convertDatapoint(Protocol::VNADatapoint<32> *res);
+    // (Re-)creates the measurement layout for the configured sweep if required
+    void updateVNALayout();
+    // Removes all S parameters without valid data from a measurement (slow, only used if the device did not send all values)
+    static void removeIncompleteMeasurements(VNAMeasurement &m);
 
     bool connected;
     unsigned int protocolVersion;
     QString serial;
+    // ID of this device in the DevicePacketLog
+    unsigned int logSource;
     Info info;
     uint8_t hardwareVersion;
     unsigned int limits_maxAmplitudePoints;
@@ -214,6 +231,13 @@ protected:
 
     std::map<int, int> portStageMapping; // maps from excitedPort (count starts at one) to stage (count starts at zero)
 
+    // Layout of the VNA measurements for the current sweep configuration
+    std::shared_ptr<const MeasurementLayout> VNALayout;
+    unsigned int VNALayoutPorts;
+    bool VNALayoutRaw;
+    // Extracts the measurements of the layout from the datapoints
+    DatapointDecoder VNADecoder;
+
     // Driver specific settings
     bool captureRawReceiverValues;
     bool harmonicMixing;
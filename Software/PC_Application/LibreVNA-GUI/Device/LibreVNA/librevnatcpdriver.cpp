@@ -7,6 +7,8 @@
 #include <QTimer>
 #include <QNetworkInterface>
 
+#include <limits>
+
 using namespace std;
 
 static const QString service_name = "urn:schemas-upnp-org:device:LibreVNA:1";
@@ -43,6 +45,13 @@ LibreVNATCPDriver::LibreVNATCPDriver()
         });
         ssdpSockets.push_back(socket);
     }
+    // Devices on this host (e.g. the virtual device of the benchmark) do not receive the multicast requests on every
+    // system (no multicast on the loopback interface), they are also asked directly
+    localSSDPSocket = new QUdpSocket();
+    localSSDPSocket->bind(QHostAddress::LocalHost, 0);
+    connect(localSSDPSocket, &QUdpSocket::readyRead, this, [=](){
+        SSDPreceived(localSSDPSocket);
+    });
 
     connect(&ssdpTimer, &QTimer::timeout,this, &LibreVNATCPDriver::SSDRequest);
     ssdpTimer.start(1000);
@@ -113,6 +122,7 @@ bool LibreVNATCPDriver::connectTo(QString serial)
 
     qInfo() << "TCP connection established" << Qt::flush;
     this->serial = serial;
+    logSource = DevicePacketLog::getInstance().registerSource(serial);
     connected = true;
 
     connect(&dataSocket, &QTcpSocket::readyRead, this, &LibreVNATCPDriver::ReceivedData, Qt::UniqueConnection);
@@ -120,6 +130,7 @@ bool LibreVNATCPDriver::connectTo(QString serial)
     connect(&transmissionTimer, &QTimer::timeout, this, &LibreVNATCPDriver::transmissionTimeout, Qt::UniqueConnection);
     connect(this, &LibreVNATCPDriver::receivedAnswer, this, &LibreVNATCPDriver::transmissionFinished, static_cast<Qt::ConnectionType>(Qt::QueuedConnection | Qt::UniqueConnection));
     connect(this, &LibreVNATCPDriver::receivedPacket, this, &LibreVNATCPDriver::handleReceivedPacket, static_cast<Qt::ConnectionType>(Qt::QueuedConnection | Qt::UniqueConnection));
+    connect(this, &LibreVNATCPDriver::receivedDatapoints, this, &LibreVNATCPDriver::handleReceivedDatapoints, static_cast<Qt::ConnectionType>(Qt::QueuedConnection | Qt::UniqueConnection));
     transmissionTimer.setSingleShot(true);
     transmissionActive = false;
 
@@ -151,6 +162,7 @@ void LibreVNATCPDriver::disconnect()
 void LibreVNATCPDriver::registerTypes()
 {
     qDebug() << "Registering meta type: " << qRegisterMetaType<Protocol::PacketInfo>();
+    qDebug() << "Registering meta type: " << qRegisterMetaType<std::vector<Protocol::PacketInfo>>();
     qDebug() << "Registering meta type: " << qRegisterMetaType<TransmissionResult>();
 }
 
@@ -171,6 +183,7 @@ void LibreVNATCPDriver::SSDRequest()
     for(auto s : ssdpSockets) {
         s->writeDatagram(data.data(), SSDPaddress, SSDPport);
     }
+    localSSDPSocket->writeDatagram(data.data(), QHostAddress::LocalHost, SSDPport);
 }
 
 void LibreVNATCPDriver::SSDPreceived(QUdpSocket *sock)
@@ -221,20 +234,26 @@ void LibreVNATCPDriver::ReceivedData()
     dataBuffer.append(dataSocket.readAll());
     Protocol::PacketInfo packet;
     uint16_t handled_len;
+    // datapoints are collected and passed on together after all available data has been decoded
+    std::vector<Protocol::PacketInfo> datapoints;
+    // storage for the next decoded datapoint, returned to the pool if no datapoint is received
+    auto datapointStorage = DatapointPool::get();
 //    qDebug() << "Received data";
     do {
 //        qDebug() << "Decoding" << dataBuffer->getReceived() << "Bytes";
-        handled_len = Protocol::DecodeBuffer((uint8_t*) dataBuffer.data(), dataBuffer.size(), &packet);
+        // DecodeBuffer() can only handle up to 64k at once, packets are much smaller
+        uint16_t len = min(dataBuffer.getReceived(), (int) numeric_limits<uint16_t>::max());
+        handled_len = Protocol::DecodeBuffer(dataBuffer.getBuffer(), len, &packet, datapointStorage.get());
 //        qDebug() << "Handled" << handled_len << "Bytes, type:" << (int) packet.type;
         if(handled_len > 0) {
             auto &log = DevicePacketLog::getInstance();
             if(packet.type != Protocol::PacketType::None) {
-                log.addPacket(packet, serial);
+                log.addPacket(packet.type, dataBuffer.getBuffer(), handled_len, logSource);
             } else {
-                log.addInvalidBytes((uint8_t*) dataBuffer.data(), handled_len, serial);
+                log.addInvalidBytes(dataBuffer.getBuffer(), handled_len, logSource);
             }
         }
-        dataBuffer.remove(0, handled_len);
+        dataBuffer.removeBytes(handled_len);
         switch(packet.type) {
         case Protocol::PacketType::Ack:
             emit receivedAnswer(TransmissionResult::Ack);
@@ -242,12 +261,21 @@ void LibreVNATCPDriver::ReceivedData()
         case Protocol::PacketType::Nack:
             emit receivedAnswer(TransmissionResult::Nack);
             break;
+        case Protocol::PacketType::VNADatapoint:
+            // the datapoint is passed on with the packet, it is returned to the pool by handleReceivedDatapoints()
+            datapointStorage.release();
+            datapointStorage = DatapointPool::get();
+            datapoints.push_back(packet);
+            break;
        default:
             // pass on to LibreVNADriver class
             emit receivedPacket(packet);
             break;
         }
     } while (handled_len > 0);
+    if(datapoints.size() > 0) {
+        emit receivedDatapoints(datapoints);
+    }
 }
 
 void LibreVNATCPDriver::ReceivedLog()
@@ -256,12 +284,12 @@ void LibreVNATCPDriver::ReceivedLog()
     uint16_t handled_len;
     do {
         handled_len = 0;
-        auto firstLinebreak = (uint8_t*) memchr((uint8_t*) logBuffer.data(), '\n', logBuffer.size());
+        auto firstLinebreak = (uint8_t*) memchr(logBuffer.getBuffer(), '\n', logBuffer.getReceived());
         if(firstLinebreak) {
-            handled_len = firstLinebreak - (uint8_t*) logBuffer.data();
-            auto line = QString::fromLatin1(logBuffer.data(), handled_len - 1);
+            handled_len = firstLinebreak - logBuffer.getBuffer();
+            auto line = QString::fromLatin1((const char*) logBuffer.getBuffer(), handled_len - 1);
             emit LogLineReceived(line);
-            logBuffer.remove(0, handled_len + 1);
+            logBuffer.removeBytes(handled_len + 1);
         }
     } while(handled_len > 0);
 }
@@ -286,20 +314,7 @@ void LibreVNATCPDriver::transmissionFinished(LibreVNADriver::TransmissionResult
         t.callback(result);
     }
     transmissionTimer.stop();
-    bool success = false;
-    while(!transmissionQueue.isEmpty() && !success) {
-        success = startNextTransmission();
-        if(!success) {
-            // failed to send this packet
-            auto t = transmissionQueue.dequeue();
-            if(t.callback) {
-                t.callback(TransmissionResult::InternalError);
-            }
-        }
-    }
-    if(transmissionQueue.isEmpty()) {
-        transmissionActive = false;
-    }
+    continueTransmissions();
 }
 
 bool LibreVNATCPDriver::SendPacket(const Protocol::PacketInfo &packet, std::function<void (LibreVNADriver::TransmissionResult)> cb, unsigned int timeout)
@@ -312,7 +327,7 @@ bool LibreVNATCPDriver::SendPacket(const Protocol::PacketInfo &packet, std::func
     transmissionQueue.enqueue(t);
 //    qDebug() << "Enqueued packet, queue at " << transmissionQueue.size();
     if(!transmissionActive) {
-        startNextTransmission();
+        continueTransmissions();
     }
     return true;
 }
@@ -358,14 +373,38 @@ bool LibreVNATCPDriver::startNextTransmission()
         return false;
     }
     auto &log = DevicePacketLog::getInstance();
-    log.addPacket(t.packet);
+    log.addPacket(t.packet.type, buffer, length);
     auto ret = dataSocket.write((char*) buffer, length);
     if(ret < 0) {
         qCritical() << "Error sending TCP data";
         return false;
     }
-    transmissionTimer.start(t.timeout);
+    if(t.timeout > 0) {
+        transmissionTimer.start(t.timeout);
+    }
 //    qDebug() << "Transmission started, queue at " << transmissionQueue.size();
     return true;
 }
 
+void LibreVNATCPDriver::continueTransmissions()
+{
+    bool waiting = false;
+    while(!transmissionQueue.isEmpty() && !waiting) {
+        bool success = startNextTransmission();
+        if(success && transmissionQueue.head().timeout > 0) {
+            // waiting for the answer
+            waiting = true;
+        } else {
+            // no answer expected or failed to send this packet
+            auto t = transmissionQueue.dequeue();
+            if(t.callback) {
+                // a packet without answer is successful once it has been sent
+                t.callback(success ? TransmissionResult::Ack : TransmissionResult::InternalError);
+            }
+        }
+    }
+    if(transmissionQueue.isEmpty()) {
+        transmissionActive = false;
+    }
+}
+
@@ -2,6 +2,7 @@
 #define LIBREVNATCPDRIVER_H
 
 #include "librevnadriver.h"
+#include "Util/streambuffer.h"
 
 #include <condition_variable>
 #include <thread>
@@ -15,6 +16,8 @@
 
 class LibreVNATCPDriver : public LibreVNADriver
 {
+    // feeds the receive path with data from a local socket
+    friend class StreamBufferTests;
     Q_OBJECT
 public:
     LibreVNATCPDriver();
@@ -70,6 +73,8 @@ private:
 
     // Sockets for SSDP protocol
     std::vector<QUdpSocket*> ssdpSockets;
+    // Socket for SSDP requests to devices on this host
+    QUdpSocket *localSSDPSocket;
     class DetectedDevice {
     public:
         QString serial;
@@ -87,8 +92,8 @@ private:
     QTcpSocket dataSocket;
     QTcpSocket logSocket;
 
-    QByteArray dataBuffer;
-    QByteArray logBuffer;
+    StreamBuffer dataBuffer;
+    StreamBuffer logBuffer;
 
     class Transmission {
     public:
@@ -101,6 +106,8 @@ private:
     std::mutex transmissionMutex;
     QQueue<Transmission> transmissionQueue;
     bool startNextTransmission();
+    // Starts queued transmissions until one is waiting for its answer. transmissionMutex must be locked
+    void continueTransmissions();
     QTimer transmissionTimer;
     QTimer ssdpTimer;
     bool transmissionActive;
@@ -4,6 +4,10 @@
 #include "devicepacketlog.h"
 
 #include <QTimer>
+#include <QVBoxLayout>
+#include <QFormLayout>
+#include <QGroupBox>
+#include <QSpinBox>
 
 using namespace std;
 
@@ -26,6 +30,7 @@ LibreVNAUSBDriver::LibreVNAUSBDriver()
     dataBuffer = nullptr;
     logBuffer = nullptr;
     m_receiveThread = nullptr;
+    receiveTransfers = 4;
 
     specificSettings.push_back(Savable::SettingDescription(&captureRawReceiverValues, "LibreVNAUSBDriver.captureRawReceiverValues", false));
     specificSettings.push_back(Savable::SettingDescription(&harmonicMixing, "LibreVNAUSBDriver.harmonicMixing", false));
@@ -34,6 +39,31 @@ LibreVNAUSBDriver::LibreVNAUSBDriver()
     specificSettings.push_back(Savable::SettingDescription(&VNAAdjustPowerLevel, "LibreVNAUSBDriver.adjustPowerLevel", false));
     specificSettings.push_back(Savable::SettingDescription(&SAUseDFT, "LibreVNAUSBDriver.useDFT", true));
     specificSettings.push_back(Savable::SettingDescription(&SARBWLimitForDFT, "LibreVNAUSBDriver.RBWlimitDFT", 3000));
+    specificSettings.push_back(Savable::SettingDescription(&receiveTransfers, "LibreVNAUSBDriver.receiveTransfers", 4));
+}
+
+QWidget *LibreVNAUSBDriver::createSettingsWidget()
+{
+    auto w = new QWidget;
+    auto layout = new QVBoxLayout(w);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(LibreVNADriver::createSettingsWidget());
+
+    auto usb = new QGroupBox("USB");
+    auto form = new QFormLayout(usb);
+    auto transfers = new QSpinBox;
+    transfers->setRange(1, 32);
+    transfers->setValue(receiveTransfers);
+    transfers->setToolTip("Number of USB transfers that are queued at the same time. Increase this value if datapoints get lost at "
+                          "high data rates (many points, high IF bandwidth). Takes effect after reconnecting to the device.");
+    form->addRow("Queued receive transfers:", transfers);
+    layout->addWidget(usb);
+
+    connect(transfers, qOverload<int>(&QSpinBox::valueChanged), this, [=](int value){
+        receiveTransfers = value;
+    });
+
+    return w;
 }
 
 QString LibreVNAUSBDriver::getDriverName()
@@ -112,9 +142,10 @@ bool LibreVNAUSBDriver::connectTo(QString serial)
         throw std::runtime_error(message.toStdString());
     }
     qInfo() << "USB connection established" << Qt::flush;
+    logSource = DevicePacketLog::getInstance().registerSource(serial);
     connected = true;
     m_receiveThread = new std::thread(&LibreVNAUSBDriver::USBHandleThread, this);
-    dataBuffer = new USBInBuffer(m_handle, EP_Data_In_Addr, 65536);
+    dataBuffer = new USBInBuffer(m_handle, EP_Data_In_Addr, 65536, receiveTransfers);
     logBuffer = new USBInBuffer(m_handle, EP_Log_In_Addr, 65536);
     connect(dataBuffer, &USBInBuffer::DataReceived, this, &LibreVNAUSBDriver::ReceivedData, Qt::DirectConnection);
     connect(dataBuffer, &USBInBuffer::TransferError, this, &LibreVNAUSBDriver::ConnectionLost);
@@ -122,6 +153,7 @@ bool LibreVNAUSBDriver::connectTo(QString serial)
     connect(&transmissionTimer, &QTimer::timeout, this, &LibreVNAUSBDriver::transmissionTimeout, Qt::UniqueConnection);
     connect(this, &LibreVNAUSBDriver::receivedAnswer, this, &LibreVNAUSBDriver::transmissionFinished, static_cast<Qt::ConnectionType>(Qt::QueuedConnection | Qt::UniqueConnection));
     connect(this, &LibreVNAUSBDriver::receivedPacket, this, &LibreVNAUSBDriver::handleReceivedPacket, static_cast<Qt::ConnectionType>(Qt::QueuedConnection | Qt::UniqueConnection));
+    connect(this, &LibreVNAUSBDriver::receivedDatapoints, this, &LibreVNAUSBDriver::handleReceivedDatapoints, static_cast<Qt::ConnectionType>(Qt::QueuedConnection | Qt::UniqueConnection));
     transmissionTimer.setSingleShot(true);
     transmissionActive = false;
 
@@ -162,17 +194,21 @@ void LibreVNAUSBDriver::ReceivedData()
 {
     Protocol::PacketInfo packet;
     uint16_t handled_len;
+    // datapoints are collected and passed on together after all available data has been decoded
+    std::vector<Protocol::PacketInfo> datapoints;
+    // storage for the next decoded datapoint, returned to the pool if no datapoint is received
+    auto datapointStorage = DatapointPool::get();
 //    qDebug() << "Received data";
     do {
 //        qDebug() << "Decoding" << dataBuffer->getReceived() << "Bytes";
-        handled_len = Protocol::DecodeBuffer(dataBuffer->getBuffer(), dataBuffer->getReceived(), &packet);
+        handled_len = Protocol::DecodeBuffer(dataBuffer->getBuffer(), dataBuffer->getReceived(), &packet, datapointStorage.get());
 //        qDebug() << "Handled" << handled_len << "Bytes, type:" << (int) packet.type;
         if(handled_len > 0) {
             auto &log = DevicePacketLog::getInstance();
             if(packet.type != Protocol::PacketType::None) {
-                log.addPacket(packet, serial);
+                log.addPacket(packet.type, dataBuffer->getBuffer(), handled_len, logSource);
             } else {
-                log.addInvalidBytes(dataBuffer->getBuffer(), handled_len, serial);
+                log.addInvalidBytes(dataBuffer->getBuffer(), handled_len, logSource);
             }
         }
         dataBuffer->removeBytes(handled_len);
@@ -183,12 +219,21 @@ void LibreVNAUSBDriver::ReceivedData()
         case Protocol::PacketType::Nack:
             emit receivedAnswer(TransmissionResult::Nack);
             break;
+        case Protocol::PacketType::VNADatapoint:
+            // the datapoint is passed on with the packet, it is returned to the pool by handleReceivedDatapoints()
+            datapointStorage.release();
+            datapointStorage = DatapointPool::get();
+            datapoints.push_back(packet);
+            break;
        default:
             // pass on to LibreVNADriver class
             emit receivedPacket(packet);
             break;
         }
     } while (handled_len > 0);
+    if(datapoints.size() > 0) {
+        emit receivedDatapoints(datapoints);
+    }
 }
 
 void LibreVNAUSBDriver::ReceivedLog()
@@ -226,20 +271,7 @@ void LibreVNAUSBDriver::transmissionFinished(LibreVNADriver::TransmissionResult
         t.callback(result);
     }
     transmissionTimer.stop();
-    bool success = false;
-    while(!transmissionQueue.isEmpty() && !success) {
-        success = startNextTransmission();
-        if(!success) {
-            // failed to send this packet
-            auto t = transmissionQueue.dequeue();
-            if(t.callback) {
-                t.callback(TransmissionResult::InternalError);
-            }
-        }
-    }
-    if(transmissionQueue.isEmpty()) {
-        transmissionActive = false;
-    }
+    continueTransmissions();
 }
 
 bool LibreVNAUSBDriver::SendPacket(const Protocol::PacketInfo &packet, std::function<void (LibreVNADriver::TransmissionResult)> cb, unsigned int timeout)
@@ -252,7 +284,7 @@ bool LibreVNAUSBDriver::SendPacket(const Protocol::PacketInfo &packet, std::func
     transmissionQueue.enqueue(t);
 //    qDebug() << "Enqueued packet, queue at " << transmissionQueue.size();
     if(!transmissionActive) {
-        startNextTransmission();
+        continueTransmissions();
     }
     return true;
 }
@@ -356,14 +388,38 @@ bool LibreVNAUSBDriver::startNextTransmission()
     }
     int actual_length;
     auto &log = DevicePacketLog::getInstance();
-    log.addPacket(t.packet);
+    log.addPacket(t.packet.type, buffer, length);
     auto ret = libusb_bulk_transfer(m_handle, EP_Data_Out_Addr, buffer, length, &actual_length, 0);
     if(ret < 0) {
         qCritical() << "Error sending data: "
                                 << libusb_strerror((libusb_error) ret);
         return false;
     }
-    transmissionTimer.start(t.timeout);
+    if(t.timeout > 0) {
+        transmissionTimer.start(t.timeout);
+    }
 //    qDebug() << "Transmission started, queue at " << transmissionQueue.size();
     return true;
 }
+
+void LibreVNAUSBDriver::continueTransmissions()
+{
+    bool waiting = false;
+    while(!transmissionQueue.isEmpty() && !waiting) {
+        bool success = startNextTransmission();
+        if(success && transmissionQueue.head().timeout > 0) {
+            // waiting for the answer
+            waiting = true;
+        } else {
+            // no answer expected or failed to send this packet
+            auto t = transmissionQueue.dequeue();
+            if(t.callback) {
+                // a packet without answer is successful once it has been sent
+                t.callback(success ? TransmissionResult::Ack : TransmissionResult::InternalError);
+            }
+        }
+    }
+    if(transmissionQueue.isEmpty()) {
+        transmissionActive = false;
+    }
+}
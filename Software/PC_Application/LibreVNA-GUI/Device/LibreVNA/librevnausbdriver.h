@@ -36,6 +36,14 @@ public:
      */
     virtual void disconnect() override;
 
+    /**
+     * @brief Returns a widget to edit the driver specific settings.
+     *
+     * Extends the settings of the LibreVNADriver with the USB specific settings
+     * @return newly constructed settings widget
+     */
+    virtual QWidget* createSettingsWidget() override;
+
 private slots:
     void ReceivedData();
     void ReceivedLog();
@@ -59,6 +67,8 @@ private:
     libusb_context *m_context;
     USBInBuffer *dataBuffer;
     USBInBuffer *logBuffer;
+    // Number of concurrently submitted transfers for the data endpoint
+    int receiveTransfers;
 
     class Transmission {
     public:
@@ -70,6 +80,8 @@ private:
     std::mutex transmissionMutex;
     QQueue<Transmission> transmissionQueue;
     bool startNextTransmission();
+    // Starts queued transmissions until one is waiting for its answer. transmissionMutex must be locked
+    void continueTransmissions();
     QTimer transmissionTimer;
     bool transmissionActive;
 
@@ -7,6 +7,8 @@
 #include <QDateTime>
 #include <QApplication>
 
+#include <algorithm>
+
 SNA5000ADriver::SNA5000ADriver()
     : DeviceTCPDriver("SNA5000A")
 {
@@ -16,8 +18,10 @@ SNA5000ADriver::SNA5000ADriver()
         m.pointNum = p.index;
         m.frequency = p.frequency;
         m.dBm = excitationPower;
-        m.measurements = p.data;
-        emit VNAmeasurementReceived(m);
+        m.measurements.setLayout(VNALayout);
+        std::copy(p.data.begin(), p.data.end(), m.measurements.data());
+        // passed on together with all other changed points of this trace
+        changedMeasurements.push_back(m);
     });
 
     traceReader.waitingForResponse = false;
@@ -196,6 +200,14 @@ bool SNA5000ADriver::setVNA(const VNASettings &s, std::function<void (bool)> cb)
 {
     excitationPower = s.dBmStart;
     excitedPorts = s.excitedPorts;
+    // one S parameter for every combination of excited ports
+    QStringList names;
+    for(auto i : excitedPorts) {
+        for(auto j : excitedPorts) {
+            names.append("S"+QString::number(i)+QString::number(j));
+        }
+    }
+    VNALayout = MeasurementLayout::get(names);
 
     if(!traceReaderStop()) {
         emit ConnectionLost();
@@ -407,12 +419,15 @@ void SNA5000ADriver::handleIncomingData()
     if(traceReader.state >= excitedPorts.size()*excitedPorts.size()) {
         // Check size, abort if wrong
         bool sizeOkay = true;
-        for(auto d : traceReader.data) {
-            if(d.second.size() != traceReader.xaxis.size() * 2) {
+        for(auto &d : traceReader.data) {
+            if(d.second.size() != traceReader.xaxis.size() * 2 || VNALayout->index(d.first) < 0) {
                 sizeOkay = false;
                 break;
             }
         }
+        if(traceReader.data.size() != VNALayout->size()) {
+            sizeOkay = false;
+        }
 
         if(sizeOkay) {
             /*
@@ -430,7 +445,7 @@ void SNA5000ADriver::handleIncomingData()
 
             int lastIndex = -1;
             for(unsigned int i=0;i<traceReader.xaxis.size();i++) {
-                for(auto d : traceReader.data) {
+                for(auto &d : traceReader.data) {
                     if(abs(d.second[i*2]) < threshold && abs(d.second[i*2+1]) < threshold) {
                         lastIndex = i;
                         break;
@@ -447,20 +462,27 @@ void SNA5000ADriver::handleIncomingData()
             }
 
             if(lastIndex > 0) {
-                // Compile VNApoints
+                // Compile VNApoints, the values are placed in the order of the layout
+                std::vector<std::pair<int, const std::vector<double>*>> sources;
+                for(auto &d : traceReader.data) {
+                    sources.push_back({VNALayout->index(d.first), &d.second});
+                }
                 std::vector<VNAPoint> trace;
                 trace.resize(lastIndex);
                 for(int i=0;i<lastIndex;i++) {
                     trace[i].index = i;
                     trace[i].frequency = traceReader.xaxis[i];
-                    std::map<QString, std::complex<double>> tracedata;
-                    for(auto d : traceReader.data) {
-                        tracedata[d.first] = std::complex(d.second[i*2], d.second[i*2+1]);
+                    trace[i].data.resize(sources.size());
+                    for(auto &source : sources) {
+                        trace[i].data[source.first] = std::complex((*source.second)[i*2], (*source.second)[i*2+1]);
                     }
-                    trace[i].data = tracedata;
                 }
 
                 diffGen->newTrace(trace);
+                if(changedMeasurements.size() > 0) {
+                    emit VNAmeasurementsReceived(changedMeasurements);
+                    changedMeasurements.clear();
+                }
             }
         }
         traceReader.state = 0;
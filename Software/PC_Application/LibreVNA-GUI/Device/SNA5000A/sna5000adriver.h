@@ -168,11 +168,15 @@ private:
     std::vector<int> excitedPorts;
     double excitationPower;
 
+    // Layout of the VNA measurements for the current sweep configuration, created in setVNA()
+    std::shared_ptr<const MeasurementLayout> VNALayout;
+
     class VNAPoint {
     public:
         unsigned int index;
         double frequency;
-        std::map<QString, std::complex<double>> data;
+        // values in the order of VNALayout
+        std::vector<std::complex<double>> data;
         bool operator==(const VNAPoint& rhs) {
             if(index != rhs.index || frequency != rhs.frequency || data.size() != rhs.data.size()) {
                 return false;
@@ -180,13 +184,15 @@ private:
             if(data.size() == 0) {
                 return true;
             } else {
-                return std::prev(data.end())->second == std::prev(rhs.data.end())->second;
+                return data.back() == rhs.data.back();
             }
 //            return index == rhs.index && frequency == rhs.frequency && data.size() == rhs.data.size() && std::equal(data.begin(), data.end(), rhs.data.begin());
         }
     };
 
     TraceDifferenceGenerator<VNAPoint> *diffGen;
+    // Measurements created by the difference generator for the last read trace
+    std::vector<VNAMeasurement> changedMeasurements;
 
     std::map<QString, QHostAddress> detectedDevices;
 };
@@ -8,6 +8,14 @@
 
 DeviceDriver *DeviceDriver::activeDriver = nullptr;
 
+DeviceDriver::DeviceDriver()
+{
+    // forward single measurements as a block, the application only handles blocks of measurements
+    connect(this, &DeviceDriver::VNAmeasurementReceived, this, [=](VNAMeasurement m){
+        emit VNAmeasurementsReceived({m});
+    });
+}
+
 DeviceDriver::~DeviceDriver()
 {
     for(auto a : specificActions) {
@@ -63,32 +71,33 @@ unsigned int DeviceDriver::SApoints() {
 
 Sparam DeviceDriver::VNAMeasurement::toSparam(int port1, int port2) const
 {
+    auto valueAt = [=](int rcv, int src) -> std::complex<double> {
+        auto index = measurements.indexS(rcv, src);
+        if(index < 0) {
+            throw std::out_of_range("Missing measurement for S"+std::to_string(rcv)+std::to_string(src));
+        }
+        return measurements.value(index);
+    };
     Sparam S;
-    S.m11 = measurements.at("S"+QString::number(port1)+QString::number(port1));
-    S.m12 = measurements.at("S"+QString::number(port1)+QString::number(port2));
-    S.m21 = measurements.at("S"+QString::number(port2)+QString::number(port1));
-    S.m22 = measurements.at("S"+QString::number(port2)+QString::number(port2));
+    S.m11 = valueAt(port1, port1);
+    S.m12 = valueAt(port1, port2);
+    S.m21 = valueAt(port2, port1);
+    S.m22 = valueAt(port2, port2);
     return S;
 }
 
 void DeviceDriver::VNAMeasurement::fromSparam(Sparam S, int port1, int port2)
 {
-    QString s11 = "S"+QString::number(port1)+QString::number(port1);
-    QString s12 = "S"+QString::number(port1)+QString::number(port2);
-    QString s21 = "S"+QString::number(port2)+QString::number(port1);
-    QString s22 = "S"+QString::number(port2)+QString::number(port2);
-    if(measurements.count(s11)) {
-        measurements[s11] = S.m11;
-    }
-    if(measurements.count(s12)) {
-        measurements[s12] = S.m12;
-    }
-    if(measurements.count(s21)) {
-        measurements[s21] = S.m21;
-    }
-    if(measurements.count(s22)) {
-        measurements[s22] = S.m22;
-    }
+    auto setValue = [=](int rcv, int src, std::complex<double> value) {
+        auto index = measurements.indexS(rcv, src);
+        if(index >= 0) {
+            measurements.value(index) = value;
+        }
+    };
+    setValue(port1, port1, S.m11);
+    setValue(port1, port2, S.m12);
+    setValue(port2, port1, S.m21);
+    setValue(port2, port2, S.m22);
 }
 
 DeviceDriver::VNAMeasurement DeviceDriver::VNAMeasurement::interpolateTo(const DeviceDriver::VNAMeasurement &to, double a)
@@ -97,11 +106,14 @@ DeviceDriver::VNAMeasurement DeviceDriver::VNAMeasurement::interpolateTo(const D
     ret.frequency = frequency * (1.0 - a) + to.frequency * a;
     ret.dBm = dBm * (1.0 - a) + to.dBm * a;
     ret.Z0 = Z0 * (1.0 - a) + to.Z0 * a;
-    for(auto m : measurements) {
-        if(to.measurements.count(m.first) == 0) {
-            throw std::runtime_error("Nothing to interpolate to, expected measurement +\""+m.first.toStdString()+"\"");
+    ret.measurements.setLayout(measurements.getLayout());
+    bool sameLayout = measurements.getLayout() == to.measurements.getLayout();
+    for(unsigned int i=0;i<measurements.size();i++) {
+        int toIndex = sameLayout ? i : to.measurements.index(measurements.name(i));
+        if(toIndex < 0) {
+            throw std::runtime_error("Nothing to interpolate to, expected measurement +\""+measurements.name(i).toStdString()+"\"");
         }
-        ret.measurements[m.first] = measurements[m.first] * (1.0 - a) + to.measurements.at(m.first) * a;
+        ret.measurements.value(i) = measurements.value(i) * (1.0 - a) + to.measurements.value(toIndex) * a;
     }
     return ret;
 }
@@ -12,6 +12,7 @@
   */
 
 #include "Tools/parameters.h"
+#include "measurementblock.h"
 #include "savable.h"
 #include "scpi.h"
 
@@ -25,7 +26,7 @@ class DeviceDriver : public QObject
 {
     Q_OBJECT
 public:
-    DeviceDriver() {}
+    DeviceDriver();
     virtual ~DeviceDriver();
 
     /**
@@ -287,9 +288,9 @@ public:
             };
         };
         // S parameter measurements
-        // Key: S parameter name, e.g. "S11"
-        // Value: complex measurement in real/imag (linear, not in dB)
-        std::map<QString, std::complex<double>> measurements;
+        // Names (e.g. "S11") are stored in the shared layout, values are complex measurements in real/imag (linear, not in dB).
+        // Drivers should create the layout once per sweep configuration and use index based access when filling in the values
+        MeasurementBlock measurements;
 
         Sparam toSparam(int port1, int port2) const;
         void fromSparam(Sparam S, int port1, int port2);
@@ -316,9 +317,24 @@ public:
 signals:
     /**
      * @brief This signal must be emitted whenever a VNA measurement is complete and should be passed on to the GUI
+     *
+     * Drivers that receive several measurements at once should emit VNAmeasurementsReceived() instead. Every
+     * measurement emitted by this signal is forwarded as a block containing only this measurement, the application
+     * only connects to VNAmeasurementsReceived().
+     *
      * @param m VNA measurement
      */
     void VNAmeasurementReceived(VNAMeasurement m);
+    /**
+     * @brief Emit this signal to pass on a block of consecutive VNA measurements to the GUI
+     *
+     * Passing on all measurements that are available at the same time (e.g. all datapoints decoded from one USB
+     * transfer) is considerably faster than emitting VNAmeasurementReceived() for every single point: the
+     * application processes the whole block at once and only updates the traces once per block.
+     *
+     * @param m VNA measurements, in the order in which they were taken
+     */
+    void VNAmeasurementsReceived(std::vector<VNAMeasurement> m);
 
 public:
     class SASettings {
@@ -464,6 +480,7 @@ public:
      * @brief maximumSupportedPorts Maximum number of supported ports by the GUI. No device driver may report a higher number of ports than this value
      */
     static constexpr unsigned int maximumSupportedPorts = 8;
+    static_assert(maximumSupportedPorts <= MeasurementLayout::maxPorts, "S parameter lookup table too small");
 
     static Info getInfo(DeviceDriver* driver) {
         if(driver) {
@@ -0,0 +1,110 @@
+#include "measurementblock.h"
+
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+using namespace std;
+
+shared_ptr<const MeasurementLayout> MeasurementLayout::get(const QStringList &names)
+{
+    // Layouts are never deleted, the number of different sweep configurations is small
+    static map<QString, shared_ptr<const MeasurementLayout>> interned;
+    static mutex access;
+
+    auto key = names.join('\n');
+    lock_guard<mutex> guard(access);
+    auto it = interned.find(key);
+    if(it != interned.end()) {
+        return it->second;
+    }
+    auto layout = shared_ptr<const MeasurementLayout>(new MeasurementLayout(names));
+    interned[key] = layout;
+    return layout;
+}
+
+bool MeasurementLayout::parseSparam(const QString &name, unsigned int &rcv, unsigned int &src)
+{
+    if(name.size() != 3 || name[0] != 'S' || !name[1].isDigit() || !name[2].isDigit()) {
+        return false;
+    }
+    rcv = name[1].digitValue();
+    src = name[2].digitValue();
+    return rcv > 0 && src > 0;
+}
+
+MeasurementLayout::MeasurementLayout(const QStringList &names)
+    : names(names)
+{
+    Sindex.fill(-1);
+    for(int i=0;i<names.size();i++) {
+        lookup[names[i]] = i;
+        unsigned int rcv, src;
+        if(parseSparam(names[i], rcv, src) && rcv <= maxPorts && src <= maxPorts) {
+            ports.push_back({rcv, src});
+            Sindex[(rcv - 1) * maxPorts + src - 1] = i;
+        } else {
+            ports.push_back({0, 0});
+        }
+    }
+}
+
+MeasurementBlock::MeasurementBlock(std::shared_ptr<const MeasurementLayout> layout)
+{
+    setLayout(layout);
+}
+
+void MeasurementBlock::setLayout(std::shared_ptr<const MeasurementLayout> layout)
+{
+    this->layout = layout;
+    local.fill(0.0);
+    if(size() > inlineSize) {
+        overflow.assign(size(), 0.0);
+    } else {
+        overflow.clear();
+    }
+}
+
+std::complex<double> MeasurementBlock::at(const QString &name) const
+{
+    auto i = index(name);
+    if(i < 0) {
+        throw out_of_range("Measurement \""+name.toStdString()+"\" not available");
+    }
+    return value(i);
+}
+
+std::complex<double> &MeasurementBlock::operator[](const QString &name)
+{
+    auto i = index(name);
+    if(i >= 0) {
+        return value(i);
+    }
+    // not included yet, switch to a layout with the additional parameter
+    QStringList names;
+    if(layout) {
+        names = layout->getNames();
+    }
+    names.append(name);
+    auto old = *this;
+    setLayout(MeasurementLayout::get(names));
+    for(unsigned int j=0;j<old.size();j++) {
+        value(j) = old.value(j);
+    }
+    return value(size() - 1);
+}
+
+void MeasurementBlock::erase(const QString &name)
+{
+    auto i = index(name);
+    if(i < 0) {
+        return;
+    }
+    auto names = layout->getNames();
+    names.removeAt(i);
+    auto old = *this;
+    setLayout(MeasurementLayout::get(names));
+    for(unsigned int j=0;j<size();j++) {
+        value(j) = old.value(j < (unsigned int) i ? j : j + 1);
+    }
+}
@@ -0,0 +1,116 @@
+#ifndef MEASUREMENTBLOCK_H
+#define MEASUREMENTBLOCK_H
+
+#include <complex>
+#include <memory>
+#include <array>
+#include <vector>
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+
+/**
+ * @brief Interned table of measurement parameter names
+ *
+ * A layout describes which parameters (e.g. "S11", "S21", "RawPort1Stage0") are contained in a measurement and at
+ * which index their values are stored. Layouts are immutable and created once per sweep configuration. Identical
+ * name lists always resolve to the same layout object, so two layouts can be compared by pointer.
+ */
+class MeasurementLayout
+{
+public:
+    // Highest port number that can be addressed by the S parameter lookup table
+    static constexpr unsigned int maxPorts = 8;
+
+    /**
+     * @brief Returns the (shared) layout for a list of parameter names
+     *
+     * This function has to search the table of already interned layouts and should not be called per point.
+     * Create the layout once when the sweep configuration changes instead.
+     *
+     * @param names Parameter names, must not contain duplicates
+     * @return Layout
+     */
+    static std::shared_ptr<const MeasurementLayout> get(const QStringList &names);
+
+    unsigned int size() const {return names.size();}
+    const QString& name(unsigned int index) const {return names[index];}
+    const QStringList& getNames() const {return names;}
+
+    // Returns the index of a parameter or -1 if the parameter is not part of this layout
+    int index(const QString &name) const {return lookup.value(name, -1);}
+    // Returns the index of the S parameter S<rcv><src> or -1 if it is not part of this layout. Port count starts at one
+    int indexS(unsigned int rcv, unsigned int src) const {
+        if(rcv == 0 || src == 0 || rcv > maxPorts || src > maxPorts) {
+            return -1;
+        }
+        return Sindex[(rcv - 1) * maxPorts + src - 1];
+    }
+    // Returns the receiving port of an S parameter at the given index (0 if the parameter is not an S parameter)
+    unsigned int receivingPort(unsigned int index) const {return ports[index].first;}
+    // Returns the source port of an S parameter at the given index (0 if the parameter is not an S parameter)
+    unsigned int sourcePort(unsigned int index) const {return ports[index].second;}
+
+    // Splits a name of the form "S<rcv><src>" into its ports, returns false for any other name
+    static bool parseSparam(const QString &name, unsigned int &rcv, unsigned int &src);
+
+private:
+    MeasurementLayout(const QStringList &names);
+
+    QStringList names;
+    QHash<QString, int> lookup;
+    std::vector<std::pair<unsigned int, unsigned int>> ports;
+    std::array<int, maxPorts*maxPorts> Sindex;
+};
+
+/**
+ * @brief Dense, index-addressed storage for the values of a single measurement point
+ *
+ * The parameter names are not stored with each point, they are part of the shared MeasurementLayout. Values are
+ * kept in an inline array, which is large enough for all S parameters of a 4-port measurement. Only larger layouts
+ * (more ports or raw receiver values) require a heap allocation per point.
+ *
+ * Index based access (value(), indexS()) should be used on the hot path. The name based count(), at() and
+ * operator[] mimic the std::map<QString, std::complex<double>> that was used previously. They are slower and
+ * operator[] needs to switch to a new layout if the name is not yet included.
+ */
+class MeasurementBlock
+{
+public:
+    MeasurementBlock() : layout(nullptr) {}
+    MeasurementBlock(std::shared_ptr<const MeasurementLayout> layout);
+
+    // Sets a new layout. All values are reset to zero
+    void setLayout(std::shared_ptr<const MeasurementLayout> layout);
+    const std::shared_ptr<const MeasurementLayout>& getLayout() const {return layout;}
+
+    unsigned int size() const {return layout ? layout->size() : 0;}
+    bool empty() const {return size() == 0;}
+    const QString& name(unsigned int index) const {return layout->name(index);}
+    std::complex<double>& value(unsigned int index) {return data()[index];}
+    const std::complex<double>& value(unsigned int index) const {return data()[index];}
+    std::complex<double>* data() {return overflow.empty() ? local.data() : overflow.data();}
+    const std::complex<double>* data() const {return overflow.empty() ? local.data() : overflow.data();}
+
+    int index(const QString &name) const {return layout ? layout->index(name) : -1;}
+    int indexS(unsigned int rcv, unsigned int src) const {return layout ? layout->indexS(rcv, src) : -1;}
+
+    // Compatibility accessors with std::map semantics
+    unsigned int count(const QString &name) const {return index(name) >= 0 ? 1 : 0;}
+    // throws std::out_of_range if the parameter is not included
+    std::complex<double> at(const QString &name) const;
+    // adds the parameter (initialized to zero) if it is not included yet
+    std::complex<double>& operator[](const QString &name);
+    void erase(const QString &name);
+    void clear() {setLayout(nullptr);}
+
+private:
+    static constexpr unsigned int inlineSize = 16;
+
+    std::shared_ptr<const MeasurementLayout> layout;
+    std::array<std::complex<double>, inlineSize> local;
+    std::vector<std::complex<double>> overflow;
+};
+
+#endif // MEASUREMENTBLOCK_H
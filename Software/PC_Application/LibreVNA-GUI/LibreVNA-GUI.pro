@@ -5,6 +5,7 @@ HEADERS += \
     Calibration/LibreCAL/librecaldialog.h \
     Calibration/LibreCAL/usbdevice.h \
     Calibration/calibration.h \
+    Calibration/calibrationkernel.h \
     Calibration/calibrationmeasurement.h \
     Calibration/calkit.h \
     Calibration/calkitdialog.h \
@@ -22,13 +23,17 @@ HEADERS += \
     Device/LibreVNA/Compound/compounddevice.h \
     Device/LibreVNA/Compound/compounddeviceeditdialog.h \
     Device/LibreVNA/Compound/compounddriver.h \
+    Device/LibreVNA/Compound/compoundmergebuffer.h \
     Device/LibreVNA/amplitudecaldialog.h \
+    Device/LibreVNA/datapointdecoder.h \
+    Device/LibreVNA/datapointpool.h \
     Device/LibreVNA/deviceconfigurationdialogv1.h \
     Device/LibreVNA/deviceconfigurationdialogvfe.h \
     Device/LibreVNA/deviceconfigurationdialogvff.h \
     Device/LibreVNA/devicepacketlog.h \
     Device/LibreVNA/devicepacketlogview.h \
     Device/LibreVNA/firmwareupdatedialog.h \
+    Device/LibreVNA/firmwareuploader.h \
     Device/LibreVNA/frequencycaldialog.h \
     Device/LibreVNA/librevnadriver.h \
     Device/LibreVNA/librevnatcpdriver.h \
@@ -43,6 +48,7 @@ HEADERS += \
     Device/devicedriver.h \
     Device/devicelog.h \
     Device/devicetcpdriver.h \
+    Device/measurementblock.h \
     Device/tracedifferencegenerator.h \
     Generator/generator.h \
     Generator/signalgenwidget.h \
@@ -58,6 +64,7 @@ HEADERS += \
     Traces/Marker/markerwidget.h \
     Traces/Math/dft.h \
     Traces/Math/expression.h \
+    Traces/Math/compiledexpression.h \
     Traces/Math/medianfilter.h \
     Traces/Math/parser/mpCompat.h \
     Traces/Math/parser/mpDefines.h \
@@ -113,6 +120,7 @@ HEADERS += \
     Traces/Math/windowfunction.h \
     Traces/eyediagramplot.h \
     Traces/fftcomplex.h \
+    Traces/polylinedecimator.h \
     Traces/sparamtraceselector.h \
     Traces/trace.h \
     Traces/traceaxis.h \
@@ -133,7 +141,9 @@ HEADERS += \
     Util/prbs.h \
     Util/qpointervariant.h \
     Util/usbinbuffer.h \
+    Util/streambuffer.h \
     Util/util.h \
+    Util/textio.h \
     Util/app_common.h \
     VNA/Deembedding/deembedding.h \
     VNA/Deembedding/deembeddingdialog.h \
@@ -148,6 +158,7 @@ HEADERS += \
     about.h \
     appwindow.h \
     averaging.h \
+    binarycontainer.h \
     csv.h \
     json.hpp \
     modehandler.h \
@@ -167,6 +178,7 @@ SOURCES += \
     Calibration/LibreCAL/librecaldialog.cpp \
     Calibration/LibreCAL/usbdevice.cpp \
     Calibration/calibration.cpp \
+    Calibration/calibrationkernel.cpp \
     Calibration/calibrationmeasurement.cpp \
     Calibration/calkit.cpp \
     Calibration/calkitdialog.cpp \
@@ -185,12 +197,15 @@ SOURCES += \
     Device/LibreVNA/Compound/compounddeviceeditdialog.cpp \
     Device/LibreVNA/Compound/compounddriver.cpp \
     Device/LibreVNA/amplitudecaldialog.cpp \
+    Device/LibreVNA/datapointdecoder.cpp \
+    Device/LibreVNA/datapointpool.cpp \
     Device/LibreVNA/deviceconfigurationdialogv1.cpp \
     Device/LibreVNA/deviceconfigurationdialogvfe.cpp \
     Device/LibreVNA/deviceconfigurationdialogvff.cpp \
     Device/LibreVNA/devicepacketlog.cpp \
     Device/LibreVNA/devicepacketlogview.cpp \
     Device/LibreVNA/firmwareupdatedialog.cpp \
+    Device/LibreVNA/firmwareuploader.cpp \
     Device/LibreVNA/frequencycaldialog.cpp \
     Device/LibreVNA/librevnadriver.cpp \
     Device/LibreVNA/librevnatcpdriver.cpp \
@@ -205,6 +220,7 @@ SOURCES += \
     Device/devicedriver.cpp \
     Device/devicelog.cpp \
     Device/devicetcpdriver.cpp \
+    Device/measurementblock.cpp \
     Generator/generator.cpp \
     Generator/signalgenwidget.cpp \
     SpectrumAnalyzer/spectrumanalyzer.cpp \
@@ -219,6 +235,7 @@ SOURCES += \
     Traces/Marker/markerwidget.cpp \
     Traces/Math/dft.cpp \
     Traces/Math/expression.cpp \
+    Traces/Math/compiledexpression.cpp \
     Traces/Math/medianfilter.cpp \
     Traces/Math/parser/mpError.cpp \
     Traces/Math/parser/mpFuncCmplx.cpp \
@@ -263,6 +280,7 @@ SOURCES += \
     Traces/Math/windowfunction.cpp \
     Traces/eyediagramplot.cpp \
     Traces/fftcomplex.cpp \
+    Traces/polylinedecimator.cpp \
     Traces/sparamtraceselector.cpp \
     Traces/trace.cpp \
     Traces/traceaxis.cpp \
@@ -282,7 +300,9 @@ SOURCES += \
     Traces/xyplotaxisdialog.cpp \
     Util/prbs.cpp \
     Util/usbinbuffer.cpp \
+    Util/streambuffer.cpp \
     Util/util.cpp \
+    Util/textio.cpp \
     VNA/Deembedding/deembedding.cpp \
     VNA/Deembedding/deembeddingdialog.cpp \
     VNA/Deembedding/deembeddingoption.cpp \
@@ -296,6 +316,7 @@ SOURCES += \
     about.cpp \
     appwindow.cpp \
     averaging.cpp \
+    binarycontainer.cpp \
     csv.cpp \
     main.cpp \
     modehandler.cpp \
@@ -317,11 +317,7 @@ SpectrumAnalyzer::SpectrumAnalyzer(AppWindow *window, QString name)
     // Set initial sweep settings
     auto& pref = Preferences::getInstance();
 
-    if(pref.Acquisition.useMedianAveraging) {
-        average.setMode(Averaging::Mode::Median);
-    } else {
-        average.setMode(Averaging::Mode::Mean);
-    }
+    average.setMode((Averaging::Mode) pref.Acquisition.averagingMode);
 
     if(pref.Startup.RememberSweepSettings) {
         LoadSweepSettings();
@@ -0,0 +1,584 @@
+#include "compiledexpression.h"
+
+#include "Util/util.h"
+
+#include <cmath>
+#include <climits>
+#include <sstream>
+#include <locale>
+#include <algorithm>
+
+using namespace Math;
+
+// Blocks are only split across threads if every thread gets at least this number of blocks
+static constexpr unsigned int minimumBlocks = 16;
+
+// same values as the constants defined by muparserx
+static constexpr double constantPi = 3.141592653589793238462643;
+static constexpr double constantE = 2.718281828459045235360287;
+
+class CompiledExpression::Parser
+{
+public:
+    Parser(const std::string &s, const std::vector<std::string> &variables)
+        : s(s), pos(0), variables(variables) {}
+
+    // Returns nullptr if the expression is not supported (or invalid)
+    std::unique_ptr<Node> parse() {
+        auto n = expression();
+        skipSpaces();
+        if(pos != s.size()) {
+            return nullptr;
+        }
+        return n;
+    }
+
+private:
+    using NodePtr = std::unique_ptr<Node>;
+
+    NodePtr expression() {
+        auto left = term();
+        while(left) {
+            skipSpaces();
+            if(accept('+')) {
+                left = combine(Op::Add, std::move(left), term());
+            } else if(accept('-')) {
+                left = combine(Op::Subtract, std::move(left), term());
+            } else {
+                break;
+            }
+        }
+        return left;
+    }
+    NodePtr term() {
+        auto left = signedFactor();
+        while(left) {
+            skipSpaces();
+            if(accept('*')) {
+                left = combine(Op::Multiply, std::move(left), signedFactor());
+            } else if(accept('/')) {
+                left = combine(Op::Divide, std::move(left), signedFactor());
+            } else {
+                break;
+            }
+        }
+        return left;
+    }
+    // the negative sign binds weaker than the power operator: -2^2 = -4, 2^-2 = 0.25
+    NodePtr signedFactor() {
+        skipSpaces();
+        if(accept('-')) {
+            skipSpaces();
+            if(peek() == '-') {
+                // multiple signs, leave to muparserx
+                return nullptr;
+            }
+            return combine(Op::Negate, power());
+        }
+        return power();
+    }
+    // right associative: 2^3^2 = 2^9
+    NodePtr power() {
+        auto base = primary();
+        skipSpaces();
+        if(base && accept('^')) {
+            return combine(Op::Power, std::move(base), signedFactor());
+        }
+        return base;
+    }
+    NodePtr primary() {
+        skipSpaces();
+        auto c = peek();
+        if(isdigit(c) || c == '.') {
+            return number();
+        } else if(accept('(')) {
+            auto n = expression();
+            skipSpaces();
+            if(!accept(')')) {
+                return nullptr;
+            }
+            return n;
+        } else if(isalpha(c) || c == '_') {
+            return name();
+        }
+        return nullptr;
+    }
+    NodePtr number() {
+        // same format as accepted by the muparserx value reader
+        auto start = pos;
+        bool digits = false;
+        while(isdigit(peek())) {
+            pos++;
+            digits = true;
+        }
+        if(accept('.')) {
+            while(isdigit(peek())) {
+                pos++;
+                digits = true;
+            }
+        }
+        if(!digits) {
+            return nullptr;
+        }
+        if(peek() == 'e' || peek() == 'E') {
+            pos++;
+            if(peek() == '+' || peek() == '-') {
+                pos++;
+            }
+            if(!isdigit(peek())) {
+                // incomplete exponent
+                return nullptr;
+            }
+            while(isdigit(peek())) {
+                pos++;
+            }
+        }
+        std::istringstream stream(s.substr(start, pos - start));
+        stream.imbue(std::locale::classic());
+        double value;
+        stream >> value;
+        if(stream.fail()) {
+            return nullptr;
+        }
+        auto n = constant(value);
+        if(accept('i')) {
+            // imaginary value
+            n->value = std::complex<double>(0.0, value);
+        } else if(isUnit(peek()) && !isNameChar(peek(1)) && !isVariable(std::string(1, peek()))) {
+            n->value *= unitMultiplier(peek());
+            pos++;
+        }
+        if(isNameChar(peek())) {
+            // unknown postfix or missing operator
+            return nullptr;
+        }
+        return n;
+    }
+    NodePtr name() {
+        auto start = pos;
+        while(isNameChar(peek())) {
+            pos++;
+        }
+        auto name = s.substr(start, pos - start);
+        bool isConstant = name == "pi" || name == "e" || name == "i";
+        Op function;
+        unsigned int args;
+        bool isFunction = functionInfo(name, function, args);
+        auto it = std::find(variables.begin(), variables.end(), name);
+        if(it != variables.end()) {
+            if(isConstant || isFunction) {
+                // ambiguous
+                return nullptr;
+            }
+            auto n = NodePtr(new Node);
+            n->op = Op::Variable;
+            n->variable = it - variables.begin();
+            return n;
+        } else if(isConstant) {
+            if(name == "pi") {
+                return constant(constantPi);
+            } else if(name == "e") {
+                return constant(constantE);
+            } else {
+                return constant(std::complex<double>(0.0, 1.0));
+            }
+        } else if(isFunction) {
+            if(!accept('(')) {
+                return nullptr;
+            }
+            auto n = NodePtr(new Node);
+            n->op = function;
+            for(unsigned int i=0;i<args;i++) {
+                if(i > 0) {
+                    skipSpaces();
+                    if(!accept(',')) {
+                        return nullptr;
+                    }
+                }
+                auto arg = expression();
+                if(!arg) {
+                    return nullptr;
+                }
+                n->args.push_back(std::move(arg));
+            }
+            skipSpaces();
+            if(!accept(')')) {
+                return nullptr;
+            }
+            return n;
+        }
+        // unknown name
+        return nullptr;
+    }
+
+    static NodePtr constant(std::complex<double> value) {
+        auto n = NodePtr(new Node);
+        n->op = Op::Constant;
+        n->value = value;
+        return n;
+    }
+    static NodePtr combine(Op op, NodePtr a, NodePtr b = nullptr) {
+        bool binary = op == Op::Add || op == Op::Subtract || op == Op::Multiply || op == Op::Divide || op == Op::Power;
+        if(!a || (binary && !b)) {
+            return nullptr;
+        }
+        auto n = NodePtr(new Node);
+        n->op = op;
+        n->args.push_back(std::move(a));
+        if(binary) {
+            n->args.push_back(std::move(b));
+        }
+        return n;
+    }
+    static bool functionInfo(const std::string &name, Op &op, unsigned int &args) {
+        static const std::vector<std::pair<std::string, Op>> functions = {
+            {"real", Op::Real}, {"imag", Op::Imag}, {"conj", Op::Conj}, {"arg", Op::Arg}, {"norm", Op::Norm}, {"abs", Op::Abs},
+            {"sin", Op::Sin}, {"cos", Op::Cos}, {"tan", Op::Tan}, {"sinh", Op::Sinh}, {"cosh", Op::Cosh}, {"tanh", Op::Tanh},
+            {"sqrt", Op::Sqrt}, {"exp", Op::Exp}, {"ln", Op::Ln}, {"log", Op::Ln}, {"log2", Op::Log2}, {"log10", Op::Log10},
+            {"pow", Op::PowFunction},
+        };
+        for(auto &f : functions) {
+            if(f.first == name) {
+                op = f.second;
+                args = op == Op::PowFunction ? 2 : 1;
+                return true;
+            }
+        }
+        return false;
+    }
+    static bool isUnit(char c) {
+        return c == 'n' || c == 'u' || c == 'm' || c == 'k' || c == 'M' || c == 'G';
+    }
+    static double unitMultiplier(char c) {
+        switch(c) {
+        case 'n': return 1e-9;
+        case 'u': return 1e-6;
+        case 'm': return 1e-3;
+        case 'k': return 1e3;
+        case 'M': return 1e6;
+        case 'G': return 1e9;
+        default: return 1.0;
+        }
+    }
+    static bool isNameChar(char c) {
+        return isalnum(c) || c == '_';
+    }
+    static bool isdigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+    static bool isalpha(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
+    static bool isalnum(char c) {
+        return isdigit(c) || isalpha(c);
+    }
+    bool isVariable(const std::string &name) const {
+        return std::find(variables.begin(), variables.end(), name) != variables.end();
+    }
+    char peek(unsigned int offset = 0) const {
+        return pos + offset < s.size() ? s[pos + offset] : '\0';
+    }
+    bool accept(char c) {
+        if(peek() == c) {
+            pos++;
+            return true;
+        }
+        return false;
+    }
+    void skipSpaces() {
+        // muparserx only skips spaces, anything else (e.g. tabs or comments) is left to muparserx
+        while(peek() == ' ') {
+            pos++;
+        }
+    }
+
+    const std::string &s;
+    unsigned int pos;
+    const std::vector<std::string> &variables;
+};
+
+// Arithmetic on separate real and imaginary parts, written to be vectorized in the block loops. Each function matches
+// the corresponding muparserx operator
+static inline void negate(double ar, double ai, double &re, double &im)
+{
+    // muparserx avoids negative zeros
+    re = ar == 0 ? 0 : -ar;
+    im = ai == 0 ? 0 : -ai;
+}
+
+static inline void add(double ar, double ai, double br, double bi, double &re, double &im)
+{
+    re = ar + br;
+    // adding 0.0 turns -0 into 0 (muparserx adds two real values without an imaginary part)
+    im = ai + bi + 0.0;
+}
+
+static inline void subtract(double ar, double ai, double br, double bi, double &re, double &im)
+{
+    re = ar - br;
+    im = ai - bi + 0.0;
+}
+
+static inline void multiply(double ar, double ai, double br, double bi, double &re, double &im)
+{
+    re = ar * br - ai * bi;
+    im = ar * bi + ai * br;
+}
+
+static inline bool needsComplexMultiply(double re, double im)
+{
+    // std::complex recovers infinities if both parts are NaN
+    return re != re && im != im;
+}
+
+static inline void divide(double ar, double ai, double br, double bi, double &re, double &im)
+{
+    if(ai == 0 && bi == 0) {
+        re = ar / br;
+        im = 0;
+    } else {
+        double n = br * br + bi * bi;
+        re = (ar * br + ai * bi) / n;
+        im = (ai * br - ar * bi) / n;
+    }
+}
+
+static inline double magnitude(double ar, double ai)
+{
+    return sqrt(ar * ar + ai * ai);
+}
+
+static inline bool isInteger(double re, double im)
+{
+    return im == 0 && re >= INT_MIN && re <= INT_MAX && re == (double) (int) re;
+}
+
+CompiledExpression::CompiledExpression()
+    : valid(false),
+      registers(0)
+{
+
+}
+
+bool CompiledExpression::compile(const std::string &expression, const std::vector<std::string> &variables)
+{
+    valid = false;
+    program.clear();
+    registers = 0;
+    usedVariables.assign(variables.size(), false);
+    Parser parser(expression, variables);
+    auto root = parser.parse();
+    if(!root) {
+        return false;
+    }
+    fold(root);
+    generate(*root);
+    valid = true;
+    return true;
+}
+
+bool CompiledExpression::usesVariable(unsigned int index) const
+{
+    return index < usedVariables.size() && usedVariables[index];
+}
+
+void CompiledExpression::evaluate(unsigned int count, const std::vector<const std::complex<double> *> &variables, std::complex<double> *result) const
+{
+    if(!valid || count == 0) {
+        return;
+    }
+    const unsigned int stride = std::min(count, blockSize);
+    const unsigned int blocks = (count + blockSize - 1) / blockSize;
+    Util::parallelFor(blocks, minimumBlocks, [&](unsigned int beginBlock, unsigned int endBlock) {
+        // not initialized, every register is written before it is used
+        std::unique_ptr<double[]> regs(new double[registers * 2 * stride]);
+        for(unsigned int block=beginBlock;block<endBlock;block++) {
+            auto offset = block * blockSize;
+            auto n = std::min(blockSize, count - offset);
+            for(auto &i : program) {
+                execute(i, regs.get(), stride, n, offset, variables);
+            }
+            auto re = regs.get() + program.back().dest * 2 * stride;
+            auto im = re + stride;
+            for(unsigned int k=0;k<n;k++) {
+                result[offset + k] = std::complex<double>(re[k], im[k]);
+            }
+        }
+    });
+}
+
+void CompiledExpression::fold(std::unique_ptr<Node> &node)
+{
+    bool constantArgs = true;
+    for(auto &arg : node->args) {
+        fold(arg);
+        if(arg->op != Op::Constant) {
+            constantArgs = false;
+        }
+    }
+    if(node->op == Op::Constant || node->op == Op::Variable || !constantArgs) {
+        return;
+    }
+    auto a = node->args[0]->value;
+    auto b = node->args.size() > 1 ? node->args[1]->value : 0.0;
+    node->value = calculate(node->op, a, b);
+    node->op = Op::Constant;
+    node->args.clear();
+}
+
+unsigned int CompiledExpression::generate(const Node &node)
+{
+    Instruction i;
+    i.op = node.op;
+    i.a = i.b = 0;
+    i.value = node.value;
+    i.variable = node.variable;
+    if(node.args.size() > 0) {
+        i.a = generate(*node.args[0]);
+    }
+    if(node.args.size() > 1) {
+        i.b = generate(*node.args[1]);
+    }
+    if(node.op == Op::Variable) {
+        usedVariables[node.variable] = true;
+    }
+    i.dest = registers++;
+    program.push_back(i);
+    return i.dest;
+}
+
+void CompiledExpression::execute(const Instruction &i, double *registers, unsigned int stride, unsigned int n, unsigned int offset,
+                                 const std::vector<const std::complex<double> *> &variables)
+{
+    double *re = registers + i.dest * 2 * stride;
+    double *im = re + stride;
+    const double *ar = registers + i.a * 2 * stride;
+    const double *ai = ar + stride;
+    const double *br = registers + i.b * 2 * stride;
+    const double *bi = br + stride;
+    switch(i.op) {
+    case Op::Constant:
+        std::fill(re, re + n, i.value.real());
+        std::fill(im, im + n, i.value.imag());
+        break;
+    case Op::Variable: {
+        auto v = variables[i.variable] + offset;
+        for(unsigned int k=0;k<n;k++) {
+            re[k] = v[k].real();
+            im[k] = v[k].imag();
+        }
+    }
+        break;
+    case Op::Negate:
+        for(unsigned int k=0;k<n;k++) {
+            negate(ar[k], ai[k], re[k], im[k]);
+        }
+        break;
+    case Op::Add:
+        for(unsigned int k=0;k<n;k++) {
+            add(ar[k], ai[k], br[k], bi[k], re[k], im[k]);
+        }
+        break;
+    case Op::Subtract:
+        for(unsigned int k=0;k<n;k++) {
+            subtract(ar[k], ai[k], br[k], bi[k], re[k], im[k]);
+        }
+        break;
+    case Op::Multiply:
+        for(unsigned int k=0;k<n;k++) {
+            multiply(ar[k], ai[k], br[k], bi[k], re[k], im[k]);
+        }
+        for(unsigned int k=0;k<n;k++) {
+            if(needsComplexMultiply(re[k], im[k])) {
+                auto r = std::complex<double>(ar[k], ai[k]) * std::complex<double>(br[k], bi[k]);
+                re[k] = r.real();
+                im[k] = r.imag();
+            }
+        }
+        break;
+    case Op::Divide:
+        for(unsigned int k=0;k<n;k++) {
+            divide(ar[k], ai[k], br[k], bi[k], re[k], im[k]);
+        }
+        break;
+    case Op::Real:
+        for(unsigned int k=0;k<n;k++) {
+            re[k] = ar[k];
+            im[k] = 0;
+        }
+        break;
+    case Op::Imag:
+        for(unsigned int k=0;k<n;k++) {
+            re[k] = ai[k];
+            im[k] = 0;
+        }
+        break;
+    case Op::Conj:
+        for(unsigned int k=0;k<n;k++) {
+            re[k] = ar[k];
+            im[k] = -ai[k];
+        }
+        break;
+    case Op::Abs:
+        for(unsigned int k=0;k<n;k++) {
+            re[k] = magnitude(ar[k], ai[k]);
+            im[k] = 0;
+        }
+        break;
+    default:
+        // no vectorized implementation, evaluate every sample
+        for(unsigned int k=0;k<n;k++) {
+            auto r = calculate(i.op, std::complex<double>(ar[k], ai[k]), std::complex<double>(br[k], bi[k]));
+            re[k] = r.real();
+            im[k] = r.imag();
+        }
+        break;
+    }
+}
+
+std::complex<double> CompiledExpression::calculate(Op op, std::complex<double> a, std::complex<double> b)
+{
+    double re = 0, im = 0;
+    switch(op) {
+    case Op::Constant:
+    case Op::Variable:
+        // not calculated
+        break;
+    case Op::Negate: negate(a.real(), a.imag(), re, im); break;
+    case Op::Add: add(a.real(), a.imag(), b.real(), b.imag(), re, im); break;
+    case Op::Subtract: subtract(a.real(), a.imag(), b.real(), b.imag(), re, im); break;
+    case Op::Multiply:
+        multiply(a.real(), a.imag(), b.real(), b.imag(), re, im);
+        if(needsComplexMultiply(re, im)) {
+            return a * b;
+        }
+        break;
+    case Op::Divide: divide(a.real(), a.imag(), b.real(), b.imag(), re, im); break;
+    case Op::Power:
+        if(a.imag() != 0 || b.imag() != 0 || (a.real() < 0 && !isInteger(b.real(), b.imag()))) {
+            return std::pow(a, b);
+        } else {
+            return std::pow(a.real(), b.real());
+        }
+    case Op::Real: return a.real();
+    case Op::Imag: return a.imag();
+    case Op::Conj: return std::complex<double>(a.real(), -a.imag());
+    case Op::Arg: return std::arg(a);
+    case Op::Norm: return std::norm(a);
+    case Op::Abs: return magnitude(a.real(), a.imag());
+    // the trigonometric functions use the real implementation for values without an imaginary part
+    case Op::Sin: return a.imag() == 0 ? std::complex<double>(std::sin(a.real())) : std::sin(a);
+    case Op::Cos: return a.imag() == 0 ? std::complex<double>(std::cos(a.real())) : std::cos(a);
+    case Op::Tan: return a.imag() == 0 ? std::complex<double>(std::tan(a.real())) : std::tan(a);
+    case Op::Sinh: return std::sinh(a);
+    case Op::Cosh: return std::cosh(a);
+    case Op::Tanh: return std::tanh(a);
+    case Op::Sqrt: return std::sqrt(a);
+    case Op::Exp: return std::exp(a);
+    case Op::Ln: return std::log(a);
+    case Op::Log2: return std::log(a) * 1.0 / std::log(2.0);
+    case Op::Log10: return std::log10(a);
+    case Op::PowFunction: return std::pow(a, b);
+    }
+    return {re, im};
+}
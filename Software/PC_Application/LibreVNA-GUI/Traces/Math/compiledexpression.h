@@ -0,0 +1,115 @@
+#ifndef COMPILEDEXPRESSION_H
+#define COMPILEDEXPRESSION_H
+
+#include <complex>
+#include <vector>
+#include <string>
+#include <memory>
+
+namespace Math {
+
+/**
+ * @brief Math expression compiled into a program which is evaluated for whole blocks of samples
+ *
+ * Supports the part of the muparserx syntax that is commonly used for trace math:
+ * - numbers (also imaginary numbers like "2i") with an optional unit postfix (n, u, m, k, M, G)
+ * - variables and the constants pi, e and i
+ * - the operators +, -, *, /, ^ and the negative sign
+ * - the functions of the muparserx complex package (real, imag, conj, arg, norm, abs, sin, cos, tan, sinh, cosh, tanh,
+ *   sqrt, exp, ln, log, log2, log10 and pow)
+ *
+ * The results are the same as when evaluating the expression sample by sample with muparserx (using the packages
+ * pckCOMMON | pckUNIT | pckCOMPLEX). compile() rejects everything else, these expressions have to be evaluated with
+ * muparserx, which also provides the error messages for invalid expressions.
+ *
+ * The program operates on blocks of samples stored as separate arrays for the real and imaginary part. The basic
+ * arithmetic operations are plain loops over these arrays which the compiler vectorizes. Large sample counts are split
+ * and evaluated in parallel.
+ */
+class CompiledExpression
+{
+public:
+    CompiledExpression();
+
+    // Compiles the expression. Variables are referenced by their index in variables. Returns false if the expression
+    // contains anything that is not supported
+    bool compile(const std::string &expression, const std::vector<std::string> &variables);
+    bool isValid() const {return valid;}
+    // Returns true if the compiled expression uses the variable (index in the variables passed to compile())
+    bool usesVariable(unsigned int index) const;
+
+    // Evaluates the expression for count samples. variables[i] points to count values of the i-th variable, it may be
+    // nullptr if the variable is not used
+    void evaluate(unsigned int count, const std::vector<const std::complex<double>*> &variables, std::complex<double> *result) const;
+
+private:
+    enum class Op {
+        Constant,
+        Variable,
+        Negate,
+        Add,
+        Subtract,
+        Multiply,
+        Divide,
+        Power,
+        Real,
+        Imag,
+        Conj,
+        Arg,
+        Norm,
+        Abs,
+        Sin,
+        Cos,
+        Tan,
+        Sinh,
+        Cosh,
+        Tanh,
+        Sqrt,
+        Exp,
+        Ln,
+        Log2,
+        Log10,
+        PowFunction,
+    };
+
+    // parsed expression tree
+    class Node {
+    public:
+        Node() : op(Op::Constant), value(0.0), variable(0) {}
+        Op op;
+        std::complex<double> value; // only used for Op::Constant
+        unsigned int variable; // only used for Op::Variable
+        std::vector<std::unique_ptr<Node>> args;
+    };
+    class Parser;
+
+    // Instruction of the program, calculates register dest from registers a and b
+    class Instruction {
+    public:
+        Op op;
+        unsigned int dest, a, b;
+        std::complex<double> value;
+        unsigned int variable;
+    };
+
+    // Evaluates constant subtrees
+    static void fold(std::unique_ptr<Node> &node);
+    unsigned int generate(const Node &node);
+
+    // Samples are evaluated in blocks of up to blockSize samples. Each register holds stride real parts followed by stride
+    // imaginary parts
+    static constexpr unsigned int blockSize = 256;
+    static void execute(const Instruction &i, double *registers, unsigned int stride, unsigned int n, unsigned int offset,
+                        const std::vector<const std::complex<double>*> &variables);
+    // Evaluates an operation for a single sample (b is ignored for operations with only one argument)
+    static std::complex<double> calculate(Op op, std::complex<double> a, std::complex<double> b);
+
+    bool valid;
+    std::vector<Instruction> program;
+    unsigned int registers;
+    std::vector<bool> usedVariables;
+};
+
+}
+
+#endif // COMPILEDEXPRESSION_H
@@ -22,6 +22,7 @@ Math::DFT::DFT()
     DCfreq = 1000000000.0;
 
     destructing = false;
+    configurationChanged = false;
     thread = new DFTThread(*this);
     thread->start(TDRThread::Priority::LowestPriority);
 
@@ -71,10 +72,12 @@ void Math::DFT::edit()
 
     connect(ui->removePadding, &QCheckBox::toggled, this, [=](bool remove){
         removePaddingFromTDR = remove;
+        updateDFT();
     });
 
     connect(ui->revertWindow, &QCheckBox::toggled, this, [=](bool revert){
         revertWindowFromTDR = revert;
+        updateDFT();
     });
 
     connect(ui->DCautomatic, &QRadioButton::toggled, this, [=](bool automatic){
@@ -141,13 +144,14 @@ void Math::DFT::fromJSON(nlohmann::json j)
     }
     removePaddingFromTDR = j.value("removePadding", true);
     revertWindowFromTDR = j.value("revertWindow", true);
+    configurationChanged = true;
 }
 
 void Math::DFT::inputSamplesChanged(unsigned int begin, unsigned int end)
 {
     Q_UNUSED(begin);
     Q_UNUSED(end);
-    if(input->getData().size() < 2) {
+    if(input->numSamples() < 2) {
         // not enough input data
         clearOutput();
         warning("Not enough input samples");
@@ -160,11 +164,18 @@ void Math::DFT::inputSamplesChanged(unsigned int begin, unsigned int end)
 
 void Math::DFT::updateDFT()
 {
+    configurationChanged = true;
     if(dataType != DataType::Invalid) {
-        inputSamplesChanged(0, input->getData().size());
+        inputSamplesChanged(0, input->numSamples());
     }
 }
 
+void Math::DFT::inputReset()
+{
+    // the output has been cleared, calculate again even if the input data is unchanged
+    configurationChanged = true;
+}
+
 void Math::DFT::clearOutput()
 {
     dataMutex.lock();
@@ -184,6 +195,8 @@ void Math::DFTThread::run()
     qDebug() << "DFT thread starting";
     using namespace std::chrono;
     auto lastCalc = system_clock::now();
+    TraceMath *lastInput = nullptr;
+    unsigned long lastInputVersion = 0;
     while(1) {
         dft.semphr.acquire();
         // clear possible additional semaphores
@@ -198,6 +211,14 @@ void Math::DFTThread::run()
             // not connected, skip calculation
             continue;
         }
+        // skip the calculation if neither the input data nor the configuration changed since the last calculation
+        auto inputVersion = dft.input->getDataVersion();
+        bool configurationChanged = dft.configurationChanged.exchange(false);
+        if(dft.input == lastInput && inputVersion == lastInputVersion && !configurationChanged) {
+            continue;
+        }
+        lastInput = dft.input;
+        lastInputVersion = inputVersion;
         auto inputData = dft.input->getData();
         if(!inputData.size()) {
             dft.clearOutput();
@@ -46,6 +46,7 @@ public slots:
 private:
     void updateDFT();
     void clearOutput();
+    void inputReset() override;
     bool automaticDC;
     double DCfreq;
     WindowFunction window;
@@ -54,6 +55,8 @@ private:
     DFTThread *thread;
     bool destructing;
     QSemaphore semphr;
+    // set when a setting changed which requires a new calculation even if the input data is the same
+    std::atomic<bool> configurationChanged;
 };
 
 }
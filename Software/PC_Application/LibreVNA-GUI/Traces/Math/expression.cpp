@@ -85,34 +85,43 @@ void Math::Expression::fromJSON(nlohmann::json j)
 
 void Math::Expression::inputSamplesChanged(unsigned int begin, unsigned int end)
 {
-    std::vector<Data> in;
-    if(input) {
-        in = input->getData();
+    if(!input) {
+        return;
     }
-    dataMutex.lock();
-    data.resize(in.size());
-    try {
-        for(unsigned int i=begin;i<end;i++) {
-            t = in[i].x;
-            f = in[i].x;
-            P = in[i].x;
-            w = in[i].x * 2 * M_PI;
-            d = root()->timeToDistance(t);
-            x = in[i].y;
-            Value res = parser->Eval();
-            data[i].x = in[i].x;
-            data[i].y = res.GetComplex();
+    {
+        // release the input before notifying the next operations
+        auto in = input->getDataView();
+        dataMutex.lock();
+        data.resize(in.size());
+        if(compiled.isValid()) {
+            evaluateCompiled(in, begin, end);
+            success();
+        } else {
+            try {
+                for(unsigned int i=begin;i<end;i++) {
+                    t = in[i].x;
+                    f = in[i].x;
+                    P = in[i].x;
+                    w = in[i].x * 2 * M_PI;
+                    d = root()->timeToDistance(t);
+                    x = in[i].y;
+                    Value res = parser->Eval();
+                    data[i].x = in[i].x;
+                    data[i].y = res.GetComplex();
+                }
+                success();
+            } catch (const ParserError &e) {
+                error(QString::fromStdString(e.GetMsg()));
+            }
         }
-        success();
-    } catch (const ParserError &e) {
-        error(QString::fromStdString(e.GetMsg()));
+        dataMutex.unlock();
     }
-    dataMutex.unlock();
     emit outputSamplesChanged(begin, end);
 }
 
 void Math::Expression::expressionChanged()
 {
+    compiled = CompiledExpression();
     if(exp.isEmpty()) {
         error("Empty expression");
         return;
@@ -141,7 +150,60 @@ void Math::Expression::expressionChanged()
     default:
         break;
     }
+    // same variables as defined for the parser
+    compiledVariables = {"x"};
+    switch(dataType) {
+    case DataType::Time: compiledVariables.insert(compiledVariables.end(), {"t", "d"}); break;
+    case DataType::Frequency: compiledVariables.insert(compiledVariables.end(), {"f", "w"}); break;
+    case DataType::Power: compiledVariables.push_back("P"); break;
+    case DataType::TimeZeroSpan: compiledVariables.push_back("t"); break;
+    default: break;
+    }
+    compiled.compile(exp.toStdString(), compiledVariables);
     if(input) {
-        inputSamplesChanged(0, input->getData().size());
+        inputSamplesChanged(0, input->numSamples());
+    }
+}
+
+void Math::Expression::evaluateCompiled(const DataView &in, unsigned int begin, unsigned int end)
+{
+    if(end <= begin) {
+        return;
+    }
+    auto count = end - begin;
+    vector<vector<complex<double>>> values(compiledVariables.size());
+    vector<const complex<double>*> pointers(compiledVariables.size(), nullptr);
+    for(unsigned int v=0;v<compiledVariables.size();v++) {
+        if(!compiled.usesVariable(v)) {
+            continue;
+        }
+        auto &name = compiledVariables[v];
+        auto &value = values[v];
+        value.resize(count);
+        if(name == "x") {
+            for(unsigned int i=0;i<count;i++) {
+                value[i] = in[begin + i].y;
+            }
+        } else if(name == "w") {
+            for(unsigned int i=0;i<count;i++) {
+                value[i] = in[begin + i].x * 2 * M_PI;
+            }
+        } else if(name == "d") {
+            for(unsigned int i=0;i<count;i++) {
+                value[i] = root()->timeToDistance(in[begin + i].x);
+            }
+        } else {
+            // t, f and P are the x coordinate
+            for(unsigned int i=0;i<count;i++) {
+                value[i] = in[begin + i].x;
+            }
+        }
+        pointers[v] = value.data();
+    }
+    vector<complex<double>> result(count);
+    compiled.evaluate(count, pointers, result.data());
+    for(unsigned int i=0;i<count;i++) {
+        data[begin + i].x = in[begin + i].x;
+        data[begin + i].y = result[i];
     }
 }
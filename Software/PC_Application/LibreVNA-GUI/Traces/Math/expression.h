@@ -2,6 +2,7 @@
 #define EXPRESSION_H
 
 #include "tracemath.h"
+#include "compiledexpression.h"
 #include "parser/mpParser.h"
 
 namespace Math {
@@ -28,9 +29,13 @@ public slots:
 private slots:
     void expressionChanged();
 private:
+    void evaluateCompiled(const DataView &in, unsigned int begin, unsigned int end);
     QString exp;
     mup::ParserX *parser;
     mup::Value t, d, f, w, x, P;
+    // used instead of the parser if the expression can be compiled
+    CompiledExpression compiled;
+    std::vector<std::string> compiledVariables;
 };
 
 }
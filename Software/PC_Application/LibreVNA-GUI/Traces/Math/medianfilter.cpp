@@ -3,15 +3,40 @@
 #include "ui_medianfilterdialog.h"
 #include "ui_medianexplanationwidget.h"
 #include "CustomWidgets/informationbox.h"
+#include "Util/util.h"
 #include "appwindow.h"
 
+#include <set>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <QDebug>
+
 using namespace Math;
 using namespace std;
 
+// Ranges are only split across threads if every thread gets at least this number of samples
+static constexpr unsigned int minimumChunk = 1024;
+
 MedianFilter::MedianFilter()
 {
     kernelSize = 3;
     order = Order::AbsoluteValue;
+
+    destructing = false;
+    pendingRecalculations = 0;
+    thread = new MedianFilterThread(*this);
+    thread->start(MedianFilterThread::Priority::LowestPriority);
+}
+
+MedianFilter::~MedianFilter()
+{
+    // tell thread to exit
+    destructing = true;
+    semphr.release();
+    thread->wait();
+    delete thread;
 }
 
 TraceMath::DataType MedianFilter::outputType(TraceMath::DataType inputType)
@@ -43,10 +68,12 @@ void MedianFilter::edit()
         }
         ui->kernelSize->setValue(newval);
         kernelSize = newval;
+        updateFilter();
     });
 
     connect(ui->sortingMethod, qOverload<int>(&QComboBox::currentIndexChanged), [=](int index) {
         order = (Order) index;
+        updateFilter();
     });
     if(AppWindow::showGUI()) {
         d->show();
@@ -79,78 +106,40 @@ void MedianFilter::fromJSON(nlohmann::json j)
 }
 
 void MedianFilter::inputSamplesChanged(unsigned int begin, unsigned int end) {
-    std::vector<Data> inputData;
-    if(input) {
-        inputData = input->getData();
+    if(!input) {
+        return;
     }
-    if(data.size() != inputData.size()) {
-        dataMutex.lock();
-        data.resize(inputData.size());
-        dataMutex.unlock();
+    if(pendingRecalculations > 0 || (begin == 0 && end > 0 && end >= input->numSamples())) {
+        // all samples changed (or a recalculation is already pending which will include the changed samples as well)
+        updateFilter();
+        return;
     }
-    if(data.size() > 0) {
-        auto kernelOffset = (kernelSize-1)/2;
-        int start = (int) begin - (int) kernelOffset;
-        unsigned int stop = end + kernelOffset;
-        if(start < 0) {
-            start = 0;
-        }
-        if(stop > inputData.size()) {
-            stop = inputData.size();
+    int start = 0;
+    unsigned int stop = 0;
+    {
+        // the input is released before notifying the next operations
+        auto inputData = input->getDataView();
+        if(data.size() != inputData.size()) {
+            dataMutex.lock();
+            data.resize(inputData.size());
+            dataMutex.unlock();
         }
-
-        auto comp = [=](const complex<double>&a, const complex<double>&b){
-           switch(order) {
-           case Order::AbsoluteValue: return abs(a) < abs(b);
-           case Order::Phase: return arg(a) < arg(b);
-           case Order::Real: return real(a) < real(b);
-           case Order::Imag: return imag(a) < imag(b);
-           default: return false;
-           }
-        };
-
-        vector<complex<double>> kernel(kernelSize);
-        dataMutex.lock();
-        for(unsigned int out=start;out<stop;out++) {
-            if(out == (unsigned int) start) {
-                // this is the first sample to update, fill initial kernel
-                for(unsigned int in=0;in<kernelSize;in++) {
-                    unsigned int inputSample;
-                    if(kernelOffset > in + out) {
-                        inputSample = 0;
-                    } else if(in + out >= inputData.size() + kernelOffset) {
-                        inputSample = inputData.size() - 1;
-                    } else {
-                        inputSample = in + out - kernelOffset;
-                    }
-                    auto sample = inputData.at(inputSample).y;
-                    kernel[in] = sample;
-                }
-                // sort initial kernel
-                sort(kernel.begin(), kernel.end(), comp);
-            } else {
-                // kernel already filled and sorted from last output sample. Only remove the one input sample that
-                // is no longer needed for this output and add the one additional input sample
-                int toRemove = out - kernelOffset - 1;
-                unsigned int toAdd = out + kernelOffset;
-                if(toRemove < 0) {
-                    toRemove = 0;
-                }
-                if(toAdd >= inputData.size()) {
-                    toAdd = inputData.size() - 1;
-                }
-                auto sampleToRemove = inputData.at(toRemove).y;
-                auto remove_iterator = lower_bound(kernel.begin(), kernel.end(), sampleToRemove, comp);
-                kernel.erase(remove_iterator);
-
-                auto sampleToAdd = inputData.at(toAdd).y;
-                // insert sample at correct position in vector
-                kernel.insert(upper_bound(kernel.begin(), kernel.end(), sampleToAdd, comp), sampleToAdd);
+        if(data.size() > 0) {
+            auto kernelOffset = (kernelSize-1)/2;
+            start = (int) begin - (int) kernelOffset;
+            stop = end + kernelOffset;
+            if(start < 0) {
+                start = 0;
+            }
+            if(stop > inputData.size()) {
+                stop = inputData.size();
             }
-            data.at(out).y = kernel[kernelOffset];
-            data.at(out).x = inputData.at(out).x;
+            dataMutex.lock();
+            filter(&inputData[0], inputData.size(), data.data(), start, stop, kernelSize, order);
+            dataMutex.unlock();
         }
-        dataMutex.unlock();
+    }
+    if(data.size() > 0) {
         emit outputSamplesChanged(start, stop);
         success();
     } else {
@@ -158,6 +147,158 @@ void MedianFilter::inputSamplesChanged(unsigned int begin, unsigned int end) {
     }
 }
 
+void MedianFilter::updateFilter()
+{
+    pendingRecalculations++;
+    semphr.release();
+}
+
+namespace {
+
+// Position of an input sample in the kernel. The position is used to order samples with the same key and may be outside of
+// the input data at the edges
+class Entry {
+public:
+    bool operator<(const Entry &o) const {
+        return key < o.key || (key == o.key && position < o.position);
+    }
+    double key;
+    int position;
+};
+
+// Sliding window which keeps the kernel split into the lower samples (up to and including the selected rank) and the
+// upper samples. Replacing a sample takes O(log k) and does not allocate memory once the window is filled
+class SlidingWindow {
+public:
+    SlidingWindow(unsigned int rank) : lowerSize(rank + 1) {}
+
+    void insert(const Entry &e) {
+        insertNode(std::set<Entry>::node_type(), e);
+    }
+    // removes the sample old and inserts the sample e
+    void replace(const Entry &old, const Entry &e) {
+        auto node = lower.extract(old);
+        if(node.empty()) {
+            node = upper.extract(old);
+        }
+        insertNode(std::move(node), e);
+    }
+    const Entry& selected() const {
+        return *lower.rbegin();
+    }
+private:
+    void insertNode(std::set<Entry>::node_type node, const Entry &e) {
+        auto &target = lower.empty() || e < *lower.rbegin() ? lower : upper;
+        if(node.empty()) {
+            target.insert(e);
+        } else {
+            node.value() = e;
+            target.insert(std::move(node));
+        }
+        // move samples between the halves until the lower half ends at the selected rank
+        while(lower.size() > lowerSize) {
+            upper.insert(lower.extract(std::prev(lower.end())));
+        }
+        while(lower.size() < lowerSize && !upper.empty()) {
+            lower.insert(upper.extract(upper.begin()));
+        }
+    }
+    unsigned int lowerSize;
+    std::set<Entry> lower, upper;
+};
+
+}
+
+void MedianFilter::filter(const Data *input, unsigned int size, Data *output, unsigned int begin, unsigned int end,
+                          unsigned int kernelSize, Order order)
+{
+    if(size == 0 || begin >= end) {
+        return;
+    }
+    kernelSize = std::max(kernelSize, 1U);
+    const int kernelOffset = (kernelSize-1)/2;
+    auto sample = [=](int position) -> const Data& {
+        return input[std::clamp(position, 0, (int) size - 1)];
+    };
+    auto entry = [=](int position) -> Entry {
+        auto y = sample(position).y;
+        double key;
+        switch(order) {
+        case Order::AbsoluteValue: key = abs(y); break;
+        case Order::Phase: key = arg(y); break;
+        case Order::Real: key = real(y); break;
+        case Order::Imag: key = imag(y); break;
+        default: key = 0.0; break;
+        }
+        if(std::isnan(key)) {
+            // NaN would break the ordering, sort it behind all other values
+            key = std::numeric_limits<double>::infinity();
+        }
+        return {key, position};
+    };
+    // each range starts with a full sort of its kernel, keep the ranges large compared to the kernel
+    Util::parallelFor(end - begin, std::max(minimumChunk, 4 * kernelSize), [&](unsigned int rangeBegin, unsigned int rangeEnd) {
+        SlidingWindow window(kernelOffset);
+        // the kernel of output sample out covers the positions [out - kernelOffset, out - kernelOffset + kernelSize)
+        int first = (int) (begin + rangeBegin) - kernelOffset;
+        for(unsigned int i=0;i<kernelSize;i++) {
+            window.insert(entry(first + i));
+        }
+        for(unsigned int out=begin+rangeBegin;out<begin+rangeEnd;out++) {
+            if(out > begin + rangeBegin) {
+                // only one sample leaves and one sample enters the kernel
+                int position = (int) out - kernelOffset;
+                window.replace(entry(position - 1), entry(position + kernelSize - 1));
+            }
+            output[out].y = sample(window.selected().position).y;
+            output[out].x = input[out].x;
+        }
+    });
+}
+
+MedianFilterThread::MedianFilterThread(MedianFilter &filter)
+    : filter(filter)
+{
+
+}
+
+void MedianFilterThread::run()
+{
+    qDebug() << "Median filter thread starting";
+    while(1) {
+        filter.semphr.acquire();
+        // clear possible additional semaphores
+        filter.semphr.tryAcquire(filter.semphr.available());
+        if(filter.destructing) {
+            // filter object about to be deleted, exit thread
+            qDebug() << "Median filter thread exiting";
+            return;
+        }
+        // all requests up to now are handled by this calculation
+        auto handled = filter.pendingRecalculations.load();
+        if(!filter.input) {
+            // not connected, skip calculation
+            filter.pendingRecalculations -= handled;
+            continue;
+        }
+        // copy the input to keep it available for new samples during the calculation
+        auto inputData = filter.input->getData();
+        vector<TraceMath::Data> output(inputData.size());
+        MedianFilter::filter(inputData.data(), inputData.size(), output.data(), 0, inputData.size(), filter.kernelSize, filter.order);
+
+        filter.dataMutex.lock();
+        filter.data.swap(output);
+        filter.dataMutex.unlock();
+        filter.pendingRecalculations -= handled;
+        if(inputData.size() > 0) {
+            emit filter.outputSamplesChanged(0, inputData.size());
+            filter.success();
+        } else {
+            filter.warning("No input data");
+        }
+    }
+}
+
 QString MedianFilter::orderToString(MedianFilter::Order o)
 {
     switch(o) {
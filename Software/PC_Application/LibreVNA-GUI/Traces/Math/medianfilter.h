@@ -3,12 +3,30 @@
 
 #include "tracemath.h"
 
+#include <QThread>
+#include <QSemaphore>
+
 namespace Math {
 
+class MedianFilter;
+
+class MedianFilterThread : public QThread
+{
+    Q_OBJECT
+public:
+    MedianFilterThread(MedianFilter &filter);
+    ~MedianFilterThread(){}
+private:
+    void run() override;
+    MedianFilter &filter;
+};
+
 class MedianFilter : public TraceMath
 {
+    friend class MedianFilterThread;
 public:
     MedianFilter();
+    ~MedianFilter();
 
     virtual DataType outputType(DataType inputType) override;
     virtual QString description() override;
@@ -21,19 +39,34 @@ public:
     virtual void fromJSON(nlohmann::json j) override;
     Type getType() override {return Type::MedianFilter;};
 
+    enum class Order {
+        AbsoluteValue = 0,
+        Phase = 1,
+        Real = 2,
+        Imag = 3,
+    };
+
+    // Calculates the output samples [begin, end) for the given input. Kernel positions outside of the input use the first/last
+    // input sample. Uses a sliding window with O(log kernelSize) updates, large ranges are split and calculated in parallel
+    static void filter(const Data *input, unsigned int size, Data *output, unsigned int begin, unsigned int end,
+                       unsigned int kernelSize, Order order);
+
 public slots:
     // a single value of the input data has changed, index determines which sample has changed
     virtual void inputSamplesChanged(unsigned int begin, unsigned int end) override;
 
 private:
+    // starts a recalculation of all samples in the background
+    void updateFilter();
     unsigned int kernelSize;
-    enum class Order {
-        AbsoluteValue = 0,
-        Phase = 1,
-        Real = 2,
-        Imag = 3,
-    } order;
+    Order order;
     static QString orderToString(Order o);
+    MedianFilterThread *thread;
+    bool destructing;
+    QSemaphore semphr;
+    // number of requested background recalculations which have not finished yet. Partial updates are calculated directly
+    // while this is zero, otherwise they are included in the next background recalculation
+    std::atomic<unsigned int> pendingRecalculations;
 };
 
 }
@@ -25,6 +25,7 @@ TDR::TDR()
     padding = 0;
 
     destructing = false;
+    configurationChanged = false;
     thread = new TDRThread(*this);
     thread->start(TDRThread::Priority::LowestPriority);
 
@@ -95,6 +96,7 @@ void TDR::edit()
 
     connect(ui->padding, &QSpinBox::valueChanged, this, [=](int value) {
         padding = value;
+        updateTDR();
     });
 
     connect(ui->computeStepResponse, &QCheckBox::toggled, this, [=](bool computeStep) {
@@ -195,6 +197,7 @@ void TDR::fromJSON(nlohmann::json j)
             stepResponse = false;
         }
     }
+    configurationChanged = true;
 }
 
 void TDR::setMode(Mode m)
@@ -204,8 +207,9 @@ void TDR::setMode(Mode m)
         return;
     }
     mode = m;
+    configurationChanged = true;
     if(input) {
-        inputSamplesChanged(0, input->getData().size());
+        inputSamplesChanged(0, input->numSamples());
     }
 }
 
@@ -213,7 +217,7 @@ void TDR::inputSamplesChanged(unsigned int begin, unsigned int end)
 {
     Q_UNUSED(begin);
     Q_UNUSED(end);
-    if(input->getData().size() >= 2) {
+    if(input->numSamples() >= 2) {
         // trigger calculation in thread
         semphr.release();
         success();
@@ -226,11 +230,18 @@ void TDR::inputSamplesChanged(unsigned int begin, unsigned int end)
 
 void TDR::updateTDR()
 {
+    configurationChanged = true;
     if(dataType != DataType::Invalid) {
-        inputSamplesChanged(0, input->getData().size());
+        inputSamplesChanged(0, input->numSamples());
     }
 }
 
+void TDR::inputReset()
+{
+    // the output has been cleared, calculate again even if the input data is unchanged
+    configurationChanged = true;
+}
+
 void TDR::clearOutput()
 {
     dataMutex.lock();
@@ -266,6 +277,8 @@ void TDRThread::run()
     qDebug() << "TDR thread starting";
     using namespace std::chrono;
     auto lastCalc = system_clock::now();
+    TraceMath *lastInput = nullptr;
+    unsigned long lastInputVersion = 0;
     while(1) {
         tdr.semphr.acquire();
         // clear possible additional semaphores
@@ -281,6 +294,14 @@ void TDRThread::run()
             // not connected, skip calculation
             continue;
         }
+        // skip the calculation if neither the input data nor the configuration changed since the last calculation
+        auto inputVersion = tdr.input->getDataVersion();
+        bool configurationChanged = tdr.configurationChanged.exchange(false);
+        if(tdr.input == lastInput && inputVersion == lastInputVersion && !configurationChanged) {
+            continue;
+        }
+        lastInput = tdr.input;
+        lastInputVersion = inputVersion;
         auto inputData = tdr.input->getData();
         if(!inputData.size()) {
             // empty input data, clear output data
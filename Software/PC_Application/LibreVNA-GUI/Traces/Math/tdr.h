@@ -56,6 +56,7 @@ public slots:
 private:
     void updateTDR();
     void clearOutput();
+    void inputReset() override;
     Mode mode;
     WindowFunction window;
     unsigned int padding;
@@ -66,6 +67,8 @@ private:
     TDRThread *thread;
     bool destructing;
     QSemaphore semphr;
+    // set when a setting changed which requires a new calculation even if the input data is the same
+    std::atomic<bool> configurationChanged;
 };
 
 }
@@ -218,24 +218,25 @@ double Math::TimeGate::getStop()
 
 void Math::TimeGate::inputSamplesChanged(unsigned int begin, unsigned int end)
 {
-    std::vector<Data> inputData;
-    if(input) {
-        inputData = input->getData();
-    }
-    if(data.size() != inputData.size()) {
+    unsigned int inputSize = input ? input->numSamples() : 0;
+    if(data.size() != inputSize) {
+        // the filter reads the input, it has to be updated before a view of the input is taken
         dataMutex.lock();
-        data.resize(inputData.size());
+        data.resize(inputSize);
         dataMutex.unlock();
         updateFilter();
     }
-    dataMutex.lock();
-    for(auto i = begin;i<end;i++) {
-        data[i] = inputData[i];
-        data[i].y *= filter[i];
+    if(input) {
+        auto inputData = input->getDataView();
+        dataMutex.lock();
+        for(auto i = begin;i<end && i<inputData.size() && i<filter.size();i++) {
+            data[i] = inputData[i];
+            data[i].y *= filter[i];
+        }
+        dataMutex.unlock();
     }
-    dataMutex.unlock();
     emit outputSamplesChanged(begin, end);
-    if(inputData.size() > 0) {
+    if(inputSize > 0) {
         success();
     } else {
         warning("No input data");
@@ -247,15 +248,22 @@ void Math::TimeGate::updateFilter()
     if(!input) {
         return;
     }
-    auto inputData = input->getData();
+    unsigned int inputSize;
+    double minX, maxX;
+    {
+        auto inputData = input->getDataView();
+        inputSize = inputData.size();
+        if(inputSize > 0) {
+            minX = inputData.front().x;
+            maxX = inputData.back().x;
+        }
+    }
     std::vector<std::complex<double>> buf;
     filter.clear();
-    buf.resize(inputData.size() * 2);
+    buf.resize(inputSize * 2);
     if(!buf.size()) {
         return;
     }
-    auto maxX = inputData.back().x;
-    auto minX = inputData.front().x;
 
     auto wc1 = Util::Scale<double>(center - span / 2, minX, maxX, 0, 1);
     auto wc2 = Util::Scale<double>(center + span / 2, minX, maxX, 0, 1);
@@ -288,7 +296,7 @@ void Math::TimeGate::updateFilter()
     emit filterUpdated();
 
     // needs to update output samples, pretend that input samples have changed
-    inputSamplesChanged(0, inputData.size());
+    inputSamplesChanged(0, inputSize);
 }
 
 Math::TimeGateGraph::TimeGateGraph(QWidget *parent)
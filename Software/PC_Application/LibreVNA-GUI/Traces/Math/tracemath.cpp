@@ -11,10 +11,14 @@
 #include <QMutexLocker>
 
 TraceMath::TraceMath()
+    : dataVersion(0)
 {
     input = nullptr;
     dataType = DataType::Invalid;
     error("Invalid input");
+    connect(this, &TraceMath::outputSamplesChanged, [=](){
+        dataVersion++;
+    });
 }
 
 std::vector<TraceMath *> TraceMath::createMath(TraceMath::Type type)
@@ -209,6 +213,7 @@ void TraceMath::removeInput()
         dataMutex.lock();
         data.clear();
         dataMutex.unlock();
+        inputReset();
         dataType = DataType::Invalid;
         emit outputTypeChanged(dataType);
     }
@@ -232,6 +237,7 @@ void TraceMath::inputTypeChanged(TraceMath::DataType type)
     dataMutex.lock();
     data.clear();
     dataMutex.unlock();
+    inputReset();
     if(dataType == DataType::Invalid) {
         error("Invalid input data");
         disconnect(input, &TraceMath::outputSamplesChanged, this, &TraceMath::inputSamplesChanged);
@@ -324,3 +330,13 @@ std::vector<TraceMath::Data> TraceMath::getData()
     dataMutex.unlock();
     return ret;
 }
+
+TraceMath::DataView TraceMath::getDataView()
+{
+    return DataView(dataMutex, data, dataVersion);
+}
+
+unsigned long TraceMath::getDataVersion() const
+{
+    return dataVersion;
+}
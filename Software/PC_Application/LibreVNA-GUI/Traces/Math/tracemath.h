@@ -7,6 +7,8 @@
 #include <QMutex>
 #include <vector>
 #include <complex>
+#include <mutex>
+#include <atomic>
 /*
  * How to implement a new type of math operation:
  * 1. Create your new math operation class by deriving from this class. Put the new class in the namespace
@@ -110,8 +112,40 @@ public:
     void removeInput();
     void assignInput(TraceMath *input);
 
+    /**
+     * @brief Read-only access to the output data without copying it
+     *
+     * The view keeps the data mutex of the math operation locked for its lifetime. Keep it short-lived, do not call
+     * functions which modify the data of the same math operation or create another view of it while the view exists.
+     * Use getData() instead if the data is needed for longer (e.g. in a worker thread).
+     */
+    class DataView {
+    public:
+        DataView(QMutex &mutex, const std::vector<Data> &data, unsigned long version)
+            : lock(mutex), data(data), _version(version) {}
+
+        std::vector<Data>::const_iterator begin() const {return data.begin();}
+        std::vector<Data>::const_iterator end() const {return data.end();}
+        unsigned int size() const {return data.size();}
+        bool empty() const {return data.empty();}
+        const Data& operator[](unsigned int index) const {return data[index];}
+        const Data& at(unsigned int index) const {return data.at(index);}
+        const Data& front() const {return data.front();}
+        const Data& back() const {return data.back();}
+        // see getDataVersion()
+        unsigned long version() const {return _version;}
+    private:
+        std::unique_lock<QMutex> lock;
+        const std::vector<Data> &data;
+        unsigned long _version;
+    };
+
     DataType getDataType() const;
+    // Returns a copy of the output data
     virtual std::vector<Data> getData();
+    virtual DataView getDataView();
+    // Incremented whenever outputSamplesChanged is emitted. Consumers can compare it with a stored value to detect changed data
+    unsigned long getDataVersion() const;
     Status getStatus() const;
     QString getStatusDescription() const;
     virtual Type getType() = 0;
@@ -142,11 +176,15 @@ protected:
     void success();
     QMutex dataMutex;
     std::vector<Data> data;
+    std::atomic<unsigned long> dataVersion;
     // buffer for time domain step response data. This makes it possible to access an arbitrary sample of the step response without having to
     // integrate the impulse response every time. Call updateStepResponse in your derived class, if step response data is valid after updating
     // data.
     std::vector<double> stepResponse;
     void updateStepResponse(bool valid);
+    // called after the output data has been cleared because the input or its data type changed. Derived classes that skip the
+    // calculation for unchanged input data have to calculate again on the next update
+    virtual void inputReset(){}
     TraceMath *input;
     DataType dataType;
 
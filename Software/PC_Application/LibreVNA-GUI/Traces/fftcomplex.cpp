@@ -29,6 +29,8 @@
 #include <stdexcept>
 #include <utility>
 #include <algorithm>
+#include <list>
+#include <mutex>
 
 using std::complex;
 using std::size_t;
@@ -40,90 +42,215 @@ using std::vector;
 static size_t reverseBits(size_t val, int width);
 
 
+// Maximum number of plans kept in the cache
+static constexpr size_t maxCachedPlans = 16;
+
+
 void Fft::transform(vector<complex<double> > &vec, bool inverse) {
     size_t n = vec.size();
     if (n == 0)
         return;
-    else if ((n & (n - 1)) == 0)  // Is power of 2
-        transformRadix2(vec, inverse);
-    else  // More complicated algorithm for arbitrary sizes
-        transformBluestein(vec, inverse);
+    plan(n, inverse)->execute(vec);
 }
 
 
 void Fft::transformRadix2(vector<complex<double> > &vec, bool inverse) {
-    // Length variables
     size_t n = vec.size();
-    int levels = 0;  // Compute levels = floor(log2(n))
-    for (size_t temp = n; temp > 1U; temp >>= 1)
-        levels++;
-    if (static_cast<size_t>(1U) << levels != n)
+    if ((n & (n - 1)) != 0)
         throw std::domain_error("Length is not a power of 2");
+    transform(vec, inverse);
+}
 
-    // Trigonometric table
-    vector<complex<double> > expTable(n / 2);
-    for (size_t i = 0; i < n / 2; i++)
-        expTable[i] = std::polar(1.0, (inverse ? 2 : -2) * M_PI * i / n);
 
-    // Bit-reversed addressing permutation
-    for (size_t i = 0; i < n; i++) {
-        size_t j = reverseBits(i, levels);
-        if (j > i)
-            std::swap(vec[i], vec[j]);
-    }
+void Fft::transformBluestein(vector<complex<double> > &vec, bool inverse) {
+    // The plan selects the algorithm by the length, both calculate the same transform
+    transform(vec, inverse);
+}
 
-    // Cooley-Tukey decimation-in-time radix-2 FFT
-    for (size_t size = 2; size <= n; size *= 2) {
-        size_t halfsize = size / 2;
-        size_t tablestep = n / size;
-        for (size_t i = 0; i < n; i += size) {
-            for (size_t j = i, k = 0; j < i + halfsize; j++, k += tablestep) {
-                complex<double> temp = vec[j + halfsize] * expTable[k];
-                vec[j + halfsize] = vec[j] - temp;
-                vec[j] += temp;
+
+Fft::Plan::Plan(size_t n, bool inverse)
+        : n(n), inverse(inverse), oddLevels(false), m(0) {
+    if (n == 0)
+        throw std::domain_error("Length must be greater than zero");
+    radix2 = (n & (n - 1)) == 0;
+    if (radix2) {
+        // Length variables
+        int levels = 0;  // Compute levels = floor(log2(n))
+        for (size_t temp = n; temp > 1U; temp >>= 1)
+            levels++;
+
+        // Bit-reversed addressing permutation
+        for (size_t i = 0; i < n; i++) {
+            size_t j = reverseBits(i, levels);
+            if (j > i)
+                swaps.emplace_back(i, j);
+        }
+
+        // Trigonometric table. A radix-2 stage is only needed for an odd number of levels, it is always the size 2 stage
+        // with a twiddle factor of 1. All other stages are radix-4 stages, each needs three twiddle factors per butterfly
+        oddLevels = levels % 2;
+        for (size_t quarter = oddLevels ? 2 : 1; quarter * 4 <= n; quarter *= 4) {
+            size_t size = quarter * 4;
+            for (size_t k = 0; k < quarter; k++) {
+                for (size_t j = 1; j <= 3; j++)
+                    twiddles.push_back(std::polar(1.0, (inverse ? 2 : -2) * M_PI * ((j * k) % size) / size));
             }
         }
-        if (size == n)  // Prevent overflow in 'size *= 2'
-            break;
+    } else {
+        // Find a power-of-2 convolution length m such that m >= n * 2 + 1
+        m = 1;
+        while (m / 2 <= n) {
+            if (m > SIZE_MAX / 2)
+                throw std::length_error("Vector too large");
+            m *= 2;
+        }
+
+        // Trigonometric table
+        chirp.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            uintmax_t temp = static_cast<uintmax_t>(i) * i;
+            temp %= static_cast<uintmax_t>(n) * 2;
+            double angle = (inverse ? M_PI : -M_PI) * temp / n;
+            chirp[i] = std::polar(1.0, angle);
+        }
+
+        convolutionForward = plan(m, false);
+        convolutionInverse = plan(m, true);
+
+        // The spectrum of the second convolution operand only depends on the length, it already includes the scaling of the
+        // inverse transform (because this FFT implementation omits it)
+        chirpSpectrum.resize(m);
+        chirpSpectrum[0] = chirp[0];
+        for (size_t i = 1; i < n; i++)
+            chirpSpectrum[i] = chirpSpectrum[m - i] = std::conj(chirp[i]);
+        convolutionForward->execute(chirpSpectrum);
+        for (auto &c : chirpSpectrum)
+            c /= static_cast<double>(m);
     }
 }
 
 
-void Fft::transformBluestein(vector<complex<double> > &vec, bool inverse) {
-    // Find a power-of-2 convolution length m such that m >= n * 2 + 1
-    size_t n = vec.size();
-    size_t m = 1;
-    while (m / 2 <= n) {
-        if (m > SIZE_MAX / 2)
-            throw std::length_error("Vector too large");
-        m *= 2;
+void Fft::Plan::execute(vector<complex<double> > &vec) const {
+    if (vec.size() != n)
+        throw std::domain_error("Mismatched lengths");
+    execute(vec.data());
+}
+
+
+void Fft::Plan::execute(complex<double> *vec) const {
+    if (radix2)
+        executeRadix2(vec);
+    else
+        executeBluestein(vec);
+}
+
+
+void Fft::Plan::executeRadix2(complex<double> *vec) const {
+    for (const auto &s : swaps)
+        std::swap(vec[s.first], vec[s.second]);
+
+    // Cooley-Tukey decimation-in-time FFT with radix-4 stages. The butterflies work on the real and imaginary parts
+    // directly, the complex multiplication of the standard library also handles infinities and is much slower
+    double *d = reinterpret_cast<double*>(vec);
+    size_t quarter = 1;
+    if (oddLevels) {
+        // odd number of levels, start with a radix-2 stage of size 2, the twiddle factor is always 1
+        for (size_t i = 0; i < 2 * n; i += 4) {
+            double ar = d[i], ai = d[i + 1];
+            double br = d[i + 2], bi = d[i + 3];
+            d[i] = ar + br;
+            d[i + 1] = ai + bi;
+            d[i + 2] = ar - br;
+            d[i + 3] = ai - bi;
+        }
+        quarter = 2;
     }
+    // multiplication with the twiddle factor of a quarter turn: -i for the forward transform, +i for the inverse transform
+    const double rot = inverse ? 1.0 : -1.0;
+    const double *w = reinterpret_cast<const double*>(twiddles.data());
+    for (; quarter * 4 <= n; quarter *= 4) {
+        size_t size = quarter * 4;
+        for (size_t i = 0; i < n; i += size) {
+            double *a0 = d + 2 * i;
+            double *a1 = a0 + 2 * quarter;
+            double *a2 = a1 + 2 * quarter;
+            double *a3 = a2 + 2 * quarter;
+            for (size_t k = 0; k < quarter; k++) {
+                const double *t = w + 6 * k;
+                // the inputs of the butterfly are in bit-reversed order: a1 needs W^2k, a2 needs W^k and a3 needs W^3k
+                double t1r = a1[2 * k] * t[2] - a1[2 * k + 1] * t[3];
+                double t1i = a1[2 * k] * t[3] + a1[2 * k + 1] * t[2];
+                double t2r = a2[2 * k] * t[0] - a2[2 * k + 1] * t[1];
+                double t2i = a2[2 * k] * t[1] + a2[2 * k + 1] * t[0];
+                double t3r = a3[2 * k] * t[4] - a3[2 * k + 1] * t[5];
+                double t3i = a3[2 * k] * t[5] + a3[2 * k + 1] * t[4];
+
+                double s0r = a0[2 * k] + t1r, s0i = a0[2 * k + 1] + t1i;
+                double d0r = a0[2 * k] - t1r, d0i = a0[2 * k + 1] - t1i;
+                double s1r = t2r + t3r, s1i = t2i + t3i;
+                // (t2 - t3) rotated by a quarter turn
+                double d1r = -rot * (t2i - t3i), d1i = rot * (t2r - t3r);
 
-    // Trigonometric table
-    vector<complex<double> > expTable(n);
-    for (size_t i = 0; i < n; i++) {
-        uintmax_t temp = static_cast<uintmax_t>(i) * i;
-        temp %= static_cast<uintmax_t>(n) * 2;
-        double angle = (inverse ? M_PI : -M_PI) * temp / n;
-        expTable[i] = std::polar(1.0, angle);
+                a0[2 * k] = s0r + s1r;
+                a0[2 * k + 1] = s0i + s1i;
+                a1[2 * k] = d0r + d1r;
+                a1[2 * k + 1] = d0i + d1i;
+                a2[2 * k] = s0r - s1r;
+                a2[2 * k + 1] = s0i - s1i;
+                a3[2 * k] = d0r - d1r;
+                a3[2 * k + 1] = d0i - d1i;
+            }
+        }
+        w += 6 * quarter;
     }
+}
+
 
-    // Temporary vectors and preprocessing
+void Fft::Plan::executeBluestein(complex<double> *vec) const {
+    // Preprocessing
     vector<complex<double> > avec(m);
     for (size_t i = 0; i < n; i++)
-        avec[i] = vec[i] * expTable[i];
-    vector<complex<double> > bvec(m);
-    bvec[0] = expTable[0];
-    for (size_t i = 1; i < n; i++)
-        bvec[i] = bvec[m - i] = std::conj(expTable[i]);
+        avec[i] = vec[i] * chirp[i];
 
-    // Convolution
-    vector<complex<double> > cvec(m);
-    convolve(avec, bvec, cvec);
+    // Convolution with the precomputed chirp spectrum
+    convolutionForward->execute(avec);
+    double *a = reinterpret_cast<double*>(avec.data());
+    const double *c = reinterpret_cast<const double*>(chirpSpectrum.data());
+    for (size_t i = 0; i < 2 * m; i += 2) {
+        double ar = a[i], ai = a[i + 1];
+        a[i] = ar * c[i] - ai * c[i + 1];
+        a[i + 1] = ar * c[i + 1] + ai * c[i];
+    }
+    convolutionInverse->execute(avec);
 
     // Postprocessing
     for (size_t i = 0; i < n; i++)
-        vec[i] = cvec[i] * expTable[i];
+        vec[i] = avec[i] * chirp[i];
+}
+
+
+std::shared_ptr<const Fft::Plan> Fft::plan(size_t n, bool inverse) {
+    // most recently used plan first
+    static std::list<std::shared_ptr<const Plan> > cache;
+    static std::mutex cacheMutex;
+
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        for (auto it = cache.begin(); it != cache.end(); it++) {
+            if ((*it)->size() == n && (*it)->isInverse() == inverse) {
+                cache.splice(cache.begin(), cache, it);
+                return cache.front();
+            }
+        }
+    }
+    // Not cached yet. Create the plan without holding the lock, Bluestein plans request their radix-2 plans from the cache.
+    // If another thread creates the same plan in the meantime, both plans are valid and the cache simply keeps both
+    auto p = std::make_shared<const Plan>(n, inverse);
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cache.push_front(p);
+    if (cache.size() > maxCachedPlans)
+        cache.pop_back();
+    return p;
 }
 
 
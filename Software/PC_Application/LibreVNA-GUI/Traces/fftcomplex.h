@@ -24,6 +24,9 @@
 #pragma once
 
 #include <complex>
+#include <cstddef>
+#include <memory>
+#include <utility>
 #include <vector>
 
 namespace Fft {
@@ -34,25 +37,70 @@ namespace Fft {
     /*
      * Computes the discrete Fourier transform (DFT) of the given complex vector, storing the result back into the vector.
      * The vector can have any length. This is a wrapper function. The inverse transform does not perform scaling, so it is not a true inverse.
+     * Uses the cached plan for the length of the vector.
      */
     void transform(std::vector<std::complex<double> > &vec, bool inverse);
 
 
     /*
      * Computes the discrete Fourier transform (DFT) of the given complex vector, storing the result back into the vector.
-     * The vector's length must be a power of 2. Uses the Cooley-Tukey decimation-in-time radix-2 algorithm.
+     * The vector's length must be a power of 2. Uses the Cooley-Tukey decimation-in-time algorithm with radix-4 stages.
      */
     void transformRadix2(std::vector<std::complex<double> > &vec, bool inverse);
 
 
     /*
      * Computes the discrete Fourier transform (DFT) of the given complex vector, storing the result back into the vector.
-     * The vector can have any length. This requires the convolution function, which in turn requires the radix-2 FFT function.
-     * Uses Bluestein's chirp z-transform algorithm.
+     * The vector can have any length. Uses Bluestein's chirp z-transform algorithm for lengths which are not a power of 2.
      */
     void transformBluestein(std::vector<std::complex<double> > &vec, bool inverse);
 
 
+    /*
+     * Precomputed tables for transforms of one length and direction: bit reversal permutation and twiddle factors for
+     * power of 2 lengths (radix-2/radix-4 stages), chirp and its spectrum for all other lengths (Bluestein). A plan is not modified after it has
+     * been created and can be used from several threads at the same time.
+     */
+    class Plan {
+    public:
+        Plan(std::size_t n, bool inverse);
+
+        // Computes the transform in place, the vector must have the length of the plan
+        void execute(std::vector<std::complex<double> > &vec) const;
+        void execute(std::complex<double> *vec) const;
+
+        std::size_t size() const {return n;}
+        bool isInverse() const {return inverse;}
+
+    private:
+        void executeRadix2(std::complex<double> *vec) const;
+        void executeBluestein(std::complex<double> *vec) const;
+
+        std::size_t n;
+        bool inverse;
+        bool radix2;
+
+        // power of 2: index pairs swapped by the bit reversal permutation
+        std::vector<std::pair<std::size_t, std::size_t> > swaps;
+        // power of 2: the first stage is a radix-2 stage if log2(n) is odd, all other stages are radix-4 stages
+        bool oddLevels;
+        // power of 2: twiddle factors W^k, W^2k, W^3k of each radix-4 butterfly, contiguous for each stage
+        std::vector<std::complex<double> > twiddles;
+
+        // Bluestein: chirp and scaled spectrum of the conjugated chirp, convolution is done with radix-2 transforms of length m
+        std::size_t m;
+        std::vector<std::complex<double> > chirp;
+        std::vector<std::complex<double> > chirpSpectrum;
+        std::shared_ptr<const Plan> convolutionForward, convolutionInverse;
+    };
+
+    /*
+     * Returns the plan for the given length and direction. Recently used plans are cached, so repeated transforms of the
+     * same length do not need to recalculate any tables. Thread-safe.
+     */
+    std::shared_ptr<const Plan> plan(std::size_t n, bool inverse);
+
+
     /*
      * Computes the circular convolution of the given complex vectors. Each vector's length must be the same.
      */
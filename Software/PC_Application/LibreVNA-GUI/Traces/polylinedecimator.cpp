@@ -0,0 +1,107 @@
+#include "polylinedecimator.h"
+
+#include <cmath>
+
+PolylineDecimator::PolylineDecimator()
+{
+    clear();
+}
+
+void PolylineDecimator::clear()
+{
+    polylines.clear();
+    open = false;
+    column.count = 0;
+}
+
+void PolylineDecimator::addSegment(const QPointF &p1, const QPointF &p2)
+{
+    if(!open || p1 != lastPoint) {
+        // not connected to the previous segment, start a new polyline
+        finish();
+        polylines.emplace_back();
+        open = true;
+        addPoint(p1);
+    }
+    addPoint(p2);
+    lastPoint = p2;
+}
+
+void PolylineDecimator::finish()
+{
+    if(!open) {
+        return;
+    }
+    flushColumn();
+    open = false;
+    if(polylines.back().size() < 2) {
+        // only a single point left (all segments had a length of zero)
+        polylines.pop_back();
+    }
+}
+
+unsigned int PolylineDecimator::getPoints() const
+{
+    unsigned int points = 0;
+    for(auto &p : polylines) {
+        points += p.size();
+    }
+    return points;
+}
+
+void PolylineDecimator::draw(QPainter &p) const
+{
+    for(auto &line : polylines) {
+        p.drawPolyline(line);
+    }
+}
+
+void PolylineDecimator::addPoint(const QPointF &p)
+{
+    int x = std::floor(p.x());
+    if(column.count > 0 && x != column.x) {
+        flushColumn();
+    }
+    if(column.count == 0) {
+        column.x = x;
+        column.first = column.min = column.max = p;
+        column.minIndex = column.maxIndex = 0;
+    } else {
+        if(p.y() < column.min.y()) {
+            column.min = p;
+            column.minIndex = column.count;
+        }
+        if(p.y() > column.max.y()) {
+            column.max = p;
+            column.maxIndex = column.count;
+        }
+    }
+    column.last = p;
+    column.count++;
+}
+
+void PolylineDecimator::flushColumn()
+{
+    if(column.count == 0) {
+        return;
+    }
+    append(column.first);
+    // keep the order in which the extremes were reached
+    if(column.minIndex < column.maxIndex) {
+        append(column.min);
+        append(column.max);
+    } else {
+        append(column.max);
+        append(column.min);
+    }
+    append(column.last);
+    column.count = 0;
+}
+
+void PolylineDecimator::append(const QPointF &p)
+{
+    auto &line = polylines.back();
+    if(line.isEmpty() || line.back() != p) {
+        line.append(p);
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef POLYLINEDECIMATOR_H
+#define POLYLINEDECIMATOR_H
+
+#include <QPointF>
+#include <QPolygonF>
+#include <QPainter>
+
+#include <vector>
+
+/**
+ * @brief Collects the line segments of a trace and reduces them to polylines with a limited number of points
+ *
+ * Segments are added in pixel coordinates. Consecutive segments which share an end point are joined into one polyline.
+ * All consecutive points of a polyline that fall into the same pixel column are replaced by the first point, the points
+ * with the minimum and maximum y coordinate (in their original order) and the last point of that column. The rendered
+ * result covers the same pixels as drawing every segment, but needs at most four points per pixel column and only one
+ * painter call per polyline.
+ */
+class PolylineDecimator
+{
+public:
+    PolylineDecimator();
+
+    // Removes all polylines
+    void clear();
+    // Adds a line segment. Continues the current polyline if p1 is the end point of the previously added segment
+    void addSegment(const QPointF &p1, const QPointF &p2);
+    // Finishes the current polyline. Must be called before accessing the polylines
+    void finish();
+
+    const std::vector<QPolygonF>& getPolylines() const {return polylines;}
+    // Number of points in all polylines
+    unsigned int getPoints() const;
+    // Draws all polylines with the current pen
+    void draw(QPainter &p) const;
+
+private:
+    void addPoint(const QPointF &p);
+    void flushColumn();
+    void append(const QPointF &p);
+
+    std::vector<QPolygonF> polylines;
+    bool open;
+    QPointF lastPoint;
+
+    // points of the current pixel column
+    class Column {
+    public:
+        int x;
+        unsigned int count;
+        QPointF first, min, max, last;
+        unsigned int minIndex, maxIndex;
+    } column;
+};
+
+#endif // POLYLINEDECIMATOR_H
@@ -30,6 +30,9 @@ Trace::Trace(QString name, QColor color, QString live)
       fileParameter(0),
       mathUpdateBegin(0),
       mathUpdateEnd(0),
+      updateDepth(0),
+      updateBegin(0),
+      updateEnd(0),
       vFactor(0.66),
       reflection(true),
       visible(true),
@@ -82,12 +85,16 @@ void Trace::clear(bool force) {
     data.clear();
     deembeddingData.clear();
     settings.valid = false;
+    // any pending sample range refers to the removed data
+    updateBegin = numeric_limits<unsigned int>::max();
+    updateEnd = 0;
     warning("No data");
     emit cleared(this);
     emit outputSamplesChanged(0, 0);
 }
 
 void Trace::addData(const Trace::Data& d, DataType domain, double reference_impedance, int index) {
+    unsigned int end = 0;
     if(this->domain != domain) {
         clear();
         this->domain = domain;
@@ -134,6 +141,8 @@ void Trace::addData(const Trace::Data& d, DataType domain, double reference_impe
         } else {
             // insert at this position
             data.insert(lower, d);
+            // all following samples moved
+            end = data.size();
         }
     }
     if(this->reference_impedance != reference_impedance) {
@@ -141,7 +150,7 @@ void Trace::addData(const Trace::Data& d, DataType domain, double reference_impe
         emit typeChanged(this);
     }
     success();
-    emit outputSamplesChanged(index, index + 1);
+    samplesChanged(index, max(end, (unsigned int) index + 1));
 }
 
 void Trace::addData(const Trace::Data &d, const DeviceDriver::SASettings &s, int index)
@@ -159,6 +168,7 @@ void Trace::addData(const Trace::Data &d, const DeviceDriver::SASettings &s, int
 void Trace::addDeembeddingData(const Trace::Data &d, double reference_impedance, int index)
 {
     bool wasAvailable = deembeddingAvailable();
+    unsigned int end = 0;
     if(index >= 0) {
         // index position specified
         if(deembeddingData.size() <= (unsigned int) index) {
@@ -182,6 +192,8 @@ void Trace::addDeembeddingData(const Trace::Data &d, double reference_impedance,
         } else {
             // insert at this position
             deembeddingData.insert(lower, d);
+            // all following samples moved
+            end = deembeddingData.size();
         }
     }
     if(deembedded_reference_impedance != reference_impedance) {
@@ -191,13 +203,44 @@ void Trace::addDeembeddingData(const Trace::Data &d, double reference_impedance,
         }
     }
     if(deembeddingActive) {
-        emit outputSamplesChanged(index, index + 1);
+        samplesChanged(index, max(end, (unsigned int) index + 1));
     }
     if(!wasAvailable) {
         emit deembeddingChanged(this);
     }
 }
 
+void Trace::beginUpdate()
+{
+    if(updateDepth == 0) {
+        updateBegin = numeric_limits<unsigned int>::max();
+        updateEnd = 0;
+    }
+    updateDepth++;
+}
+
+void Trace::endUpdate()
+{
+    if(updateDepth == 0) {
+        return;
+    }
+    updateDepth--;
+    if(updateDepth == 0 && updateEnd > updateBegin) {
+        emit outputSamplesChanged(updateBegin, updateEnd);
+    }
+}
+
+void Trace::samplesChanged(unsigned int begin, unsigned int end)
+{
+    if(updateDepth > 0) {
+        // collect range, signal is emitted in endUpdate()
+        updateBegin = min(updateBegin, begin);
+        updateEnd = max(updateEnd, end);
+    } else {
+        emit outputSamplesChanged(begin, end);
+    }
+}
+
 void Trace::setName(QString name) {
     _name = name;
     emit nameChanged();
@@ -218,10 +261,9 @@ void Trace::fillFromTouchstone(Touchstone &t, unsigned int parameter)
     fileParameter = parameter;
     filename = t.getFilename();
     for(unsigned int i=0;i<t.points();i++) {
-        auto tData = t.point(i);
         Data d;
-        d.x = tData.frequency;
-        d.y = t.point(i).S[parameter];
+        d.x = t.frequency(i);
+        d.y = t.parameter(i, parameter);
         addData(d, DataType::Frequency);
     }
     // check if parameter is a reflection measurement (e.i. S11/S22/S33/...)
@@ -324,22 +366,42 @@ void Trace::fillFromDatapoints(std::map<QString, Trace *> traceSet, const std::v
             m.second->clearDeembedding();
         }
     }
-    // add new points to traces
-    for(auto d : data) {
+    for(auto m : traceSet) {
+        m.second->beginUpdate();
+    }
+    // add new points to traces. The points are sorted by frequency, they can be stored by index.
+    // Traces are only looked up when the layout of the points changes
+    shared_ptr<const MeasurementLayout> layout;
+    vector<Trace*> traces;
+    for(unsigned int index=0;index<data.size();index++) {
+        auto &d = data[index];
+        if(d.measurements.getLayout() != layout) {
+            layout = d.measurements.getLayout();
+            traces.assign(d.measurements.size(), nullptr);
+            for(unsigned int i=0;i<d.measurements.size();i++) {
+                auto it = traceSet.find(d.measurements.name(i));
+                if(it != traceSet.end()) {
+                    traces[i] = it->second;
+                }
+            }
+        }
         Trace::Data td;
         td.x = d.frequency;
-        for(auto m : d.measurements) {
-            td.y = m.second;
-            QString measurement = m.first;
-            if(traceSet.count(measurement)) {
-                if(!deembedded) {
-                    traceSet[measurement]->addData(td, DataType::Frequency);
-                } else {
-                    traceSet[measurement]->addDeembeddingData(td);
-                }
+        for(unsigned int i=0;i<d.measurements.size();i++) {
+            if(!traces[i]) {
+                continue;
+            }
+            td.y = d.measurements.value(i);
+            if(!deembedded) {
+                traces[i]->addData(td, DataType::Frequency, 50.0, index);
+            } else {
+                traces[i]->addDeembeddingData(td, 50.0, index);
             }
         }
     }
+    for(auto m : traceSet) {
+        m.second->endUpdate();
+    }
 }
 
 void Trace::fromLivedata(Trace::LivedataType type, QString param)
@@ -535,29 +597,69 @@ void Trace::calculateMath()
         return;
     }
     if(!isPaused()) {
-        try {
-            ParserX parser(pckCOMMON | pckUNIT | pckCOMPLEX);
-            parser.SetExpr(mathFormula.toStdString());
-            map<Trace*,Value> values;
-            Value x;
-            parser.DefineVar("x", Variable(&x));
-            for(const auto &ts : mathSourceTraces) {
-                values[ts.first] = Value();
-                parser.DefineVar(ts.second.toStdString(), Variable(&values[ts.first]));
+        // evaluate all requested samples at once if the formula can be compiled
+        vector<string> names = {"x"};
+        vector<Trace*> sources;
+        for(const auto &ts : mathSourceTraces) {
+            names.push_back(ts.second.toStdString());
+            sources.push_back(ts.first);
+        }
+        auto formula = mathFormula.toStdString();
+        if(formula != compiledFormula || names != compiledVariables) {
+            // only compile again if the formula or the variables changed
+            compiledFormula = formula;
+            compiledVariables = names;
+            compiled.compile(formula, names);
+        }
+        if(compiled.isValid()) {
+            unsigned int count = mathUpdateEnd > mathUpdateBegin ? mathUpdateEnd - mathUpdateBegin : 0;
+            vector<vector<complex<double>>> values(names.size());
+            vector<const complex<double>*> pointers(names.size(), nullptr);
+            values[0].resize(count);
+            for(unsigned int i=0;i<count;i++) {
+                values[0][i] = data[mathUpdateBegin + i].x;
             }
-            for(unsigned int i=mathUpdateBegin;i<mathUpdateEnd;i++) {
-                x = data[i].x;
-                for(auto &val : values) {
-                    val.second = val.first->interpolatedSample(data[i].x).y;
+            pointers[0] = values[0].data();
+            for(unsigned int s=0;s<sources.size();s++) {
+                if(!compiled.usesVariable(s + 1)) {
+                    continue;
                 }
-                Value res = parser.Eval();
-                data[i].y = res.GetComplex();
+                values[s + 1].resize(count);
+                for(unsigned int i=0;i<count;i++) {
+                    values[s + 1][i] = sources[s]->interpolatedSample(data[mathUpdateBegin + i].x).y;
+                }
+                pointers[s + 1] = values[s + 1].data();
             }
-        } catch (const ParserError &e) {
-            error(QString::fromStdString(e.GetMsg()));
-            // parser error occurred
-            for(unsigned int i=mathUpdateBegin;i<mathUpdateEnd;i++) {
-                data[i].y = numeric_limits<complex<double>>::quiet_NaN();
+            vector<complex<double>> result(count);
+            compiled.evaluate(count, pointers, result.data());
+            for(unsigned int i=0;i<count;i++) {
+                data[mathUpdateBegin + i].y = result[i];
+            }
+        } else {
+            try {
+                ParserX parser(pckCOMMON | pckUNIT | pckCOMPLEX);
+                parser.SetExpr(mathFormula.toStdString());
+                map<Trace*,Value> values;
+                Value x;
+                parser.DefineVar("x", Variable(&x));
+                for(const auto &ts : mathSourceTraces) {
+                    values[ts.first] = Value();
+                    parser.DefineVar(ts.second.toStdString(), Variable(&values[ts.first]));
+                }
+                for(unsigned int i=mathUpdateBegin;i<mathUpdateEnd;i++) {
+                    x = data[i].x;
+                    for(auto &val : values) {
+                        val.second = val.first->interpolatedSample(data[i].x).y;
+                    }
+                    Value res = parser.Eval();
+                    data[i].y = res.GetComplex();
+                }
+            } catch (const ParserError &e) {
+                error(QString::fromStdString(e.GetMsg()));
+                // parser error occurred
+                for(unsigned int i=mathUpdateBegin;i<mathUpdateEnd;i++) {
+                    data[i].y = numeric_limits<complex<double>>::quiet_NaN();
+                }
             }
         }
         success();
@@ -1028,22 +1130,56 @@ std::vector<DeviceDriver::VNAMeasurement> Trace::assembleDatapoints(std::map<QSt
     vector<DeviceDriver::VNAMeasurement> ret;
 
     // Sanity check traces
-    unsigned int samples = traceSet.begin()->second->size();
+    auto freqs = commonFrequencies(traceSet);
+    if(freqs.empty()) {
+        return ret;
+    }
+    unsigned int samples = freqs.size();
     auto impedance = traceSet.begin()->second->getReferenceImpedance();
+
+    // Checks passed, assemble datapoints
+    QStringList names;
+    for(auto m : traceSet) {
+        names.append(m.first);
+    }
+    auto layout = MeasurementLayout::get(names);
+    for(unsigned int i=0;i<samples;i++) {
+        DeviceDriver::VNAMeasurement d;
+        d.measurements.setLayout(layout);
+        unsigned int index = 0;
+        for(auto m : traceSet) {
+            const Trace *t = m.second;
+            d.measurements.value(index++) = t->sample(i).y;
+        }
+        d.pointNum = i;
+        d.frequency = freqs[i];
+        d.Z0 = impedance;
+        ret.push_back(d);
+    }
+    return ret;
+}
+
+std::vector<double> Trace::commonFrequencies(std::map<QString, Trace *> traceSet)
+{
     vector<double> freqs;
+    if(traceSet.empty()) {
+        return freqs;
+    }
+    unsigned int samples = traceSet.begin()->second->size();
+    auto impedance = traceSet.begin()->second->getReferenceImpedance();
     for(auto m : traceSet) {
         const Trace *t = m.second;
         if(t->size() != samples) {
             qWarning() << "Selected traces do not have the same size";
-            return ret;
+            return {};
         }
         if(t->getReferenceImpedance() != impedance) {
             qWarning() << "Selected traces do not have the same reference impedance";
-            return ret;
+            return {};
         }
         if(t->outputType() != Trace::DataType::Frequency) {
             qWarning() << "Selected trace not in frequency domain";
-            return ret;
+            return {};
         }
         if(freqs.empty()) {
             // Create frequency vector
@@ -1055,26 +1191,12 @@ std::vector<DeviceDriver::VNAMeasurement> Trace::assembleDatapoints(std::map<QSt
             for(unsigned int i=0;i<samples;i++) {
                 if(t->sample(i).x != freqs[i]) {
                     qWarning() << "Selected traces do not have identical frequency points";
-                    return ret;
+                    return {};
                 }
             }
         }
     }
-
-    // Checks passed, assemble datapoints
-    for(unsigned int i=0;i<samples;i++) {
-        DeviceDriver::VNAMeasurement d;
-        for(auto m : traceSet) {
-            QString measurement = m.first;
-            const Trace *t = m.second;
-            d.measurements[measurement] = t->sample(i).y;
-        }
-        d.pointNum = i;
-        d.frequency = freqs[i];
-        d.Z0 = impedance;
-        ret.push_back(d);
-    }
-    return ret;
+    return freqs;
 }
 
 Trace::LivedataType Trace::TypeFromString(QString s)
@@ -1354,8 +1476,9 @@ void Trace::clearDeembedding()
 
 double Trace::minX()
 {
-    if(lastMath->numSamples() > 0) {
-        return lastMath->getData().front().x;
+    auto data = lastMath->getDataView();
+    if(!data.empty()) {
+        return data.front().x;
     } else {
         return numeric_limits<double>::max();
     }
@@ -1363,8 +1486,9 @@ double Trace::minX()
 
 double Trace::maxX()
 {
-    if(lastMath->numSamples() > 0) {
-        return lastMath->getData().back().x;
+    auto data = lastMath->getDataView();
+    if(!data.empty()) {
+        return data.back().x;
     } else {
         return numeric_limits<double>::lowest();
     }
@@ -1374,7 +1498,7 @@ double Trace::findExtremum(bool max, double xmin, double xmax)
 {
     double compare = max ? numeric_limits<double>::min() : numeric_limits<double>::max();
     double freq = 0.0;
-    for(auto sample : lastMath->getData()) {
+    for(const auto &sample : lastMath->getDataView()) {
         if(sample.x < xmin || sample.x > xmax) {
             continue;
         }
@@ -1405,7 +1529,7 @@ std::vector<double> Trace::findPeakFrequencies(unsigned int maxPeaks, double min
     double frequency = 0.0;
     double max_dbm = -200.0;
     double min_dbm = 200.0;
-    for(auto d : lastMath->getData()) {
+    for(const auto &d : lastMath->getDataView()) {
         if(d.x < xmin || d.x > xmax) {
             continue;
         }
@@ -1526,6 +1650,15 @@ std::vector<Trace::Data> Trace::getData()
     }
 }
 
+TraceMath::DataView Trace::getDataView()
+{
+    if(deembeddingActive && deembeddingAvailable()) {
+        return DataView(dataMutex, deembeddingData, dataVersion);
+    } else {
+        return TraceMath::getDataView();
+    }
+}
+
 double Trace::getUnwrappedPhase(unsigned int index)
 {
     if(index >= size()) {
@@ -1620,12 +1753,13 @@ double Trace::getGroupDelay(double frequency)
 
 int Trace::index(double x)
 {
-    auto lower = lower_bound(lastMath->getData().begin(), lastMath->getData().end(), x, [](const Data &lhs, const double x) -> bool {
+    auto data = lastMath->getDataView();
+    auto lower = lower_bound(data.begin(), data.end(), x, [](const Data &lhs, const double x) -> bool {
         return lhs.x < x;
     });
-    if(lower == lastMath->getData().end()) {
+    if(lower == data.end()) {
         // actually beyond the last sample, return the index of the last anyway to avoid access past data
-        return lastMath->getData().size() - 1;
+        return data.size() - 1;
     }
-    return lower - lastMath->getData().begin();
+    return lower - data.begin();
 }
@@ -5,6 +5,7 @@
 #include "csv.h"
 #include "Device/devicedriver.h"
 #include "Math/tracemath.h"
+#include "Math/compiledexpression.h"
 #include "Tools/parameters.h"
 
 #include <QObject>
@@ -47,6 +48,10 @@ public:
     void addData(const Data& d, DataType domain, double reference_impedance = 50.0, int index = -1);
     void addData(const Data& d, const DeviceDriver::SASettings &s, int index = -1);
     void addDeembeddingData(const Data& d, double reference_impedance = 50.0, int index = -1);
+    // Sample changes between beginUpdate() and endUpdate() are combined into a single outputSamplesChanged signal.
+    // Use this when adding multiple points at once. Calls can be nested
+    void beginUpdate();
+    void endUpdate();
     void setName(QString name);
     void setVelocityFactor(double v);
     void fillFromTouchstone(Touchstone &t, unsigned int parameter);
@@ -96,6 +101,7 @@ public:
     virtual Data getInterpolatedSample(double x) override;
     virtual unsigned int numSamples() override;
     virtual std::vector<Data> getData() override;
+    virtual DataView getDataView() override;
 
     double getUnwrappedPhase(unsigned int index);
     // returns a (possibly interpolated sample) at a specified frequency/time/power
@@ -155,6 +161,8 @@ public:
     // Assembles datapoints as received from the VNA from four S parameter traces. Requires that all traces are in the frequency domain,
     // have the same number of samples and their samples must be at the same frequencies across all traces
     static std::vector<DeviceDriver::VNAMeasurement> assembleDatapoints(std::map<QString, Trace *> traceSet);
+    // Checks the same requirements as assembleDatapoints and returns the common frequencies of all traces (empty if the requirements are not met)
+    static std::vector<double> commonFrequencies(std::map<QString, Trace *> traceSet);
 
     static LivedataType TypeFromString(QString s);
     static QString TypeToString(LivedataType t);
@@ -265,12 +273,22 @@ private:
     std::map<Trace*,QString> mathSourceTraces;
     std::map<unsigned int,QString> mathSourceUnresolvedHashes;
     QString mathFormula;
+    // mathFormula compiled for the variables in compiledVariables
+    Math::CompiledExpression compiled;
+    std::string compiledFormula;
+    std::vector<std::string> compiledVariables;
     static constexpr int MinMathUpdateInterval = 100;
     QTime lastMathUpdate;
     QTimer mathCalcTimer;
     unsigned int mathUpdateBegin;
     unsigned int mathUpdateEnd;
 
+    // Pending sample range while inside beginUpdate()/endUpdate()
+    void samplesChanged(unsigned int begin, unsigned int end);
+    unsigned int updateDepth;
+    unsigned int updateBegin;
+    unsigned int updateEnd;
+
     double vFactor;
     bool reflection;
     bool visible;
@@ -305,8 +305,9 @@ void TraceModel::addVNAData(const DeviceDriver::VNAMeasurement& d, TraceMath::Da
                 return;
             }
             lastSweepPosition = td.x;
-            if(d.measurements.count(t->liveParameter())) {
-                td.y = d.measurements.at(t->liveParameter());
+            auto measurementIndex = d.measurements.index(t->liveParameter());
+            if(measurementIndex >= 0) {
+                td.y = d.measurements.value(measurementIndex);
             } else {
                 // parameter not included in data, skip
                 continue;
@@ -320,6 +321,19 @@ void TraceModel::addVNAData(const DeviceDriver::VNAMeasurement& d, TraceMath::Da
     }
 }
 
+void TraceModel::addVNAData(const std::vector<DeviceDriver::VNAMeasurement> &data, TraceMath::DataType datatype, bool deembedded)
+{
+    for(auto t : traces) {
+        t->beginUpdate();
+    }
+    for(auto &d : data) {
+        addVNAData(d, datatype, deembedded);
+    }
+    for(auto t : traces) {
+        t->endUpdate();
+    }
+}
+
 void TraceModel::addSAData(const DeviceDriver::SAMeasurement& d, const DeviceDriver::SASettings &settings)
 {
     source = DataSource::SA;
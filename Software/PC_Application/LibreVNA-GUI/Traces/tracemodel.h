@@ -72,6 +72,8 @@ signals:
 public slots:
     void clearLiveData();
     void addVNAData(const DeviceDriver::VNAMeasurement& d, TraceMath::DataType datatype, bool deembedded);
+    // Adds a block of measurements, each trace emits only one update for the whole block
+    void addVNAData(const std::vector<DeviceDriver::VNAMeasurement>& data, TraceMath::DataType datatype, bool deembedded);
     void addSAData(const DeviceDriver::SAMeasurement &d, const DeviceDriver::SASettings &settings);
 
 private:
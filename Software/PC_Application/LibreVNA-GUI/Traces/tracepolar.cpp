@@ -241,6 +241,92 @@ bool TracePolar::markerVisible(double x)
     }
 }
 
+bool TracePolar::TraceCache::Key::operator==(const Key &o) const
+{
+    return source == o.source && version == o.version && fmin == o.fmin && fmax == o.fmax && hideAfterSweep == o.hideAfterSweep
+            && xSweep == o.xSweep && hidePercent == o.hidePercent && limitToEdge == o.limitToEdge && edgeReflection == o.edgeReflection
+            && offset == o.offset && transform == o.transform && scale == o.scale;
+}
+
+const PolylineDecimator &TracePolar::traceLines(Trace *t, double scale)
+{
+    auto &pref = Preferences::getInstance();
+    auto &cache = traceCache[t];
+
+    TraceCache::Key key;
+    key.source = t->getLastMath();
+    key.version = key.source->getDataVersion();
+    key.fmin = minimumVisibleFrequency();
+    key.fmax = maximumVisibleFrequency();
+    key.hideAfterSweep = pref.Graphs.SweepIndicator.hide && !isnan(xSweep) && t->getSource() == Trace::Source::Live && t->isVisible() && !t->isPaused();
+    // only compare the sweep position if it is used, it may be NaN otherwise
+    key.xSweep = key.hideAfterSweep ? xSweep : 0.0;
+    key.hidePercent = key.hideAfterSweep ? pref.Graphs.SweepIndicator.hidePercent : 0.0;
+    key.limitToEdge = limitToEdge;
+    key.edgeReflection = edgeReflection;
+    key.offset = offset;
+    key.transform = transform;
+    key.scale = scale;
+
+    if(cache.valid && cache.key == key) {
+        return cache.lines;
+    }
+    cache.lines.clear();
+    int nPoints = t->size();
+    for(int i=1;i<nPoints;i++) {
+        auto last = t->sample(i-1);
+        auto now = t->sample(i);
+        if ((t->getDataType() == Trace::DataType::Frequency) && (last.x < key.fmin || now.x > key.fmax)) {
+            continue;
+        }
+        if(isnan(now.y.real())) {
+            break;
+        }
+
+        if(key.hideAfterSweep) {
+            // check if this part of the trace is visible
+            double range = key.fmax - key.fmin;
+            double afterSweep = now.x - xSweep;
+            if(afterSweep > 0 && afterSweep * 100 / range <= key.hidePercent) {
+                // do not display this part of the trace
+                continue;
+            }
+        }
+
+        last = dataAddOffset(last);
+        now = dataAddOffset(now);
+
+        // scale to size of the chart
+        QPointF p1 = dataToPixel(last);
+        QPointF p2 = dataToPixel(now);
+
+        if(limitToEdge && (abs(last.y) > edgeReflection || abs(now.y) > edgeReflection)) {
+            // partially outside of visible area, constrain
+            if(!TracePolar::constrainLineToCircle(p1, p2, transform.map(QPointF(0,0)), polarCoordMax * scale)) {
+                // completely out of visible area
+                continue;
+            }
+        }
+
+        cache.lines.addSegment(p1, p2);
+    }
+    cache.lines.finish();
+    cache.key = key;
+    cache.valid = true;
+    return cache.lines;
+}
+
+void TracePolar::pruneTraceLines()
+{
+    for(auto it = traceCache.begin();it != traceCache.end();) {
+        if(traces.count(it->first) && traces[it->first]) {
+            it++;
+        } else {
+            it = traceCache.erase(it);
+        }
+    }
+}
+
 void TracePolar::updateContextMenu()
 {
     contextmenu->clear();
@@ -2,6 +2,9 @@
 #define TRACEPOLAR_H
 
 #include "traceplot.h"
+#include "polylinedecimator.h"
+
+#include <map>
 
 class PolarArc {
 public:
@@ -57,6 +60,12 @@ protected:
     // if the line lies completely outside of the circle (or is tangent to the circle)
     static bool constrainLineToCircle(QPointF &a, QPointF &b, QPointF center, double radius);
 
+    // Returns the decimated pixel polylines of a trace. They are only calculated again if the trace data or the geometry of
+    // the chart changed. Call after transform has been updated, scale is the scaling of the chart coordinates
+    const PolylineDecimator& traceLines(Trace *t, double scale);
+    // Removes the polylines of traces that are no longer displayed
+    void pruneTraceLines();
+
     bool limitToSpan;
     bool limitToEdge;
     bool manualFrequencyRange;
@@ -65,6 +74,29 @@ protected:
     double edgeReflection; // magnitude of reflection coefficient at the edge of the polar chart (zoom factor)
     QPointF offset;
     QTransform transform;
+
+private:
+    class TraceCache {
+    public:
+        class Key {
+        public:
+            bool operator==(const Key &o) const;
+            TraceMath *source;
+            unsigned long version;
+            double fmin, fmax;
+            bool hideAfterSweep;
+            double xSweep;
+            double hidePercent;
+            bool limitToEdge;
+            double edgeReflection;
+            QPointF offset;
+            QTransform transform;
+            double scale;
+        } key;
+        bool valid = false;
+        PolylineDecimator lines;
+    };
+    std::map<Trace*, TraceCache> traceCache;
 };
 
 #endif // TRACEPOLAR_H
@@ -127,6 +127,7 @@ void TracePolarChart::draw(QPainter &p) {
         }
     }
 
+    pruneTraceLines();
     for(auto t : traces) {
         if(!t.second) {
             // trace not enabled in plot
@@ -140,45 +141,7 @@ void TracePolarChart::draw(QPainter &p) {
         pen = QPen(trace->color(), pref.Graphs.lineWidth);
         pen.setCosmetic(true);
         p.setPen(pen);
-        int nPoints = trace->size();
-        for(int i=1;i<nPoints;i++) {
-            auto last = trace->sample(i-1);
-            auto now = trace->sample(i);
-            if ((trace->getDataType() == Trace::DataType::Frequency) && (last.x < minimumVisibleFrequency() || now.x > maximumVisibleFrequency())) {
-                continue;
-            }
-            if(isnan(now.y.real())) {
-                break;
-            }
-
-            if(pref.Graphs.SweepIndicator.hide && !isnan(xSweep) && trace->getSource() == Trace::Source::Live && trace->isVisible() && !trace->isPaused()) {
-                // check if this part of the trace is visible
-                double range = maximumVisibleFrequency() - minimumVisibleFrequency();
-                double afterSweep = now.x - xSweep;
-                if(afterSweep > 0 && afterSweep * 100 / range <= pref.Graphs.SweepIndicator.hidePercent) {
-                    // do not display this part of the trace
-                    continue;
-                }
-            }
-
-            last = dataAddOffset(last);
-            now = dataAddOffset(now);
-
-            // scale to size of smith diagram
-            QPointF p1 = dataToPixel(last);
-            QPointF p2 = dataToPixel(now);
-
-            if(limitToEdge && (abs(last.y) > edgeReflection || abs(now.y) > edgeReflection)) {
-                // partially outside of visible area, constrain
-                if(!TracePolar::constrainLineToCircle(p1, p2, transform.map(QPointF(0,0)), polarCoordMax * scale)) {
-                    // completely out of visible area
-                    continue;
-                }
-            }
-
-            // draw line
-            p.drawLine(p1, p2);
-        }
+        traceLines(trace, scale).draw(p);
         if(trace->size() > 0) {
             // only draw markers if the trace has at least one point
             auto markers = t.first->getMarkers();
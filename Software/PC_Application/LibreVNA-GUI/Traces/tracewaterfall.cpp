@@ -10,6 +10,9 @@
 #include <QFileDialog>
 #include <QPainter>
 
+#include <array>
+#include <cstring>
+
 using namespace std;
 
 TraceWaterfall::TraceWaterfall(TraceModel &model, QWidget *parent)
@@ -19,7 +22,11 @@ TraceWaterfall::TraceWaterfall(TraceModel &model, QWidget *parent)
       trace(nullptr),
       pixelsPerLine(1),
       keepDataBeyondPlotSize(false),
-      maxDataSweeps(500)
+      maxDataSweeps(500),
+      imageValid(false),
+      sweepsAdded(0),
+      sweepsRasterised(0),
+      newestSweepChanged(false)
 {
     plotAreaTop = 0;
     plotAreaLeft = 0;
@@ -154,6 +161,9 @@ void TraceWaterfall::axisSetupDialog()
 void TraceWaterfall::resetWaterfall()
 {
     data.clear();
+    imageValid = false;
+    sweepsAdded = 0;
+    sweepsRasterised = 0;
     updateYAxis();
 }
 
@@ -386,73 +396,14 @@ void TraceWaterfall::draw(QPainter &p)
     }
 
     p.setClipRect(QRect(plotRect.x()+1, plotRect.y()+1, plotRect.width()-1, plotRect.height()-1));
-    if(data.size()) {
-        // plot waterfall data
-        int ytop, ybottom;
-        bool lastLine = false;
-        if(dir == Direction::TopToBottom) {
-            ytop = plotAreaTop;
-            ybottom = ytop + pixelsPerLine - 1;
-        } else {
-            ybottom = plotAreaBottom - 1;
-            ytop = ybottom - pixelsPerLine + 1;
-        }
-        int i;
-        for(i=data.size() - 1;i>=0;i--) {
-            auto sweep = data[i];
-            for(unsigned int s=0;s<sweep.size();s++) {
-                auto x = xAxis.sampleToCoordinate(sweep[s], trace);
-                double x_start;
-                double x_stop;
-                if(x < xAxis.getRangeMin() || x > xAxis.getRangeMax()) {
-                    // out of range, skip
-                    continue;
-                }
-                if(s == 0) {
-                    x_start = x;
-                } else {
-                    auto prev_x = xAxis.sampleToCoordinate(sweep[s-1], trace);
-                    x_start = (prev_x + x) / 2.0;
-                }
-                x_start = xAxis.transform(x_start, plotAreaLeft, plotAreaLeft + plotAreaWidth);
-                if(s == sweep.size() - 1) {
-                    x_stop = x;
-                } else {
-                    auto next_x = xAxis.sampleToCoordinate(sweep[s+1], trace);
-                    x_stop = (next_x + x) / 2.0;
-                }
-                x_stop = xAxis.transform(x_stop, plotAreaLeft, plotAreaLeft + plotAreaWidth);
-                auto y = yAxis.sampleToCoordinate(sweep[s]);
-                auto color = Util::getIntensityGradeColor(yAxis.transform(y, 0.0, 1.0));
-                auto rect = QRect(round(x_start), ytop, round(x_stop - x_start) + 1, ybottom - ytop + 1);
-                p.fillRect(rect, QBrush(color));
-            }
-            if(lastLine) {
-                break;
-            }
-            // update ycoords for next line
-            if(dir == Direction::TopToBottom) {
-                ytop = ybottom + 1;
-                ybottom = ytop + pixelsPerLine - 1;
-                if(ybottom >= plotAreaBottom) {
-                    ybottom = plotAreaBottom;
-                    lastLine = true;
-                }
-            } else {
-                ybottom = ytop - 1;
-                ytop = ybottom - pixelsPerLine + 1;
-                if(ytop <= plotAreaTop) {
-                    ytop = plotAreaTop;
-                    lastLine = true;
-                }
-            }
-        }
-        if(!keepDataBeyondPlotSize && i >= 0) {
-            // not all data could be plotted, drop
-            data.erase(data.begin(), data.begin() + i);
-            updateYAxis();
-        }
+    if(!keepDataBeyondPlotSize && data.size() > visibleLines()) {
+        // not all data can be plotted, drop
+        data.erase(data.begin(), data.begin() + (data.size() - visibleLines()));
+        updateYAxis();
     }
+    // plot waterfall data
+    updateImage(plotRect);
+    p.drawImage(plotAreaLeft, plotAreaTop, image);
     p.setClipping(false);
 
     // show sweep indicator if activated
@@ -566,6 +517,7 @@ void TraceWaterfall::traceDataChanged(unsigned int begin, unsigned int end)
         }
         // start new row
         data.push_back(std::vector<Trace::Data>());
+        sweepsAdded++;
         while (data.size() > maxDataSweeps) {
             data.pop_front();
             // min/max might have changed due to removed data
@@ -591,6 +543,7 @@ void TraceWaterfall::traceDataChanged(unsigned int begin, unsigned int end)
             }
         }
     }
+    newestSweepChanged = true;
     if(yAxis.getAutorange() && !YAxisUpdateRequired && (min != yAxis.getRangeMin() || max != yAxis.getRangeMax())) {
         // axis scaling needs update due to new trace data
         yAxis.set(yAxis.getType(), yAxis.getLog(), true, min, max, yAxis.getDivs(), yAxis.getAutoDivs());
@@ -604,7 +557,7 @@ void TraceWaterfall::updateYAxis()
     if(yAxis.getAutorange()) {
         double min = std::numeric_limits<double>::max();
         double max = std::numeric_limits<double>::lowest();
-        for(auto sweep : data) {
+        for(const auto &sweep : data) {
             for(unsigned int i=0;i<sweep.size();i++) {
                 double val = yAxis.sampleToCoordinate(sweep[i]);
                 if(isnan(val) || isinf(val)) {
@@ -624,6 +577,173 @@ void TraceWaterfall::updateYAxis()
     }
 }
 
+bool TraceWaterfall::ImageKey::operator==(const ImageKey &o) const
+{
+    return left == o.left && width == o.width && height == o.height && pixelsPerLine == o.pixelsPerLine && dir == o.dir
+            && xType == o.xType && yType == o.yType && xMin == o.xMin && xMax == o.xMax && yMin == o.yMin && yMax == o.yMax
+            && xLog == o.xLog && yLog == o.yLog;
+}
+
+void TraceWaterfall::updateImage(const QRect &plotRect)
+{
+    ImageKey key;
+    // the image covers all pixels from the left to the right and from the top to the bottom border of the plot area
+    key.left = plotRect.x();
+    key.width = plotRect.width() + 1;
+    key.height = plotRect.height() + 1;
+    key.pixelsPerLine = pixelsPerLine;
+    key.dir = dir;
+    key.xType = xAxis.getType();
+    key.yType = yAxis.getType();
+    key.xMin = xAxis.getRangeMin();
+    key.xMax = xAxis.getRangeMax();
+    key.yMin = yAxis.getRangeMin();
+    key.yMax = yAxis.getRangeMax();
+    key.xLog = xAxis.getLog();
+    key.yLog = yAxis.getLog();
+
+    auto newSweeps = sweepsAdded - sweepsRasterised;
+    if(!imageValid || !(key == imageKey) || newSweeps >= visibleLines()) {
+        // redraw everything
+        if(image.width() != key.width || image.height() != key.height) {
+            image = QImage(key.width, key.height, QImage::Format_ARGB32_Premultiplied);
+        }
+        image.fill(Qt::transparent);
+        imageKey = key;
+        unsigned int lines = std::min((unsigned long) visibleLines(), (unsigned long) data.size());
+        for(unsigned int i=0;i<lines;i++) {
+            rasteriseLine(data[data.size() - 1 - i], i);
+        }
+    } else if(newSweeps > 0 || newestSweepChanged) {
+        // scroll the existing lines to make room for the new sweeps
+        int shift = newSweeps * pixelsPerLine;
+        if(shift > 0 && shift < image.height()) {
+            auto bytes = (image.height() - shift) * image.bytesPerLine();
+            if(dir == Direction::TopToBottom) {
+                memmove(image.scanLine(shift), image.scanLine(0), bytes);
+            } else {
+                memmove(image.scanLine(0), image.scanLine(shift), bytes);
+            }
+        }
+        // draw the new sweeps and the previously newest sweep, it may have been incomplete
+        for(unsigned int i=0;i<=newSweeps && i<data.size();i++) {
+            rasteriseLine(data[data.size() - 1 - i], i);
+        }
+        if(data.size() < visibleLines()) {
+            // lines beyond the stored data may contain scrolled sweeps which are no longer available
+            if(dir == Direction::TopToBottom) {
+                clearRows(lineTop(data.size()), image.height() - 1);
+            } else {
+                clearRows(0, lineTop(data.size()) + pixelsPerLine - 1);
+            }
+        }
+    }
+    sweepsRasterised = sweepsAdded;
+    newestSweepChanged = false;
+    imageValid = true;
+}
+
+int TraceWaterfall::lineTop(unsigned int line) const
+{
+    int height = plotAreaBottom - plotAreaTop + 1;
+    int ppl = std::max(pixelsPerLine, 1U);
+    if(dir == Direction::TopToBottom) {
+        return line * ppl;
+    } else {
+        // the newest line ends one pixel above the bottom border
+        return height - 1 - (int) (line + 1) * ppl;
+    }
+}
+
+unsigned int TraceWaterfall::visibleLines() const
+{
+    int height = plotAreaBottom - plotAreaTop + 1;
+    int ppl = std::max(pixelsPerLine, 1U);
+    if(dir == Direction::TopToBottom) {
+        return std::max((height + ppl - 1) / ppl, 0);
+    } else {
+        return std::max((height - 2) / ppl + 1, 0);
+    }
+}
+
+void TraceWaterfall::rasteriseLine(const std::vector<Trace::Data> &sweep, unsigned int line)
+{
+    int first = std::max(lineTop(line), 0);
+    int last = std::min(lineTop(line) + (int) pixelsPerLine, image.height()) - 1;
+    if(first > last) {
+        // line not visible
+        return;
+    }
+    const int width = image.width();
+    rowBuffer.assign(width, qRgba(0, 0, 0, 0));
+    for(unsigned int s=0;s<sweep.size();s++) {
+        auto x = xAxis.sampleToCoordinate(sweep[s], trace);
+        double x_start;
+        double x_stop;
+        if(x < xAxis.getRangeMin() || x > xAxis.getRangeMax()) {
+            // out of range, skip
+            continue;
+        }
+        if(s == 0) {
+            x_start = x;
+        } else {
+            auto prev_x = xAxis.sampleToCoordinate(sweep[s-1], trace);
+            x_start = (prev_x + x) / 2.0;
+        }
+        x_start = xAxis.transform(x_start, plotAreaLeft, plotAreaLeft + plotAreaWidth);
+        if(s == sweep.size() - 1) {
+            x_stop = x;
+        } else {
+            auto next_x = xAxis.sampleToCoordinate(sweep[s+1], trace);
+            x_stop = (next_x + x) / 2.0;
+        }
+        x_stop = xAxis.transform(x_stop, plotAreaLeft, plotAreaLeft + plotAreaWidth);
+        auto y = yAxis.sampleToCoordinate(sweep[s]);
+        auto color = intensityColor(yAxis.transform(y, 0.0, 1.0));
+        // same pixels as a rectangle from x_start with a width of x_stop - x_start + 1
+        int start = round(x_start) - plotAreaLeft;
+        int stop = start + round(x_stop - x_start);
+        start = std::max(start, 0);
+        stop = std::min(stop, width - 1);
+        for(int i=start;i<=stop;i++) {
+            rowBuffer[i] = color;
+        }
+    }
+    for(int row=first;row<=last;row++) {
+        memcpy(image.scanLine(row), rowBuffer.data(), width * sizeof(QRgb));
+    }
+}
+
+void TraceWaterfall::clearRows(int first, int last)
+{
+    first = std::max(first, 0);
+    last = std::min(last, image.height() - 1);
+    for(int row=first;row<=last;row++) {
+        memset(image.scanLine(row), 0, image.width() * sizeof(QRgb));
+    }
+}
+
+QRgb TraceWaterfall::intensityColor(double intensity)
+{
+    // Util::getIntensityGradeColor only uses integer hues from 240 (blue) to 0 (red)
+    static const auto table = [](){
+        std::array<QRgb, 241> t;
+        for(int hue=0;hue<=240;hue++) {
+            t[hue] = QColor::fromHsv(hue, 255, 255).rgba();
+        }
+        return t;
+    }();
+    if(intensity >= 0.0 && intensity <= 1.0) {
+        int hue = Util::Scale<double>(intensity, 0.0, 1.0, 240, 0);
+        return table[hue];
+    } else if(intensity > 1.0) {
+        return qRgb(255, 255, 255);
+    } else {
+        // below range or NaN
+        return qRgb(0, 0, 0);
+    }
+}
+
 QString TraceWaterfall::AlignmentToString(Alignment a)
 {
     switch(a) {
@@ -5,11 +5,14 @@
 
 #include "traceaxis.h"
 
+#include <QImage>
+
 #include <deque>
 
 class TraceWaterfall : public TracePlot
 {
     friend class WaterfallAxisDialog;
+    friend class TraceWaterfallTests;
     Q_OBJECT
 public:
     TraceWaterfall(TraceModel &model, QWidget *parent = 0);
@@ -65,6 +68,16 @@ private:
     static QString AlignmentToString(Alignment a);
     static Alignment AlignmentFromString(QString s);
 
+    // brings the waterfall image up to date with the stored sweeps
+    void updateImage(const QRect &plotRect);
+    // first image row of a waterfall line (line 0 is the newest sweep), may be outside of the image
+    int lineTop(unsigned int line) const;
+    unsigned int visibleLines() const;
+    void rasteriseLine(const std::vector<Trace::Data> &sweep, unsigned int line);
+    void clearRows(int first, int last);
+    // same as Util::getIntensityGradeColor but using a lookup table
+    static QRgb intensityColor(double intensity);
+
     Direction dir;
     Alignment align;
 
@@ -74,10 +87,33 @@ private:
     YAxis yAxis;
 
     std::deque<std::vector<Trace::Data>> data;
+
     unsigned int pixelsPerLine;
     int plotAreaLeft, plotAreaWidth, plotAreaBottom, plotAreaTop;
     bool keepDataBeyondPlotSize;
     unsigned int maxDataSweeps;
+
+    // Backing store of the waterfall area. Lines of new sweeps are rasterised once and the image is scrolled for every new
+    // sweep. The whole image is only redrawn when the axes, the plot area or the display settings change
+    QImage image;
+    class ImageKey {
+    public:
+        bool operator==(const ImageKey &o) const;
+        // the sample positions are rounded to screen pixels, moving the plot area may shift them within the image
+        int left, width, height;
+        unsigned int pixelsPerLine;
+        Direction dir;
+        XAxis::Type xType;
+        YAxis::Type yType;
+        double xMin, xMax, yMin, yMax;
+        bool xLog, yLog;
+    } imageKey;
+    bool imageValid;
+    // number of sweeps started since the last reset and the number of sweeps contained in the image
+    unsigned long sweepsAdded, sweepsRasterised;
+    // the newest sweep received more samples since it was rasterised
+    bool newestSweepChanged;
+    std::vector<QRgb> rowBuffer;
 };
 
 #endif // TRACEWATERFALL_H
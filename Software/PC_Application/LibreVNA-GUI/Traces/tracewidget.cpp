@@ -378,6 +378,34 @@ void TraceWidget::SetupSCPI()
         if(!t) {
            return SCPI::getResultName(SCPI::Result::Error);
         }
+        auto root = getRoot();
+        if(root && root->getDataFormat() == SCPI::DataFormat::Real64) {
+            // binary block, written directly from the trace data: x followed by real and imaginary part (or only the
+            // level in dBm for spectrum analyzer traces) for every point
+            bool SAParameter = Trace::isSAParameter(t->liveParameter());
+            QByteArray block;
+            {
+                // the view locks the trace data, release it before sending
+                auto data = t->getLastMath()->getDataView();
+                block = root->createBlock(data.size() * (SAParameter ? 2 : 3));
+                for(const auto &d : data) {
+                    root->appendValue(block, d.x);
+                    if(std::isnan(d.x)) {
+                        root->appendValue(block, d.x);
+                        if(!SAParameter) {
+                            root->appendValue(block, d.x);
+                        }
+                    } else if(SAParameter) {
+                        root->appendValue(block, Util::SparamTodB(d.y.real()));
+                    } else {
+                        root->appendValue(block, d.y.real());
+                        root->appendValue(block, d.y.imag());
+                    }
+                }
+            }
+            root->sendBlock(block);
+            return SCPI::getResultName(SCPI::Result::Empty);
+        }
         QString ret;
         if(t->size() > 0) {
             for(unsigned int i=0;i<t->size();i++) {
@@ -567,48 +567,24 @@ void TraceXYPlot::draw(QPainter &p)
             }
             p.setPen(pen);
             auto nPoints = t->size();
-            for(unsigned int j=1;j<nPoints;j++) {
-                auto last = traceToCoordinate(t, j-1, yAxis[i]);
-                auto now = traceToCoordinate(t, j, yAxis[i]);
+            auto &cache = updateTraceCache(t, i, plotRect);
 
-                // checking limits
-                for(auto limit : constantLines) {
-                    if(i == 0 && limit->getAxis() != XYPlotConstantLine::Axis::Primary) {
-                        continue;
-                    }
-                    if(i == 1 && limit->getAxis() != XYPlotConstantLine::Axis::Secondary) {
-                        continue;
-                    }
-                    if(!limit->pass(now)) {
-                        limitPassing = false;
-                    }
+            // checking limits on the full resolution data
+            for(auto limit : constantLines) {
+                if(i == 0 && limit->getAxis() != XYPlotConstantLine::Axis::Primary) {
+                    continue;
                 }
-
-                if(isnan(last.y()) || isnan(now.y()) || isinf(last.y()) || isinf(now.y())) {
+                if(i == 1 && limit->getAxis() != XYPlotConstantLine::Axis::Secondary) {
                     continue;
                 }
-
-                if((xAxis.getType() == XAxis::Type::Frequency || xAxis.getType() == XAxis::Type::TimeZeroSpan || xAxis.getType() == XAxis::Type::Power)
-                        && pref.Graphs.SweepIndicator.hide && !isnan(xSweep) && t->getSource() == Trace::Source::Live && t->isVisible() && !t->isPaused()) {
-                    // check if this part of the trace is visible
-                    double range = xAxis.getRangeMax() - xAxis.getRangeMin();
-                    double afterSweep = now.x() - xSweep;
-                    if(afterSweep > 0 && afterSweep * 100 / range <= pref.Graphs.SweepIndicator.hidePercent) {
-                        // do not display this part of the trace
-                        continue;
+                for(unsigned int j=1;j<cache.values.size() && limitPassing;j++) {
+                    if(!limit->pass(cache.values[j])) {
+                        limitPassing = false;
                     }
                 }
-
-                // scale to plot coordinates
-                auto p1 = plotValueToPixel(last, i);
-                auto p2 = plotValueToPixel(now, i);
-                if(!plotRect.contains(p1) && !plotRect.contains(p2)) {
-                    // completely out of frame
-                    continue;
-                }
-                // draw line
-                p.drawLine(p1, p2);
             }
+
+            cache.lines.draw(p);
             if(i == 0 && nPoints > 0) {
                 // only draw markers on primary YAxis and if the trace has at least one point
                 auto markers = t->getMarkers();
@@ -1036,6 +1012,7 @@ void TraceXYPlot::enableTraceAxis(Trace *t, int axis, bool enabled)
             tracesAxis[axis].insert(t);
         } else {
             tracesAxis[axis].erase(t);
+            traceCache[axis].erase(t);
             if(axis == 0) {
                 disconnect(t, &Trace::markerAdded, this, &TraceXYPlot::markerAdded);
                 disconnect(t, &Trace::markerRemoved, this, &TraceXYPlot::markerRemoved);
@@ -1100,6 +1077,92 @@ bool TraceXYPlot::supported(Trace *t, YAxis::Type type)
     return true;
 }
 
+bool TraceXYPlot::TraceCache::ValueKey::operator==(const ValueKey &o) const
+{
+    return source == o.source && version == o.version && xType == o.xType && yType == o.yType
+            && referenceImpedance == o.referenceImpedance && velocityFactor == o.velocityFactor
+            && groupDelaySamples == o.groupDelaySamples;
+}
+
+bool TraceXYPlot::TraceCache::LineKey::operator==(const LineKey &o) const
+{
+    return xMin == o.xMin && xMax == o.xMax && yMin == o.yMin && yMax == o.yMax && xLog == o.xLog && yLog == o.yLog
+            && plotRect == o.plotRect && hideAfterSweep == o.hideAfterSweep && xSweep == o.xSweep && hidePercent == o.hidePercent;
+}
+
+TraceXYPlot::TraceCache &TraceXYPlot::updateTraceCache(Trace *t, int axis, const QRect &plotRect)
+{
+    auto &pref = Preferences::getInstance();
+    auto &cache = traceCache[axis][t];
+
+    TraceCache::ValueKey valueKey;
+    valueKey.source = t->getLastMath();
+    valueKey.version = valueKey.source->getDataVersion();
+    valueKey.xType = xAxis.getType();
+    valueKey.yType = yAxis[axis].getType();
+    valueKey.referenceImpedance = t->getReferenceImpedance();
+    valueKey.velocityFactor = t->velocityFactor();
+    valueKey.groupDelaySamples = pref.Acquisition.groupDelaySamples;
+
+    TraceCache::LineKey lineKey;
+    lineKey.xMin = xAxis.getRangeMin();
+    lineKey.xMax = xAxis.getRangeMax();
+    lineKey.yMin = yAxis[axis].getRangeMin();
+    lineKey.yMax = yAxis[axis].getRangeMax();
+    lineKey.xLog = xAxis.getLog();
+    lineKey.yLog = yAxis[axis].getLog();
+    lineKey.plotRect = plotRect;
+    lineKey.hideAfterSweep = (xAxis.getType() == XAxis::Type::Frequency || xAxis.getType() == XAxis::Type::TimeZeroSpan || xAxis.getType() == XAxis::Type::Power)
+            && pref.Graphs.SweepIndicator.hide && !isnan(xSweep) && t->getSource() == Trace::Source::Live && t->isVisible() && !t->isPaused();
+    // only compare the sweep position if it is used, it may be NaN otherwise
+    lineKey.xSweep = lineKey.hideAfterSweep ? xSweep : 0.0;
+    lineKey.hidePercent = lineKey.hideAfterSweep ? pref.Graphs.SweepIndicator.hidePercent : 0.0;
+
+    bool valuesChanged = !cache.valid || !(cache.valueKey == valueKey);
+    if(valuesChanged) {
+        auto nPoints = t->size();
+        cache.values.resize(nPoints);
+        for(unsigned int j=0;j<nPoints;j++) {
+            cache.values[j] = traceToCoordinate(t, j, yAxis[axis]);
+        }
+        cache.valueKey = valueKey;
+    }
+    if(valuesChanged || !(cache.lineKey == lineKey)) {
+        cache.lines.clear();
+        for(unsigned int j=1;j<cache.values.size();j++) {
+            auto last = cache.values[j-1];
+            auto now = cache.values[j];
+
+            if(isnan(last.y()) || isnan(now.y()) || isinf(last.y()) || isinf(now.y())) {
+                continue;
+            }
+
+            if(lineKey.hideAfterSweep) {
+                // check if this part of the trace is visible
+                double range = xAxis.getRangeMax() - xAxis.getRangeMin();
+                double afterSweep = now.x() - xSweep;
+                if(afterSweep > 0 && afterSweep * 100 / range <= pref.Graphs.SweepIndicator.hidePercent) {
+                    // do not display this part of the trace
+                    continue;
+                }
+            }
+
+            // scale to plot coordinates
+            auto p1 = plotValueToPixel(last, axis);
+            auto p2 = plotValueToPixel(now, axis);
+            if(!plotRect.contains(p1) && !plotRect.contains(p2)) {
+                // completely out of frame
+                continue;
+            }
+            cache.lines.addSegment(p1, p2);
+        }
+        cache.lines.finish();
+        cache.lineKey = lineKey;
+    }
+    cache.valid = true;
+    return cache;
+}
+
 QPointF TraceXYPlot::traceToCoordinate(Trace *t, unsigned int sample, YAxis &yaxis)
 {
     QPointF ret = QPointF(numeric_limits<double>::quiet_NaN(), numeric_limits<double>::quiet_NaN());
@@ -3,8 +3,10 @@
 
 #include "traceplot.h"
 #include "traceaxis.h"
+#include "polylinedecimator.h"
 
 #include <set>
+#include <map>
 
 class XYPlotConstantLine : public QObject, public Savable
 {
@@ -115,10 +117,43 @@ private:
     void traceDropped(Trace *t, QPoint position) override;
     QString mouseText(QPoint pos) override;
 
+    // Plot values of a trace on one Y axis and its decimated pixel polylines. The plot values are only recalculated if the
+    // trace data or the conversion to plot values changed, the polylines additionally depend on the axis ranges and the plot area
+    class TraceCache {
+    public:
+        class ValueKey {
+        public:
+            bool operator==(const ValueKey &o) const;
+            TraceMath *source;
+            unsigned long version;
+            XAxis::Type xType;
+            YAxis::Type yType;
+            double referenceImpedance;
+            double velocityFactor;
+            unsigned int groupDelaySamples;
+        } valueKey;
+        class LineKey {
+        public:
+            bool operator==(const LineKey &o) const;
+            double xMin, xMax, yMin, yMax;
+            bool xLog, yLog;
+            QRect plotRect;
+            bool hideAfterSweep;
+            double xSweep;
+            double hidePercent;
+        } lineKey;
+        bool valid = false;
+        std::vector<QPointF> values;
+        PolylineDecimator lines;
+    };
+    // updates the cached plot values and polylines of a trace if necessary
+    TraceCache &updateTraceCache(Trace *t, int axis, const QRect &plotRect);
+
     bool dropOnLeftAxis;
     bool dropOnRightAxis;
 
     std::set<Trace*> tracesAxis[2];
+    std::map<Trace*, TraceCache> traceCache[2];
 
     YAxis yAxis[2];
     XAxis xAxis;
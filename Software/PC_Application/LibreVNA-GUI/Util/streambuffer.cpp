@@ -0,0 +1,33 @@
+#include "streambuffer.h"
+
+StreamBuffer::StreamBuffer()
+    : start(0)
+{
+
+}
+
+void StreamBuffer::append(const char *data, int len)
+{
+    if(start > 0) {
+        // discard the handled bytes, moving the remaining ones only once
+        buffer.erase(buffer.begin(), buffer.begin() + start);
+        start = 0;
+    }
+    buffer.insert(buffer.end(), (const uint8_t*) data, (const uint8_t*) data + len);
+}
+
+void StreamBuffer::clear()
+{
+    buffer.clear();
+    start = 0;
+}
+
+void StreamBuffer::removeBytes(int handled_bytes)
+{
+    if(handled_bytes >= getReceived()) {
+        // everything handled, nothing has to be kept
+        clear();
+    } else {
+        start += handled_bytes;
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef STREAMBUFFER_H
+#define STREAMBUFFER_H
+
+#include <QByteArray>
+
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief Receive buffer for a byte stream (e.g. a TCP socket)
+ *
+ * Received data is appended at the end, handled bytes are removed from the front by only advancing the start of the
+ * buffer (same interface as USBInBuffer). The remaining bytes are moved to the front once per append() instead of
+ * after every removed packet, so decoding all packets of a large read takes linear time.
+ */
+class StreamBuffer {
+public:
+    StreamBuffer();
+
+    void append(const char *data, int len);
+    void append(const QByteArray &data) {append(data.constData(), data.size());}
+    void clear();
+
+    void removeBytes(int handled_bytes);
+    int getReceived() const {return buffer.size() - start;}
+    uint8_t *getBuffer() {return buffer.data() + start;}
+
+private:
+    std::vector<uint8_t> buffer;
+    // start of the unhandled bytes
+    std::size_t start;
+};
+
+#endif // STREAMBUFFER_H
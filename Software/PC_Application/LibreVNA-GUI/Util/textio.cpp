@@ -0,0 +1,144 @@
+#include "textio.h"
+
+#include <charconv>
+#include <algorithm>
+#include <limits>
+#include <cstring>
+#include <cctype>
+#include <stdexcept>
+
+using namespace std;
+
+TextIO::FileView::FileView(QString filename)
+    : file(filename),
+      data(nullptr),
+      size(0)
+{
+    if(!file.open(QIODevice::ReadOnly)) {
+        throw runtime_error("Unable to open file:"+filename.toStdString());
+    }
+    size = file.size();
+    if(size > 0) {
+        data = (const char*) file.map(0, size);
+        if(!data) {
+            // mapping not supported for this file, read it instead
+            buffer = file.readAll();
+            data = buffer.constData();
+            size = buffer.size();
+        }
+    }
+}
+
+std::vector<TextIO::Line> TextIO::splitLines(const char *begin, const char *end)
+{
+    vector<Line> lines;
+    unsigned int number = 1;
+    while(begin < end) {
+        auto lineEnd = (const char*) memchr(begin, '\n', end - begin);
+        auto next = lineEnd ? lineEnd + 1 : end;
+        if(!lineEnd) {
+            lineEnd = end;
+        }
+        if(lineEnd > begin && lineEnd[-1] == '\r') {
+            lineEnd--;
+        }
+        lines.push_back({begin, lineEnd, number++});
+        begin = next;
+    }
+    return lines;
+}
+
+unsigned int TextIO::countTokens(const char *begin, const char *end)
+{
+    unsigned int tokens = 0;
+    bool inToken = false;
+    for(;begin < end;begin++) {
+        bool blank = isBlank(*begin);
+        if(!blank && !inToken) {
+            tokens++;
+        }
+        inToken = !blank;
+    }
+    return tokens;
+}
+
+const char *TextIO::parseDouble(const char *begin, const char *end, double &value)
+{
+    if(begin < end && *begin == '+') {
+        begin++;
+        if(begin == end || *begin == '-' || *begin == '+') {
+            return nullptr;
+        }
+    }
+#if defined(__cpp_lib_to_chars)
+    auto result = from_chars(begin, end, value);
+    if(result.ec == errc::result_out_of_range) {
+        // the value is not changed in this case. Values with a negative exponent are too small, all others too large
+        bool negative = *begin == '-';
+        auto exponent = find_if(begin, result.ptr, [](char c) {
+            return c == 'e' || c == 'E';
+        });
+        bool small = exponent + 1 < result.ptr && exponent[1] == '-';
+        value = small ? 0.0 : numeric_limits<double>::infinity();
+        if(negative) {
+            value = -value;
+        }
+    } else if(result.ec != errc()) {
+        return nullptr;
+    }
+    return result.ptr;
+#else
+    auto tokenEnd = begin;
+    while(tokenEnd < end && (isalnum((unsigned char) *tokenEnd) || *tokenEnd == '.' || *tokenEnd == '+' || *tokenEnd == '-')) {
+        tokenEnd++;
+    }
+    bool ok;
+    value = QByteArray::fromRawData(begin, tokenEnd - begin).toDouble(&ok);
+    return ok ? tokenEnd : nullptr;
+#endif
+}
+
+TextIO::Writer::Writer(ostream *stream)
+    : stream(stream)
+{
+    if(stream) {
+        buffer.reserve(flushSize + 1024);
+    }
+}
+
+TextIO::Writer::~Writer()
+{
+    flush();
+}
+
+void TextIO::Writer::write(double value, int precision, bool fixed)
+{
+#if defined(__cpp_lib_to_chars)
+    // large enough for any double in fixed notation
+    char text[400];
+    auto result = to_chars(text, text + sizeof(text), value, fixed ? chars_format::fixed : chars_format::general, precision);
+    if(result.ec == errc()) {
+        buffer.append(text, result.ptr - text);
+    } else {
+        buffer.append(QByteArray::number(value, fixed ? 'f' : 'g', precision).toStdString());
+    }
+#else
+    buffer.append(QByteArray::number(value, fixed ? 'f' : 'g', precision).toStdString());
+#endif
+    checkFlush();
+}
+
+void TextIO::Writer::flush()
+{
+    if(stream && !buffer.empty()) {
+        stream->write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+}
+
+std::string TextIO::Writer::takeText()
+{
+    string ret;
+    ret.swap(buffer);
+    return ret;
+}
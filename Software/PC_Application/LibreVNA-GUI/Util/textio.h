@@ -0,0 +1,91 @@
+#ifndef TEXTIO_H
+#define TEXTIO_H
+
+#include <QFile>
+#include <QByteArray>
+#include <QString>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * Helpers for reading and writing large text files with numeric data (Touchstone, CSV).
+ *
+ * Numbers are always converted with '.' as the decimal separator, independent of the locale. If the standard library
+ * provides the floating point overloads of std::from_chars/std::to_chars they are used, otherwise the conversion falls
+ * back to the (slower) Qt functions.
+ */
+namespace TextIO {
+
+// Read only view of the content of a file. The file is memory mapped if possible, otherwise it is read into memory
+class FileView {
+public:
+    // Throws std::runtime_error if the file can not be opened
+    FileView(QString filename);
+
+    const char *begin() const {return data;}
+    const char *end() const {return data + size;}
+
+private:
+    QFile file;
+    QByteArray buffer;
+    const char *data;
+    qint64 size;
+};
+
+class Line {
+public:
+    const char *begin;
+    const char *end;
+    // line number within the file, starting at 1
+    unsigned int number;
+};
+
+// Splits the text into lines. Line endings ("\n" or "\r\n") are not included in the lines
+std::vector<Line> splitLines(const char *begin, const char *end);
+
+static inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+static inline const char *skipBlanks(const char *begin, const char *end) {
+    while(begin < end && isBlank(*begin)) {
+        begin++;
+    }
+    return begin;
+}
+// Returns the number of blank separated tokens
+unsigned int countTokens(const char *begin, const char *end);
+
+// Parses the number at the start of [begin, end), a leading '+' is accepted. Returns the position after the number or
+// nullptr if there is no valid number
+const char *parseDouble(const char *begin, const char *end, double &value);
+
+// Formats text into a large buffer. The buffer is written to the stream whenever it is full. Without a stream, the
+// complete text is kept in the buffer and can be retrieved with takeText()
+class Writer {
+public:
+    Writer(std::ostream *stream = nullptr);
+    ~Writer();
+
+    // fixed: same output as std::fixed with the given precision, otherwise same as the default floatfield
+    void write(double value, int precision, bool fixed);
+    void write(char c) {buffer.push_back(c); checkFlush();}
+    void write(const std::string &s) {buffer.append(s); checkFlush();}
+    void flush();
+    std::string takeText();
+
+private:
+    static constexpr unsigned int flushSize = 1 << 20;
+    void checkFlush() {
+        if(stream && buffer.size() >= flushSize) {
+            flush();
+        }
+    }
+    std::ostream *stream;
+    std::string buffer;
+};
+
+}
+
+#endif // TEXTIO_H
@@ -1,38 +1,67 @@
 #include "usbinbuffer.h"
 
-#include <mutex>
+#include <algorithm>
+#include <cstring>
 
 #include <QDebug>
 
 using namespace std;
 
-USBInBuffer::USBInBuffer(libusb_device_handle *handle, unsigned char endpoint, int buffer_size) :
-    buffer_size(buffer_size),
+USBInBuffer::USBInBuffer(libusb_device_handle *handle, unsigned char endpoint, int buffer_size, int transfers) :
+    data(nullptr),
     received_size(0),
     inCallback(false),
-    cancelling(false)
+    cancelling(false),
+    errorReported(false),
+    activeTransfers(0)
 {
-    buffer = new unsigned char[buffer_size];
-    memset(buffer, 0, buffer_size);
-    transfer = libusb_alloc_transfer(0);
-    libusb_fill_bulk_transfer(transfer, handle, endpoint, buffer, buffer_size, CallbackTrampoline, this, 0);
-    libusb_submit_transfer(transfer);
+    if(transfers < 1) {
+        transfers = 1;
+    }
+    // transfer length must be a multiple of the maximum packet size
+    int transfer_size = (buffer_size / transfers / 512) * 512;
+    if(transfer_size < 512) {
+        transfer_size = 512;
+    }
+    for(int i=0;i<transfers;i++) {
+        auto buffer = new unsigned char[transfer_size];
+        memset(buffer, 0, transfer_size);
+        auto transfer = libusb_alloc_transfer(0);
+        libusb_fill_bulk_transfer(transfer, handle, endpoint, buffer, transfer_size, CallbackTrampoline, this, 0);
+        buffers.push_back(buffer);
+        this->transfers.push_back(transfer);
+    }
+    // submit all transfers, they are completed in this order
+    lock_guard<mutex> lock(activeMutex);
+    for(auto &t : this->transfers) {
+        if(libusb_submit_transfer(t) == 0) {
+            activeTransfers++;
+        } else {
+            libusb_free_transfer(t);
+            t = nullptr;
+        }
+    }
 }
 
 USBInBuffer::~USBInBuffer()
 {
-    if(transfer) {
+    unique_lock<mutex> lck(activeMutex);
+    if(activeTransfers > 0) {
         cancelling = true;
-        libusb_cancel_transfer(transfer);
+        for(auto t : transfers) {
+            if(t) {
+                libusb_cancel_transfer(t);
+            }
+        }
         // wait for cancellation to complete
-        mutex mtx;
-        unique_lock<mutex> lck(mtx);
         using namespace std::chrono_literals;
-        if(cv.wait_for(lck, 100ms) == cv_status::timeout) {
+        if(!cv.wait_for(lck, 100ms, [=](){return activeTransfers == 0;})) {
             qWarning() << "Timed out waiting for mutex acquisition during disconnect";
         }
     }
-    delete[] buffer;
+    for(auto b : buffers) {
+        delete[] b;
+    }
 }
 
 void USBInBuffer::removeBytes(int handled_bytes)
@@ -43,8 +72,8 @@ void USBInBuffer::removeBytes(int handled_bytes)
     if(handled_bytes >= received_size) {
         received_size = 0;
     } else {
-        // not removing all bytes, have to move remaining data to the beginning of the buffer
-        memmove(buffer, &buffer[handled_bytes], received_size - handled_bytes);
+        // only advance the start, remaining bytes are moved once the receiver is done
+        data += handled_bytes;
         received_size -= handled_bytes;
     }
 }
@@ -58,43 +87,76 @@ void USBInBuffer::Callback(libusb_transfer *transfer)
 {
     if(cancelling || (transfer->status == LIBUSB_TRANSFER_CANCELLED)) {
         // destructor called, do not resubmit
-        libusb_free_transfer(transfer);
-        this->transfer = nullptr;
-        cv.notify_all();
+        freeTransfer(transfer);
         return;
     }
     switch(transfer->status) {
     case LIBUSB_TRANSFER_COMPLETED:
     case LIBUSB_TRANSFER_TIMED_OUT:
         if(transfer->actual_length > 0) {
-            received_size += transfer->actual_length;
-            inCallback = true;
-            emit DataReceived();
-            inCallback = false;
+            int offset = 0;
+            if(remaining.size() > 0) {
+                // Bytes from the previous transfer have to be handled first. Only append as many new bytes as needed to
+                // complete them: start with a small chunk and double it until the receiver was able to handle the old bytes
+                int chunk = max((int) remaining.size(), 64);
+                while(offset < transfer->actual_length) {
+                    auto copy = min(chunk, transfer->actual_length - offset);
+                    remaining.insert(remaining.end(), transfer->buffer + offset, transfer->buffer + offset + copy);
+                    offset += copy;
+                    chunk *= 2;
+                    auto unhandled = handleData(remaining.data(), remaining.size());
+                    if(unhandled <= offset) {
+                        // all old bytes have been handled, continue with the rest of the transfer in place
+                        remaining.clear();
+                        offset -= unhandled;
+                        break;
+                    }
+                    remaining.erase(remaining.begin(), remaining.end() - unhandled);
+                }
+            }
+            if(remaining.size() == 0 && offset < transfer->actual_length) {
+                // handle data in place, keep unhandled bytes for the next transfer
+                auto unhandled = handleData(transfer->buffer + offset, transfer->actual_length - offset);
+                remaining.assign(transfer->buffer + transfer->actual_length - unhandled, transfer->buffer + transfer->actual_length);
+            }
         }
         break;
     case LIBUSB_TRANSFER_NO_DEVICE:
         qCritical() << "LIBUSB_TRANSFER_NO_DEVICE";
-        libusb_free_transfer(transfer);
+        freeTransfer(transfer);
         return;
     case LIBUSB_TRANSFER_ERROR:
     case LIBUSB_TRANSFER_OVERFLOW:
     case LIBUSB_TRANSFER_STALL:
         qCritical() << "LIBUSB_ERROR" << transfer->status;
-        libusb_free_transfer(transfer);
-        this->transfer = nullptr;
-        emit TransferError();
+        freeTransfer(transfer);
+        if(!errorReported) {
+            // only report once, the other transfers will most likely fail as well
+            errorReported = true;
+            emit TransferError();
+        }
         return;
         break;
     case LIBUSB_TRANSFER_CANCELLED:
         // already handled before switch-case
         break;
     }
-    // Resubmit the transfer
-    transfer->buffer = &buffer[received_size];
-    transfer->length = buffer_size - received_size;
-    transfer->length = (transfer->length / 512) * 512;
-    libusb_submit_transfer(transfer);
+    // Resubmit the transfer, it is now the last one in the queue
+    if(libusb_submit_transfer(transfer) != 0) {
+        freeTransfer(transfer);
+    }
+}
+
+int USBInBuffer::handleData(uint8_t *buffer, int size)
+{
+    data = buffer;
+    received_size = size;
+    inCallback = true;
+    emit DataReceived();
+    inCallback = false;
+    auto unhandled = received_size;
+    received_size = 0;
+    return unhandled;
 }
 
 void USBInBuffer::CallbackTrampoline(libusb_transfer *transfer)
@@ -103,7 +165,20 @@ void USBInBuffer::CallbackTrampoline(libusb_transfer *transfer)
     usb->Callback(transfer);
 }
 
+void USBInBuffer::freeTransfer(libusb_transfer *transfer)
+{
+    lock_guard<mutex> lock(activeMutex);
+    for(auto &t : transfers) {
+        if(t == transfer) {
+            t = nullptr;
+        }
+    }
+    libusb_free_transfer(transfer);
+    activeTransfers--;
+    cv.notify_all();
+}
+
 uint8_t *USBInBuffer::getBuffer() const
 {
-    return buffer;
+    return data;
 }
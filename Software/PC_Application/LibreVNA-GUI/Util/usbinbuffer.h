@@ -9,13 +9,32 @@
 #include <libusb-1.0/libusb.h>
 #endif
 #include <condition_variable>
+#include <mutex>
+#include <vector>
 
 #include <QObject>
 
+/**
+ * @brief Asynchronous receive buffer for an USB bulk endpoint
+ *
+ * Several bulk transfers are submitted at the same time, so the endpoint keeps receiving while the data of a
+ * completed transfer is handled. Completed transfers are handled in order: DataReceived() is emitted (from the libusb
+ * event thread) with getBuffer() pointing directly at the data of the transfer. Handled bytes must be removed with
+ * removeBytes(). Bytes that are not removed (e.g. an incomplete packet at the end of the transfer) are kept. Only the
+ * bytes of the next transfer that are needed to complete them are copied behind them, the rest of the next transfer is
+ * handled in place again.
+ */
 class USBInBuffer : public QObject {
     Q_OBJECT
 public:
-    USBInBuffer(libusb_device_handle *handle, unsigned char endpoint, int buffer_size);
+    /**
+     * @brief Constructor, submits the transfers
+     * @param handle USB device handle
+     * @param endpoint Address of the bulk IN endpoint
+     * @param buffer_size Overall size of the buffers, shared by all transfers
+     * @param transfers Number of transfers that are submitted at the same time
+     */
+    USBInBuffer(libusb_device_handle *handle, unsigned char endpoint, int buffer_size, int transfers = 1);
     ~USBInBuffer();
 
     void removeBytes(int handled_bytes);
@@ -29,12 +48,24 @@ signals:
 private:
     void Callback(libusb_transfer *transfer);
     static void LIBUSB_CALL CallbackTrampoline(libusb_transfer *transfer);
-    libusb_transfer *transfer;
-    unsigned char *buffer;
-    int buffer_size;
+    // Passes data to the receiver, returns the number of bytes that have not been handled (located at the end of the data)
+    int handleData(uint8_t *buffer, int size);
+    // Frees a transfer that will not be resubmitted
+    void freeTransfer(libusb_transfer *transfer);
+
+    std::vector<libusb_transfer*> transfers;
+    std::vector<unsigned char*> buffers;
+    // Unhandled bytes from previous transfers
+    std::vector<uint8_t> remaining;
+    // Data that is available to the receiver in DataReceived()
+    uint8_t *data;
     int received_size;
     bool inCallback;
     bool cancelling;
+    bool errorReported;
+
+    std::mutex activeMutex;
+    int activeTransfers;
     std::condition_variable cv;
 };
 
@@ -2,6 +2,8 @@
 
 #include <random>
 #include <QVector2D>
+#include <QThreadPool>
+#include <QSemaphore>
 
 void Util::unwrapPhase(std::vector<double> &phase, unsigned int start_index)
 {
@@ -225,3 +227,30 @@ bool Util::firmwareEqualOrHigher(QString firmware, QString compare)
         return true;
     }
 }
+
+void Util::parallelFor(unsigned int count, unsigned int minChunk, std::function<void (unsigned int, unsigned int)> f)
+{
+    auto pool = QThreadPool::globalInstance();
+    unsigned int chunks = std::min(count / std::max(minChunk, 1U), (unsigned int) std::max(pool->maxThreadCount(), 1));
+    if(chunks <= 1) {
+        f(0, count);
+        return;
+    }
+    auto chunkBegin = [=](unsigned int chunk) -> unsigned int {
+        return (unsigned long long) count * chunk / chunks;
+    };
+    QSemaphore done;
+    for(unsigned int i=1;i<chunks;i++) {
+        auto task = [=, &f, &done](){
+            f(chunkBegin(i), chunkBegin(i + 1));
+            done.release();
+        };
+        if(!pool->tryStart(task)) {
+            // no idle thread available (e.g. when called from within the pool), process in this thread instead
+            task();
+        }
+    }
+    // the calling thread takes the first range
+    f(0, chunkBegin(1));
+    done.acquire(chunks - 1);
+}
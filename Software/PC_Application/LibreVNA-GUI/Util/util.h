@@ -5,6 +5,7 @@
 #include <math.h>
 #include <limits>
 #include <vector>
+#include <functional>
 
 #include <QColor>
 #include <QPoint>
@@ -132,6 +133,10 @@ namespace Util {
     QColor getIntensityGradeColor(double intensity);
 
     bool firmwareEqualOrHigher(QString firmware, QString compare);
+
+    // Calls f(begin, end) for consecutive ranges covering [0, count), distributed across the global thread pool.
+    // Ranges contain at least minChunk elements, small counts are processed in the calling thread. Returns once all ranges are done
+    void parallelFor(unsigned int count, unsigned int minChunk, std::function<void(unsigned int begin, unsigned int end)> f);
 }
 
 #endif // UTILH_H
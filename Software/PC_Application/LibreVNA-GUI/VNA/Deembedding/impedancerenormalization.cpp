@@ -36,34 +36,42 @@ std::set<unsigned int> ImpedanceRenormalization::getAffectedPorts()
 
 void ImpedanceRenormalization::transformDatapoint(DeviceDriver::VNAMeasurement &p)
 {
-    std::map<QString, std::complex<double>> transformed;
-    int ports = 0;
-    QString name = "S11";
-    while(p.measurements.count(name) > 0) {
+    // transformed values are written back in place, the original values are still needed for the two-port conversions
+    auto S = p.measurements;
+    std::vector<bool> transformed(S.size(), false);
+    unsigned int ports = 0;
+    while(S.indexS(ports+1, ports+1) >= 0) {
         ports++;
-        name = "S"+QString::number(ports+1)+QString::number(ports+1);
     }
-    for(auto i=1;i<=ports;i++) {
-        auto S11name = "S"+QString::number(i)+QString::number(i);
-        auto S11 = p.measurements[S11name];
-        transformed[S11name] = Sparam(ABCDparam(Sparam(S11, 0.1, 0.1, 1.0), p.Z0), impedance).m11;
-        for(auto j=i+1;j<=ports;j++) {
-                auto S12name = "S"+QString::number(i)+QString::number(j);
-                auto S21name = "S"+QString::number(j)+QString::number(i);
-                auto S22name = "S"+QString::number(j)+QString::number(j);
-                if(!p.measurements.count(S12name) || !p.measurements.count(S21name) || !p.measurements.count(S22name)) {
+    for(unsigned int i=1;i<=ports;i++) {
+        auto S11index = S.indexS(i, i);
+        auto S11 = S.value(S11index);
+        p.measurements.value(S11index) = Sparam(ABCDparam(Sparam(S11, 0.1, 0.1, 1.0), p.Z0), impedance).m11;
+        transformed[S11index] = true;
+        for(unsigned int j=i+1;j<=ports;j++) {
+                auto S12index = S.indexS(i, j);
+                auto S21index = S.indexS(j, i);
+                auto S22index = S.indexS(j, j);
+                if(S12index < 0 || S21index < 0 || S22index < 0) {
                     // not all measurements available, skip this
                     continue;
                 }
-                auto S12 = p.measurements[S12name];
-                auto S21 = p.measurements[S21name];
-                auto S22 = p.measurements[S22name];
+                auto S12 = S.value(S12index);
+                auto S21 = S.value(S21index);
+                auto S22 = S.value(S22index);
             auto S_t = Sparam(ABCDparam(Sparam(S11, S12, S21, S22), p.Z0), impedance);
-            transformed[S12name] = S_t.m12;
-            transformed[S21name] = S_t.m21;
+            p.measurements.value(S12index) = S_t.m12;
+            p.measurements.value(S21index) = S_t.m21;
+            transformed[S12index] = true;
+            transformed[S21index] = true;
+        }
+    }
+    // only the transformed measurements are valid at the new impedance, remove everything else
+    for(unsigned int i=0;i<S.size();i++) {
+        if(!transformed[i]) {
+            p.measurements.erase(S.name(i));
         }
     }
-    p.measurements = transformed;
     p.Z0 = impedance;
 }
 
@@ -101,28 +101,35 @@ void MatchingNetwork::transformDatapoint(DeviceDriver::VNAMeasurement &p)
     auto m = matching[p.frequency];
     DeviceDriver::VNAMeasurement uncorrected = p;
 
-    auto portReflectionName = "S"+QString::number(port)+QString::number(port);
-    if(!uncorrected.measurements.count(portReflectionName)) {
+    auto portReflectionIndex = uncorrected.measurements.indexS(port, port);
+    if(portReflectionIndex < 0) {
         // the reflection measurement for the port to de-embed is not included, nothing can be done
         return;
     }
     // calculate internal reflection at the matching port
-    auto portReflectionS = uncorrected.measurements[portReflectionName];
+    auto portReflectionS = uncorrected.measurements.value(portReflectionIndex);
     auto matchingReflectionS = Sparam(m.forward, p.Z0).m22;
     auto internalPortReflectionS = matchingReflectionS / (1.0 - matchingReflectionS * portReflectionS);
 
     // handle the measurements
-    for(auto &meas : p.measurements) {
-        QString name = meas.first;
-        unsigned int i = name.mid(1,1).toUInt();
-        unsigned int j = name.mid(2,1).toUInt();
+    auto uncorrectedS = [&](unsigned int rcv, unsigned int src) -> std::complex<double> {
+        auto index = uncorrected.measurements.indexS(rcv, src);
+        return index >= 0 ? uncorrected.measurements.value(index) : 0.0;
+    };
+    for(unsigned int index=0;index<p.measurements.size();index++) {
+        unsigned int i = p.measurements.getLayout()->receivingPort(index);
+        unsigned int j = p.measurements.getLayout()->sourcePort(index);
+        if(i == 0) {
+            // not an S parameter
+            continue;
+        }
         if(i == j) {
             // reflection measurement
             if(i == port) {
                 // the port of the matching network itself
-                auto S = Sparam(uncorrected.measurements[name], 1.0, 1.0, 0.0);
+                auto S = Sparam(uncorrected.measurements.value(index), 1.0, 1.0, 0.0);
                 auto corrected = Sparam(m.forward * ABCDparam(S, p.Z0), p.Z0);
-                p.measurements[name] = corrected.m11;
+                p.measurements.value(index) = corrected.m11;
             } else {
                 // another reflection measurement
                 try {
@@ -138,9 +145,9 @@ void MatchingNetwork::transformDatapoint(DeviceDriver::VNAMeasurement &p)
             if(i != port && j != port) {
                 try {
                     // find through measurements from these two ports to and from the embedding port
-                    auto toPort = uncorrected.measurements["S"+QString::number(port)+QString::number(j)];
-                    auto fromPort = uncorrected.measurements["S"+QString::number(i)+QString::number(port)];
-                    p.measurements[name] = p.measurements[name] + toPort * internalPortReflectionS * fromPort;
+                    auto toPort = uncorrectedS(port, j);
+                    auto fromPort = uncorrectedS(i, port);
+                    p.measurements.value(index) = p.measurements.value(index) + toPort * internalPortReflectionS * fromPort;
                 } catch (...) {
                     // missing measurements, nothing can be done
                 }
@@ -48,14 +48,14 @@ void PortExtension::transformDatapoint(DeviceDriver::VNAMeasurement &d)
     // convert from db to factor
     auto att = pow(10.0, -db_attennuation / 20.0);
     auto correction = polar<double>(att, phase);
-    for(auto &m : d.measurements) {
-        if(m.first.mid(1, 1).toUInt() == port) {
+    for(unsigned int i=0;i<d.measurements.size();i++) {
+        if(d.measurements.getLayout()->receivingPort(i) == port) {
             // selected port is the destination of this S parameter
-            m.second /= correction;
+            d.measurements.value(i) /= correction;
         }
-        if(m.first.mid(2, 1).toUInt() == port) {
+        if(d.measurements.getLayout()->sourcePort(i) == port) {
             // selected port is the source of this S parameter
-            m.second /= correction;
+            d.measurements.value(i) /= correction;
         }
     }
 }
@@ -147,8 +147,8 @@ void PortExtension::measurementCompleted(std::vector<DeviceDriver::VNAMeasuremen
         double avg_x = 0.0, avg_y = 0.0;
         for(auto p : m) {
             // grab correct measurement
-            QString name = "S"+QString::number(port)+QString::number(port);
-            auto reflection = p.measurements[name];
+            auto index = p.measurements.indexS(port, port);
+            auto reflection = index >= 0 ? p.measurements.value(index) : 0.0;
             // remove calkit if specified
             if(!isIdeal) {
                 complex<double> calStandard = 1.0;
@@ -167,7 +167,7 @@ VNA::VNA(AppWindow *window, QString name)
     calDialog->setMinimumDuration(0);
 
     // A modal QProgressDialog calls processEvents() in setValue(). Needs to use a queued connection to update the progress
-    // value from within the NewDatapoint slot to prevent possible re-entrancy.
+    // value from within the NewDatapoints slot to prevent possible re-entrancy.
     connect(this, &VNA::calibrationMeasurementPercentage, calDialog, &QProgressDialog::setValue, Qt::QueuedConnection);
 
     connect(calDialog, &QProgressDialog::canceled, this, [=]() {
@@ -248,7 +248,7 @@ VNA::VNA(AppWindow *window, QString name)
        if(window->getDevice()) {
            auto key = "DefaultCalibration"+window->getDevice()->getSerial();
            QSettings settings;
-           auto filename = QFileDialog::getOpenFileName(nullptr, "Load calibration data", settings.value(key).toString(), "Calibration files (*.cal)", nullptr, Preferences::QFileDialogOptions());
+           auto filename = QFileDialog::getOpenFileName(nullptr, "Load calibration data", settings.value(key).toString(), "Calibration files (*.cal *.calbin)", nullptr, Preferences::QFileDialogOptions());
            if(!filename.isEmpty()) {
                settings.setValue(key, filename);
                removeDefaultCal->setEnabled(true);
@@ -626,11 +626,7 @@ VNA::VNA(AppWindow *window, QString name)
     // Set initial sweep settings
     auto& pref = Preferences::getInstance();
 
-    if(pref.Acquisition.useMedianAveraging) {
-        average.setMode(Averaging::Mode::Median);
-    } else {
-        average.setMode(Averaging::Mode::Mean);
-    }
+    average.setMode((Averaging::Mode) pref.Acquisition.averagingMode);
 
     if(pref.Startup.RememberSweepSettings) {
         LoadSweepSettings();
@@ -770,7 +766,7 @@ void VNA::initializeDevice()
     SetComboBoxItemEnabled(cbSweepType, 1, window->getDevice()->supports(DeviceDriver::Feature::VNAPowerSweep));
 
     defaultCalMenu->setEnabled(true);
-    connect(window->getDevice(), &DeviceDriver::VNAmeasurementReceived, this, &VNA::NewDatapoint, Qt::UniqueConnection);
+    connect(window->getDevice(), &DeviceDriver::VNAmeasurementsReceived, this, &VNA::NewDatapoints, Qt::UniqueConnection);
     // Check if default calibration exists and attempt to load it
     QSettings s;
     auto key = "DefaultCalibration"+window->getDevice()->getSerial();
@@ -916,7 +912,7 @@ void VNA::fromJSON(nlohmann::json j)
 
 using namespace std;
 
-void VNA::NewDatapoint(DeviceDriver::VNAMeasurement m)
+void VNA::NewDatapoints(std::vector<DeviceDriver::VNAMeasurement> block)
 {
     if(isActive != true) {
         // ignore
@@ -928,115 +924,155 @@ void VNA::NewDatapoint(DeviceDriver::VNAMeasurement m)
         return;
     }
 
-    // Calculate sweep time
-    if(m.pointNum == 0) {
-        // new sweep started
-        static auto lastStart = QDateTime::currentDateTimeUtc();
-        auto now = QDateTime::currentDateTimeUtc();
-        auto sweepTime = lastStart.msecsTo(now);
-        lastStart = now;
-        qDebug() << "Sweep took"<<sweepTime<<"milliseconds";
+    TraceMath::DataType type = TraceMath::DataType::Frequency;
+    if(settings.zerospan) {
+        type = TraceMath::DataType::TimeZeroSpan;
+    } else {
+        switch(settings.sweepType) {
+        case SweepType::Last:
+        case SweepType::Frequency:
+            type = TraceMath::DataType::Frequency;
+            break;
+        case SweepType::Power:
+            type = TraceMath::DataType::Power;
+            break;
+        }
     }
 
-    emit newRawDatapoint(m);
-
-    if(singleSweep && average.getLevel() == averages) {
-        Stop();
-        return;
+    // Processed points of this block, they are passed on to the traces all at once
+    std::vector<DeviceDriver::VNAMeasurement> processed;
+    std::vector<DeviceDriver::VNAMeasurement> deembedded;
+    processed.reserve(block.size());
+    if(deembedding_active) {
+        deembedded.reserve(block.size());
     }
+    bool sweepCompleted = false;
+    bool needsSegmentUpdate = false;
+    // the calibration measurement is only reported as complete once the whole block has been handled
+    bool calCompleted = false;
+
+    for(auto &m : block) {
+        // Calculate sweep time
+        if(m.pointNum == 0) {
+            // new sweep started
+            static auto lastStart = QDateTime::currentDateTimeUtc();
+            auto now = QDateTime::currentDateTimeUtc();
+            auto sweepTime = lastStart.msecsTo(now);
+            lastStart = now;
+            qDebug() << "Sweep took"<<sweepTime<<"milliseconds";
+        }
 
-    auto m_avg = m;
+        emit newRawDatapoint(m);
 
-    bool needsSegmentUpdate = false;
-    if (settings.segments > 1) {
-        // using multiple segments, adjust pointNum
-        auto pointsPerSegment = ceil((double) settings.npoints / settings.segments);
-        if (m_avg.pointNum == pointsPerSegment - 1) {
-            needsSegmentUpdate = true;
+        if(singleSweep && average.getLevel() == averages) {
+            Stop();
+            break;
         }
-        m_avg.pointNum += pointsPerSegment * settings.activeSegment;
-        if(m_avg.pointNum == settings.npoints - 1) {
-            needsSegmentUpdate = true;
+
+        auto m_avg = m;
+
+        if (settings.segments > 1) {
+            // using multiple segments, adjust pointNum
+            auto pointsPerSegment = ceil((double) settings.npoints / settings.segments);
+            if (m_avg.pointNum == pointsPerSegment - 1) {
+                needsSegmentUpdate = true;
+            }
+            m_avg.pointNum += pointsPerSegment * settings.activeSegment;
+            if(m_avg.pointNum == settings.npoints - 1) {
+                needsSegmentUpdate = true;
+            }
         }
-    }
 
-    if(m_avg.pointNum >= settings.npoints) {
-        qWarning() << "Ignoring point with too large point number (" << m.pointNum << ")";
-        return;
-    }
+        if(m_avg.pointNum >= settings.npoints) {
+            qWarning() << "Ignoring point with too large point number (" << m.pointNum << ")";
+            continue;
+        }
 
-    m_avg = average.process(m_avg);
+        m_avg = average.process(m_avg);
 
-    window->addStreamingData(m_avg, AppWindow::VNADataType::Raw);
+        window->addStreamingData(m_avg, AppWindow::VNADataType::Raw);
 
-    if(average.settled()) {
-        setOperationPending(false);
-    }
+        if(average.settled()) {
+            setOperationPending(false);
+        }
 
-    if(calMeasuring) {
-        if(average.currentSweep() == averages) {
-            // this is the last averaging sweep, use values for calibration
-            if(!calWaitFirst || m_avg.pointNum == 0) {
-                calWaitFirst = false;
-                cal.addMeasurements(calMeasurements, m_avg);
-                if(m_avg.pointNum == settings.npoints - 1) {
-                    calMeasuring = false;
-                    cal.measurementsComplete();
+        if(calMeasuring) {
+            if(average.currentSweep() == averages) {
+                // this is the last averaging sweep, use values for calibration
+                if(!calWaitFirst || m_avg.pointNum == 0) {
+                    calWaitFirst = false;
+                    cal.addMeasurements(calMeasurements, m_avg);
+                    if(m_avg.pointNum == settings.npoints - 1) {
+                        calMeasuring = false;
+                        calCompleted = true;
+                    }
                 }
             }
+            int percentage = (((average.currentSweep() - 1) * 100) + (m_avg.pointNum + 1) * 100 / settings.npoints) / averages;
+            emit calibrationMeasurementPercentage(percentage);
         }
-        int percentage = (((average.currentSweep() - 1) * 100) + (m_avg.pointNum + 1) * 100 / settings.npoints) / averages;
-        emit calibrationMeasurementPercentage(percentage);
-    }
 
-    cal.correctMeasurement(m_avg);
+        processed.push_back(m_avg);
 
-    if(cal.getCaltype().type != Calibration::Type::None) {
-        window->addStreamingData(m_avg, AppWindow::VNADataType::Calibrated);
-    }
-
-    TraceMath::DataType type = TraceMath::DataType::Frequency;
-    if(settings.zerospan) {
-        type = TraceMath::DataType::TimeZeroSpan;
+        if(m_avg.pointNum == settings.npoints - 1) {
+            sweepCompleted = true;
+        }
 
-        // keep track of first point time
-        if(m_avg.pointNum == 0) {
-            settings.firstPointTime = m_avg.us;
-            m_avg.us = 0;
-        } else {
-            m_avg.us -= settings.firstPointTime;
+        static unsigned int lastPoint = 0;
+        if(m_avg.pointNum > 0 && m_avg.pointNum != lastPoint + 1) {
+            qWarning() << "Got point" << m_avg.pointNum << "but last received point was" << lastPoint << "("<<(m_avg.pointNum-lastPoint-1)<<"missed points)";
         }
-    } else {
-        switch(settings.sweepType) {
-        case SweepType::Last:
-        case SweepType::Frequency:
-            type = TraceMath::DataType::Frequency;
-            break;
-        case SweepType::Power:
-            type = TraceMath::DataType::Power;
+        lastPoint = m_avg.pointNum;
+
+        if(needsSegmentUpdate) {
+            // any following points still belong to the old segment, they would be ignored anyway
             break;
         }
     }
 
-    traceModel.addVNAData(m_avg, type, false);
-    if(deembedding_active) {
-        deembedding.Deembed(m_avg);
-        window->addStreamingData(m_avg, AppWindow::VNADataType::Deembedded);
-        traceModel.addVNAData(m_avg, type, true);
+    // the calibration is applied to the whole block at once
+    cal.correctMeasurements(processed);
+    bool calibrated = cal.getCaltype().type != Calibration::Type::None;
+
+    for(auto &m : processed) {
+        if(calibrated) {
+            window->addStreamingData(m, AppWindow::VNADataType::Calibrated);
+        }
+
+        if(settings.zerospan) {
+            // keep track of first point time
+            if(m.pointNum == 0) {
+                settings.firstPointTime = m.us;
+                m.us = 0;
+            } else {
+                m.us -= settings.firstPointTime;
+            }
+        }
+
+        if(deembedding_active) {
+            auto m_deembed = m;
+            deembedding.Deembed(m_deembed);
+            window->addStreamingData(m_deembed, AppWindow::VNADataType::Deembedded);
+            deembedded.push_back(m_deembed);
+        }
     }
 
+    if(processed.size() > 0) {
+        traceModel.addVNAData(processed, type, false);
+        if(deembedded.size() > 0) {
+            traceModel.addVNAData(deembedded, type, true);
+        }
 
-    emit dataChanged();
-    if(m_avg.pointNum == settings.npoints - 1) {
-        UpdateAverageCount();
-        markerModel->updateMarkers();
+        emit dataChanged();
+        if(sweepCompleted) {
+            UpdateAverageCount();
+            markerModel->updateMarkers();
+        }
     }
 
-    static unsigned int lastPoint = 0;
-    if(m_avg.pointNum > 0 && m_avg.pointNum != lastPoint + 1) {
-        qWarning() << "Got point" << m_avg.pointNum << "but last received point was" << lastPoint << "("<<(m_avg.pointNum-lastPoint-1)<<"missed points)";
+    if(calCompleted) {
+        cal.measurementsComplete();
     }
-    lastPoint = m_avg.pointNum;
 
     if (needsSegmentUpdate) {
         if( settings.activeSegment < settings.segments - 1) {
@@ -91,7 +91,7 @@ public slots:
     bool SaveCalibration(QString filename = "");
 
 private slots:
-    void NewDatapoint(DeviceDriver::VNAMeasurement m);
+    void NewDatapoints(std::vector<DeviceDriver::VNAMeasurement> block);
     void StartImpedanceMatching();
     void StartMixedModeConversion();
     // Sweep control
@@ -23,6 +23,7 @@
 #include "mode.h"
 #include "modehandler.h"
 #include "modewindow.h"
+#include "binarycontainer.h"
 #include "Device/LibreVNA/librevnausbdriver.h"
 #include "Device/LibreVNA/librevnatcpdriver.h"
 
@@ -122,19 +123,19 @@ AppWindow::AppWindow(QWidget *parent)
     }
 
     if(p.StreamingServers.VNARawData.enabled) {
-        streamVNARawData = new StreamingServer(p.StreamingServers.VNARawData.port);
+        streamVNARawData = new StreamingServer(p.StreamingServers.VNARawData.port, p.StreamingServers.VNARawData.binary);
     }
     if(p.StreamingServers.VNACalibratedData.enabled) {
-        streamVNACalibratedData = new StreamingServer(p.StreamingServers.VNACalibratedData.port);
+        streamVNACalibratedData = new StreamingServer(p.StreamingServers.VNACalibratedData.port, p.StreamingServers.VNACalibratedData.binary);
     }
     if(p.StreamingServers.VNADeembeddedData.enabled) {
-        streamVNADeembeddedData = new StreamingServer(p.StreamingServers.VNADeembeddedData.port);
+        streamVNADeembeddedData = new StreamingServer(p.StreamingServers.VNADeembeddedData.port, p.StreamingServers.VNADeembeddedData.binary);
     }
     if(p.StreamingServers.SARawData.enabled) {
-        streamSARawData = new StreamingServer(p.StreamingServers.SARawData.port);
+        streamSARawData = new StreamingServer(p.StreamingServers.SARawData.port, p.StreamingServers.SARawData.binary);
     }
     if(p.StreamingServers.SANormalizedData.enabled) {
-        streamSANormalizedData = new StreamingServer(p.StreamingServers.SANormalizedData.port);
+        streamSANormalizedData = new StreamingServer(p.StreamingServers.SANormalizedData.port, p.StreamingServers.SANormalizedData.binary);
     }
 
     ui->setupUi(this);
@@ -229,15 +230,19 @@ void AppWindow::SetupMenu()
     connect(ui->actionDisconnect, &QAction::triggered, this, &AppWindow::DisconnectDevice);
     connect(ui->actionQuit, &QAction::triggered, this, &AppWindow::close);
     connect(ui->actionSave_setup, &QAction::triggered, [=](){
-        auto filename = QFileDialog::getSaveFileName(nullptr, "Save setup data", "", "Setup files (*.setup)", nullptr, Preferences::QFileDialogOptions());
+        QString filter;
+        auto filename = QFileDialog::getSaveFileName(nullptr, "Save setup data", "", "Setup files (*.setup);;Binary setup files (*.setupbin)", &filter, Preferences::QFileDialogOptions());
         if(filename.isEmpty()) {
             // aborted selection
             return;
         }
+        if(filter.contains("*.setupbin") && !filename.endsWith(".setupbin", Qt::CaseInsensitive)) {
+            filename.append(".setupbin");
+        }
         SaveSetup(filename);
     });
     connect(ui->actionLoad_setup, &QAction::triggered, [=](){
-        auto filename = QFileDialog::getOpenFileName(nullptr, "Load setup data", "", "Setup files (*.setup)", nullptr, Preferences::QFileDialogOptions());
+        auto filename = QFileDialog::getOpenFileName(nullptr, "Load setup data", "", "Setup files (*.setup *.setupbin)", nullptr, Preferences::QFileDialogOptions());
         if(filename.isEmpty()) {
             // aborted selection
             return;
@@ -521,6 +526,7 @@ void AppWindow::SetupSCPI()
     scpi.add(new SCPICommand("*RST", [=](QStringList){
         SetResetState();
         ResetReference();
+        scpi.resetDataFormat();
         return SCPI::getResultName(SCPI::Result::Empty);
     }, nullptr));
     auto scpi_dev = new SCPINode("DEVice");
@@ -783,6 +789,7 @@ void AppWindow::StartTCPServer(int port)
     server = new TCPServer(port);
     connect(server, &TCPServer::received, &scpi, &SCPI::input);
     connect(&scpi, &SCPI::output, server, &TCPServer::send);
+    connect(&scpi, &SCPI::outputBlock, server, &TCPServer::sendBlock);
 }
 
 void AppWindow::StopTCPServer()
@@ -805,23 +812,23 @@ void AppWindow::preferencesChanged()
         StartTCPServer(p.SCPIServer.port);
     }
 
-    auto updateStreamingServer = [](StreamingServer **server, bool enabled, int port) {
+    auto updateStreamingServer = [](StreamingServer **server, bool enabled, int port, bool binary) {
         if(*server && !enabled) {
             delete *server;
             *server = nullptr;
         } else if(!*server && enabled) {
-            *server = new StreamingServer(port);
-        } else if(*server && (*server)->getPort() != port) {
+            *server = new StreamingServer(port, binary);
+        } else if(*server && ((*server)->getPort() != port || (*server)->isBinary() != binary)) {
             delete *server;
-            *server = new StreamingServer(port);
+            *server = new StreamingServer(port, binary);
         }
     };
 
-    updateStreamingServer(&streamVNARawData, p.StreamingServers.VNARawData.enabled, p.StreamingServers.VNARawData.port);
-    updateStreamingServer(&streamVNACalibratedData, p.StreamingServers.VNACalibratedData.enabled, p.StreamingServers.VNACalibratedData.port);
-    updateStreamingServer(&streamVNADeembeddedData, p.StreamingServers.VNADeembeddedData.enabled, p.StreamingServers.VNADeembeddedData.port);
-    updateStreamingServer(&streamSARawData, p.StreamingServers.SARawData.enabled, p.StreamingServers.SARawData.port);
-    updateStreamingServer(&streamSANormalizedData, p.StreamingServers.SANormalizedData.enabled, p.StreamingServers.SANormalizedData.port);
+    updateStreamingServer(&streamVNARawData, p.StreamingServers.VNARawData.enabled, p.StreamingServers.VNARawData.port, p.StreamingServers.VNARawData.binary);
+    updateStreamingServer(&streamVNACalibratedData, p.StreamingServers.VNACalibratedData.enabled, p.StreamingServers.VNACalibratedData.port, p.StreamingServers.VNACalibratedData.binary);
+    updateStreamingServer(&streamVNADeembeddedData, p.StreamingServers.VNADeembeddedData.enabled, p.StreamingServers.VNADeembeddedData.port, p.StreamingServers.VNADeembeddedData.binary);
+    updateStreamingServer(&streamSARawData, p.StreamingServers.SARawData.enabled, p.StreamingServers.SARawData.port, p.StreamingServers.SARawData.binary);
+    updateStreamingServer(&streamSANormalizedData, p.StreamingServers.SANormalizedData.enabled, p.StreamingServers.SANormalizedData.port, p.StreamingServers.SANormalizedData.binary);
 
     // averaging mode may have changed, update for all relevant modes
     for (auto m : modeHandler->getModes())
@@ -830,12 +837,7 @@ void AppWindow::preferencesChanged()
         {
             case Mode::Type::VNA:
             case Mode::Type::SA:
-                if(p.Acquisition.useMedianAveraging) {
-                    m->setAveragingMode(Averaging::Mode::Median);
-                }
-                else {
-                    m->setAveragingMode(Averaging::Mode::Mean);
-                }
+                m->setAveragingMode((Averaging::Mode) p.Acquisition.averagingMode);
                 break;
             case Mode::Type::SG:
             case Mode::Type::Last:
@@ -1087,13 +1089,21 @@ void AppWindow::DeviceInfoUpdated()
 
 void AppWindow::SaveSetup(QString filename)
 {
-    if(!filename.endsWith(".setup")) {
-        filename.append(".setup");
+    if(filename.endsWith(".setupbin", Qt::CaseInsensitive)) {
+        // compact binary format, trace data is stored in arrays instead of JSON text
+        BinaryContainer container;
+        if(!container.save(filename, container.pack(SaveSetup()))) {
+            qWarning() << "Unable to write setup file:" << filename;
+        }
+    } else {
+        if(!filename.endsWith(".setup")) {
+            filename.append(".setup");
+        }
+        ofstream file;
+        file.open(filename.toStdString());
+        file << setw(4) << SaveSetup() << endl;
+        file.close();
     }
-    ofstream file;
-    file.open(filename.toStdString());
-    file << setw(4) << SaveSetup() << endl;
-    file.close();
     QFileInfo fi(filename);
     lSetupName.setText("Setup: "+fi.fileName());
 }
@@ -1124,6 +1134,22 @@ nlohmann::json AppWindow::SaveSetup()
 
 bool AppWindow::LoadSetup(QString filename)
 {
+    if(BinaryContainer::isBinary(filename)) {
+        nlohmann::json j;
+        try {
+            BinaryContainer container;
+            container.open(filename);
+            j = container.unpack(container.getDocument());
+        } catch (exception &e) {
+            InformationBox::ShowError("Error", "Failed to parse the setup file (" + QString(e.what()) + ")");
+            qWarning() << "Parsing of setup file failed: " << e.what();
+            return false;
+        }
+        LoadSetup(j);
+        QFileInfo fi(filename);
+        lSetupName.setText("Setup: "+fi.fileName());
+        return true;
+    }
     ifstream file;
     file.open(filename.toStdString());
     if(!file.is_open()) {
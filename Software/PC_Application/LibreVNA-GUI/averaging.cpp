@@ -1,75 +1,71 @@
 #include "averaging.h"
 
+#include <QDebug>
+
+#include <algorithm>
+
 using namespace std;
 
 Averaging::Averaging()
 {
     averages = 1;
+    numPoints = 0;
     numMeasurements = 0;
     mode = Mode::Mean;
 }
 
 void Averaging::reset(unsigned int points)
 {
-    avg.clear();
-    for(unsigned int i = 0;i<points;i++) {
-        avg.push_back(deque<vector<complex<double>>>());
-    }
+    // discard all samples, the storage itself is kept
+    numPoints = 0;
+    state.clear();
+    sums.clear();
+    exponential.clear();
+    resize(points, numMeasurements, averages);
 }
 
 void Averaging::setAverages(unsigned int a)
 {
-    averages = a;
-    // throw away additional stored data if averaging has been reduced
-    for(auto &d : avg) {
-        while(d.size() > averages) {
-            d.pop_front();
-        }
+    a = max(a, 1U);
+    if(a != averages) {
+        // keeps the newest samples if averaging has been reduced
+        resize(numPoints, numMeasurements, a);
     }
 }
 
 DeviceDriver::VNAMeasurement Averaging::process(DeviceDriver::VNAMeasurement d)
 {
     if(d.measurements.size() != numMeasurements) {
-        numMeasurements = d.measurements.size();
-        reset(avg.size());
-    }
-
-    vector<complex<double>> data;
-    for(auto m : d.measurements) {
-        data.push_back(m.second);
-    }
-    process(d.pointNum, data);
-    int i=0;
-    for(auto &m : d.measurements) {
-        m.second = data[i++];
+        resize(numPoints, d.measurements.size(), averages);
     }
+    // averaged in place
+    process(d.pointNum, d.measurements.data());
     return d;
 }
 
 DeviceDriver::SAMeasurement Averaging::process(DeviceDriver::SAMeasurement d)
 {
     if(d.measurements.size() != numMeasurements) {
-        numMeasurements = d.measurements.size();
-        reset(avg.size());
+        resize(numPoints, d.measurements.size(), averages);
     }
 
-    vector<complex<double>> data;
-    for(auto m : d.measurements) {
-        data.push_back(m.second);
+    SAValues.resize(numMeasurements);
+    unsigned int i=0;
+    for(auto &m : d.measurements) {
+        SAValues[i++] = m.second;
     }
-    process(d.pointNum, data);
-    int i=0;
+    process(d.pointNum, SAValues.data());
+    i=0;
     for(auto &m : d.measurements) {
-        m.second = data[i++].real();
+        m.second = SAValues[i++].real();
     }
     return d;
 }
 
 unsigned int Averaging::getLevel()
 {
-    if(avg.size() > 0) {
-        return avg.back().size();
+    if(state.size() > 0) {
+        return state.back().stored;
     } else {
         return 0;
     }
@@ -77,8 +73,8 @@ unsigned int Averaging::getLevel()
 
 unsigned int Averaging::currentSweep()
 {
-    if(avg.size() > 0) {
-        return avg.front().size();
+    if(state.size() > 0) {
+        return state.front().stored;
     } else {
         return 0;
     }
@@ -96,82 +92,141 @@ Averaging::Mode Averaging::getMode() const
 
 void Averaging::setMode(const Mode &value)
 {
-    mode = value;
+    switch(value) {
+    case Mode::Mean:
+    case Mode::Median:
+    case Mode::Exponential:
+        mode = value;
+        break;
+    default:
+        // the mode is passed on from the preferences as an integer, unknown values would leave the points unaveraged
+        qWarning() << "Unknown averaging mode" << (int) value << ", using mean";
+        mode = Mode::Mean;
+        break;
+    }
 }
 
-void Averaging::process(unsigned int pointNum, std::vector<std::complex<double>> &data)
+void Averaging::process(unsigned int pointNum, std::complex<double> *values)
 {
-    if(data.size() != numMeasurements) {
-        numMeasurements = data.size();
-        reset(avg.size());
+    if(pointNum == numPoints) {
+        // add moving average entry
+        resize(numPoints + 1, numMeasurements, averages);
+    }
+    if(pointNum >= numPoints) {
+        // unable to average this point
+        return;
     }
 
-    if (pointNum == avg.size()) {
-        // add moving average entry
-        deque<vector<complex<double>>> deque;
-        avg.push_back(deque);
-    }
-
-    if (pointNum < avg.size()) {
-        // can compute average
-        // get correct queue
-        auto deque = &avg[pointNum];
-        // add newest sample to queue
-        deque->push_back(data);
-        // remove oldest sample if required number of averages reached
-        while(deque->size() > averages) {
-            deque->pop_front();
+    auto &s = state[pointNum];
+    auto sum = &sums[(size_t) pointNum * numMeasurements];
+    complex<double> *slot;
+    if(s.stored < averages) {
+        slot = sample(pointNum, s.stored);
+        s.stored++;
+    } else {
+        // replace the oldest sample
+        slot = sample(pointNum, s.oldest);
+        for(unsigned int i=0;i<numMeasurements;i++) {
+            sum[i] -= slot[i];
         }
+        s.oldest = (s.oldest + 1) % averages;
+    }
+    copy(values, values + numMeasurements, slot);
+    if(s.stored == averages && s.oldest == 0) {
+        // recalculate the sum once per cycle through the buffer, keeps rounding errors from adding up
+        updateSum(pointNum);
+    } else {
+        for(unsigned int i=0;i<numMeasurements;i++) {
+            sum[i] += values[i];
+        }
+    }
+    auto ema = &exponential[(size_t) pointNum * numMeasurements];
+    for(unsigned int i=0;i<numMeasurements;i++) {
+        ema[i] += (values[i] - ema[i]) / (double) s.stored;
+    }
 
-        std::deque<complex<double>> averagedResults = {};
-
-        switch(mode) {
-        case Mode::Mean: {
-            // calculate average
-            complex<double> sum[numMeasurements];
-            for(auto s : *deque) {
-                for(unsigned int i=0;i<numMeasurements;i++) {
-                    sum[i] += s[i];
-                }
-            }
-            for(auto s : sum) {
-                averagedResults.push_back(s / (double) (deque->size()));
-            }
+    switch(mode) {
+    case Mode::Mean:
+        for(unsigned int i=0;i<numMeasurements;i++) {
+            values[i] = sum[i] / (double) s.stored;
         }
-            break;
-        case Mode::Median: {
-            auto size = deque->size();
-            // create sorted vectors
-            vector<vector<complex<double>>> vectors(numMeasurements);
-
-            auto comp = [=](const complex<double>&a, const complex<double>&b){
-                return abs(a) < abs(b);
-            };
-            for(auto d : *deque) {
-                int i=0;
-                for(auto &v : vectors) {
-                    v.insert(upper_bound(v.begin(), v.end(), d[i], comp), d[i]);
-                    i++;
-                }
+        break;
+    case Mode::Median: {
+        auto comp = [=](const complex<double>&a, const complex<double>&b){
+            return norm(a) < norm(b);
+        };
+        auto size = s.stored;
+        medianSamples.resize(size);
+        for(unsigned int i=0;i<numMeasurements;i++) {
+            for(unsigned int j=0;j<size;j++) {
+                medianSamples[j] = sample(pointNum, j)[i];
             }
+            auto middle = medianSamples.begin() + size / 2;
+            nth_element(medianSamples.begin(), middle, medianSamples.end(), comp);
             if(size & 0x01) {
                 // odd number of samples
-                for(auto v : vectors) {
-                    averagedResults.push_back(v[size / 2]);
-                }
+                values[i] = *middle;
             } else {
-                // even number, use average of middle samples
-                for(auto v : vectors) {
-                    averagedResults.push_back((v[size / 2 - 1] + v[size / 2]) / 2.0);
-                }
+                // even number, use average of middle samples (the largest one below the middle)
+                values[i] = (*max_element(medianSamples.begin(), middle, comp) + *middle) / 2.0;
             }
         }
-            break;
+    }
+        break;
+    case Mode::Exponential:
+        copy(ema, ema + numMeasurements, values);
+        break;
+    }
+}
+
+void Averaging::resize(unsigned int points, unsigned int measurements, unsigned int averages)
+{
+    if(measurements == numMeasurements && averages == this->averages) {
+        // the point is the outermost dimension of the storage, the samples of the other points stay in place
+        numPoints = points;
+        state.resize(points, {0, 0});
+        samples.resize((size_t) points * averages * measurements);
+        sums.resize((size_t) points * measurements);
+        exponential.resize((size_t) points * measurements);
+        return;
+    }
+
+    vector<PointState> newState(points, {0, 0});
+    vector<complex<double>> newSamples((size_t) points * averages * measurements);
+    vector<complex<double>> newExponential((size_t) points * measurements);
+    if(measurements == numMeasurements) {
+        // number of averages changed, keep the newest samples
+        for(unsigned int p=0;p<min(points, numPoints);p++) {
+            auto &s = state[p];
+            auto keep = min(s.stored, averages);
+            for(unsigned int i=0;i<keep;i++) {
+                auto src = sample(p, (s.oldest + s.stored - keep + i) % this->averages);
+                copy(src, src + measurements, &newSamples[((size_t) p * averages + i) * measurements]);
+            }
+            newState[p].stored = keep;
+            copy_n(&exponential[(size_t) p * measurements], measurements, &newExponential[(size_t) p * measurements]);
         }
+    }
+    numPoints = points;
+    numMeasurements = measurements;
+    this->averages = averages;
+    state.swap(newState);
+    samples.swap(newSamples);
+    exponential.swap(newExponential);
+    sums.assign((size_t) points * measurements, 0.0);
+    for(unsigned int p=0;p<points;p++) {
+        updateSum(p);
+    }
+}
 
-        for(auto &m : data) {
-            m = averagedResults.front();
-            averagedResults.pop_front();
+void Averaging::updateSum(unsigned int point)
+{
+    auto sum = &sums[(size_t) point * numMeasurements];
+    fill(sum, sum + numMeasurements, 0.0);
+    for(unsigned int j=0;j<state[point].stored;j++) {
+        auto s = sample(point, j);
+        for(unsigned int i=0;i<numMeasurements;i++) {
+            sum[i] += s[i];
         }
     }
 }
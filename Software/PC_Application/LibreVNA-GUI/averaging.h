@@ -3,16 +3,27 @@
 
 #include "Device/devicedriver.h"
 
-#include <array>
-#include <deque>
+#include <vector>
 #include <complex>
 
+/**
+ * @brief Averages measurements of repeated sweeps point by point
+ *
+ * The last samples of every point are kept in a preallocated circular buffer, one contiguous block with the layout
+ * [point][sample][measurement] is used for all points. A running sum per point and measurement makes the mean
+ * independent of the number of averages and the median only selects the middle sample(s) instead of sorting. The
+ * exponential average does not depend on the stored samples at all and keeps averaging after all averages have been
+ * taken. VNA and SA measurements use the same storage.
+ */
 class Averaging
 {
 public:
     enum class Mode {
         Mean,
-        Median
+        Median,
+        // exponential moving average with a weight of 1/averages for the newest sample (1/sample count until that many
+        // samples have been taken)
+        Exponential,
     };
 
     Averaging();
@@ -32,12 +43,38 @@ public:
     void setMode(const Mode &value);
 
 private:
-    void process(unsigned int pointNum, std::vector<std::complex<double> > &data);
+    // Adds the values (numMeasurements) of a point and replaces them with the averaged result
+    void process(unsigned int pointNum, std::complex<double> *values);
+    // (Re-)allocates the storage for the current number of points, measurements and averages, keeping the newest samples
+    void resize(unsigned int points, unsigned int measurements, unsigned int averages);
+    // Recalculates the running sum of a point from its stored samples
+    void updateSum(unsigned int point);
+    std::complex<double> *sample(unsigned int point, unsigned int index) {
+        return &samples[((std::size_t) point * averages + index) * numMeasurements];
+    }
 
-    std::vector<std::deque<std::vector<std::complex<double>>>> avg;
+    class PointState {
+    public:
+        // number of stored samples (at most averages)
+        unsigned int stored;
+        // index of the oldest stored sample, the next sample is placed here once the buffer is full
+        unsigned int oldest;
+    };
+
+    unsigned int numPoints;
     unsigned int numMeasurements;
     unsigned int averages;
     Mode mode;
+
+    std::vector<PointState> state;
+    // [point][sample][measurement]
+    std::vector<std::complex<double>> samples;
+    // [point][measurement]
+    std::vector<std::complex<double>> sums;
+    std::vector<std::complex<double>> exponential;
+    // temporary storage
+    std::vector<std::complex<double>> SAValues;
+    std::vector<std::complex<double>> medianSamples;
 };
 
 #endif // AVERAGING_H
@@ -0,0 +1,230 @@
+#include "binarycontainer.h"
+
+#include <QtEndian>
+
+#include <cstring>
+#include <stdexcept>
+
+#if Q_BYTE_ORDER != Q_LITTLE_ENDIAN
+#error "The binary container format is only implemented for little endian platforms"
+#endif
+
+using namespace std;
+
+// keys of the object that replaces a packed array of objects
+static const string columnsKey = "binaryColumns";
+static const string rowsKey = "binaryRows";
+
+BinaryContainer::BinaryContainer()
+{
+
+}
+
+unsigned int BinaryContainer::addArray(std::vector<double> values)
+{
+    added.push_back(std::move(values));
+    return added.size() - 1;
+}
+
+nlohmann::json BinaryContainer::pack(const nlohmann::json &j)
+{
+    if(j.is_object()) {
+        auto ret = nlohmann::json::object();
+        for(auto it = j.begin(); it != j.end(); it++) {
+            ret[it.key()] = pack(it.value());
+        }
+        return ret;
+    } else if(!j.is_array()) {
+        return j;
+    }
+    if(j.size() >= minimumRows && j.front().is_structured()) {
+        // the fields of the first element determine the columns
+        auto first = j.front().flatten();
+        bool packable = !first.empty() && first.unflatten() == j.front();
+        vector<string> names;
+        for(auto it = first.begin(); it != first.end() && packable; it++) {
+            packable = it.value().is_number_float();
+            names.push_back(it.key());
+        }
+        vector<vector<double>> columns(names.size());
+        for(auto &c : columns) {
+            c.reserve(j.size());
+        }
+        for(auto e = j.begin(); e != j.end() && packable; e++) {
+            // every element needs exactly the same fields
+            auto flat = e->flatten();
+            if(flat.size() != names.size()) {
+                packable = false;
+                break;
+            }
+            for(unsigned int i=0;i<names.size();i++) {
+                auto field = flat.find(names[i]);
+                if(field == flat.end() || !field->is_number_float()) {
+                    packable = false;
+                    break;
+                }
+                columns[i].push_back(field->get<double>());
+            }
+        }
+        if(packable) {
+            nlohmann::json jcolumns;
+            for(unsigned int i=0;i<names.size();i++) {
+                jcolumns[names[i]] = addArray(std::move(columns[i]));
+            }
+            nlohmann::json ret;
+            ret[columnsKey] = jcolumns;
+            ret[rowsKey] = j.size();
+            return ret;
+        }
+    }
+    auto ret = nlohmann::json::array();
+    for(auto &e : j) {
+        ret.push_back(pack(e));
+    }
+    return ret;
+}
+
+bool BinaryContainer::save(QString filename, const nlohmann::json &document)
+{
+    QFile f(filename);
+    if(!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    auto text = document.dump();
+
+    Header header;
+    memcpy(header.identifier, identifier, sizeof(identifier));
+    header.version = version;
+    header.arrays = added.size();
+    vector<IndexEntry> index;
+    quint64 offset = sizeof(Header) + added.size() * sizeof(IndexEntry);
+    for(auto &a : added) {
+        index.push_back({offset, a.size()});
+        offset += a.size() * sizeof(double);
+    }
+    header.documentOffset = offset;
+    header.documentSize = text.size();
+
+    bool success = f.write((const char*) &header, sizeof(header)) == sizeof(header);
+    if(!index.empty()) {
+        success &= f.write((const char*) index.data(), index.size() * sizeof(IndexEntry)) == (qint64) (index.size() * sizeof(IndexEntry));
+    }
+    for(auto &a : added) {
+        if(!a.empty()) {
+            success &= f.write((const char*) a.data(), a.size() * sizeof(double)) == (qint64) (a.size() * sizeof(double));
+        }
+    }
+    success &= f.write(text.data(), text.size()) == (qint64) text.size();
+    success &= f.flush();
+    return success;
+}
+
+bool BinaryContainer::isBinary(QString filename)
+{
+    QFile f(filename);
+    if(!f.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    char buffer[sizeof(identifier)];
+    return f.read(buffer, sizeof(buffer)) == sizeof(buffer) && memcmp(buffer, identifier, sizeof(identifier)) == 0;
+}
+
+void BinaryContainer::open(QString filename)
+{
+    arrays.clear();
+    document = nlohmann::json();
+    file.close();
+    file.setFileName(filename);
+    if(!file.open(QIODevice::ReadOnly)) {
+        throw runtime_error("Unable to open file "+filename.toStdString());
+    }
+    quint64 size = file.size();
+    if(size < sizeof(Header)) {
+        throw runtime_error("File too short for binary format");
+    }
+    auto data = file.map(0, size);
+    if(!data) {
+        throw runtime_error("Unable to map file "+filename.toStdString());
+    }
+    Header header;
+    memcpy(&header, data, sizeof(header));
+    if(memcmp(header.identifier, identifier, sizeof(identifier)) != 0) {
+        throw runtime_error("Not a binary file");
+    }
+    if(header.version > version) {
+        throw runtime_error("Unsupported binary format version "+to_string(header.version));
+    }
+    if(header.arrays > (size - sizeof(Header)) / sizeof(IndexEntry)) {
+        throw runtime_error("Array index exceeds file size");
+    }
+    for(unsigned int i=0;i<header.arrays;i++) {
+        IndexEntry entry;
+        memcpy(&entry, data + sizeof(Header) + i * sizeof(IndexEntry), sizeof(entry));
+        if(entry.offset % sizeof(double) != 0 || entry.offset > size || entry.size > (size - entry.offset) / sizeof(double)) {
+            throw runtime_error("Invalid array "+to_string(i));
+        }
+        arrays.push_back({(const double*) (data + entry.offset), entry.size});
+    }
+    if(header.documentOffset > size || header.documentSize > size - header.documentOffset) {
+        throw runtime_error("Document exceeds file size");
+    }
+    auto text = (const char*) data + header.documentOffset;
+    document = nlohmann::json::parse(text, text + header.documentSize);
+}
+
+const double *BinaryContainer::getArray(unsigned int index) const
+{
+    if(index >= arrays.size()) {
+        return nullptr;
+    }
+    return arrays[index].data;
+}
+
+unsigned long long BinaryContainer::getArraySize(unsigned int index) const
+{
+    if(index >= arrays.size()) {
+        return 0;
+    }
+    return arrays[index].size;
+}
+
+nlohmann::json BinaryContainer::unpack(const nlohmann::json &j) const
+{
+    if(j.is_array()) {
+        auto ret = nlohmann::json::array();
+        for(auto &e : j) {
+            ret.push_back(unpack(e));
+        }
+        return ret;
+    } else if(!j.is_object()) {
+        return j;
+    }
+    if(j.size() == 2 && j.contains(columnsKey) && j.contains(rowsKey)) {
+        // restore the array of objects from the columns
+        unsigned long long rows = j[rowsKey];
+        vector<nlohmann::json::json_pointer> fields;
+        vector<const double*> columns;
+        for(auto it = j[columnsKey].begin(); it != j[columnsKey].end(); it++) {
+            unsigned int index = it.value();
+            if(getArraySize(index) != rows) {
+                throw runtime_error("Invalid column "+it.key());
+            }
+            fields.push_back(nlohmann::json::json_pointer(it.key()));
+            columns.push_back(getArray(index));
+        }
+        auto ret = nlohmann::json::array();
+        for(unsigned long long r=0;r<rows;r++) {
+            nlohmann::json e;
+            for(unsigned int i=0;i<fields.size();i++) {
+                e[fields[i]] = columns[i][r];
+            }
+            ret.push_back(std::move(e));
+        }
+        return ret;
+    }
+    auto ret = nlohmann::json::object();
+    for(auto it = j.begin(); it != j.end(); it++) {
+        ret[it.key()] = unpack(it.value());
+    }
+    return ret;
+}
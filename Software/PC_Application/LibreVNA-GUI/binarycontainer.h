@@ -0,0 +1,85 @@
+#ifndef BINARYCONTAINER_H
+#define BINARYCONTAINER_H
+
+#include "json.hpp"
+
+#include <QFile>
+#include <QString>
+
+#include <vector>
+
+/**
+ * @brief Compact binary file format for JSON documents with large amounts of numeric data
+ *
+ * Arrays of objects which all contain the same floating point fields (e.g. the points of a calibration measurement or
+ * the data of a trace) are moved out of the document by pack() and stored column wise as contiguous float64 arrays.
+ * The remaining document only references these arrays. Additional arrays can be added directly with addArray().
+ *
+ * File layout (native byte order, which is little endian on all supported platforms):
+ * - header: identifier "LVNABIN\0", format version (uint32), number of arrays (uint32), offset and size of the document (uint64 each)
+ * - array index: offset and number of values (uint64 each) for every array
+ * - array data: float64 values, all arrays start at an offset aligned to 8 bytes
+ * - document: JSON text
+ *
+ * For reading, the file is memory mapped. The arrays are used in place and only the parts that are actually accessed
+ * are read from disk.
+ */
+class BinaryContainer
+{
+public:
+    BinaryContainer();
+
+    // Adds an array to the file. Returns the index that has to be stored in the document to reference the array
+    unsigned int addArray(std::vector<double> values);
+    // Moves all arrays of objects with identical floating point fields into column arrays, returns the remaining document
+    nlohmann::json pack(const nlohmann::json &j);
+    // Writes the document and all added arrays. Returns false if the file could not be written
+    bool save(QString filename, const nlohmann::json &document);
+
+    // Returns true if the file starts with the identifier of this format
+    static bool isBinary(QString filename);
+    // Maps the file and reads the document. Throws std::runtime_error if the file is not a valid container
+    void open(QString filename);
+    const nlohmann::json &getDocument() const {return document;}
+    unsigned int getNumArrays() const {return arrays.size();}
+    // Returns the values of an array, pointing into the mapped file (valid as long as the container exists)
+    const double *getArray(unsigned int index) const;
+    unsigned long long getArraySize(unsigned int index) const;
+    // Restores the arrays of objects which were moved into column arrays by pack(). Throws std::runtime_error if the
+    // referenced arrays do not exist
+    nlohmann::json unpack(const nlohmann::json &j) const;
+
+private:
+    static constexpr char identifier[8] = {'L', 'V', 'N', 'A', 'B', 'I', 'N', '\0'};
+    static constexpr unsigned int version = 1;
+    // arrays of objects are only packed if they have at least this number of elements
+    static constexpr unsigned int minimumRows = 16;
+
+    class Header {
+    public:
+        char identifier[8];
+        quint32 version;
+        quint32 arrays;
+        quint64 documentOffset;
+        quint64 documentSize;
+    };
+    class IndexEntry {
+    public:
+        quint64 offset;
+        quint64 size;
+    };
+    class Array {
+    public:
+        const double *data;
+        unsigned long long size;
+    };
+
+    // arrays added for writing
+    std::vector<std::vector<double>> added;
+    // arrays of the mapped file
+    std::vector<Array> arrays;
+    QFile file;
+    nlohmann::json document;
+};
+
+#endif // BINARYCONTAINER_H
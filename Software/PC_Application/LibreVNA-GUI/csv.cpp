@@ -1,12 +1,18 @@
 #include "csv.h"
 
+#include "Util/textio.h"
+#include "Util/util.h"
+
 #include <exception>
 #include <fstream>
+#include <cstring>
 #include <QStringList>
-#include <iomanip>
 
 using namespace std;
 
+// data lines are parsed in parallel in chunks of at least this number of lines
+static constexpr unsigned int minimumLinesPerThread = 1024;
+
 CSV::CSV()
 {
 
@@ -15,39 +21,43 @@ CSV::CSV()
 CSV CSV::fromFile(QString filename, char sep)
 {
     CSV csv;
-    ifstream file;
-    file.open(filename.toStdString());
-    if(!file.is_open()) {
-        throw runtime_error("Unable to open file:"+filename.toStdString());
-    }
-    string line;
-    bool firstLine = true;
-    while(getline(file, line)) {
-        auto qline = QString::fromStdString(line);
-        auto stringList = qline.split(sep);
-        if(firstLine) {
-            // create columns and set headers
-            for(auto l : stringList) {
-                if(l.isEmpty()) {
-                    // header needs to be present, abort here
-                    break;
-                }
-                Column c;
-                c.header = l;
-                csv._columns.push_back(c);
+    TextIO::FileView file(filename);
+    auto lines = TextIO::splitLines(file.begin(), file.end());
+    if(lines.size() > 0) {
+        // create columns and set headers
+        auto stringList = QString::fromUtf8(lines[0].begin, lines[0].end - lines[0].begin).split(sep);
+        for(auto l : stringList) {
+            if(l.isEmpty()) {
+                // header needs to be present, abort here
+                break;
             }
-            firstLine = false;
-        } else {
-            // not the header, attempt to parse data
-            for(unsigned int i=0;i < csv._columns.size();i++) {
+            Column c;
+            c.header = l;
+            c.data.resize(lines.size() - 1);
+            csv._columns.push_back(std::move(c));
+        }
+    }
+    // not the header, attempt to parse data. Missing or invalid values are set to zero
+    Util::parallelFor(lines.size() > 0 ? lines.size() - 1 : 0, minimumLinesPerThread, [&](unsigned int begin, unsigned int end) {
+        for(unsigned int i=begin;i<end;i++) {
+            auto &line = lines[i + 1];
+            auto pos = line.begin;
+            for(unsigned int j=0;j < csv._columns.size();j++) {
                 double value = 0.0;
-                if(i < (unsigned int) stringList.size()) {
-                    value = stringList[i].toDouble();
+                auto fieldEnd = pos < line.end ? (const char*) memchr(pos, sep, line.end - pos) : nullptr;
+                if(!fieldEnd) {
+                    fieldEnd = line.end;
+                }
+                auto valueBegin = TextIO::skipBlanks(pos, fieldEnd);
+                auto valueEnd = TextIO::parseDouble(valueBegin, fieldEnd, value);
+                if(!valueEnd || TextIO::skipBlanks(valueEnd, fieldEnd) != fieldEnd) {
+                    value = 0.0;
                 }
-                csv._columns[i].data.push_back(value);
+                csv._columns[j].data[i] = value;
+                pos = fieldEnd < line.end ? fieldEnd + 1 : line.end;
             }
         }
-    }
+    });
     csv.filename = filename;
     return csv;
 }
@@ -59,24 +69,26 @@ void CSV::toFile(QString filename, char sep)
         filename.append(".csv");
     }
     file.open(filename.toStdString());
-    file << setprecision(10);
+    TextIO::Writer writer(&file);
     unsigned maxlen = 0;
-    for(auto c : _columns) {
-        file << c.header.toStdString();
-        file << sep;
+    for(auto &c : _columns) {
+        writer.write(c.header.toStdString());
+        writer.write(sep);
         if(c.data.size() > maxlen) {
             maxlen = c.data.size();
         }
     }
-    file << endl;
+    writer.write('\n');
     for(unsigned int i=0;i<maxlen;i++) {
-        for(auto c : _columns) {
+        for(auto &c : _columns) {
             if(i < c.data.size()) {
-                file << c.data[i] << sep;
+                writer.write(c.data[i], 10, false);
+                writer.write(sep);
             }
         }
-        file << endl;
+        writer.write('\n');
     }
+    writer.flush();
     file.close();
     this->filename = filename;
 }
@@ -4,6 +4,7 @@
 #include "CustomWidgets/informationbox.h"
 #include "appwindow.h"
 #include "Device/LibreVNA/Compound/compounddeviceeditdialog.h"
+#include "averaging.h"
 
 #include <QSettings>
 #include <QPushButton>
@@ -255,7 +256,7 @@ void PreferencesDialog::setInitialGUIState()
 
     ui->AcquisitionAlwaysExciteBoth->setChecked(p->Acquisition.alwaysExciteAllPorts);
     ui->AcquisitionAllowSegmentedSweep->setChecked(p->Acquisition.allowSegmentedSweep);
-    ui->AcquisitionAveragingMode->setCurrentIndex(p->Acquisition.useMedianAveraging ? 1 : 0);
+    ui->AcquisitionAveragingMode->setCurrentIndex(p->Acquisition.averagingMode);
     ui->AcquisitionFullSpanBehavior->setCurrentIndex(p->Acquisition.fullSpanManual ? 1 : 0);
     ui->AcquisitionFullSpanStart->setValue(p->Acquisition.fullSpanStart);
     ui->AcquisitionFullSpanStop->setValue(p->Acquisition.fullSpanStop);
@@ -324,14 +325,19 @@ void PreferencesDialog::setInitialGUIState()
 
     ui->streamingServerVNArawEnabled->setChecked(p->StreamingServers.VNARawData.enabled);
     ui->streamingServerVNArawPort->setValue(p->StreamingServers.VNARawData.port);
+    ui->streamingServerVNArawFormat->setCurrentIndex(p->StreamingServers.VNARawData.binary ? 1 : 0);
     ui->streamingServerVNAcalibratedEnabled->setChecked(p->StreamingServers.VNACalibratedData.enabled);
     ui->streamingServerVNAcalibratedPort->setValue(p->StreamingServers.VNACalibratedData.port);
+    ui->streamingServerVNAcalibratedFormat->setCurrentIndex(p->StreamingServers.VNACalibratedData.binary ? 1 : 0);
     ui->streamingServerVNAdeembeddedEnabled->setChecked(p->StreamingServers.VNADeembeddedData.enabled);
     ui->streamingServerVNAdeembeddedPort->setValue(p->StreamingServers.VNADeembeddedData.port);
+    ui->streamingServerVNAdeembeddedFormat->setCurrentIndex(p->StreamingServers.VNADeembeddedData.binary ? 1 : 0);
     ui->streamingServerSArawEnabled->setChecked(p->StreamingServers.SARawData.enabled);
     ui->streamingServerSArawPort->setValue(p->StreamingServers.SARawData.port);
+    ui->streamingServerSArawFormat->setCurrentIndex(p->StreamingServers.SARawData.binary ? 1 : 0);
     ui->streamingServerSAnormalizedEnabled->setChecked(p->StreamingServers.SANormalizedData.enabled);
     ui->streamingServerSAnormalizedPort->setValue(p->StreamingServers.SANormalizedData.port);
+    ui->streamingServerSAnormalizedFormat->setCurrentIndex(p->StreamingServers.SANormalizedData.binary ? 1 : 0);
 
     ui->DebugMaxUSBlogSize->setValue(p->Debug.USBlogSizeLimit);
     ui->DebugSaveTraceData->setChecked(p->Debug.saveTraceData);
@@ -370,7 +376,7 @@ void PreferencesDialog::updateFromGUI()
 
     p->Acquisition.alwaysExciteAllPorts = ui->AcquisitionAlwaysExciteBoth->isChecked();
     p->Acquisition.allowSegmentedSweep = ui->AcquisitionAllowSegmentedSweep->isChecked();
-    p->Acquisition.useMedianAveraging = ui->AcquisitionAveragingMode->currentIndex() == 1;
+    p->Acquisition.averagingMode = ui->AcquisitionAveragingMode->currentIndex();
     p->Acquisition.fullSpanManual = ui->AcquisitionFullSpanBehavior->currentIndex() == 1;
     p->Acquisition.fullSpanStart = ui->AcquisitionFullSpanStart->value();
     p->Acquisition.fullSpanStop = ui->AcquisitionFullSpanStop->value();
@@ -438,14 +444,19 @@ void PreferencesDialog::updateFromGUI()
 
     p->StreamingServers.VNARawData.enabled = ui->streamingServerVNArawEnabled->isChecked();
     p->StreamingServers.VNARawData.port = ui->streamingServerVNArawPort->value();
+    p->StreamingServers.VNARawData.binary = ui->streamingServerVNArawFormat->currentIndex() == 1;
     p->StreamingServers.VNACalibratedData.enabled = ui->streamingServerVNAcalibratedEnabled->isChecked();
     p->StreamingServers.VNACalibratedData.port = ui->streamingServerVNAcalibratedPort->value();
+    p->StreamingServers.VNACalibratedData.binary = ui->streamingServerVNAcalibratedFormat->currentIndex() == 1;
     p->StreamingServers.VNADeembeddedData.enabled = ui->streamingServerVNAdeembeddedEnabled->isChecked();
     p->StreamingServers.VNADeembeddedData.port = ui->streamingServerVNAdeembeddedPort->value();
+    p->StreamingServers.VNADeembeddedData.binary = ui->streamingServerVNAdeembeddedFormat->currentIndex() == 1;
     p->StreamingServers.SARawData.enabled = ui->streamingServerSArawEnabled->isChecked();
     p->StreamingServers.SARawData.port = ui->streamingServerSArawPort->value();
+    p->StreamingServers.SARawData.binary = ui->streamingServerSArawFormat->currentIndex() == 1;
     p->StreamingServers.SANormalizedData.enabled = ui->streamingServerSAnormalizedEnabled->isChecked();
     p->StreamingServers.SANormalizedData.port = ui->streamingServerSAnormalizedPort->value();
+    p->StreamingServers.SANormalizedData.binary = ui->streamingServerSAnormalizedFormat->currentIndex() == 1;
 
     p->Debug.USBlogSizeLimit = ui->DebugMaxUSBlogSize->value();
     p->Debug.saveTraceData = ui->DebugSaveTraceData->isChecked();
@@ -464,6 +475,11 @@ void Preferences::load()
     // load settings, using default values if not present
     qInfo() << "Loading preferences";
     load(descr);
+    // Older versions stored a bool under the key of the averaging mode. Text settings formats keep it as "true", which
+    // does not convert to the mode
+    if(QSettings().value("Acquisition.useMedianAveraging").toString() == "true") {
+        Acquisition.averagingMode = (int) Averaging::Mode::Median;
+    }
     for(auto driver : DeviceDriver::getDrivers()) {
         driver->registerTypes();
         load(driver->driverSpecificSettings());
@@ -624,7 +640,10 @@ QVariant Preferences::get(QString name)
 
 void Preferences::nonTrivialParsing()
 {
-
+    if(Acquisition.averagingMode < (int) Averaging::Mode::Mean || Acquisition.averagingMode > (int) Averaging::Mode::Exponential) {
+        // unknown averaging mode (e.g. from a newer version), fall back to the default
+        Acquisition.averagingMode = (int) Averaging::Mode::Mean;
+    }
 }
 
 void Preferences::nonTrivialWriting()
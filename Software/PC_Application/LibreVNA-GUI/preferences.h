@@ -101,7 +101,8 @@ public:
     struct {
         bool alwaysExciteAllPorts;
         bool allowSegmentedSweep;
-        bool useMedianAveraging;
+        // Averaging::Mode, stored under the key of the former bool useMedianAveraging (true is Mode::Median)
+        int averagingMode;
 
         // Full span settings
         bool fullSpanManual;
@@ -173,22 +174,27 @@ public:
         struct {
             bool enabled;
             int port;
+            bool binary;
         } VNARawData;
         struct {
             bool enabled;
             int port;
+            bool binary;
         } VNACalibratedData;
         struct {
             bool enabled;
             int port;
+            bool binary;
         } VNADeembeddedData;
         struct {
             bool enabled;
             int port;
+            bool binary;
         } SARawData;
         struct {
             bool enabled;
             int port;
+            bool binary;
         } SANormalizedData;
     } StreamingServers;
     struct {
@@ -242,7 +248,7 @@ private:
         {&Startup.SA.averaging, "Startup.SA.averaging", 1},
         {&Acquisition.alwaysExciteAllPorts, "Acquisition.alwaysExciteBothPorts", true},
         {&Acquisition.allowSegmentedSweep, "Acquisition.allowSegmentedSweep", true},
-        {&Acquisition.useMedianAveraging, "Acquisition.useMedianAveraging", false},
+        {&Acquisition.averagingMode, "Acquisition.useMedianAveraging", 0},
         {&Acquisition.fullSpanManual, "Acquisition.fullSpanManual", false},
         {&Acquisition.fullSpanStart, "Acquisition.fullSpanStart", 0.0},
         {&Acquisition.fullSpanStop, "Acquisition.fullSpanStop", 6000000000.0},
@@ -306,14 +312,19 @@ private:
         {&SCPIServer.port, "SCPIServer.port", 19542},
         {&StreamingServers.VNARawData.enabled, "StreamingServers.VNARawData.enabled", false},
         {&StreamingServers.VNARawData.port, "StreamingServers.VNARawData.port", 19000},
+        {&StreamingServers.VNARawData.binary, "StreamingServers.VNARawData.binary", false},
         {&StreamingServers.VNACalibratedData.enabled, "StreamingServers.VNACalibratedData.enabled", false},
         {&StreamingServers.VNACalibratedData.port, "StreamingServers.VNACalibratedData.port", 19001},
+        {&StreamingServers.VNACalibratedData.binary, "StreamingServers.VNACalibratedData.binary", false},
         {&StreamingServers.VNADeembeddedData.enabled, "StreamingServers.VNADeembeddedData.enabled", false},
         {&StreamingServers.VNADeembeddedData.port, "StreamingServers.VNADeembeddedData.port", 19002},
+        {&StreamingServers.VNADeembeddedData.binary, "StreamingServers.VNADeembeddedData.binary", false},
         {&StreamingServers.SARawData.enabled, "StreamingServers.sARawData.enabled", false},
         {&StreamingServers.SARawData.port, "StreamingServers.sARawData.port", 19100},
+        {&StreamingServers.SARawData.binary, "StreamingServers.sARawData.binary", false},
         {&StreamingServers.SANormalizedData.enabled, "StreamingServers.SANormalizedData.enabled", false},
         {&StreamingServers.SANormalizedData.port, "StreamingServers.SANormalizedData.port", 19101},
+        {&StreamingServers.SANormalizedData.binary, "StreamingServers.SANormalizedData.binary", false},
         {&Debug.USBlogSizeLimit, "Debug.USBlogSizeLimit", 10000000.0},
         {&Debug.saveTraceData, "Debug.saveTraceData", false},
         {&Debug.useNativeDialogs, "Debug.useNativeDialogs", true},
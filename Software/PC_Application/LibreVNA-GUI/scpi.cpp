@@ -1,6 +1,9 @@
 #include "scpi.h"
 
 #include <QDebug>
+#include <QtEndian>
+
+#include <cstring>
 
 SCPI::SCPI() :
     SCPINode(""),
@@ -14,6 +17,7 @@ SCPI::SCPI() :
     SESR = 0x00;
     ESE = 0xFF;
     processing = false;
+    resetDataFormat();
 
     add(new SCPICommand("*CLS", [=](QStringList) {
         SESR = 0x00;
@@ -77,6 +81,44 @@ SCPI::SCPI() :
         createCommandList("", list);
         return list.trimmed();
     }));
+
+    add(new SCPICommand("FORMat:DATA", [=](QStringList params) -> QString {
+        // accepts "ASCii[,0]" and "REAL[,64]" (optionally with a space after the comma)
+        auto format = params.join("").split(",");
+        if(format.size() > 2) {
+            return SCPI::getResultName(SCPI::Result::Error);
+        }
+        if(SCPI::match(format[0], "ASCii") && (format.size() == 1 || format[1] == "0")) {
+            dataFormat = DataFormat::ASCII;
+        } else if(SCPI::match(format[0], "REAL") && (format.size() == 1 || format[1] == "64")) {
+            dataFormat = DataFormat::Real64;
+        } else {
+            return SCPI::getResultName(SCPI::Result::Error);
+        }
+        return SCPI::getResultName(SCPI::Result::Empty);
+    }, [=](QStringList) -> QString {
+        switch(dataFormat) {
+        case DataFormat::ASCII: return "ASC";
+        case DataFormat::Real64: return "REAL,64";
+        }
+        return SCPI::getResultName(SCPI::Result::Error);
+    }));
+
+    add(new SCPICommand("FORMat:BORDer", [=](QStringList params) -> QString {
+        if(params.size() != 1) {
+            return SCPI::getResultName(SCPI::Result::Error);
+        }
+        if(SCPI::match(params[0], "NORMal")) {
+            byteOrderSwapped = false;
+        } else if(SCPI::match(params[0], "SWAPped")) {
+            byteOrderSwapped = true;
+        } else {
+            return SCPI::getResultName(SCPI::Result::Error);
+        }
+        return SCPI::getResultName(SCPI::Result::Empty);
+    }, [=](QStringList) -> QString {
+        return byteOrderSwapped ? "SWAP" : "NORM";
+    }));
 }
 
 bool SCPI::match(QString s1, QString s2)
@@ -178,6 +220,41 @@ QString SCPI::getResultName(SCPI::Result r)
     }
 }
 
+void SCPI::resetDataFormat()
+{
+    dataFormat = DataFormat::ASCII;
+    byteOrderSwapped = false;
+}
+
+QByteArray SCPI::createBlock(unsigned long long numValues)
+{
+    auto length = QByteArray::number(numValues * sizeof(double));
+    QByteArray block;
+    block.reserve(2 + length.size() + numValues * sizeof(double));
+    block.append('#');
+    block.append(QByteArray::number(length.size()));
+    block.append(length);
+    return block;
+}
+
+void SCPI::appendValue(QByteArray &block, double value) const
+{
+    quint64 raw;
+    memcpy(&raw, &value, sizeof(raw));
+    char bytes[sizeof(raw)];
+    if(byteOrderSwapped) {
+        qToLittleEndian(raw, bytes);
+    } else {
+        qToBigEndian(raw, bytes);
+    }
+    block.append(bytes, sizeof(bytes));
+}
+
+void SCPI::sendBlock(const QByteArray &block)
+{
+    emit outputBlock(block);
+}
+
 void SCPI::input(QString line)
 {
     semQueue.acquire();
@@ -375,6 +452,15 @@ void SCPINode::setOperationPending(bool pending)
     }
 }
 
+SCPI *SCPINode::getRoot()
+{
+    auto root = this;
+    while(root->parent) {
+        root = root->parent;
+    }
+    return dynamic_cast<SCPI*>(root);
+}
+
 bool SCPINode::isOperationPending()
 {
     if(operationPending) {
@@ -7,6 +7,8 @@
 #include <vector>
 #include <functional>
 
+class SCPI;
+
 class SCPICommand {
 public:
     SCPICommand(QString name, std::function<QString(QStringList)> cmd, std::function<QString(QStringList)> query, bool convertToUppercase = true) :
@@ -52,6 +54,8 @@ public:
 
 protected:
     bool isOperationPending();
+    // returns the root of the command tree or nullptr if this node has not been added to a tree yet
+    SCPI *getRoot();
 
 private:
     QString parse(QString cmd, SCPINode* &lastNode);
@@ -95,6 +99,29 @@ public:
 
     static QString getResultName(SCPI::Result r);
 
+    // Format of bulk data in query responses (selected with FORMat:DATA)
+    enum class DataFormat {
+        ASCII,
+        // IEEE 488.2 definite length block of 64 bit floating point values
+        Real64,
+    };
+    DataFormat getDataFormat() const {return dataFormat;}
+    // Byte order of binary data (selected with FORMat:BORDer). Normal is big endian, swapped is little endian
+    bool isByteOrderSwapped() const {return byteOrderSwapped;}
+    // back to ASCII data and normal byte order (used by *RST)
+    void resetDataFormat();
+
+    /**
+     * @brief Starts a binary response with the values in the selected byte order
+     *
+     * Returns a definite length block (#<number of digits><length><payload>) with the header already filled in. The
+     * payload has to be filled in with appendValue(), the block is sent with sendBlock() when it is complete.
+     */
+    QByteArray createBlock(unsigned long long numValues);
+    void appendValue(QByteArray &block, double value) const;
+    // Sends a binary block as the response to the currently executed query
+    void sendBlock(const QByteArray &block);
+
     // call whenever a subnode completes an operation
     void someOperationCompleted();
 
@@ -103,6 +130,8 @@ public slots:
     void process();
 signals:
     void output(QString line);
+    // binary response, terminated with a newline when sent
+    void outputBlock(QByteArray block);
 
 private:
 
@@ -121,6 +150,9 @@ private:
     void clearFlag(Flag flag);
     bool getFlag(Flag flag);
 
+    DataFormat dataFormat;
+    bool byteOrderSwapped;
+
     unsigned int SESR;
     unsigned int ESE;
 
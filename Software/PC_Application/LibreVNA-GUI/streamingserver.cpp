@@ -2,12 +2,26 @@
 
 #include "json.hpp"
 
-StreamingServer::StreamingServer(int port)
+#include <QtEndian>
+#include <cstring>
+
+StreamingServer::StreamingServer(int port, bool binary)
+    : port(port),
+      binary(binary),
+      flushScheduled(false),
+      layoutType(DataType::VNA),
+      layoutValid(false),
+      dataFrameStart(-1),
+      dataFrameRecords(0)
 {
-    this->port = port;
     server.listen(QHostAddress::Any, port);
     connect(&server, &QTcpServer::newConnection, [&](){
         auto socket = server.nextPendingConnection();
+        if(this->binary && layoutValid) {
+            // send everything that belongs to the previous clients first, the new client starts with the current layout
+            flush();
+            socket->write(layoutFrame());
+        }
         sockets.insert(socket);
 
         connect(socket, &QTcpSocket::stateChanged, [this, socket](QAbstractSocket::SocketState state){
@@ -22,39 +36,192 @@ StreamingServer::StreamingServer(int port)
 
 void StreamingServer::addData(const DeviceDriver::VNAMeasurement &m)
 {
-    nlohmann::json j;
-    j["pointNum"] = m.pointNum;
-    j["frequency"] = m.frequency;
-    j["dBm"] = m.dBm;
-    j["Z0"] = m.Z0;
-    nlohmann::json jp;
-    for(auto const &p : m.measurements) {
-        jp[QString(p.first+"_real").toStdString()] = p.second.real();
-        jp[QString(p.first+"_imag").toStdString()] = p.second.imag();
+    if(sockets.empty()) {
+        // nobody is listening, skip serialization
+        return;
     }
-    j["measurements"] = jp;
-    std::string toSend = j.dump();
-    for(auto s : sockets) {
-        if(s->isOpen()) {
-            s->write(QByteArray::fromStdString(toSend+'\n'));
+    if(!binary) {
+        nlohmann::json j;
+        j["pointNum"] = m.pointNum;
+        j["frequency"] = m.frequency;
+        j["dBm"] = m.dBm;
+        j["Z0"] = m.Z0;
+        nlohmann::json jp;
+        for(unsigned int i=0;i<m.measurements.size();i++) {
+            auto name = m.measurements.name(i).toStdString();
+            jp[name+"_real"] = m.measurements.value(i).real();
+            jp[name+"_imag"] = m.measurements.value(i).imag();
+        }
+        j["measurements"] = jp;
+        pending.append(QByteArray::fromStdString(j.dump()+'\n'));
+        scheduleFlush();
+        return;
+    }
+
+    auto layout = m.measurements.getLayout();
+    bool layoutChanged = !layoutValid || layoutType != DataType::VNA || layout != lastVNALayout;
+    if(layoutChanged) {
+        layoutNames = QStringList({"pointNum", "frequency", "dBm", "Z0"});
+        for(unsigned int i=0;i<m.measurements.size();i++) {
+            layoutNames.append(m.measurements.name(i)+"_real");
+            layoutNames.append(m.measurements.name(i)+"_imag");
         }
+        lastVNALayout = layout;
+    }
+    beginRecords(DataType::VNA, layoutChanged, m.pointNum == 0);
+    appendRecordValue(m.pointNum);
+    appendRecordValue(m.frequency);
+    appendRecordValue(m.dBm);
+    appendRecordValue(m.Z0);
+    for(unsigned int i=0;i<m.measurements.size();i++) {
+        appendRecordValue(m.measurements.value(i).real());
+        appendRecordValue(m.measurements.value(i).imag());
     }
+    dataFrameRecords++;
+    scheduleFlush();
 }
 
 void StreamingServer::addData(const DeviceDriver::SAMeasurement &m)
 {
-    nlohmann::json j;
-    j["pointNum"] = m.pointNum;
-    j["frequency"] = m.frequency;
-    nlohmann::json jp;
+    if(sockets.empty()) {
+        // nobody is listening, skip serialization
+        return;
+    }
+    if(!binary) {
+        nlohmann::json j;
+        j["pointNum"] = m.pointNum;
+        j["frequency"] = m.frequency;
+        nlohmann::json jp;
+        for(auto const &p : m.measurements) {
+            jp[p.first.toStdString()] = p.second;
+        }
+        j["measurements"] = jp;
+        pending.append(QByteArray::fromStdString(j.dump()+'\n'));
+        scheduleFlush();
+        return;
+    }
+
+    // the first two columns are pointNum and frequency, compare the remaining names with the measurements
+    bool layoutChanged = !layoutValid || layoutType != DataType::SA || (unsigned int) layoutNames.size() != m.measurements.size() + 2;
+    if(!layoutChanged) {
+        int column = 2;
+        for(auto const &p : m.measurements) {
+            if(p.first != layoutNames[column++]) {
+                layoutChanged = true;
+                break;
+            }
+        }
+    }
+    if(layoutChanged) {
+        layoutNames = QStringList({"pointNum", "frequency"});
+        for(auto const &p : m.measurements) {
+            layoutNames.append(p.first);
+        }
+        lastVNALayout = nullptr;
+    }
+    beginRecords(DataType::SA, layoutChanged, m.pointNum == 0);
+    appendRecordValue(m.pointNum);
+    appendRecordValue(m.frequency);
     for(auto const &p : m.measurements) {
-        jp[p.first.toStdString()] = p.second;
+        appendRecordValue(p.second);
     }
-    j["measurements"] = jp;
-    std::string toSend = j.dump();
+    dataFrameRecords++;
+    scheduleFlush();
+}
+
+void StreamingServer::write(QByteArray data)
+{
     for(auto s : sockets) {
         if(s->isOpen()) {
-            s->write(QByteArray::fromStdString(toSend+'\n'));
+            // implicitly shared, the data is not copied per socket
+            s->write(data);
         }
     }
 }
+
+void StreamingServer::scheduleFlush()
+{
+    if(!flushScheduled) {
+        flushScheduled = true;
+        QMetaObject::invokeMethod(this, &StreamingServer::flush, Qt::QueuedConnection);
+    }
+}
+
+void StreamingServer::flush()
+{
+    flushScheduled = false;
+    finishDataFrame();
+    if(pending.size() > 0) {
+        write(pending);
+        pending = QByteArray();
+    }
+}
+
+void StreamingServer::beginRecords(DataType type, bool layoutChanged, bool newSweep)
+{
+    if(layoutChanged || newSweep) {
+        finishDataFrame();
+        layoutType = type;
+        layoutValid = true;
+        pending.append(layoutFrame());
+    }
+    if(dataFrameStart < 0) {
+        dataFrameStart = pending.size();
+        dataFrameRecords = 0;
+        // header and record count are updated when the frame is finished
+        appendFrameHeader(pending, FrameType::Data, 0);
+        pending.append(4, '\0');
+    }
+}
+
+void StreamingServer::appendRecordValue(double value)
+{
+    quint64 raw;
+    memcpy(&raw, &value, sizeof(raw));
+    raw = qToLittleEndian(raw);
+    pending.append(reinterpret_cast<const char*>(&raw), sizeof(raw));
+}
+
+void StreamingServer::finishDataFrame()
+{
+    if(dataFrameStart < 0) {
+        return;
+    }
+    auto frame = pending.data() + dataFrameStart;
+    quint32 payloadLength = pending.size() - dataFrameStart - frameHeaderSize;
+    qToLittleEndian(payloadLength, frame + 8);
+    qToLittleEndian(dataFrameRecords, frame + frameHeaderSize);
+    dataFrameStart = -1;
+    dataFrameRecords = 0;
+}
+
+QByteArray StreamingServer::layoutFrame() const
+{
+    QByteArray payload;
+    payload.append((char) layoutType);
+    payload.append('\0');
+    quint16 columns = qToLittleEndian<quint16>(layoutNames.size());
+    payload.append(reinterpret_cast<const char*>(&columns), sizeof(columns));
+    for(auto const &name : layoutNames) {
+        auto utf8 = name.toUtf8();
+        quint16 length = qToLittleEndian<quint16>(utf8.size());
+        payload.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        payload.append(utf8);
+    }
+    QByteArray frame;
+    appendFrameHeader(frame, FrameType::Layout, payload.size());
+    frame.append(payload);
+    return frame;
+}
+
+void StreamingServer::appendFrameHeader(QByteArray &buffer, FrameType type, quint32 payloadLength)
+{
+    char header[frameHeaderSize];
+    qToLittleEndian(binaryMagic, header);
+    header[4] = binaryVersion;
+    header[5] = (char) type;
+    header[6] = 0;
+    header[7] = 0;
+    qToLittleEndian(payloadLength, header + 8);
+    buffer.append(header, frameHeaderSize);
+}
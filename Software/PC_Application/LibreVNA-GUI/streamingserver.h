@@ -3,25 +3,79 @@
 
 #include <QTcpServer>
 #include <QTcpSocket>
+#include <QByteArray>
+#include <QStringList>
 #include <set>
 
 #include "Device/devicedriver.h"
 
+/**
+ * @brief TCP server which streams measurement points to all connected clients
+ *
+ * Two output formats are available:
+ * - JSON: one newline-terminated JSON object per measurement point
+ * - Binary: length-prefixed frames. A layout frame describes the contained parameters, it is sent at the start of
+ *   every sweep, whenever the parameters change and to every new client. Data frames contain packed little-endian
+ *   float64 records in the order given by the last layout frame. See the programming guide for the frame format.
+ *
+ * Incoming points are collected and written to the sockets once per event loop iteration. The serialized data is
+ * shared between all sockets.
+ */
 class StreamingServer : public QObject
 {
     Q_OBJECT
 public:
-    StreamingServer(int port);
+    StreamingServer(int port, bool binary = false);
 
     void addData(const DeviceDriver::VNAMeasurement &m);
     void addData(const DeviceDriver::SAMeasurement &m);
 
     int getPort() {return port;}
+    bool isBinary() {return binary;}
+
+    // Binary frame format, keep in sync with the reference decoders in Documentation/UserManual/SCPI_Examples
+    // and the benchmark (LibreVNA-Benchmark)
+    static constexpr quint32 binaryMagic = 0x5453564C; // "LVST" when read as little-endian bytes
+    static constexpr quint8 binaryVersion = 1;
+    enum class FrameType : quint8 {
+        Layout = 0,
+        Data = 1,
+    };
+    enum class DataType : quint8 {
+        VNA = 0,
+        SA = 1,
+    };
+    // magic, version, frame type, reserved, payload length
+    static constexpr int frameHeaderSize = 12;
 
 private:
+    void write(QByteArray data);
+    void scheduleFlush();
+    void flush();
+    // opens a data frame if none is open. Sends the current layout first if it changed or a new sweep started
+    void beginRecords(DataType type, bool layoutChanged, bool newSweep);
+    void appendRecordValue(double value);
+    void finishDataFrame();
+    QByteArray layoutFrame() const;
+    static void appendFrameHeader(QByteArray &buffer, FrameType type, quint32 payloadLength);
+
     int port;
+    bool binary;
     QTcpServer server;
     std::set<QTcpSocket*> sockets;
+
+    // data collected since the last write to the sockets
+    QByteArray pending;
+    bool flushScheduled;
+
+    // state of the binary format
+    DataType layoutType;
+    QStringList layoutNames;
+    std::shared_ptr<const MeasurementLayout> lastVNALayout;
+    bool layoutValid;
+    // offset of the currently open data frame within pending (-1 if no frame is open)
+    int dataFrameStart;
+    quint32 dataFrameRecords;
 };
 
 #endif // STREAMINGSERVER_H
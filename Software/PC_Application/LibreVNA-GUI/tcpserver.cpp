@@ -40,3 +40,14 @@ bool TCPServer::send(QString line)
         return false;
     }
 }
+
+bool TCPServer::sendBlock(QByteArray block)
+{
+    if (socket) {
+        socket->write(block);
+        socket->write("\n", 1);
+        return true;
+    } else {
+        return false;
+    }
+}
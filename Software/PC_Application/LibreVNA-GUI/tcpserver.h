@@ -15,6 +15,8 @@ public:
 
 public slots:
     bool send(QString line);
+    // sends binary data unchanged, followed by a newline
+    bool sendBlock(QByteArray block);
 signals:
     void received(QString line);
 private:
@@ -1,9 +1,12 @@
 #include "touchstone.h"
 
 #include "Util/util.h"
-#include "unit.h"
 
 #include <limits>
+#include <numeric>
+#include <mutex>
+#include <exception>
+#include <cstring>
 #include <algorithm>
 #include <fstream>
 #include <iomanip>
@@ -14,11 +17,13 @@
 
 using namespace std;
 
+// data lines are parsed in parallel in chunks of at least this number of lines
+static constexpr unsigned int minimumLinesPerThread = 1024;
+
 Touchstone::Touchstone(unsigned int ports)
 {
     this->m_ports = ports;
     referenceImpedance = 50.0;
-    m_datapoints.clear();
 }
 
 void Touchstone::AddDatapoint(Touchstone::Datapoint p)
@@ -27,16 +32,20 @@ void Touchstone::AddDatapoint(Touchstone::Datapoint p)
         throw runtime_error("Invalid number of parameters");
     }
 
-    bool needs_sort = false;
-    if (m_datapoints.size() > 0 && m_datapoints.back().frequency >= p.frequency) {
-        needs_sort = true;
-    }
-    m_datapoints.push_back(p);
-    if(needs_sort) {
-        sort(m_datapoints.begin(), m_datapoints.end(), [](Datapoint &a, Datapoint &b) {
-           return a.frequency < b.frequency;
-        });
-    }
+    // keep the points sorted by frequency
+    auto pos = upper_bound(m_frequencies.begin(), m_frequencies.end(), p.frequency);
+    auto index = pos - m_frequencies.begin();
+    m_frequencies.insert(pos, p.frequency);
+    m_S.insert(m_S.begin() + index * p.S.size(), p.S.begin(), p.S.end());
+}
+
+Touchstone::Datapoint Touchstone::point(int index)
+{
+    Datapoint ret;
+    ret.frequency = m_frequencies.at(index);
+    auto S = m_S.begin() + index * m_ports * m_ports;
+    ret.S.assign(S, S + m_ports * m_ports);
+    return ret;
 }
 
 void Touchstone::toFile(QString filename, Scale unit, Format format)
@@ -51,7 +60,9 @@ void Touchstone::toFile(QString filename, Scale unit, Format format)
     ofstream file;
     file.open(filename.toStdString());
 
-    file << toString(unit, format).rdbuf();
+    TextIO::Writer writer(&file);
+    write(writer, unit, format);
+    writer.flush();
 
     file.close();
     this->filename = filename;
@@ -59,90 +70,102 @@ void Touchstone::toFile(QString filename, Scale unit, Format format)
 
 stringstream Touchstone::toString(Touchstone::Scale unit, Touchstone::Format format)
 {
-    stringstream s;
-    s << std::fixed << std::setprecision(12);
+    TextIO::Writer writer;
+    write(writer, unit, format);
+    return stringstream(writer.takeText());
+}
+
+void Touchstone::write(TextIO::Writer &w, Scale unit, Format format)
+{
+    // all values are written with 12 decimal places
+    constexpr int precision = 12;
     // write option line
-    s << "# ";
+    w.write("# ");
     switch(unit) {
-        case Scale::Hz: s << "HZ "; break;
-        case Scale::kHz: s << "KHZ "; break;
-        case Scale::MHz: s << "MHZ "; break;
-        case Scale::GHz: s << "GHZ "; break;
+        case Scale::Hz: w.write("HZ "); break;
+        case Scale::kHz: w.write("KHZ "); break;
+        case Scale::MHz: w.write("MHZ "); break;
+        case Scale::GHz: w.write("GHZ "); break;
     }
     // only S parameters supported so far
-    s << "S ";
+    w.write("S ");
     switch(format) {
-        case Format::DBAngle: s << "DB "; break;
-        case Format::RealImaginary: s << "RI "; break;
-        case Format::MagnitudeAngle: s << "MA "; break;
+        case Format::DBAngle: w.write("DB "); break;
+        case Format::RealImaginary: w.write("RI "); break;
+        case Format::MagnitudeAngle: w.write("MA "); break;
     }
     // reference impedance
-    s << "R " << referenceImpedance << "\n";
+    w.write("R ");
+    w.write(referenceImpedance, precision, true);
+    w.write('\n');
 
-    auto printParameter = [format](ostream &out, complex<double> &c) {
+    auto printParameter = [&w, format](complex<double> c) {
         switch (format) {
         case Format::RealImaginary:
-            out << c.real() << " " << c.imag();
+            w.write(c.real(), precision, true);
+            w.write(' ');
+            w.write(c.imag(), precision, true);
             break;
         case Format::MagnitudeAngle:
-            out << abs(c) << " " << arg(c) / M_PI * 180.0;
+            w.write(abs(c), precision, true);
+            w.write(' ');
+            w.write(arg(c) / M_PI * 180.0, precision, true);
             break;
         case Format::DBAngle:
-            out << Util::SparamTodB(c) << " " << arg(c) / M_PI * 180.0;
+            w.write(Util::SparamTodB(c), precision, true);
+            w.write(' ');
+            w.write(arg(c) / M_PI * 180.0, precision, true);
             break;
         }
     };
 
-    for(auto p : m_datapoints) {
+    for(unsigned int p=0;p<points();p++) {
+        auto frequency = m_frequencies[p];
         switch(unit) {
-            case Scale::Hz: s << p.frequency; break;
-            case Scale::kHz: s << p.frequency / 1e3; break;
-            case Scale::MHz: s << p.frequency / 1e6; break;
-            case Scale::GHz: s << p.frequency / 1e9; break;
+            case Scale::Hz: break;
+            case Scale::kHz: frequency /= 1e3; break;
+            case Scale::MHz: frequency /= 1e6; break;
+            case Scale::GHz: frequency /= 1e9; break;
         }
-        s << " ";
+        w.write(frequency, precision, true);
+        w.write(' ');
+        auto S = &m_S[p * m_ports * m_ports];
         // special cases for 1 and 2 port
         if (m_ports == 1) {
-            printParameter(s, p.S[0]);
-            s << "\n";
+            printParameter(S[0]);
+            w.write('\n');
         } else if (m_ports == 2){
-            printParameter(s, p.S[0]);
+            printParameter(S[0]);
             // touchstone expects S11 S21 S12 S22 order, swap S12 and S21
-            s << " ";
-            printParameter(s, p.S[2]);
-            s << " ";
-            printParameter(s, p.S[1]);
-            s << " ";
-            printParameter(s, p.S[3]);
-            s << "\n";
+            w.write(' ');
+            printParameter(S[2]);
+            w.write(' ');
+            printParameter(S[1]);
+            w.write(' ');
+            printParameter(S[3]);
+            w.write('\n');
         } else {
             // print parameters in matrix form
             for(unsigned int i=0;i<m_ports;i++) {
                 for(unsigned int j=0;j<m_ports;j++) {
-                    printParameter(s, p.S[i*m_ports + j]);
+                    printParameter(S[i*m_ports + j]);
                     if (j%4 == 3) {
-                        s << "\n";
+                        w.write('\n');
                     } else {
-                        s << " ";
+                        w.write(' ');
                     }
                 }
                 if(m_ports%4 != 0) {
-                    s << "\n";
+                    w.write('\n');
                 }
             }
         }
     }
-    return s;
 }
 
 Touchstone Touchstone::fromFile(string filename)
 {
-    ifstream file;
-    file.open(filename);
-
-    if(!file.is_open()) {
-        throw runtime_error("Unable to open file:" + filename);
-    }
+    TextIO::FileView file(QString::fromStdString(filename));
 
     // extract number of ports from filename
     auto index_extension = filename.find_last_of('.');
@@ -158,33 +181,37 @@ Touchstone Touchstone::fromFile(string filename)
     Format format = Format::RealImaginary;
 
     bool option_line_found = false;
-    unsigned int parameter_cnt = 0;
 
-    Datapoint point;
+    class DataLine {
+    public:
+        TextIO::Line line;
+        unsigned int tokens;
+        // index of the point this line belongs to and index of its first value (excluding the frequency) within the point
+        unsigned int point;
+        unsigned int value;
+    };
+    vector<DataLine> dataLines;
 
-    string line;
-    unsigned int lineCnt = 0;
-    while(getline(file, line)) {
-        lineCnt++;
+    for(auto l : TextIO::splitLines(file.begin(), file.end())) {
         // remove comments
-        auto comment = line.find_first_of('!');
-        if(comment != string::npos) {
-            line.erase(comment);
+        auto comment = (const char*) memchr(l.begin, '!', l.end - l.begin);
+        if(comment) {
+            l.end = comment;
         }
         // remove leading whitespace
-        size_t first = line.find_first_not_of(" \t\r\n");
-        if (string::npos == first) {
+        l.begin = TextIO::skipBlanks(l.begin, l.end);
+        if(l.begin == l.end) {
             // string does only contain whitespace, skip line
             continue;
         }
-        line.erase(0, first);
 
-        if (line[0] == '#') {
+        if (*l.begin == '#') {
             // this is the option line
             if (option_line_found) {
                 throw runtime_error("Additional option line present");
             }
             option_line_found = true;
+            string line(l.begin, l.end);
             transform(line.begin(), line.end(), line.begin(), ::toupper);
             // check individual options
             line.erase(0,1);
@@ -234,58 +261,127 @@ Touchstone Touchstone::fromFile(string filename)
             if(!option_line_found) {
                 throw runtime_error("First dataline before option line");
             }
-            auto parseDatapoint = [format, &point, &lineCnt](istream &in) -> complex<double> {
-                double part1, part2;
-                if(!(in >> part1) || !(in >> part2)) {
-                    throw runtime_error("Failed to parse parameters on line "+std::to_string(lineCnt)+" with frequency "+Unit::ToString(point.frequency,"Hz", " kMG", 10).toStdString());
-                }
-                complex<double> ret;
-                switch(format) {
-                case Format::MagnitudeAngle:
-                    ret = polar(part1, part2 / 180.0 * M_PI);
-                    break;
-                case Format::DBAngle:
-                    ret = polar(pow(10, part1/20), part2 / 180.0 * M_PI);
-                    break;
-                case Format::RealImaginary:
-                    ret = complex<double>(part1, part2);
-                    break;
-                }
-                return ret;
-            };
-            istringstream iss(line);
-            if (parameter_cnt == 0) {
-                iss >> point.frequency;
-                point.S.clear();
-                switch(unit) {
-                    case Scale::Hz: break;
-                    case Scale::kHz: point.frequency *= 1e3; break;
-                    case Scale::MHz: point.frequency *= 1e6; break;
-                    case Scale::GHz: point.frequency *= 1e9; break;
-                }
+            dataLines.push_back({l, 0, 0, 0});
+        }
+    }
+
+    Util::parallelFor(dataLines.size(), minimumLinesPerThread, [&](unsigned int begin, unsigned int end) {
+        for(unsigned int i=begin;i<end;i++) {
+            dataLines[i].tokens = TextIO::countTokens(dataLines[i].line.begin, dataLines[i].line.end);
+        }
+    });
+
+    // Assign the lines to the points. A point starts with the frequency, followed by pairs of values. It may be split
+    // into several lines, only its first line has an odd number of values
+    const unsigned int valuesPerPoint = 2 * ports * ports;
+    unsigned int points = 0;
+    unsigned int missing = 0;
+    for(auto &l : dataLines) {
+        unsigned int values;
+        if(missing == 0) {
+            if(l.tokens % 2 == 0) {
+                throw runtime_error("Unexpected number of values on line "+std::to_string(l.line.number));
             }
-            unsigned int parameters_per_line;
-            if(ports == 1) {
-                parameters_per_line = 1;
-            } else if(ports == 3) {
-                parameters_per_line = 3;
-            } else {
-                parameters_per_line = 4;
+            l.point = points++;
+            l.value = 0;
+            values = l.tokens - 1;
+            missing = valuesPerPoint;
+        } else {
+            if(l.tokens % 2 == 1) {
+                throw runtime_error("Missing parameters before line "+std::to_string(l.line.number));
             }
-            unsigned int parameters_per_point = ports * ports;
-            for(unsigned int i=0;i<parameters_per_line;i++) {
-                point.S.push_back(parseDatapoint(iss));
-                parameter_cnt++;
-                if(parameter_cnt >= parameters_per_point) {
-                    parameter_cnt = 0;
-                    if(ports == 2) {
+            l.point = points - 1;
+            l.value = valuesPerPoint - missing;
+            values = l.tokens;
+        }
+        if(values > missing) {
+            throw runtime_error("Too many parameters on line "+std::to_string(l.line.number));
+        }
+        missing -= values;
+    }
+    if(missing > 0) {
+        throw runtime_error("Missing parameters for the last point");
+    }
+
+    double frequencyScale = 1.0;
+    switch(unit) {
+        case Scale::Hz: break;
+        case Scale::kHz: frequencyScale = 1e3; break;
+        case Scale::MHz: frequencyScale = 1e6; break;
+        case Scale::GHz: frequencyScale = 1e9; break;
+    }
+
+    // Every line can now be parsed independently, directly into its final location
+    ret.m_frequencies.resize(points);
+    ret.m_S.resize(points * ports * ports);
+    exception_ptr error;
+    mutex errorMutex;
+    Util::parallelFor(dataLines.size(), minimumLinesPerThread, [&](unsigned int begin, unsigned int end) {
+        try {
+            for(unsigned int i=begin;i<end;i++) {
+                auto &l = dataLines[i];
+                auto pos = l.line.begin;
+                auto parseValue = [&]() -> double {
+                    double value;
+                    pos = TextIO::skipBlanks(pos, l.line.end);
+                    auto valueEnd = TextIO::parseDouble(pos, l.line.end, value);
+                    if(!valueEnd || (valueEnd < l.line.end && !TextIO::isBlank(*valueEnd))) {
+                        throw runtime_error("Failed to parse parameters on line "+std::to_string(l.line.number));
+                    }
+                    pos = valueEnd;
+                    return value;
+                };
+                auto values = l.tokens;
+                if(l.tokens % 2 == 1) {
+                    // first line of the point
+                    ret.m_frequencies[l.point] = parseValue() * frequencyScale;
+                    values--;
+                }
+                auto S = &ret.m_S[l.point * ports * ports];
+                for(unsigned int v=l.value;v<l.value+values;v+=2) {
+                    double part1 = parseValue();
+                    double part2 = parseValue();
+                    auto index = v / 2;
+                    if(ports == 2 && (index == 1 || index == 2)) {
                         // 2 port touchstone has S11 S21 S12 S22 order, swap S12 and S21
-                        swap(point.S[1], point.S[2]);
+                        index = 3 - index;
+                    }
+                    switch(format) {
+                    case Format::MagnitudeAngle:
+                        S[index] = polar(part1, part2 / 180.0 * M_PI);
+                        break;
+                    case Format::DBAngle:
+                        S[index] = polar(pow(10, part1/20), part2 / 180.0 * M_PI);
+                        break;
+                    case Format::RealImaginary:
+                        S[index] = complex<double>(part1, part2);
+                        break;
                     }
-                    ret.AddDatapoint(point);
-                    break;
                 }
             }
+        } catch (...) {
+            lock_guard<mutex> lock(errorMutex);
+            if(!error) {
+                error = current_exception();
+            }
+        }
+    });
+    if(error) {
+        rethrow_exception(error);
+    }
+
+    if(!is_sorted(ret.m_frequencies.begin(), ret.m_frequencies.end())) {
+        // points are not in order, sort them by frequency
+        vector<unsigned int> order(points);
+        iota(order.begin(), order.end(), 0);
+        stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) {
+            return ret.m_frequencies[a] < ret.m_frequencies[b];
+        });
+        auto frequencies = ret.m_frequencies;
+        auto S = ret.m_S;
+        for(unsigned int i=0;i<points;i++) {
+            ret.m_frequencies[i] = frequencies[order[i]];
+            copy_n(&S[order[i] * ports * ports], ports * ports, &ret.m_S[i * ports * ports]);
         }
     }
     ret.filename = QString::fromStdString(filename);
@@ -294,8 +390,8 @@ Touchstone Touchstone::fromFile(string filename)
 
 double Touchstone::minFreq()
 {
-    if (m_datapoints.size() > 0) {
-        return m_datapoints.front().frequency;
+    if (m_frequencies.size() > 0) {
+        return m_frequencies.front();
     } else {
         return numeric_limits<double>::quiet_NaN();
     }
@@ -303,8 +399,8 @@ double Touchstone::minFreq()
 
 double Touchstone::maxFreq()
 {
-    if (m_datapoints.size() > 0) {
-        return m_datapoints.back().frequency;
+    if (m_frequencies.size() > 0) {
+        return m_frequencies.back();
     } else {
         return numeric_limits<double>::quiet_NaN();
     }
@@ -312,26 +408,25 @@ double Touchstone::maxFreq()
 
 Touchstone::Datapoint Touchstone::interpolate(double frequency)
 {
-    if(m_datapoints.size() == 0) {
+    if(m_frequencies.size() == 0) {
         throw runtime_error("Trying to interpolate empty touchstone data");
     }
     // Check if requested frequency is outside of points and return first/last datapoint respectively
-    if(frequency <= m_datapoints.front().frequency) {
-        return m_datapoints.front();
-    } else if(frequency >= m_datapoints.back().frequency) {
-        return m_datapoints.back();
+    if(frequency <= m_frequencies.front()) {
+        return point(0);
+    } else if(frequency >= m_frequencies.back()) {
+        return point(points() - 1);
     }
     // frequency within points, interpolate
-    auto lower = lower_bound(m_datapoints.begin(), m_datapoints.end(), frequency, [](const Datapoint &lhs, double rhs) -> bool {
-        return lhs.frequency < rhs;
-    });
-    auto highPoint = *lower;
-    auto lowPoint = *prev(lower);
-    double alpha = (frequency - lowPoint.frequency) / (highPoint.frequency - lowPoint.frequency);
+    auto lower = lower_bound(m_frequencies.begin(), m_frequencies.end(), frequency);
+    auto high = lower - m_frequencies.begin();
+    auto low = high - 1;
+    double alpha = (frequency - m_frequencies[low]) / (m_frequencies[high] - m_frequencies[low]);
+    auto parameters = m_ports * m_ports;
     Datapoint ret;
     ret.frequency = frequency;
-    for(unsigned int i=0;i<lowPoint.S.size();i++) {
-        ret.S.push_back(lowPoint.S[i] * (1.0-alpha) + highPoint.S[i] * alpha);
+    for(unsigned int i=0;i<parameters;i++) {
+        ret.S.push_back(m_S[low * parameters + i] * (1.0-alpha) + m_S[high * parameters + i] * alpha);
     }
     return ret;
 }
@@ -348,17 +443,16 @@ void Touchstone::reduceTo2Port(unsigned int port1, unsigned int port2)
     if(m_ports == 2) {
         swap(S21_index, S12_index);
     }
-    for(auto &p : m_datapoints) {
-        auto S11 = p.S[S11_index];
-        auto S12 = p.S[S12_index];
-        auto S21 = p.S[S21_index];
-        auto S22 = p.S[S22_index];
-        p.S.clear();
-        p.S.push_back(S11);
-        p.S.push_back(S21);
-        p.S.push_back(S12);
-        p.S.push_back(S22);
+    vector<complex<double>> S;
+    S.reserve(points() * 4);
+    for(unsigned int i=0;i<points();i++) {
+        auto p = &m_S[i * m_ports * m_ports];
+        S.push_back(p[S11_index]);
+        S.push_back(p[S21_index]);
+        S.push_back(p[S12_index]);
+        S.push_back(p[S22_index]);
     }
+    m_S = std::move(S);
     m_ports = 2;
 }
 
@@ -372,11 +466,12 @@ void Touchstone::reduceTo1Port(unsigned int port)
         return;
     }
     unsigned int S11_index = port * m_ports + port;
-    for(auto &p : m_datapoints) {
-        auto S11 = p.S[S11_index];
-        p.S.clear();
-        p.S.push_back(S11);
+    vector<complex<double>> S;
+    S.reserve(points());
+    for(unsigned int i=0;i<points();i++) {
+        S.push_back(m_S[i * m_ports * m_ports + S11_index]);
     }
+    m_S = std::move(S);
     m_ports = 1;
 }
 
@@ -390,13 +485,14 @@ nlohmann::json Touchstone::toJSON()
     nlohmann::json j;
     j["ports"] = m_ports;
     j["filename"] = filename.toStdString();
-    if(m_datapoints.size() > 0) {
+    if(points() > 0) {
         nlohmann::json json_points;
-        for(auto d : m_datapoints) {
+        for(unsigned int i=0;i<points();i++) {
             nlohmann::json point;
-            point["frequency"] = d.frequency;
+            point["frequency"] = m_frequencies[i];
             nlohmann::json sparams;
-            for(auto s : d.S) {
+            for(unsigned int j=0;j<m_ports*m_ports;j++) {
+                auto s = m_S[i * m_ports * m_ports + j];
                 nlohmann::json sparam;
                 sparam["real"] = s.real();
                 sparam["imag"] = s.imag();
@@ -412,7 +508,8 @@ nlohmann::json Touchstone::toJSON()
 
 void Touchstone::fromJSON(nlohmann::json j)
 {
-    m_datapoints.clear();
+    m_frequencies.clear();
+    m_S.clear();
     filename = QString::fromStdString(j.value("filename", ""));
     m_ports = j.value("ports", 0);
     if(!m_ports || !j.contains("datapoints")) {
@@ -420,22 +517,20 @@ void Touchstone::fromJSON(nlohmann::json j)
     }
     auto json_points = j["datapoints"];
     for(auto point : json_points) {
-        Datapoint d;
         if(!point.contains("frequency") || !point.contains("Sparams")) {
             // missing data, abort here
             qWarning() << "Touchstone data point does not contain frequency or S parameters";
             break;
         }
-        d.frequency = point["frequency"];
         if(point["Sparams"].size() != m_ports * m_ports) {
             // invalid number of Sparams, abort here
             qWarning() << "Invalid number of S parameters, got" << point["Sparams"].size() << "expected" << m_ports*m_ports;
             break;
         }
+        m_frequencies.push_back(point["frequency"].get<double>());
         for(auto Sparam : point["Sparams"]) {
-            d.S.push_back(complex<double>(Sparam.value("real", 0.0), Sparam.value("imag", 0.0)));
+            m_S.push_back(complex<double>(Sparam.value("real", 0.0), Sparam.value("imag", 0.0)));
         }
-        m_datapoints.push_back(d);
     }
 }
 
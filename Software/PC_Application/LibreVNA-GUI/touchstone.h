@@ -2,6 +2,7 @@
 #define TOUCHSTONE_H
 
 #include "savable.h"
+#include "Util/textio.h"
 
 #include <complex>
 #include <vector>
@@ -38,8 +39,11 @@ public:
     static Touchstone fromFile(std::string filename);
     double minFreq();
     double maxFreq();
-    unsigned int points() { return m_datapoints.size(); }
-    Datapoint point(int index) { return m_datapoints.at(index); }
+    unsigned int points() { return m_frequencies.size(); }
+    Datapoint point(int index);
+    // direct access to the stored data without creating a Datapoint (S parameter index as in Datapoint::S)
+    double frequency(unsigned int index) const { return m_frequencies.at(index); }
+    std::complex<double> parameter(unsigned int index, unsigned int parameter) const { return m_S.at(index * m_ports * m_ports + parameter); }
     Datapoint interpolate(double frequency);
     // remove all paramaters except the ones regarding port1 and port2 (port cnt starts at 0)
     void reduceTo2Port(unsigned int port1, unsigned int port2);
@@ -57,9 +61,13 @@ public:
 
 
 private:
+    void write(TextIO::Writer &w, Scale unit, Format format);
+
     unsigned int m_ports;
     double referenceImpedance;
-    std::vector<Datapoint> m_datapoints;
+    // all points are stored in contiguous arrays, m_ports * m_ports S parameters per point
+    std::vector<double> m_frequencies;
+    std::vector<std::complex<double>> m_S;
     QString filename;
 };
 
@@ -7,10 +7,12 @@ TEMPLATE = app
 
 SOURCES +=  \
     ../../VNA_embedded/Application/Communication/Protocol.cpp \
+    ../../VNA_embedded/Application/Communication/FirmwareTransfer.cpp \
     ../LibreVNA-GUI/Calibration/LibreCAL/caldevice.cpp \
     ../LibreVNA-GUI/Calibration/LibreCAL/librecaldialog.cpp \
     ../LibreVNA-GUI/Calibration/LibreCAL/usbdevice.cpp \
     ../LibreVNA-GUI/Calibration/calibration.cpp \
+    ../LibreVNA-GUI/Calibration/calibrationkernel.cpp \
     ../LibreVNA-GUI/Calibration/calibrationmeasurement.cpp \
     ../LibreVNA-GUI/Calibration/calkit.cpp \
     ../LibreVNA-GUI/Calibration/calkitdialog.cpp \
@@ -26,10 +28,13 @@ SOURCES +=  \
     ../LibreVNA-GUI/CustomWidgets/touchstoneimport.cpp \
     ../LibreVNA-GUI/CustomWidgets/tracesetselector.cpp \
     ../LibreVNA-GUI/Device/LibreVNA/amplitudecaldialog.cpp \
+    ../LibreVNA-GUI/Device/LibreVNA/datapointdecoder.cpp \
+    ../LibreVNA-GUI/Device/LibreVNA/datapointpool.cpp \
     ../LibreVNA-GUI/Device/LibreVNA/deviceconfigurationdialogv1.cpp \
     ../LibreVNA-GUI/Device/LibreVNA/deviceconfigurationdialogvfe.cpp \
     ../LibreVNA-GUI/Device/LibreVNA/deviceconfigurationdialogvff.cpp \
     ../LibreVNA-GUI/Device/LibreVNA/firmwareupdatedialog.cpp \
+    ../LibreVNA-GUI/Device/LibreVNA/firmwareuploader.cpp \
     ../LibreVNA-GUI/Device/LibreVNA/frequencycaldialog.cpp \
     ../LibreVNA-GUI/Device/LibreVNA/librevnadriver.cpp \
     ../LibreVNA-GUI/Device/LibreVNA/librevnatcpdriver.cpp \
@@ -49,6 +54,7 @@ SOURCES +=  \
     ../LibreVNA-GUI/Device/LibreVNA/devicepacketlog.cpp \
     ../LibreVNA-GUI/Device/LibreVNA/devicepacketlogview.cpp \
     ../LibreVNA-GUI/Device/devicetcpdriver.cpp \
+    ../LibreVNA-GUI/Device/measurementblock.cpp \
     ../LibreVNA-GUI/Generator/generator.cpp \
     ../LibreVNA-GUI/Generator/signalgenwidget.cpp \
     ../LibreVNA-GUI/SpectrumAnalyzer/spectrumanalyzer.cpp \
@@ -63,6 +69,7 @@ SOURCES +=  \
     ../LibreVNA-GUI/Traces/Marker/markerwidget.cpp \
     ../LibreVNA-GUI/Traces/Math/dft.cpp \
     ../LibreVNA-GUI/Traces/Math/expression.cpp \
+    ../LibreVNA-GUI/Traces/Math/compiledexpression.cpp \
     ../LibreVNA-GUI/Traces/Math/medianfilter.cpp \
     ../LibreVNA-GUI/Traces/Math/parser/mpError.cpp \
     ../LibreVNA-GUI/Traces/Math/parser/mpFuncCmplx.cpp \
@@ -107,6 +114,7 @@ SOURCES +=  \
     ../LibreVNA-GUI/Traces/Math/windowfunction.cpp \
     ../LibreVNA-GUI/Traces/eyediagramplot.cpp \
     ../LibreVNA-GUI/Traces/fftcomplex.cpp \
+    ../LibreVNA-GUI/Traces/polylinedecimator.cpp \
     ../LibreVNA-GUI/Traces/sparamtraceselector.cpp \
     ../LibreVNA-GUI/Traces/trace.cpp \
     ../LibreVNA-GUI/Traces/traceaxis.cpp \
@@ -126,7 +134,9 @@ SOURCES +=  \
     ../LibreVNA-GUI/Traces/xyplotaxisdialog.cpp \
     ../LibreVNA-GUI/Util/prbs.cpp \
     ../LibreVNA-GUI/Util/util.cpp \
+    ../LibreVNA-GUI/Util/textio.cpp \
     ../LibreVNA-GUI/Util/usbinbuffer.cpp \
+    ../LibreVNA-GUI/Util/streambuffer.cpp \
     ../LibreVNA-GUI/VNA/Deembedding/deembedding.cpp \
     ../LibreVNA-GUI/VNA/Deembedding/deembeddingdialog.cpp \
     ../LibreVNA-GUI/VNA/Deembedding/deembeddingoption.cpp \
@@ -140,6 +150,7 @@ SOURCES +=  \
     ../LibreVNA-GUI/about.cpp \
     ../LibreVNA-GUI/appwindow.cpp \
     ../LibreVNA-GUI/averaging.cpp \
+    ../LibreVNA-GUI/binarycontainer.cpp \
     ../LibreVNA-GUI/csv.cpp \
     ../LibreVNA-GUI/mode.cpp \
     ../LibreVNA-GUI/modehandler.cpp \
@@ -151,14 +162,33 @@ SOURCES +=  \
     ../LibreVNA-GUI/streamingserver.cpp \
     ../LibreVNA-GUI/touchstone.cpp \
     ../LibreVNA-GUI/unit.cpp \
+    crctests.cpp \
+    datapointpooltests.cpp \
+    calibrationkerneltests.cpp \
     ffttests.cpp \
     main.cpp \
     parametertests.cpp \
     portextensiontests.cpp \
+    polylinedecimatortests.cpp \
+    medianfiltertests.cpp \
+    compiledexpressiontests.cpp \
+    calibrationcomputetests.cpp \
+    binarycontainertests.cpp \
+    fileiotests.cpp \
+    devicepacketlogtests.cpp \
+    streambuffertests.cpp \
+    timedomaintests.cpp \
+    averagingtests.cpp \
+    firmwaretransfertests.cpp \
+    compoundmergebuffertests.cpp \
+    datapointdecodertests.cpp \
+    measurementblocktests.cpp \
+    tracewaterfalltests.cpp \
     utiltests.cpp
 
 HEADERS += \
     ../../VNA_embedded/Application/Communication/Protocol.hpp \
+    ../../VNA_embedded/Application/Communication/FirmwareTransfer.hpp \
     ../LibreVNA-GUI/Calibration/Eigen/Cholesky \
     ../LibreVNA-GUI/Calibration/Eigen/CholmodSupport \
     ../LibreVNA-GUI/Calibration/Eigen/Core \
@@ -193,6 +223,7 @@ HEADERS += \
     ../LibreVNA-GUI/Calibration/LibreCAL/librecaldialog.h \
     ../LibreVNA-GUI/Calibration/LibreCAL/usbdevice.h \
     ../LibreVNA-GUI/Calibration/calibration.h \
+    ../LibreVNA-GUI/Calibration/calibrationkernel.h \
     ../LibreVNA-GUI/Calibration/calibrationmeasurement.h \
     ../LibreVNA-GUI/Calibration/calkit.h \
     ../LibreVNA-GUI/Calibration/calkitdialog.h \
@@ -208,10 +239,13 @@ HEADERS += \
     ../LibreVNA-GUI/CustomWidgets/touchstoneimport.h \
     ../LibreVNA-GUI/CustomWidgets/tracesetselector.h \
     ../LibreVNA-GUI/Device/LibreVNA/amplitudecaldialog.h \
+    ../LibreVNA-GUI/Device/LibreVNA/datapointdecoder.h \
+    ../LibreVNA-GUI/Device/LibreVNA/datapointpool.h \
     ../LibreVNA-GUI/Device/LibreVNA/deviceconfigurationdialogv1.h \
     ../LibreVNA-GUI/Device/LibreVNA/deviceconfigurationdialogvfe.h \
     ../LibreVNA-GUI/Device/LibreVNA/deviceconfigurationdialogvff.h \
     ../LibreVNA-GUI/Device/LibreVNA/firmwareupdatedialog.h \
+    ../LibreVNA-GUI/Device/LibreVNA/firmwareuploader.h \
     ../LibreVNA-GUI/Device/LibreVNA/frequencycaldialog.h \
     ../LibreVNA-GUI/Device/LibreVNA/librevnadriver.h \
     ../LibreVNA-GUI/Device/LibreVNA/librevnatcpdriver.h \
@@ -223,6 +257,7 @@ HEADERS += \
     ../LibreVNA-GUI/Device/LibreVNA/sourcecaldialog.h \
     ../LibreVNA-GUI/Device/LibreVNA/Compound/compounddevice.h \
     ../LibreVNA-GUI/Device/LibreVNA/Compound/compounddriver.h \
+    ../LibreVNA-GUI/Device/LibreVNA/Compound/compoundmergebuffer.h \
     ../LibreVNA-GUI/Device/LibreVNA/Compound/compounddeviceeditdialog.h \
     ../LibreVNA-GUI/Device/SSA3000X/ssa3000xdriver.h \
     ../LibreVNA-GUI/Device/SNA5000A/sna5000adriver.h \
@@ -231,6 +266,7 @@ HEADERS += \
     ../LibreVNA-GUI/Device/LibreVNA/devicepacketlog.h \
     ../LibreVNA-GUI/Device/LibreVNA/devicepacketlogview.h \
     ../LibreVNA-GUI/Device/devicetcpdriver.h \
+    ../LibreVNA-GUI/Device/measurementblock.h \
     ../LibreVNA-GUI/Generator/generator.h \
     ../LibreVNA-GUI/Generator/signalgenwidget.h \
     ../LibreVNA-GUI/SpectrumAnalyzer/spectrumanalyzer.h \
@@ -245,6 +281,7 @@ HEADERS += \
     ../LibreVNA-GUI/Traces/Marker/markerwidget.h \
     ../LibreVNA-GUI/Traces/Math/dft.h \
     ../LibreVNA-GUI/Traces/Math/expression.h \
+    ../LibreVNA-GUI/Traces/Math/compiledexpression.h \
     ../LibreVNA-GUI/Traces/Math/medianfilter.h \
     ../LibreVNA-GUI/Traces/Math/parser/mpCompat.h \
     ../LibreVNA-GUI/Traces/Math/parser/mpDefines.h \
@@ -300,6 +337,7 @@ HEADERS += \
     ../LibreVNA-GUI/Traces/Math/windowfunction.h \
     ../LibreVNA-GUI/Traces/eyediagramplot.h \
     ../LibreVNA-GUI/Traces/fftcomplex.h \
+    ../LibreVNA-GUI/Traces/polylinedecimator.h \
     ../LibreVNA-GUI/Traces/sparamtraceselector.h \
     ../LibreVNA-GUI/Traces/trace.h \
     ../LibreVNA-GUI/Traces/traceaxis.h \
@@ -319,7 +357,9 @@ HEADERS += \
     ../LibreVNA-GUI/Traces/xyplotaxisdialog.h \
     ../LibreVNA-GUI/Util/prbs.h \
     ../LibreVNA-GUI/Util/util.h \
+    ../LibreVNA-GUI/Util/textio.h \
     ../LibreVNA-GUI/Util/usbinbuffer.h \
+    ../LibreVNA-GUI/Util/streambuffer.h \
     ../LibreVNA-GUI/VNA/Deembedding/deembedding.h \
     ../LibreVNA-GUI/VNA/Deembedding/deembeddingdialog.h \
     ../LibreVNA-GUI/VNA/Deembedding/deembeddingoption.h \
@@ -333,6 +373,7 @@ HEADERS += \
     ../LibreVNA-GUI/about.h \
     ../LibreVNA-GUI/appwindow.h \
     ../LibreVNA-GUI/averaging.h \
+    ../LibreVNA-GUI/binarycontainer.h \
     ../LibreVNA-GUI/csv.h \
     ../LibreVNA-GUI/json.hpp \
     ../LibreVNA-GUI/mode.h \
@@ -345,9 +386,27 @@ HEADERS += \
     ../LibreVNA-GUI/streamingserver.h \
     ../LibreVNA-GUI/touchstone.h \
     ../LibreVNA-GUI/unit.h \
+    crctests.h \
+    datapointpooltests.h \
+    calibrationkerneltests.h \
     ffttests.h \
     parametertests.h \
     portextensiontests.h \
+    polylinedecimatortests.h \
+    medianfiltertests.h \
+    compiledexpressiontests.h \
+    calibrationcomputetests.h \
+    binarycontainertests.h \
+    fileiotests.h \
+    devicepacketlogtests.h \
+    streambuffertests.h \
+    timedomaintests.h \
+    averagingtests.h \
+    firmwaretransfertests.h \
+    compoundmergebuffertests.h \
+    datapointdecodertests.h \
+    measurementblocktests.h \
+    tracewaterfalltests.h \
     utiltests.h
 
 INCLUDEPATH += \
@@ -0,0 +1,265 @@
+#include "averagingtests.h"
+
+#include "averaging.h"
+
+#include <deque>
+#include <random>
+#include <algorithm>
+
+using namespace std;
+
+// Straightforward averaging of the stored samples of a single point (sums/sorts all samples for every new one)
+class ReferenceAveraging {
+public:
+    ReferenceAveraging(unsigned int averages) : averages(averages) {}
+    vector<complex<double>> process(vector<complex<double>> data, Averaging::Mode mode) {
+        samples.push_back(data);
+        while(samples.size() > averages) {
+            samples.pop_front();
+        }
+        auto size = samples.size();
+        for(unsigned int i=0;i<data.size();i++) {
+            if(mode == Averaging::Mode::Mean) {
+                complex<double> sum = 0.0;
+                for(auto &s : samples) {
+                    sum += s[i];
+                }
+                data[i] = sum / (double) size;
+            } else {
+                vector<complex<double>> sorted;
+                for(auto &s : samples) {
+                    sorted.insert(upper_bound(sorted.begin(), sorted.end(), s[i], [](const complex<double>&a, const complex<double>&b){
+                        return abs(a) < abs(b);
+                    }), s[i]);
+                }
+                data[i] = size & 0x01 ? sorted[size / 2] : (sorted[size / 2 - 1] + sorted[size / 2]) / 2.0;
+            }
+        }
+        return data;
+    }
+    unsigned int averages;
+    deque<vector<complex<double>>> samples;
+};
+
+static DeviceDriver::VNAMeasurement measurement(unsigned int pointNum, mt19937 &gen) {
+    static auto layout = MeasurementLayout::get({"S11", "S12", "S21", "S22"});
+    uniform_real_distribution<double> dist(-1.0, 1.0);
+    DeviceDriver::VNAMeasurement m;
+    m.pointNum = pointNum;
+    m.frequency = 1000000 + pointNum;
+    m.dBm = -10.0;
+    m.Z0 = 50.0;
+    m.measurements.setLayout(layout);
+    for(unsigned int i=0;i<m.measurements.size();i++) {
+        m.measurements.value(i) = complex<double>(dist(gen), dist(gen));
+    }
+    return m;
+}
+
+static vector<complex<double>> values(const DeviceDriver::VNAMeasurement &m) {
+    return vector<complex<double>>(m.measurements.data(), m.measurements.data() + m.measurements.size());
+}
+
+// Compares the averaging of a few points with the reference
+static void compareWithReference(Averaging::Mode mode, unsigned int averages, unsigned int sweeps) {
+    constexpr unsigned int points = 5;
+    Averaging a;
+    a.setMode(mode);
+    a.setAverages(averages);
+    a.reset(points);
+    vector<ReferenceAveraging> reference(points, ReferenceAveraging(averages));
+    mt19937 gen(averages);
+    for(unsigned int sweep=0;sweep<sweeps;sweep++) {
+        for(unsigned int p=0;p<points;p++) {
+            auto m = measurement(p, gen);
+            auto expected = reference[p].process(values(m), mode);
+            auto result = values(a.process(m));
+            for(unsigned int i=0;i<expected.size();i++) {
+                QVERIFY(abs(result[i] - expected[i]) < 1e-12);
+            }
+        }
+    }
+}
+
+AveragingTests::AveragingTests()
+{
+
+}
+
+void AveragingTests::mean()
+{
+    for(auto averages : {1, 2, 3, 10}) {
+        compareWithReference(Averaging::Mode::Mean, averages, 35);
+    }
+    // the running sum is not allowed to drift away over many sweeps
+    compareWithReference(Averaging::Mode::Mean, 7, 5000);
+}
+
+void AveragingTests::median()
+{
+    for(auto averages : {1, 2, 3, 4, 10, 11}) {
+        compareWithReference(Averaging::Mode::Median, averages, 35);
+    }
+}
+
+void AveragingTests::exponential()
+{
+    constexpr unsigned int averages = 4;
+    Averaging a;
+    a.setMode(Averaging::Mode::Exponential);
+    a.setAverages(averages);
+    a.reset(1);
+    mt19937 gen(1);
+    vector<complex<double>> expected;
+    for(unsigned int sweep=1;sweep<=20;sweep++) {
+        auto m = measurement(0, gen);
+        auto v = values(m);
+        if(expected.empty()) {
+            expected = v;
+        }
+        // same as the mean until the number of averages has been reached, then weighted with 1/averages
+        double weight = 1.0 / min(sweep, averages);
+        for(unsigned int i=0;i<v.size();i++) {
+            expected[i] = expected[i] * (1.0 - weight) + v[i] * weight;
+        }
+        auto result = values(a.process(m));
+        for(unsigned int i=0;i<v.size();i++) {
+            QVERIFY(abs(result[i] - expected[i]) < 1e-12);
+        }
+        QCOMPARE(a.getLevel(), min(sweep, averages));
+    }
+}
+
+void AveragingTests::unknownMode()
+{
+    // e.g. set through the preferences at runtime
+    Averaging a;
+    a.setMode((Averaging::Mode) 7);
+    QCOMPARE(a.getMode(), Averaging::Mode::Mean);
+    a.setMode(Averaging::Mode::Median);
+    a.setMode((Averaging::Mode) -1);
+    QCOMPARE(a.getMode(), Averaging::Mode::Mean);
+}
+
+void AveragingTests::changeAverages()
+{
+    Averaging a;
+    a.setAverages(5);
+    a.reset(1);
+    mt19937 gen(1);
+    ReferenceAveraging reference(5);
+    for(unsigned int sweep=0;sweep<8;sweep++) {
+        auto m = measurement(0, gen);
+        reference.process(values(m), Averaging::Mode::Mean);
+        a.process(m);
+    }
+    // reducing the number of averages keeps the newest samples
+    a.setAverages(3);
+    reference.averages = 3;
+    QCOMPARE(a.getLevel(), 3U);
+    for(unsigned int sweep=0;sweep<4;sweep++) {
+        auto m = measurement(0, gen);
+        auto expected = reference.process(values(m), Averaging::Mode::Mean);
+        auto result = values(a.process(m));
+        for(unsigned int i=0;i<expected.size();i++) {
+            QVERIFY(abs(result[i] - expected[i]) < 1e-12);
+        }
+    }
+    // increasing keeps all samples
+    a.setAverages(10);
+    reference.averages = 10;
+    QCOMPARE(a.getLevel(), 3U);
+    QVERIFY(!a.settled());
+    auto m = measurement(0, gen);
+    auto expected = reference.process(values(m), Averaging::Mode::Mean);
+    auto result = values(a.process(m));
+    QCOMPARE(a.getLevel(), 4U);
+    for(unsigned int i=0;i<expected.size();i++) {
+        QVERIFY(abs(result[i] - expected[i]) < 1e-12);
+    }
+}
+
+void AveragingTests::spectrumAnalyzer()
+{
+    Averaging a;
+    a.setAverages(2);
+    a.reset(1);
+    DeviceDriver::SAMeasurement m;
+    m.pointNum = 0;
+    m.frequency = 1000000;
+    m.measurements["PORT1"] = 1.0;
+    m.measurements["PORT2"] = 3.0;
+    a.process(m);
+    m.measurements["PORT1"] = 2.0;
+    m.measurements["PORT2"] = 5.0;
+    auto result = a.process(m);
+    QCOMPARE(result.measurements["PORT1"], 1.5);
+    QCOMPARE(result.measurements["PORT2"], 4.0);
+}
+
+void AveragingTests::levels()
+{
+    constexpr unsigned int points = 3;
+    Averaging a;
+    a.setAverages(2);
+    a.reset(points);
+    QCOMPARE(a.getLevel(), 0U);
+    QCOMPARE(a.currentSweep(), 0U);
+    mt19937 gen(1);
+    a.process(measurement(0, gen));
+    QCOMPARE(a.currentSweep(), 1U);
+    QCOMPARE(a.getLevel(), 0U);
+    a.process(measurement(1, gen));
+    a.process(measurement(2, gen));
+    QCOMPARE(a.getLevel(), 1U);
+    QVERIFY(!a.settled());
+    for(unsigned int p=0;p<points;p++) {
+        a.process(measurement(p, gen));
+    }
+    QCOMPARE(a.getLevel(), 2U);
+    QVERIFY(a.settled());
+    // points beyond the configured number are added on demand
+    a.process(measurement(points, gen));
+    QCOMPARE(a.getLevel(), 1U);
+    // points with even larger numbers are passed on unchanged
+    auto m = measurement(points + 5, gen);
+    QVERIFY(values(a.process(m)) == values(m));
+
+    a.reset(points);
+    QCOMPARE(a.getLevel(), 0U);
+}
+
+static void benchmark(Averaging::Mode mode) {
+    constexpr unsigned int points = 1001;
+    constexpr unsigned int averages = 100;
+    mt19937 gen(1);
+    vector<DeviceDriver::VNAMeasurement> sweep;
+    for(unsigned int p=0;p<points;p++) {
+        sweep.push_back(measurement(p, gen));
+    }
+    Averaging a;
+    a.setMode(mode);
+    a.setAverages(averages);
+    a.reset(points);
+    // fill the buffers first
+    for(unsigned int i=0;i<averages;i++) {
+        for(auto &m : sweep) {
+            a.process(m);
+        }
+    }
+    QBENCHMARK {
+        for(auto &m : sweep) {
+            a.process(m);
+        }
+    }
+}
+
+void AveragingTests::benchmarkMean()
+{
+    benchmark(Averaging::Mode::Mean);
+}
+
+void AveragingTests::benchmarkMedian()
+{
+    benchmark(Averaging::Mode::Median);
+}
@@ -0,0 +1,24 @@
+#ifndef AVERAGINGTESTS_H
+#define AVERAGINGTESTS_H
+
+#include <QtTest>
+
+class AveragingTests : public QObject
+{
+    Q_OBJECT
+public:
+    AveragingTests();
+
+private slots:
+    void mean();
+    void median();
+    void exponential();
+    void unknownMode();
+    void changeAverages();
+    void spectrumAnalyzer();
+    void levels();
+    void benchmarkMean();
+    void benchmarkMedian();
+};
+
+#endif // AVERAGINGTESTS_H
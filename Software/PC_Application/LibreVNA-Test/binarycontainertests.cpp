@@ -0,0 +1,162 @@
+#include "binarycontainertests.h"
+
+#include "binarycontainer.h"
+
+#include <QTemporaryDir>
+
+#include <fstream>
+
+using namespace std;
+
+BinaryContainerTests::BinaryContainerTests()
+{
+
+}
+
+// Document with the same structure as a calibration: measurement points of one and two port measurements
+static nlohmann::json calibrationDocument(unsigned int points) {
+    nlohmann::json j;
+    j["format"] = 3;
+    j["ports"] = {1, 2};
+    for(unsigned int m=0;m<4;m++) {
+        nlohmann::json jmeas;
+        jmeas["type"] = "Open";
+        jmeas["data"]["port"] = m;
+        for(unsigned int i=0;i<points;i++) {
+            nlohmann::json jpoint;
+            jpoint["frequency"] = 1000000.0 + i * 1000.0;
+            jpoint["real"] = i * 0.001;
+            jpoint["imag"] = -(i * 0.002);
+            jmeas["data"]["points"].push_back(jpoint);
+        }
+        j["measurements"].push_back(jmeas);
+    }
+    nlohmann::json jthrough;
+    jthrough["type"] = "Through";
+    for(unsigned int i=0;i<points;i++) {
+        nlohmann::json jpoint;
+        jpoint["frequency"] = 1000000.0 + i * 1000.0;
+        for(auto name : {"m11", "m12", "m21", "m22"}) {
+            jpoint["Sparam"][string(name)+"_real"] = i * 0.5;
+            jpoint["Sparam"][string(name)+"_imag"] = 0.25;
+        }
+        jthrough["data"]["points"].push_back(jpoint);
+    }
+    j["measurements"].push_back(jthrough);
+    return j;
+}
+
+void BinaryContainerTests::packUnpack()
+{
+    auto j = calibrationDocument(100);
+    // not packed: too short, integer fields, different fields in the elements
+    for(unsigned int i=0;i<20;i++) {
+        j["integers"].push_back({{"x", 1.0 * i}, {"index", i}});
+        j["different"].push_back({{i % 2 ? "x" : "y", 1.0 * i}});
+    }
+    j["short"] = {{{"x", 1.0}}, {{"x", 2.0}}};
+    j["empty"] = nlohmann::json::array();
+    // nested arrays as in the isolation measurement
+    for(unsigned int i=0;i<20;i++) {
+        j["nested"].push_back({{"frequency", 1.0 * i}, {"S", {{{{"real", 1.0 * i}, {"imag", 2.0}}, {{"real", 3.0}, {"imag", 4.0 * i}}}}}});
+    }
+
+    BinaryContainer container;
+    auto packed = container.pack(j);
+    QVERIFY(packed["measurements"][0]["data"]["points"].is_object());
+    QVERIFY(packed["measurements"][4]["data"]["points"].is_object());
+    QVERIFY(packed["nested"].is_object());
+    QVERIFY(packed["integers"].is_array());
+    QVERIFY(packed["different"].is_array());
+    QVERIFY(packed["short"].is_array());
+    // a packed document is much smaller
+    QVERIFY(packed.dump().size() * 10 < j.dump().size());
+
+    QTemporaryDir dir;
+    auto filename = dir.filePath("packed.bin");
+    QVERIFY(container.save(filename, packed));
+    BinaryContainer read;
+    read.open(filename);
+    QVERIFY(read.unpack(read.getDocument()) == j);
+}
+
+void BinaryContainerTests::saveAndOpen()
+{
+    QTemporaryDir dir;
+    auto filename = dir.filePath("arrays.bin");
+    BinaryContainer container;
+    nlohmann::json j;
+    j["first"] = container.addArray({1.0, 2.0, 3.0});
+    j["empty"] = container.addArray({});
+    j["second"] = container.addArray({-1.5});
+    QVERIFY(container.save(filename, j));
+
+    QVERIFY(BinaryContainer::isBinary(filename));
+    BinaryContainer read;
+    read.open(filename);
+    QVERIFY(read.getDocument() == j);
+    QCOMPARE(read.getNumArrays(), 3U);
+    QCOMPARE(read.getArraySize(j["first"]), 3ULL);
+    QCOMPARE(read.getArray(j["first"])[2], 3.0);
+    QCOMPARE(read.getArraySize(j["empty"]), 0ULL);
+    QCOMPARE(read.getArraySize(j["second"]), 1ULL);
+    QCOMPARE(read.getArray(j["second"])[0], -1.5);
+    // arrays are used in place and have to be aligned
+    QVERIFY((quintptr) read.getArray(j["second"]) % alignof(double) == 0);
+    QVERIFY(read.getArray(3) == nullptr);
+}
+
+void BinaryContainerTests::invalidFiles()
+{
+    QTemporaryDir dir;
+    auto json = dir.filePath("file.json");
+    ofstream(json.toStdString()) << calibrationDocument(10);
+    QVERIFY(!BinaryContainer::isBinary(json));
+    QVERIFY(!BinaryContainer::isBinary(dir.filePath("missing")));
+
+    auto filename = dir.filePath("file.bin");
+    BinaryContainer container;
+    QVERIFY(container.save(filename, container.pack(calibrationDocument(100))));
+    QFile f(filename);
+    QVERIFY(f.open(QIODevice::ReadOnly));
+    auto content = f.readAll();
+    f.close();
+
+    // every truncated version has to be rejected
+    auto truncated = dir.filePath("truncated.bin");
+    for(int size : {0, 8, 31, 100, content.size() / 2, content.size() - 1}) {
+        QFile t(truncated);
+        QVERIFY(t.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        t.write(content.left(size));
+        t.close();
+        BinaryContainer read;
+        QVERIFY_EXCEPTION_THROWN(read.open(truncated), std::exception);
+    }
+    BinaryContainer read;
+    QVERIFY_EXCEPTION_THROWN(read.open(json), std::runtime_error);
+}
+
+void BinaryContainerTests::benchmarkLoad()
+{
+    // 4 port calibration with 20k points, 20 measurements
+    constexpr unsigned int points = 20000;
+    nlohmann::json j;
+    for(unsigned int m=0;m<5;m++) {
+        auto document = calibrationDocument(points);
+        for(auto &meas : document["measurements"]) {
+            j["measurements"].push_back(meas);
+        }
+    }
+    QTemporaryDir dir;
+    auto binaryFile = dir.filePath("cal.calbin");
+    BinaryContainer container;
+    QVERIFY(container.save(binaryFile, container.pack(j)));
+
+    nlohmann::json unpacked;
+    QBENCHMARK {
+        BinaryContainer read;
+        read.open(binaryFile);
+        unpacked = read.unpack(read.getDocument());
+    }
+    QVERIFY(unpacked == j);
+}
@@ -0,0 +1,19 @@
+#ifndef BINARYCONTAINERTESTS_H
+#define BINARYCONTAINERTESTS_H
+
+#include <QtTest>
+
+class BinaryContainerTests : public QObject
+{
+    Q_OBJECT
+public:
+    BinaryContainerTests();
+
+private slots:
+    void packUnpack();
+    void saveAndOpen();
+    void invalidFiles();
+    void benchmarkLoad();
+};
+
+#endif // BINARYCONTAINERTESTS_H
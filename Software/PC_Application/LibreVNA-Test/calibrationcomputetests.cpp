@@ -0,0 +1,251 @@
+#include "calibrationcomputetests.h"
+
+#include "Calibration/calibration.h"
+#include "Eigen/Dense"
+
+#include <random>
+
+using namespace std;
+using cd = complex<double>;
+
+// frequency range of the calibration measurements, within the usable range of the line standard
+static constexpr double startFreq = 1000000000.0;
+static constexpr double stopFreq = 4000000000.0;
+static constexpr double lineDelay = 100e-12;
+
+CalibrationComputeTests::CalibrationComputeTests()
+{
+
+}
+
+// Random error box in front of every port. This error model can be calibrated with SOLT as well as with TRL
+class ErrorModel {
+public:
+    ErrorModel(unsigned int ports, mt19937 &gen) {
+        uniform_real_distribution<double> dist(-0.2, 0.2);
+        auto rnd = [&](double offset) -> cd {
+            return cd(offset + dist(gen), dist(gen));
+        };
+        for(unsigned int i=0;i<ports;i++) {
+            D.push_back(rnd(0.0));
+            S.push_back(rnd(0.0));
+            x.push_back(rnd(1.0));
+            y.push_back(rnd(1.0));
+        }
+    }
+
+    // Returns the raw measurement of a device connected to the given ports (port count starts at 1)
+    Eigen::MatrixXcd measure(const Eigen::MatrixXcd &dut, const vector<unsigned int> &ports) const {
+        unsigned int n = ports.size();
+        Eigen::MatrixXcd M(n, n);
+        for(unsigned int i=0;i<n;i++) {
+            auto src = ports[i] - 1;
+            // waves at the device when port i is excited, all other ports are terminated by the match of their error box
+            Eigen::MatrixXcd A = Eigen::MatrixXcd::Identity(n, n);
+            Eigen::VectorXcd excitation = Eigen::VectorXcd::Zero(n);
+            excitation(i) = 1.0;
+            for(unsigned int k=0;k<n;k++) {
+                if(k != i) {
+                    A.row(k) -= S[ports[k] - 1] * dut.row(k);
+                }
+            }
+            Eigen::VectorXcd a = A.partialPivLu().solve(excitation);
+            Eigen::VectorXcd b = dut * a;
+            auto incident = 1.0 / (1.0 - S[src] * b(i));
+            M(i,i) = D[src] + x[src] * y[src] * b(i) * incident;
+            for(unsigned int k=0;k<n;k++) {
+                if(k != i) {
+                    M(k,i) = x[src] * y[ports[k] - 1] * b(k) * incident;
+                }
+            }
+        }
+        return M;
+    }
+
+    // directivity, source match and the transmission of the error boxes in both directions
+    vector<cd> D, S, x, y;
+};
+
+static double frequency(unsigned int point, unsigned int points) {
+    return startFreq + (stopFreq - startFreq) * point / (points - 1);
+}
+
+// Creates the standards and all measurements required for the calibration type and computes the calibration
+static void createCalibration(Calibration &cal, Calibration::Type type, unsigned int ports, unsigned int points, const ErrorModel &model) {
+    auto open = new CalStandard::Open;
+    auto _short = new CalStandard::Short;
+    auto load = new CalStandard::Load;
+    auto through = new CalStandard::Through;
+    auto reflect = new CalStandard::Reflect;
+    auto line = new CalStandard::Line;
+    line->fromJSON({{"name", "Line"}, {"delay", lineDelay}});
+    vector<CalStandard::Virtual*> standards = {open, _short, load, through, reflect, line};
+    for(auto s : standards) {
+        cal.getKit().addStandard(s);
+    }
+
+    nlohmann::json jmeasurements;
+    auto addMeasurement = [&](CalibrationMeasurement::Base::Type type, CalStandard::Virtual *standard, vector<unsigned int> measPorts,
+            function<Eigen::MatrixXcd(double)> dut) {
+        nlohmann::json j;
+        j["standard"] = standard->getID();
+        if(measPorts.size() == 1) {
+            j["port"] = measPorts[0];
+        } else {
+            j["port1"] = measPorts[0];
+            j["port2"] = measPorts[1];
+        }
+        for(unsigned int i=0;i<points;i++) {
+            auto f = frequency(i, points);
+            auto M = model.measure(dut(f), measPorts);
+            nlohmann::json jpoint;
+            jpoint["frequency"] = f;
+            if(measPorts.size() == 1) {
+                jpoint["real"] = M(0,0).real();
+                jpoint["imag"] = M(0,0).imag();
+            } else {
+                jpoint["Sparam"] = Sparam(M(0,0), M(0,1), M(1,0), M(1,1)).toJSON();
+            }
+            j["points"].push_back(jpoint);
+        }
+        nlohmann::json jmeas;
+        jmeas["type"] = CalibrationMeasurement::Base::TypeToString(type).toStdString();
+        jmeas["data"] = j;
+        jmeasurements.push_back(jmeas);
+    };
+    auto reflection = [](cd value) -> Eigen::MatrixXcd {
+        return Eigen::MatrixXcd::Constant(1, 1, value);
+    };
+
+    vector<unsigned int> usedPorts;
+    for(unsigned int p=1;p<=ports;p++) {
+        usedPorts.push_back(p);
+        if(type == Calibration::Type::SOLT) {
+            addMeasurement(CalibrationMeasurement::Base::Type::Open, open, {p}, [&](double f) {return reflection(open->toS11(f));});
+            addMeasurement(CalibrationMeasurement::Base::Type::Short, _short, {p}, [&](double f) {return reflection(_short->toS11(f));});
+            addMeasurement(CalibrationMeasurement::Base::Type::Load, load, {p}, [&](double f) {return reflection(load->toS11(f));});
+        } else {
+            // reflect standard is a short
+            addMeasurement(CalibrationMeasurement::Base::Type::Reflect, reflect, {p}, [&](double) {return reflection(-1.0);});
+        }
+    }
+    for(unsigned int p1=1;p1<=ports;p1++) {
+        for(unsigned int p2=p1+1;p2<=ports;p2++) {
+            addMeasurement(CalibrationMeasurement::Base::Type::Through, through, {p1, p2}, [&](double f) {
+                auto S = through->toSparam(f);
+                Eigen::MatrixXcd M(2, 2);
+                M << S.m11, S.m12, S.m21, S.m22;
+                return M;
+            });
+            if(type == Calibration::Type::TRL) {
+                addMeasurement(CalibrationMeasurement::Base::Type::Line, line, {p1, p2}, [&](double f) {
+                    auto transmission = exp(cd(0.0, -2.0 * M_PI * f * lineDelay));
+                    Eigen::MatrixXcd M(2, 2);
+                    M << 0.0, transmission, transmission, 0.0;
+                    return M;
+                });
+            }
+        }
+    }
+
+    nlohmann::json j;
+    j["format"] = 3;
+    j["measurements"] = jmeasurements;
+    j["type"] = Calibration::TypeToString(type).toStdString();
+    j["ports"] = usedPorts;
+    // also computes the calibration
+    cal.fromJSON(j);
+}
+
+// Checks that the calibration removes the error model from the measurement of a random device
+static void verifyCorrection(Calibration &cal, unsigned int ports, const ErrorModel &model, mt19937 &gen) {
+    uniform_real_distribution<double> dist(-0.5, 0.5);
+    Eigen::MatrixXcd dut(ports, ports);
+    QStringList names;
+    vector<unsigned int> usedPorts;
+    for(unsigned int i=1;i<=ports;i++) {
+        usedPorts.push_back(i);
+        for(unsigned int j=1;j<=ports;j++) {
+            dut(i-1, j-1) = cd(dist(gen), dist(gen));
+            names.append("S"+QString::number(i)+QString::number(j));
+        }
+    }
+    auto measured = model.measure(dut, usedPorts);
+    DeviceDriver::VNAMeasurement m;
+    m.pointNum = 0;
+    m.frequency = (startFreq + stopFreq) / 2;
+    m.dBm = -10.0;
+    m.Z0 = 50.0;
+    m.measurements.setLayout(MeasurementLayout::get(names));
+    for(unsigned int rcv=1;rcv<=ports;rcv++) {
+        for(unsigned int src=1;src<=ports;src++) {
+            m.measurements.value(m.measurements.indexS(rcv, src)) = measured(rcv-1, src-1);
+        }
+    }
+    cal.correctMeasurement(m);
+    for(unsigned int rcv=1;rcv<=ports;rcv++) {
+        for(unsigned int src=1;src<=ports;src++) {
+            QVERIFY(abs(m.measurements.value(m.measurements.indexS(rcv, src)) - dut(rcv-1, src-1)) < 1e-9);
+        }
+    }
+}
+
+void CalibrationComputeTests::correctionSOLT()
+{
+    mt19937 gen(1);
+    for(unsigned int ports=1;ports<=4;ports++) {
+        ErrorModel model(ports, gen);
+        Calibration cal;
+        createCalibration(cal, Calibration::Type::SOLT, ports, 201, model);
+        QVERIFY(cal.getCaltype().type == Calibration::Type::SOLT);
+        QVERIFY(cal.getCaltype().usedPorts.size() == ports);
+        verifyCorrection(cal, ports, model, gen);
+    }
+}
+
+void CalibrationComputeTests::correctionTRL()
+{
+    mt19937 gen(2);
+    for(unsigned int ports=2;ports<=4;ports++) {
+        ErrorModel model(ports, gen);
+        Calibration cal;
+        createCalibration(cal, Calibration::Type::TRL, ports, 201, model);
+        QVERIFY(cal.getCaltype().type == Calibration::Type::TRL);
+        QVERIFY(cal.getCaltype().usedPorts.size() == ports);
+        verifyCorrection(cal, ports, model, gen);
+    }
+}
+
+// Computes the coefficients of a calibration with 1001 points per benchmark iteration
+static void benchmarkCompute(Calibration::Type type, unsigned int ports) {
+    constexpr unsigned int points = 1001;
+    mt19937 gen(3);
+    ErrorModel model(ports, gen);
+    Calibration cal;
+    createCalibration(cal, type, ports, points, model);
+    auto caltype = cal.getCaltype();
+    QVERIFY(caltype.usedPorts.size() == ports);
+    QBENCHMARK {
+        cal.compute(caltype);
+    }
+}
+
+void CalibrationComputeTests::benchmarkSOLT2Port()
+{
+    benchmarkCompute(Calibration::Type::SOLT, 2);
+}
+
+void CalibrationComputeTests::benchmarkSOLT4Port()
+{
+    benchmarkCompute(Calibration::Type::SOLT, 4);
+}
+
+void CalibrationComputeTests::benchmarkTRL2Port()
+{
+    benchmarkCompute(Calibration::Type::TRL, 2);
+}
+
+void CalibrationComputeTests::benchmarkTRL4Port()
+{
+    benchmarkCompute(Calibration::Type::TRL, 4);
+}
@@ -0,0 +1,21 @@
+#ifndef CALIBRATIONCOMPUTETESTS_H
+#define CALIBRATIONCOMPUTETESTS_H
+
+#include <QtTest>
+
+class CalibrationComputeTests : public QObject
+{
+    Q_OBJECT
+public:
+    CalibrationComputeTests();
+
+private slots:
+    void correctionSOLT();
+    void correctionTRL();
+    void benchmarkSOLT2Port();
+    void benchmarkSOLT4Port();
+    void benchmarkTRL2Port();
+    void benchmarkTRL4Port();
+};
+
+#endif // CALIBRATIONCOMPUTETESTS_H
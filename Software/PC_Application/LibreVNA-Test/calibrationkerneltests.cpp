@@ -0,0 +1,307 @@
+#include "calibrationkerneltests.h"
+
+#include "Calibration/calibrationkernel.h"
+#include "Eigen/Dense"
+
+#include <random>
+
+using namespace std;
+using cd = complex<double>;
+
+CalibrationKernelTests::CalibrationKernelTests()
+{
+
+}
+
+// Error terms of one calibration point, same layout as in Calibration::Point
+class ErrorTerms {
+public:
+    double frequency;
+    vector<cd> D, R, S;
+    vector<vector<cd>> L, T, I;
+};
+
+static ErrorTerms randomTerms(double frequency, unsigned int ports, mt19937 &gen) {
+    uniform_real_distribution<double> dist(-0.2, 0.2);
+    auto rnd = [&](double offset) -> cd {
+        return cd(offset + dist(gen), dist(gen));
+    };
+    ErrorTerms t;
+    t.frequency = frequency;
+    for(unsigned int i=0;i<ports;i++) {
+        t.D.push_back(rnd(0.0));
+        t.R.push_back(rnd(1.0));
+        t.S.push_back(rnd(0.0));
+        t.L.push_back({});
+        t.T.push_back({});
+        t.I.push_back({});
+        for(unsigned int j=0;j<ports;j++) {
+            t.L[i].push_back(rnd(0.0));
+            t.T[i].push_back(rnd(1.0));
+            t.I[i].push_back(rnd(0.0) * 0.01);
+        }
+    }
+    return t;
+}
+
+static DeviceDriver::VNAMeasurement randomMeasurement(unsigned int pointNum, double frequency, unsigned int ports, mt19937 &gen) {
+    uniform_real_distribution<double> dist(-0.5, 0.5);
+    QStringList names;
+    for(unsigned int i=1;i<=ports;i++) {
+        for(unsigned int j=1;j<=ports;j++) {
+            names.append("S"+QString::number(i)+QString::number(j));
+        }
+    }
+    DeviceDriver::VNAMeasurement m;
+    m.pointNum = pointNum;
+    m.frequency = frequency;
+    m.dBm = -10.0;
+    m.Z0 = 50.0;
+    m.measurements.setLayout(MeasurementLayout::get(names));
+    for(unsigned int i=0;i<m.measurements.size();i++) {
+        m.measurements.value(i) = cd(dist(gen), dist(gen));
+    }
+    return m;
+}
+
+static ErrorTerms interpolate(const ErrorTerms &from, const ErrorTerms &to, double alpha) {
+    auto lerp = [=](cd a, cd b) {
+        return a * (1.0 - alpha) + b * alpha;
+    };
+    ErrorTerms ret = from;
+    for(unsigned int i=0;i<from.D.size();i++) {
+        ret.D[i] = lerp(from.D[i], to.D[i]);
+        ret.R[i] = lerp(from.R[i], to.R[i]);
+        ret.S[i] = lerp(from.S[i], to.S[i]);
+        for(unsigned int j=0;j<from.D.size();j++) {
+            ret.L[i][j] = lerp(from.L[i][j], to.L[i][j]);
+            ret.T[i][j] = lerp(from.T[i][j], to.T[i][j]);
+            ret.I[i][j] = lerp(from.I[i][j], to.I[i][j]);
+        }
+    }
+    return ret;
+}
+
+// Straightforward correction with dynamic matrices, as previously done in Calibration::correctMeasurement
+static void referenceCorrection(DeviceDriver::VNAMeasurement &d, const vector<ErrorTerms> &points, const vector<unsigned int> &usedPorts) {
+    ErrorTerms p;
+    if(d.frequency <= points.front().frequency) {
+        p = points.front();
+    } else if(d.frequency >= points.back().frequency) {
+        p = points.back();
+    } else {
+        auto upper = lower_bound(points.begin(), points.end(), d.frequency, [](const ErrorTerms &lhs, double rhs) {
+            return lhs.frequency < rhs;
+        });
+        auto lower = prev(upper);
+        p = interpolate(*lower, *upper, (d.frequency - lower->frequency) / (upper->frequency - lower->frequency));
+    }
+    auto n = usedPorts.size();
+    Eigen::MatrixXcd S(n, n), a(n, n), b(n, n);
+    for(unsigned int i=0;i<n;i++) {
+        for(unsigned int j=0;j<n;j++) {
+            S(j,i) = d.measurements.value(d.measurements.indexS(usedPorts[j], usedPorts[i]));
+            if(i != j) {
+                S(j,i) -= p.I[i][j];
+            }
+        }
+    }
+    for(unsigned int i=0;i<n;i++) {
+        for(unsigned int j=0;j<n;j++) {
+            if(i == j) {
+                a(j,i) = 1.0 + p.S[i]/p.R[i]*(S(j,i) - p.D[i]);
+                b(j,i) = (1.0 / p.R[i]) * (S(j,i) - p.D[i]);
+            } else {
+                a(j,i) = p.L[i][j]*S(j,i) / p.T[i][j];
+                b(j,i) = S(j,i) / p.T[i][j];
+            }
+        }
+    }
+    S = b * a.inverse();
+    for(unsigned int i=0;i<n;i++) {
+        for(unsigned int j=0;j<n;j++) {
+            d.measurements.value(d.measurements.indexS(usedPorts[j], usedPorts[i])) = S(j,i);
+        }
+    }
+}
+
+static void loadKernel(CalibrationKernel &kernel, const vector<ErrorTerms> &points, const vector<unsigned int> &usedPorts) {
+    kernel.reset(usedPorts, points.size());
+    for(unsigned int i=0;i<points.size();i++) {
+        auto &p = points[i];
+        kernel.setPoint(i, p.frequency, p.D, p.R, p.S, p.L, p.T, p.I);
+    }
+}
+
+void CalibrationKernelTests::identity()
+{
+    ErrorTerms ideal;
+    ideal.frequency = 1000000;
+    ideal.D = {0.0, 0.0};
+    ideal.R = {1.0, 1.0};
+    ideal.S = {0.0, 0.0};
+    ideal.L = {{0.0, 0.0}, {0.0, 0.0}};
+    ideal.T = {{1.0, 1.0}, {1.0, 1.0}};
+    ideal.I = {{0.0, 0.0}, {0.0, 0.0}};
+    CalibrationKernel kernel;
+    loadKernel(kernel, {ideal}, {1, 2});
+
+    mt19937 gen(0);
+    auto m = randomMeasurement(0, 1000000, 2, gen);
+    auto corrected = m;
+    kernel.correct(corrected);
+    for(unsigned int i=0;i<m.measurements.size();i++) {
+        QVERIFY(abs(corrected.measurements.value(i) - m.measurements.value(i)) < 1e-12);
+    }
+}
+
+void CalibrationKernelTests::compareWithReference()
+{
+    mt19937 gen(1);
+    for(unsigned int ports=1;ports<=5;ports++) {
+        vector<unsigned int> usedPorts;
+        for(unsigned int i=1;i<=ports;i++) {
+            usedPorts.push_back(i);
+        }
+        vector<ErrorTerms> points;
+        for(unsigned int i=0;i<5;i++) {
+            points.push_back(randomTerms(1000000 + i * 1000000, ports, gen));
+        }
+        CalibrationKernel kernel;
+        loadKernel(kernel, points, usedPorts);
+        // below, exactly at, between and above the calibration points. Run twice to also use the cached interpolation
+        vector<double> frequencies = {500000, 1000000, 1500000, 3000000, 4999999, 5000000, 6000000};
+        for(unsigned int sweep=0;sweep<2;sweep++) {
+            for(unsigned int i=0;i<frequencies.size();i++) {
+                auto m = randomMeasurement(i, frequencies[i], ports, gen);
+                auto expected = m;
+                referenceCorrection(expected, points, usedPorts);
+                kernel.correct(m);
+                for(unsigned int j=0;j<m.measurements.size();j++) {
+                    QVERIFY(abs(m.measurements.value(j) - expected.measurements.value(j)) < 1e-9);
+                }
+            }
+        }
+    }
+}
+
+void CalibrationKernelTests::blockAndSweep()
+{
+    mt19937 gen(3);
+    for(unsigned int ports=1;ports<=5;ports++) {
+        vector<unsigned int> usedPorts;
+        for(unsigned int i=1;i<=ports;i++) {
+            usedPorts.push_back(i);
+        }
+        vector<ErrorTerms> points;
+        for(unsigned int i=0;i<101;i++) {
+            points.push_back(randomTerms(1000000 + i * 1000000, ports, gen));
+        }
+        CalibrationKernel kernel;
+        loadKernel(kernel, points, usedPorts);
+        // large enough to be split across threads
+        vector<DeviceDriver::VNAMeasurement> block, expected;
+        for(unsigned int i=0;i<2001;i++) {
+            block.push_back(randomMeasurement(i, 500000 + i * 51000.0, ports, gen));
+            expected.push_back(block.back());
+            referenceCorrection(expected.back(), points, usedPorts);
+        }
+        // one array per S parameter for the sweep correction
+        vector<double> frequencies;
+        vector<vector<cd>> values(ports * ports);
+        for(auto &m : block) {
+            frequencies.push_back(m.frequency);
+            for(unsigned int i=0;i<ports;i++) {
+                for(unsigned int j=0;j<ports;j++) {
+                    values[i*ports+j].push_back(m.measurements.value(m.measurements.indexS(usedPorts[j], usedPorts[i])));
+                }
+            }
+        }
+        vector<cd*> parameters;
+        for(auto &v : values) {
+            parameters.push_back(v.data());
+        }
+
+        kernel.correct(block);
+        kernel.correctSweep(frequencies.data(), frequencies.size(), parameters);
+        for(unsigned int k=0;k<block.size();k++) {
+            for(unsigned int i=0;i<ports;i++) {
+                for(unsigned int j=0;j<ports;j++) {
+                    auto index = expected[k].measurements.indexS(usedPorts[j], usedPorts[i]);
+                    QVERIFY(abs(block[k].measurements.value(index) - expected[k].measurements.value(index)) < 1e-9);
+                    QVERIFY(abs(values[i*ports+j][k] - expected[k].measurements.value(index)) < 1e-9);
+                }
+            }
+        }
+    }
+}
+
+// Corrects a sweep of 1001 points per benchmark iteration
+static void benchmarkSOLT(unsigned int ports) {
+    constexpr unsigned int sweepPoints = 1001;
+    mt19937 gen(2);
+    vector<unsigned int> usedPorts;
+    for(unsigned int i=1;i<=ports;i++) {
+        usedPorts.push_back(i);
+    }
+    // calibration with fewer points than the sweep, every point has to be interpolated
+    vector<ErrorTerms> points;
+    for(unsigned int i=0;i<501;i++) {
+        points.push_back(randomTerms(1000000 + i * 12000000.0, ports, gen));
+    }
+    CalibrationKernel kernel;
+    loadKernel(kernel, points, usedPorts);
+    vector<DeviceDriver::VNAMeasurement> sweep;
+    for(unsigned int i=0;i<sweepPoints;i++) {
+        sweep.push_back(randomMeasurement(i, 1000000 + i * 5999000.0, ports, gen));
+    }
+    QBENCHMARK {
+        // corrects copies, correcting the same data over and over would diverge
+        for(auto m : sweep) {
+            kernel.correct(m);
+        }
+    }
+}
+
+void CalibrationKernelTests::benchmarkSOLT2Port()
+{
+    benchmarkSOLT(2);
+}
+
+void CalibrationKernelTests::benchmarkSOLT4Port()
+{
+    benchmarkSOLT(4);
+}
+
+void CalibrationKernelTests::benchmarkSweep4Port()
+{
+    // stored 64k point sweep, corrected as a whole
+    constexpr unsigned int sweepPoints = 65536;
+    constexpr unsigned int ports = 4;
+    mt19937 gen(4);
+    uniform_real_distribution<double> dist(-0.5, 0.5);
+    vector<unsigned int> usedPorts = {1, 2, 3, 4};
+    vector<ErrorTerms> points;
+    for(unsigned int i=0;i<1001;i++) {
+        points.push_back(randomTerms(1000000 + i * 6000000.0, ports, gen));
+    }
+    CalibrationKernel kernel;
+    loadKernel(kernel, points, usedPorts);
+    vector<double> frequencies;
+    vector<vector<cd>> values(ports * ports);
+    for(unsigned int k=0;k<sweepPoints;k++) {
+        frequencies.push_back(1000000 + k * 91553.0);
+        for(auto &v : values) {
+            v.push_back(cd(dist(gen), dist(gen)));
+        }
+    }
+    QBENCHMARK {
+        // corrects copies, correcting the same data over and over would diverge
+        auto copy = values;
+        vector<cd*> parameters;
+        for(auto &v : copy) {
+            parameters.push_back(v.data());
+        }
+        kernel.correctSweep(frequencies.data(), sweepPoints, parameters);
+    }
+}
@@ -0,0 +1,21 @@
+#ifndef CALIBRATIONKERNELTESTS_H
+#define CALIBRATIONKERNELTESTS_H
+
+#include <QtTest>
+
+class CalibrationKernelTests : public QObject
+{
+    Q_OBJECT
+public:
+    CalibrationKernelTests();
+
+private slots:
+    void identity();
+    void compareWithReference();
+    void blockAndSweep();
+    void benchmarkSOLT2Port();
+    void benchmarkSOLT4Port();
+    void benchmarkSweep4Port();
+};
+
+#endif // CALIBRATIONKERNELTESTS_H
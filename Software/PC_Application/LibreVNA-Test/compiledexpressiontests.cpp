@@ -0,0 +1,153 @@
+#include "compiledexpressiontests.h"
+
+#include "Traces/Math/compiledexpression.h"
+#include "Traces/Math/parser/mpParser.h"
+
+#include <random>
+
+using namespace std;
+using namespace mup;
+using Math::CompiledExpression;
+
+CompiledExpressionTests::CompiledExpressionTests()
+{
+
+}
+
+// samples of the variables x (complex), f (real frequency), S11 and S21 (complex)
+class Samples {
+public:
+    Samples(unsigned int count) {
+        mt19937 gen(1);
+        uniform_real_distribution<double> dist(-2.0, 2.0);
+        x.resize(count);
+        f.resize(count);
+        S11.resize(count);
+        S21.resize(count);
+        for(unsigned int i=0;i<count;i++) {
+            x[i] = complex<double>(dist(gen), dist(gen));
+            f[i] = 1000000.0 + i * 6000000000.0 / count;
+            S11[i] = complex<double>(dist(gen), dist(gen)) / 2.0;
+            S21[i] = complex<double>(dist(gen), dist(gen)) / 2.0;
+        }
+        // values which take different paths in muparserx
+        const vector<complex<double>> special = {0.0, 1.0, -1.0, 2.0, -2.0, 0.5, -0.5, complex<double>(0, 1), complex<double>(0, -2)};
+        for(unsigned int i=0;i<special.size() && i<count;i++) {
+            x[i] = special[i];
+            S11[count - 1 - i] = special[i];
+        }
+    }
+    const vector<string> names = {"x", "f", "S11", "S21"};
+    vector<const complex<double>*> pointers() const {
+        return {x.data(), f.data(), S11.data(), S21.data()};
+    }
+    vector<complex<double>> x, f, S11, S21;
+};
+
+static vector<complex<double>> evaluateWithParser(const string &expression, const Samples &samples)
+{
+    ParserX parser(pckCOMMON | pckUNIT | pckCOMPLEX);
+    parser.SetExpr(expression);
+    Value x, f, S11, S21;
+    parser.DefineVar("x", Variable(&x));
+    parser.DefineVar("f", Variable(&f));
+    parser.DefineVar("S11", Variable(&S11));
+    parser.DefineVar("S21", Variable(&S21));
+    vector<complex<double>> result(samples.x.size());
+    for(unsigned int i=0;i<result.size();i++) {
+        x = samples.x[i];
+        f = samples.f[i].real();
+        S11 = samples.S11[i];
+        S21 = samples.S21[i];
+        Value res = parser.Eval();
+        result[i] = res.GetComplex();
+    }
+    return result;
+}
+
+static bool equal(complex<double> a, complex<double> b)
+{
+    auto equalPart = [](double a, double b) {
+        if(std::isnan(a) || std::isnan(b)) {
+            return std::isnan(a) && std::isnan(b);
+        }
+        // allow for rounding differences (e.g. when the compiler contracts to fused multiply-add)
+        return a == b || abs(a - b) <= 1e-12 * max(1.0, max(abs(a), abs(b)));
+    };
+    return equalPart(a.real(), b.real()) && equalPart(a.imag(), b.imag());
+}
+
+void CompiledExpressionTests::compareWithParser()
+{
+    const vector<string> expressions = {
+        "x", "2*x+1", "x*x - x/3", "-x^2", "2^-x", "2^3^0.5", "x^2", "x^0.5", "real(x)^2", "real(x)^0.5", "(-2)^real(x)",
+        "(x-1)/(x+1)", "1/x", "x/-2", "2*-x", "x - -2", "-(x)", " - x * 3 ", "-x+1", ".5*x", "1.5e-3k*x", "2i*x", "x*2M",
+        "f/1G", "f*1n", "5m + 3u", "e^x", "i*x", "abs(x)", "arg(x)", "norm(x)", "real(x)*imag(x)", "conj(x)", "sqrt(x)",
+        "exp(-i*2*pi*f*1n)", "ln(x)+log(x)", "log2(x)", "20*log10(abs(x))", "sin(x)+cos(x)-tan(real(x))",
+        "sin(real(x))*cos(imag(x))", "sinh(x)*cosh(x)/tanh(x)", "pow(x, 2.5)", "pow(real(x), 2)", "x^3", "S21/(1-S11)",
+        "(S11 - S21)/(1 - S11*S21)*x + f/1G",
+    };
+    Samples samples(1000);
+    for(auto &e : expressions) {
+        CompiledExpression compiled;
+        QVERIFY2(compiled.compile(e, samples.names), e.c_str());
+        vector<complex<double>> result(samples.x.size());
+        compiled.evaluate(result.size(), samples.pointers(), result.data());
+        auto expected = evaluateWithParser(e, samples);
+        for(unsigned int i=0;i<result.size();i++) {
+            QVERIFY2(equal(result[i], expected[i]), qPrintable(QString::fromStdString(e)+" at sample "+QString::number(i)));
+        }
+    }
+}
+
+void CompiledExpressionTests::unsupportedExpressions()
+{
+    const vector<string> expressions = {
+        "", "x>1?1:2", "max(x,2)", "x!", "--x", "+x", "2 k", "sin x", "y", "0x10", "2e", "x#comment", "a=2", "x\t", "sin(x,2)",
+        "pow(x)", "(x", "x)", "2x", "2kx", "x k", "1,2", "true",
+    };
+    Samples samples(1);
+    for(auto &e : expressions) {
+        CompiledExpression compiled;
+        QVERIFY2(!compiled.compile(e, samples.names), e.c_str());
+        QVERIFY(!compiled.isValid());
+    }
+    // variable names which collide with constants or unit postfixes are left to muparserx
+    CompiledExpression compiled;
+    QVERIFY(!compiled.compile("e*2", {"e"}));
+    QVERIFY(!compiled.compile("2m", {"m"}));
+}
+
+void CompiledExpressionTests::usedVariables()
+{
+    Samples samples(1);
+    CompiledExpression compiled;
+    QVERIFY(compiled.compile("S21*2", samples.names));
+    QVERIFY(!compiled.usesVariable(0));
+    QVERIFY(!compiled.usesVariable(1));
+    QVERIFY(!compiled.usesVariable(2));
+    QVERIFY(compiled.usesVariable(3));
+}
+
+// typical user math on a 20k point sweep
+static const string benchmarkExpression = "20*log10(abs((S11 - S21)/(1 - S11*S21)))";
+static const unsigned int benchmarkPoints = 20000;
+
+void CompiledExpressionTests::benchmarkCompiled()
+{
+    Samples samples(benchmarkPoints);
+    CompiledExpression compiled;
+    QVERIFY(compiled.compile(benchmarkExpression, samples.names));
+    vector<complex<double>> result(benchmarkPoints);
+    QBENCHMARK {
+        compiled.evaluate(result.size(), samples.pointers(), result.data());
+    }
+}
+
+void CompiledExpressionTests::benchmarkParser()
+{
+    Samples samples(benchmarkPoints);
+    QBENCHMARK {
+        evaluateWithParser(benchmarkExpression, samples);
+    }
+}
@@ -0,0 +1,20 @@
+#ifndef COMPILEDEXPRESSIONTESTS_H
+#define COMPILEDEXPRESSIONTESTS_H
+
+#include <QtTest>
+
+class CompiledExpressionTests : public QObject
+{
+    Q_OBJECT
+public:
+    CompiledExpressionTests();
+
+private slots:
+    void compareWithParser();
+    void unsupportedExpressions();
+    void usedVariables();
+    void benchmarkCompiled();
+    void benchmarkParser();
+};
+
+#endif // COMPILEDEXPRESSIONTESTS_H
@@ -0,0 +1,274 @@
+#include "compoundmergebuffertests.h"
+
+#include "Device/LibreVNA/Compound/compoundmergebuffer.h"
+#include "../../VNA_embedded/Application/Communication/Protocol.hpp"
+
+#include <vector>
+#include <random>
+
+using namespace std;
+
+using Datapoint = Protocol::VNADatapoint<32>;
+using Buffer = CompoundMergeBuffer<Datapoint>;
+
+class Transmission {
+public:
+    unsigned int device;
+    // running index of the point (counted across sweeps)
+    unsigned int index;
+};
+
+// Creates the order in which the datapoints of several devices arrive: every device delivers its points in order and
+// in blocks of random size, the devices never drift apart by more than maxDrift points
+static vector<Transmission> interleavedStream(unsigned int devices, unsigned int points, unsigned int maxDrift, unsigned int seed) {
+    vector<Transmission> ret;
+    vector<unsigned int> next(devices, 0);
+    mt19937 rng(seed);
+    uniform_int_distribution<unsigned int> block(1, 20);
+    uniform_int_distribution<unsigned int> device(0, devices - 1);
+    while(true) {
+        auto slowest = *min_element(next.begin(), next.end());
+        if(slowest >= points) {
+            break;
+        }
+        auto d = device(rng);
+        auto n = min(block(rng), points - next[d]);
+        n = min(n, slowest + maxDrift - next[d]);
+        for(unsigned int i=0;i<n;i++) {
+            ret.push_back({d, next[d]++});
+        }
+    }
+    return ret;
+}
+
+// Feeds a stream to the buffer. Returns the number of completed points of every sweep that contain the datapoints of
+// the same point and sweep from all devices
+static vector<unsigned int> replay(Buffer &buffer, const vector<Transmission> &stream, unsigned int devices, unsigned int sweepPoints);
+
+// Datapoint of a device as it would be sent by an 8-port compound device made of 4 devices
+static Datapoint createDatapoint(unsigned int device, unsigned int index, unsigned int sweepPoints) {
+    Datapoint d;
+    d.pointNum = index % sweepPoints;
+    d.frequency = 1000000 + index;
+    for(int stage=0;stage<8;stage++) {
+        for(int port=0;port<2;port++) {
+            d.addValue(device, index, stage, 0x01 << port);
+            d.addValue(device, -(float) index, stage, (0x01 << port) | (int) Protocol::Source::Reference);
+        }
+    }
+    return d;
+}
+
+CompoundMergeBufferTests::CompoundMergeBufferTests()
+{
+
+}
+
+static vector<unsigned int> replay(Buffer &buffer, const vector<Transmission> &stream, unsigned int devices, unsigned int sweepPoints) {
+    vector<unsigned int> ret;
+    for(auto t : stream) {
+        auto d = createDatapoint(t.device, t.index, sweepPoints);
+        if(buffer.add(t.device, d.pointNum, d) != Buffer::Result::Complete) {
+            continue;
+        }
+        bool matches = true;
+        for(unsigned int i=0;i<devices;i++) {
+            auto &merged = buffer.get(i);
+            if(merged.frequency != (uint64_t) (1000000 + t.index) || merged.getValue(0).value != complex<double>(i, t.index)) {
+                matches = false;
+            }
+        }
+        auto sweep = t.index / sweepPoints;
+        if(sweep >= ret.size()) {
+            ret.resize(sweep + 1, 0);
+        }
+        if(matches) {
+            ret[sweep]++;
+        }
+    }
+    return ret;
+}
+
+void CompoundMergeBufferTests::replayInterleaved()
+{
+    constexpr unsigned int devices = 4;
+    constexpr unsigned int sweepPoints = 101;
+    constexpr unsigned int points = 3 * sweepPoints;
+    Buffer buffer(64);
+    buffer.reset(devices, sweepPoints);
+    auto stream = interleavedStream(devices, points, 40, 1);
+    QCOMPARE(stream.size(), (size_t) (devices * points));
+
+    unsigned int expected = 0;
+    for(auto t : stream) {
+        auto d = createDatapoint(t.device, t.index, sweepPoints);
+        auto result = buffer.add(t.device, d.pointNum, d);
+        if(result == Buffer::Result::Complete) {
+            // points complete in order, every device contributes its own datapoint
+            QCOMPARE(t.index, expected);
+            for(unsigned int i=0;i<devices;i++) {
+                auto &merged = buffer.get(i);
+                QCOMPARE(merged.pointNum, (uint16_t) (expected % sweepPoints));
+                QCOMPARE(merged.frequency, (uint64_t) (1000000 + expected));
+                QCOMPARE(merged.getNumValues(), 32U);
+                QCOMPARE(merged.getValue(0).value, complex<double>(i, expected));
+            }
+            expected++;
+        } else {
+            QCOMPARE(result, Buffer::Result::Incomplete);
+        }
+    }
+    QCOMPARE(expected, points);
+    QCOMPARE(buffer.getCompleted(), (uint64_t) points);
+    QCOMPARE(buffer.getDiscarded(), (uint64_t) 0);
+}
+
+void CompoundMergeBufferTests::missingPoint()
+{
+    Buffer buffer(8);
+    buffer.reset(2, 10);
+    Datapoint d;
+    // device 1 misses point 3
+    for(unsigned int i=0;i<10;i++) {
+        QCOMPARE(buffer.add(0, i, d), Buffer::Result::Incomplete);
+        if(i != 3) {
+            QCOMPARE(buffer.add(1, i, d), Buffer::Result::Complete);
+        }
+    }
+    QCOMPARE(buffer.getCompleted(), (uint64_t) 9);
+    // the incomplete point is discarded once device 0 delivers it again in the next sweep
+    QCOMPARE(buffer.getDiscarded(), (uint64_t) 0);
+    for(unsigned int i=0;i<4;i++) {
+        QCOMPARE(buffer.add(0, i, d), Buffer::Result::Incomplete);
+    }
+    QCOMPARE(buffer.getDiscarded(), (uint64_t) 1);
+    QCOMPARE(buffer.add(1, 0, d), Buffer::Result::Complete);
+    QCOMPARE(buffer.add(1, 3, d), Buffer::Result::Complete);
+}
+
+void CompoundMergeBufferTests::duplicate()
+{
+    Buffer buffer(8);
+    buffer.reset(2, 10);
+    Datapoint d;
+    QCOMPARE(buffer.add(0, 0, d), Buffer::Result::Incomplete);
+    QCOMPARE(buffer.add(0, 0, d), Buffer::Result::Duplicate);
+    QCOMPARE(buffer.add(1, 0, d), Buffer::Result::Complete);
+    QCOMPARE(buffer.add(1, 0, d), Buffer::Result::Duplicate);
+    // invalid device or point number
+    QCOMPARE(buffer.add(2, 1, d), Buffer::Result::Late);
+    QCOMPARE(buffer.add(0, 10, d), Buffer::Result::Late);
+    QCOMPARE(buffer.getCompleted(), (uint64_t) 1);
+}
+
+void CompoundMergeBufferTests::laggingDevice()
+{
+    Buffer buffer(8);
+    buffer.reset(2, 100);
+    Datapoint d;
+    // device 0 runs ahead by more than the window, its oldest points are discarded
+    for(unsigned int i=0;i<10;i++) {
+        QCOMPARE(buffer.add(0, i, d), Buffer::Result::Incomplete);
+    }
+    QCOMPARE(buffer.getDiscarded(), (uint64_t) 2);
+    QCOMPARE(buffer.add(1, 0, d), Buffer::Result::Incomplete);
+    QCOMPARE(buffer.add(1, 1, d), Buffer::Result::Incomplete);
+    QCOMPARE(buffer.add(1, 2, d), Buffer::Result::Complete);
+    // skipping points is fine, but older points can not complete after a newer one
+    QCOMPARE(buffer.add(1, 5, d), Buffer::Result::Complete);
+    QCOMPARE(buffer.add(0, 4, d), Buffer::Result::Late);
+    // the lagging device catches up and the points complete again
+    for(unsigned int i=6;i<10;i++) {
+        buffer.add(1, i, d);
+    }
+    for(unsigned int i=10;i<20;i++) {
+        QCOMPARE(buffer.add(0, i, d), Buffer::Result::Incomplete);
+        QCOMPARE(buffer.add(1, i, d), Buffer::Result::Complete);
+    }
+}
+
+void CompoundMergeBufferTests::previousSweepAfterReset()
+{
+    constexpr unsigned int sweepPoints = 50;
+    Buffer buffer(16);
+    buffer.reset(2, sweepPoints);
+    // device 1 still sends points of the previous sweep configuration
+    Datapoint d;
+    for(unsigned int i=30;i<35;i++) {
+        QCOMPARE(buffer.add(1, i, d), Buffer::Result::Late);
+    }
+    vector<Transmission> stream;
+    for(unsigned int i=0;i<2*sweepPoints;i++) {
+        stream.push_back({0, i});
+        stream.push_back({1, i});
+    }
+    QCOMPARE(replay(buffer, stream, 2, sweepPoints), vector<unsigned int>({sweepPoints, sweepPoints}));
+    QCOMPARE(buffer.getDiscarded(), (uint64_t) 0);
+}
+
+void CompoundMergeBufferTests::droppedSweep()
+{
+    constexpr unsigned int sweepPoints = 300;
+    for(unsigned int droppingDevice=0;droppingDevice<2;droppingDevice++) {
+        Buffer buffer;
+        buffer.reset(2, sweepPoints);
+        auto stream = interleavedStream(2, 5 * sweepPoints, 20, droppingDevice);
+        // one device misses the second sweep completely
+        stream.erase(remove_if(stream.begin(), stream.end(), [=](const Transmission &t){
+            return t.device == droppingDevice && t.index >= sweepPoints && t.index < 2 * sweepPoints;
+        }), stream.end());
+        auto completed = replay(buffer, stream, 2, sweepPoints);
+        QCOMPARE(completed.size(), (size_t) 5);
+        QCOMPARE(completed[0], sweepPoints);
+        // the sweep after the missing one may contain stale datapoints, afterwards all points are complete again
+        QCOMPARE(completed[3], sweepPoints);
+        QCOMPARE(completed[4], sweepPoints);
+    }
+}
+
+void CompoundMergeBufferTests::singlePointSweep()
+{
+    // every point is the first point of a new sweep
+    Buffer buffer(4);
+    buffer.reset(3, 1);
+    Datapoint d;
+    for(unsigned int i=0;i<10;i++) {
+        d.frequency = i;
+        QCOMPARE(buffer.add(2, 0, d), Buffer::Result::Incomplete);
+        QCOMPARE(buffer.add(0, 0, d), Buffer::Result::Incomplete);
+        QCOMPARE(buffer.add(1, 0, d), Buffer::Result::Complete);
+        QCOMPARE(buffer.get(2).frequency, (uint64_t) i);
+    }
+    QCOMPARE(buffer.getCompleted(), (uint64_t) 10);
+    // device 1 misses a point, the following points still combine the same samples
+    d.frequency = 10;
+    buffer.add(0, 0, d);
+    buffer.add(2, 0, d);
+    for(unsigned int i=11;i<20;i++) {
+        d.frequency = i;
+        QCOMPARE(buffer.add(0, 0, d), Buffer::Result::Incomplete);
+        QCOMPARE(buffer.add(2, 0, d), Buffer::Result::Incomplete);
+        QCOMPARE(buffer.add(1, 0, d), Buffer::Result::Complete);
+        QCOMPARE(buffer.get(0).frequency, (uint64_t) i);
+        QCOMPARE(buffer.get(2).frequency, (uint64_t) i);
+    }
+}
+
+void CompoundMergeBufferTests::benchmarkReplay()
+{
+    constexpr unsigned int devices = 4;
+    constexpr unsigned int sweepPoints = 1001;
+    Buffer buffer;
+    auto stream = interleavedStream(devices, sweepPoints, 100, 2);
+    vector<Datapoint> datapoints;
+    for(auto t : stream) {
+        datapoints.push_back(createDatapoint(t.device, t.index, sweepPoints));
+    }
+    QBENCHMARK {
+        buffer.reset(devices, sweepPoints);
+        for(unsigned int i=0;i<stream.size();i++) {
+            buffer.add(stream[i].device, datapoints[i].pointNum, datapoints[i]);
+        }
+    }
+    QCOMPARE(buffer.getCompleted(), (uint64_t) sweepPoints);
+}
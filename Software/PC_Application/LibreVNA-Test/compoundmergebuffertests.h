@@ -0,0 +1,23 @@
+#ifndef COMPOUNDMERGEBUFFERTESTS_H
+#define COMPOUNDMERGEBUFFERTESTS_H
+
+#include <QtTest>
+
+class CompoundMergeBufferTests : public QObject
+{
+    Q_OBJECT
+public:
+    CompoundMergeBufferTests();
+
+private slots:
+    void replayInterleaved();
+    void missingPoint();
+    void duplicate();
+    void laggingDevice();
+    void previousSweepAfterReset();
+    void droppedSweep();
+    void singlePointSweep();
+    void benchmarkReplay();
+};
+
+#endif // COMPOUNDMERGEBUFFERTESTS_H
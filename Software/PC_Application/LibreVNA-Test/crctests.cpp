@@ -0,0 +1,123 @@
+#include "crctests.h"
+
+#include "../../VNA_embedded/Application/Communication/Protocol.hpp"
+
+#include <vector>
+
+using namespace std;
+
+// Bit-serial implementation as used before the table driven version, serves as the reference
+static uint32_t CRC32Bitwise(uint32_t crc, const void *data, uint32_t len) {
+    auto u8buf = (const uint8_t*) data;
+    crc = ~crc;
+    while (len--) {
+        crc ^= *u8buf++;
+        for (int k = 0; k < 8; k++) {
+            crc = crc & 1 ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+        }
+    }
+    return ~crc;
+}
+
+static vector<uint8_t> randomData(unsigned int len) {
+    vector<uint8_t> data(len);
+    srand(0);
+    for(auto &d : data) {
+        d = rand();
+    }
+    return data;
+}
+
+CRCTests::CRCTests()
+{
+
+}
+
+void CRCTests::checkValue()
+{
+    // standard check value of CRC-32
+    const char *check = "123456789";
+    QCOMPARE(Protocol::CRC32(0, check, 9), 0xCBF43926);
+    QCOMPARE(Protocol::CRC32(0, check, 0), 0x00000000U);
+}
+
+void CRCTests::compareWithBitwise()
+{
+    auto data = randomData(1100);
+    // all lengths and alignments around the eight byte blocks
+    for(unsigned int offset=0;offset<8;offset++) {
+        for(unsigned int len=0;len<=1024;len++) {
+            QCOMPARE(Protocol::CRC32(0, &data[offset], len), CRC32Bitwise(0, &data[offset], len));
+        }
+    }
+}
+
+void CRCTests::incremental()
+{
+    // calculating the CRC in chunks (as done for the firmware file) must give the same result
+    auto data = randomData(1000);
+    uint32_t crc = 0;
+    for(unsigned int i=0;i<data.size();i+=77) {
+        auto len = min(77U, (unsigned int) data.size() - i);
+        crc = Protocol::CRC32(crc, &data[i], len);
+    }
+    QCOMPARE(crc, CRC32Bitwise(0, data.data(), data.size()));
+}
+
+void CRCTests::datapointPacket()
+{
+    Protocol::PacketInfo p;
+    p.type = Protocol::PacketType::VNADatapoint;
+    p.VNAdatapoint = new Protocol::VNADatapoint<32>;
+    p.VNAdatapoint->frequency = 1000000000;
+    p.VNAdatapoint->pointNum = 42;
+    p.VNAdatapoint->addValue(0.5, -0.25, 0, (int) Protocol::Source::Port1);
+    p.VNAdatapoint->addValue(0.125, 1.0, 0, (int) Protocol::Source::Port1 | (int) Protocol::Source::Reference);
+    uint8_t buf[512];
+    auto len = Protocol::EncodePacket(p, buf, sizeof(buf));
+    delete p.VNAdatapoint;
+    QVERIFY(len > 0);
+
+    // datapoints carry a valid CRC
+    uint32_t crc;
+    memcpy(&crc, &buf[len - 4], 4);
+    QCOMPARE(crc, CRC32Bitwise(0, buf, len - 4));
+
+    Protocol::PacketInfo decoded;
+    QCOMPARE(Protocol::DecodeBuffer(buf, len, &decoded), len);
+    QCOMPARE(decoded.type, Protocol::PacketType::VNADatapoint);
+    QCOMPARE(decoded.VNAdatapoint->pointNum, (uint16_t) 42);
+    delete decoded.VNAdatapoint;
+
+    // corrupted datapoints must be rejected
+    buf[10] ^= 0x01;
+    Protocol::DecodeBuffer(buf, len, &decoded);
+    QCOMPARE(decoded.type, Protocol::PacketType::None);
+    buf[10] ^= 0x01;
+
+    // datapoints without CRC (older firmware) are still accepted
+    memset(&buf[len - 4], 0, 4);
+    QCOMPARE(Protocol::DecodeBuffer(buf, len, &decoded), len);
+    QCOMPARE(decoded.type, Protocol::PacketType::VNADatapoint);
+    delete decoded.VNAdatapoint;
+}
+
+void CRCTests::benchmarkBitwise()
+{
+    // typical size of a 2-port datapoint packet
+    auto data = randomData(200);
+    // volatile, the result is not used otherwise and the calculation could be optimized away
+    volatile uint32_t crc = 0;
+    QBENCHMARK {
+        crc = CRC32Bitwise(crc, data.data(), data.size());
+    }
+}
+
+void CRCTests::benchmarkTable()
+{
+    auto data = randomData(200);
+    volatile uint32_t crc = 0;
+    QBENCHMARK {
+        crc = Protocol::CRC32(crc, data.data(), data.size());
+    }
+}
@@ -0,0 +1,21 @@
+#ifndef CRCTESTS_H
+#define CRCTESTS_H
+
+#include <QtTest>
+
+class CRCTests : public QObject
+{
+    Q_OBJECT
+public:
+    CRCTests();
+
+private slots:
+    void checkValue();
+    void compareWithBitwise();
+    void incremental();
+    void datapointPacket();
+    void benchmarkBitwise();
+    void benchmarkTable();
+};
+
+#endif // CRCTESTS_H
@@ -0,0 +1,171 @@
+#include "datapointdecodertests.h"
+
+#include "Device/LibreVNA/datapointdecoder.h"
+
+#include <vector>
+
+using namespace std;
+
+using Datapoint = Protocol::VNADatapoint<32>;
+
+// Number of datapoints per benchmark iteration
+static constexpr unsigned int benchmarkPoints = 1000;
+
+// Creates a datapoint of a 4-port sweep with all ports excited, values are added in the same order as by the firmware
+static Datapoint createDatapoint(unsigned int pointNum, unsigned int ports = 4) {
+    Datapoint d;
+    d.pointNum = pointNum;
+    d.frequency = 1000000 + pointNum * 1000;
+    int allPorts = 0;
+    for(unsigned int i=0;i<ports;i++) {
+        allPorts |= 0x01 << i;
+    }
+    for(unsigned int stage=0;stage<ports;stage++) {
+        for(unsigned int port=0;port<ports;port++) {
+            d.addValue(0.1 * (port + 1) + pointNum, -0.2 * (stage + 1), stage, 0x01 << port);
+        }
+        d.addValue(1.0 + stage, 0.5 + pointNum, stage, allPorts | (int) Protocol::Source::Reference);
+    }
+    return d;
+}
+
+// Adds all S parameters and raw values of a sweep in which every port is excited in the stage with its own number
+static void addSparameters(DatapointDecoder &decoder, unsigned int ports = 4) {
+    unsigned int out = 0;
+    for(unsigned int stage=0;stage<ports;stage++) {
+        for(unsigned int port=0;port<ports;port++) {
+            decoder.addRatio(out++, 0, stage, port, 0, stage, stage);
+            decoder.addValue(out++, 0, stage, port, false);
+            decoder.addValue(out++, 0, stage, port, true);
+        }
+    }
+}
+
+static void compare(complex<double> a, complex<double> b) {
+    QVERIFY(abs(a - b) <= 1e-12 * abs(b));
+}
+
+DatapointDecoderTests::DatapointDecoderTests()
+{
+
+}
+
+void DatapointDecoderTests::matchesScan()
+{
+    DatapointDecoder decoder;
+    QVERIFY(decoder.empty());
+    addSparameters(decoder);
+    QVERIFY(!decoder.empty());
+    vector<complex<double>> out(48);
+    for(unsigned int i=0;i<3;i++) {
+        auto d = createDatapoint(i);
+        auto p = &d;
+        QVERIFY(decoder.decode(&p, out.data()));
+        unsigned int index = 0;
+        for(unsigned int stage=0;stage<4;stage++) {
+            auto ref = d.getValue(stage, stage, true);
+            for(unsigned int port=0;port<4;port++) {
+                auto input = d.getValue(stage, port, false);
+                compare(out[index++], input / ref);
+                QCOMPARE(out[index++], input);
+                QCOMPARE(out[index++], d.getValue(stage, port, true));
+            }
+        }
+    }
+}
+
+void DatapointDecoderTests::missingValue()
+{
+    DatapointDecoder decoder;
+    addSparameters(decoder);
+    // the datapoint of a 2-port sweep does not contain the values of port 3 and 4
+    auto d = createDatapoint(0, 2);
+    auto p = &d;
+    vector<complex<double>> out(48);
+    QVERIFY(!decoder.decode(&p, out.data()));
+    // S11 is available, S31 (third entry of stage 0) and all values of stage 2 are not
+    compare(out[0], d.getValue(0, 0, false) / d.getValue(0, 0, true));
+    QVERIFY(std::isnan(out[6].real()));
+    QVERIFY(std::isnan(out[24].real()));
+}
+
+void DatapointDecoderTests::descriptorChange()
+{
+    DatapointDecoder decoder;
+    decoder.addRatio(0, 0, 0, 1, 0, 0, 0);
+    complex<double> out;
+    // values in the firmware order
+    auto d = createDatapoint(0, 2);
+    auto p = &d;
+    QVERIFY(decoder.decode(&p, &out));
+    compare(out, d.getValue(0, 1, false) / d.getValue(0, 0, true));
+
+    // same values in a different order, the positions have to be resolved again
+    Datapoint reversed;
+    for(int i=d.getNumValues()-1;i>=0;i--) {
+        auto v = d.getValue(i);
+        reversed.addValue(v.value.real() * 2, v.value.imag(), v.flags >> DPNT_CONF_STAGE_OFFSET, v.flags & ((1 << DPNT_CONF_STAGE_OFFSET) - 1));
+    }
+    QVERIFY(!reversed.sameDescriptors(d));
+    p = &reversed;
+    QVERIFY(decoder.decode(&p, &out));
+    compare(out, reversed.getValue(0, 1, false) / reversed.getValue(0, 0, true));
+}
+
+void DatapointDecoderTests::multipleSources()
+{
+    // S21 of a compound device: port 1 on the first device, port 2 on the second device
+    DatapointDecoder decoder;
+    decoder.addRatio(0, 1, 0, 0, 0, 0, 0, false);
+    decoder.addRatio(1, 1, 0, 0, 0, 0, 0, true);
+    auto d1 = createDatapoint(0, 2);
+    auto d2 = createDatapoint(5, 2);
+    Datapoint *sources[] = {&d1, &d2};
+    complex<double> out[2];
+    QVERIFY(decoder.decode(sources, out));
+    auto S = d2.getValue(0, 0, false) / d1.getValue(0, 0, true);
+    compare(out[0], S);
+    // phase discarded
+    QCOMPARE(out[1].imag(), 0.0);
+    compare(out[1], abs(S));
+}
+
+void DatapointDecoderTests::benchmarkScan()
+{
+    vector<Datapoint> datapoints;
+    for(unsigned int i=0;i<benchmarkPoints;i++) {
+        datapoints.push_back(createDatapoint(i));
+    }
+    vector<complex<double>> out(48);
+    QBENCHMARK {
+        for(auto &d : datapoints) {
+            unsigned int index = 0;
+            for(unsigned int stage=0;stage<4;stage++) {
+                auto ref = d.getValue(stage, stage, true);
+                for(unsigned int port=0;port<4;port++) {
+                    auto input = d.getValue(stage, port, false);
+                    out[index++] = input / ref;
+                    out[index++] = input;
+                    out[index++] = d.getValue(stage, port, true);
+                }
+            }
+        }
+    }
+}
+
+void DatapointDecoderTests::benchmarkDecoder()
+{
+    vector<Datapoint> datapoints;
+    for(unsigned int i=0;i<benchmarkPoints;i++) {
+        datapoints.push_back(createDatapoint(i));
+    }
+    DatapointDecoder decoder;
+    addSparameters(decoder);
+    vector<complex<double>> out(48);
+    QBENCHMARK {
+        for(auto &d : datapoints) {
+            auto p = &d;
+            decoder.decode(&p, out.data());
+        }
+    }
+}
@@ -0,0 +1,21 @@
+#ifndef DATAPOINTDECODERTESTS_H
+#define DATAPOINTDECODERTESTS_H
+
+#include <QtTest>
+
+class DatapointDecoderTests : public QObject
+{
+    Q_OBJECT
+public:
+    DatapointDecoderTests();
+
+private slots:
+    void matchesScan();
+    void missingValue();
+    void descriptorChange();
+    void multipleSources();
+    void benchmarkScan();
+    void benchmarkDecoder();
+};
+
+#endif // DATAPOINTDECODERTESTS_H
@@ -0,0 +1,119 @@
+#include "datapointpooltests.h"
+
+#include "Device/LibreVNA/datapointpool.h"
+
+#include <vector>
+
+using namespace std;
+
+// Number of datapoints per decoding benchmark iteration
+static constexpr unsigned int benchmarkPoints = 1000;
+
+// Encodes datapoints as they are sent by a 2-port device into one buffer
+static vector<uint8_t> encodedDatapoints(unsigned int points) {
+    vector<uint8_t> ret;
+    Protocol::PacketInfo p;
+    p.type = Protocol::PacketType::VNADatapoint;
+    p.VNAdatapoint = new Protocol::VNADatapoint<32>;
+    uint8_t buf[512];
+    for(unsigned int i=0;i<points;i++) {
+        p.VNAdatapoint->clear();
+        p.VNAdatapoint->pointNum = i;
+        p.VNAdatapoint->frequency = 1000000 + i * 1000;
+        for(int stage=0;stage<2;stage++) {
+            for(int port=0;port<2;port++) {
+                p.VNAdatapoint->addValue(0.1 * i, -0.2 * i, stage, 0x01 << port);
+                p.VNAdatapoint->addValue(0.3 * i, 0.4 * i, stage, (0x01 << port) | (int) Protocol::Source::Reference);
+            }
+        }
+        auto len = Protocol::EncodePacket(p, buf, sizeof(buf));
+        ret.insert(ret.end(), buf, buf + len);
+    }
+    delete p.VNAdatapoint;
+    return ret;
+}
+
+// DecodeBuffer() can only handle up to 64k at once
+static uint16_t remaining(const vector<uint8_t> &data, unsigned int offset) {
+    return min(data.size() - offset, (size_t) numeric_limits<uint16_t>::max());
+}
+
+DatapointPoolTests::DatapointPoolTests()
+{
+
+}
+
+void DatapointPoolTests::reuse()
+{
+    Protocol::VNADatapoint<32> *first;
+    {
+        auto h = DatapointPool::get();
+        first = h.get();
+    }
+    // released datapoint is handed out again
+    auto h = DatapointPool::get();
+    QCOMPARE(h.get(), first);
+
+    // adopting a released handle keeps the datapoint in the pool
+    auto available = DatapointPool::available();
+    DatapointPool::adopt(h.release());
+    QCOMPARE(DatapointPool::available(), available + 1);
+}
+
+void DatapointPoolTests::copy()
+{
+    Protocol::VNADatapoint<32> d;
+    d.pointNum = 7;
+    d.frequency = 123456;
+    d.addValue(1.0, 2.0, 0, 0x01);
+    auto h = DatapointPool::copy(d);
+    QCOMPARE(h->pointNum, (uint16_t) 7);
+    QCOMPARE(h->frequency, (uint64_t) 123456);
+    QCOMPARE(h->getNumValues(), 1U);
+    QCOMPARE(h->getValue(0).value, complex<double>(1.0, 2.0));
+}
+
+void DatapointPoolTests::decodeIntoPool()
+{
+    auto data = encodedDatapoints(10);
+    unsigned int offset = 0;
+    for(unsigned int i=0;i<10;i++) {
+        auto storage = DatapointPool::get();
+        Protocol::PacketInfo p;
+        offset += Protocol::DecodeBuffer(&data[offset], remaining(data, offset), &p, storage.get());
+        QCOMPARE(p.type, Protocol::PacketType::VNADatapoint);
+        // decoded into the supplied storage instead of a new allocation
+        QCOMPARE(p.VNAdatapoint, storage.get());
+        QCOMPARE(p.VNAdatapoint->pointNum, (uint16_t) i);
+        QCOMPARE(p.VNAdatapoint->getNumValues(), 8U);
+    }
+    QCOMPARE(offset, (unsigned int) data.size());
+}
+
+void DatapointPoolTests::benchmarkDecodeHeap()
+{
+    auto data = encodedDatapoints(benchmarkPoints);
+    QBENCHMARK {
+        unsigned int offset = 0;
+        while(offset < data.size()) {
+            Protocol::PacketInfo p;
+            offset += Protocol::DecodeBuffer(&data[offset], remaining(data, offset), &p);
+            if(p.type == Protocol::PacketType::VNADatapoint) {
+                delete p.VNAdatapoint;
+            }
+        }
+    }
+}
+
+void DatapointPoolTests::benchmarkDecodePool()
+{
+    auto data = encodedDatapoints(benchmarkPoints);
+    QBENCHMARK {
+        unsigned int offset = 0;
+        while(offset < data.size()) {
+            auto storage = DatapointPool::get();
+            Protocol::PacketInfo p;
+            offset += Protocol::DecodeBuffer(&data[offset], remaining(data, offset), &p, storage.get());
+        }
+    }
+}
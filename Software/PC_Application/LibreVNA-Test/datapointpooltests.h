@@ -0,0 +1,20 @@
+#ifndef DATAPOINTPOOLTESTS_H
+#define DATAPOINTPOOLTESTS_H
+
+#include <QtTest>
+
+class DatapointPoolTests : public QObject
+{
+    Q_OBJECT
+public:
+    DatapointPoolTests();
+
+private slots:
+    void reuse();
+    void copy();
+    void decodeIntoPool();
+    void benchmarkDecodeHeap();
+    void benchmarkDecodePool();
+};
+
+#endif // DATAPOINTPOOLTESTS_H
@@ -0,0 +1,188 @@
+#include "devicepacketlogtests.h"
+
+#include "Device/LibreVNA/devicepacketlog.h"
+
+#include <vector>
+#include <thread>
+#include <atomic>
+
+using namespace std;
+
+// Encodes a datapoint as it is sent by a 2-port device
+static vector<uint8_t> encodedDatapoint(unsigned int pointNum) {
+    Protocol::VNADatapoint<32> d;
+    d.pointNum = pointNum;
+    d.frequency = 1000000 + pointNum * 1000;
+    for(int stage=0;stage<2;stage++) {
+        for(int port=0;port<2;port++) {
+            d.addValue(0.1 * pointNum, -0.2 * pointNum, stage, 0x01 << port);
+            d.addValue(0.3 * pointNum, 0.4 * pointNum, stage, (0x01 << port) | (int) Protocol::Source::Reference);
+        }
+    }
+    Protocol::PacketInfo p;
+    p.type = Protocol::PacketType::VNADatapoint;
+    p.VNAdatapoint = &d;
+    vector<uint8_t> ret(512);
+    ret.resize(Protocol::EncodePacket(p, ret.data(), ret.size()));
+    return ret;
+}
+
+static void addDatapoint(DevicePacketLog &log, unsigned int pointNum, unsigned int source = 0) {
+    auto frame = encodedDatapoint(pointNum);
+    log.addPacket(Protocol::PacketType::VNADatapoint, frame.data(), frame.size(), source);
+}
+
+DevicePacketLogTests::DevicePacketLogTests()
+{
+
+}
+
+void DevicePacketLogTests::packetsAndInvalidBytes()
+{
+    auto &log = DevicePacketLog::getInstance();
+    log.reset();
+    auto source = log.registerSource("0123456789");
+    QCOMPARE(log.registerSource("0123456789"), source);
+    QCOMPARE(log.registerSource(""), 0U);
+
+    // received data with some bytes in front of the frame
+    auto frame = encodedDatapoint(5);
+    vector<uint8_t> received = {0x01, 0x02, 0x03};
+    received.insert(received.end(), frame.begin(), frame.end());
+    log.addPacket(Protocol::PacketType::VNADatapoint, received.data(), received.size(), source);
+
+    // transmitted packet
+    Protocol::PacketInfo ack;
+    ack.type = Protocol::PacketType::Ack;
+    uint8_t buffer[64];
+    auto length = Protocol::EncodePacket(ack, buffer, sizeof(buffer));
+    log.addPacket(ack.type, buffer, length);
+
+    // too many for one entry, split into several
+    vector<uint8_t> invalid(1000, 0x11);
+    log.addInvalidBytes(invalid.data(), invalid.size(), source);
+
+    auto entries = log.getEntries();
+    QVERIFY(entries.size() > 3);
+    QCOMPARE(entries[0].type, DevicePacketLog::LogEntry::Type::Packet);
+    QCOMPARE(entries[0].serial, QString("0123456789"));
+    QCOMPARE(entries[0].p->type, Protocol::PacketType::VNADatapoint);
+    QCOMPARE(entries[0].datapoint->pointNum, (uint16_t) 5);
+    QCOMPARE(entries[0].datapoint->getNumValues(), 8U);
+    QCOMPARE(entries[1].type, DevicePacketLog::LogEntry::Type::Packet);
+    QCOMPARE(entries[1].serial, QString(""));
+    QCOMPARE(entries[1].p->type, Protocol::PacketType::Ack);
+    QVERIFY(qAbs(entries[1].timestamp.msecsTo(QDateTime::currentDateTimeUtc())) < 1000);
+    vector<uint8_t> loggedInvalid;
+    for(unsigned int i=2;i<entries.size();i++) {
+        QCOMPARE(entries[i].type, DevicePacketLog::LogEntry::Type::InvalidBytes);
+        loggedInvalid.insert(loggedInvalid.end(), entries[i].bytes.begin(), entries[i].bytes.end());
+    }
+    QVERIFY(loggedInvalid == invalid);
+}
+
+void DevicePacketLogTests::jsonRoundTrip()
+{
+    auto &log = DevicePacketLog::getInstance();
+    log.reset();
+    auto source = log.registerSource("0123456789");
+    for(unsigned int i=0;i<10;i++) {
+        addDatapoint(log, i, source);
+    }
+    vector<uint8_t> invalid = {0x01, 0x02, 0x03};
+    log.addInvalidBytes(invalid.data(), invalid.size());
+
+    auto before = log.getEntries();
+    log.fromJSON(log.toJSON());
+    auto after = log.getEntries();
+    QCOMPARE(after.size(), before.size());
+    for(unsigned int i=0;i<10;i++) {
+        QCOMPARE(after[i].type, DevicePacketLog::LogEntry::Type::Packet);
+        QCOMPARE(after[i].serial, before[i].serial);
+        QCOMPARE(after[i].timestamp, before[i].timestamp);
+        QCOMPARE(after[i].datapoint->pointNum, (uint16_t) i);
+        QCOMPARE(after[i].datapoint->getValue(7).value, before[i].datapoint->getValue(7).value);
+    }
+    QCOMPARE(after.back().type, DevicePacketLog::LogEntry::Type::InvalidBytes);
+    QVERIFY(after.back().bytes == invalid);
+}
+
+void DevicePacketLogTests::packetTypeSelection()
+{
+    auto &log = DevicePacketLog::getInstance();
+    log.reset();
+    log.setLogging(Protocol::PacketType::VNADatapoint, false);
+    QVERIFY(!log.isLogged(Protocol::PacketType::VNADatapoint));
+    QVERIFY(log.isLogged(Protocol::PacketType::Ack));
+    addDatapoint(log, 0);
+    QCOMPARE(log.getEntries().size(), (size_t) 0);
+
+    log.setLogging(Protocol::PacketType::VNADatapoint, true);
+    addDatapoint(log, 1);
+    auto entries = log.getEntries();
+    QCOMPARE(entries.size(), (size_t) 1);
+    QCOMPARE(entries[0].datapoint->pointNum, (uint16_t) 1);
+}
+
+void DevicePacketLogTests::overwriteOldest()
+{
+    auto &log = DevicePacketLog::getInstance();
+    log.reset();
+    auto capacity = log.getCapacity();
+    constexpr unsigned int overwritten = 100;
+    for(unsigned int i=0;i<capacity + overwritten;i++) {
+        addDatapoint(log, i % 10000);
+    }
+    auto entries = log.getEntries();
+    QCOMPARE(entries.size(), (size_t) capacity);
+    QCOMPARE(entries.front().datapoint->pointNum, (uint16_t) overwritten);
+    QCOMPARE(entries.back().datapoint->pointNum, (uint16_t) ((capacity + overwritten - 1) % 10000));
+    QCOMPARE(log.getUsedStorageSize(), log.getMaxStorageSize());
+
+    log.reset();
+    QCOMPARE(log.getEntries().size(), (size_t) 0);
+    QCOMPARE(log.getUsedStorageSize(), 0UL);
+}
+
+void DevicePacketLogTests::concurrentWriters()
+{
+    auto &log = DevicePacketLog::getInstance();
+    log.reset();
+    atomic<bool> stop(false);
+    auto writer = [&](unsigned int source) {
+        unsigned int i = 0;
+        while(!stop) {
+            addDatapoint(log, i++ % 1000, source);
+        }
+    };
+    thread writer1(writer, log.registerSource("1")), writer2(writer, log.registerSource("2"));
+    // entries that are overwritten while being read are skipped, all others have to be intact
+    unsigned long checked = 0;
+    for(unsigned int i=0;i<10;i++) {
+        for(auto &e : log.getEntries()) {
+            QCOMPARE(e.type, DevicePacketLog::LogEntry::Type::Packet);
+            QVERIFY(e.serial == "1" || e.serial == "2");
+            QCOMPARE(e.datapoint->getNumValues(), 8U);
+            QCOMPARE(e.datapoint->getValue(1).value, complex<double>((float) (0.3 * e.datapoint->pointNum), (float) (0.4 * e.datapoint->pointNum)));
+            checked++;
+        }
+    }
+    stop = true;
+    writer1.join();
+    writer2.join();
+    QVERIFY(checked > 0);
+}
+
+void DevicePacketLogTests::benchmarkAddDatapoint()
+{
+    auto &log = DevicePacketLog::getInstance();
+    log.reset();
+    constexpr unsigned int packets = 100000;
+    auto frame = encodedDatapoint(1);
+    QBENCHMARK {
+        for(unsigned int i=0;i<packets;i++) {
+            log.addPacket(Protocol::PacketType::VNADatapoint, frame.data(), frame.size());
+        }
+    }
+    log.reset();
+}
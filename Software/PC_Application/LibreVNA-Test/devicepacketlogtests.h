@@ -0,0 +1,21 @@
+#ifndef DEVICEPACKETLOGTESTS_H
+#define DEVICEPACKETLOGTESTS_H
+
+#include <QtTest>
+
+class DevicePacketLogTests : public QObject
+{
+    Q_OBJECT
+public:
+    DevicePacketLogTests();
+
+private slots:
+    void packetsAndInvalidBytes();
+    void jsonRoundTrip();
+    void packetTypeSelection();
+    void overwriteOldest();
+    void concurrentWriters();
+    void benchmarkAddDatapoint();
+};
+
+#endif // DEVICEPACKETLOGTESTS_H
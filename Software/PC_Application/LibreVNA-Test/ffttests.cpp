@@ -2,6 +2,8 @@
 
 #include "Traces/fftcomplex.h"
 
+#include <random>
+
 using namespace std;
 
 fftTests::fftTests() {}
@@ -57,3 +59,61 @@ void fftTests::fftAndIfftWithShift()
 {
 
 }
+
+static vector<complex<double>> naiveDFT(const vector<complex<double>> &in, bool inverse) {
+    vector<complex<double>> out(in.size());
+    for(unsigned int k=0;k<in.size();k++) {
+        for(unsigned int n=0;n<in.size();n++) {
+            // reduce the product first to keep the angle accurate
+            auto index = ((unsigned long) k * n) % in.size();
+            out[k] += in[n] * polar(1.0, (inverse ? 2 : -2) * M_PI * index / in.size());
+        }
+    }
+    return out;
+}
+
+void fftTests::compareWithDFT()
+{
+    mt19937 gen(1);
+    uniform_real_distribution<double> dist(-1.0, 1.0);
+    // powers of two (radix-2) and other lengths (Bluestein), transform each length twice to also use the cached plans
+    for(unsigned int size : {1, 2, 4, 8, 32, 64, 1024, 3, 5, 7, 100, 1001, 1001, 1024}) {
+        for(bool inverse : {false, true}) {
+            vector<complex<double>> data(size);
+            for(auto &d : data) {
+                d = complex<double>(dist(gen), dist(gen));
+            }
+            auto expected = naiveDFT(data, inverse);
+            Fft::transform(data, inverse);
+            double maxError = 0.0;
+            for(unsigned int i=0;i<size;i++) {
+                maxError = max(maxError, abs(data[i] - expected[i]));
+            }
+            QVERIFY2(maxError < 1e-9 * size, qPrintable("Size "+QString::number(size)+": error "+QString::number(maxError)));
+        }
+    }
+}
+
+static void benchmarkTransform(unsigned int size)
+{
+    vector<complex<double>> data(size);
+    for(unsigned int i=0;i<size;i++) {
+        data[i] = polar(1.0, i * 0.1);
+    }
+    QBENCHMARK {
+        // transforms copies, transforming the same data over and over would overflow
+        auto copy = data;
+        Fft::transform(copy, false);
+    }
+}
+
+void fftTests::benchmarkRadix2()
+{
+    benchmarkTransform(8192);
+}
+
+void fftTests::benchmarkBluestein()
+{
+    // typical TDR length for a sweep with 4001 points (mirrored spectrum plus DC)
+    benchmarkTransform(8003);
+}
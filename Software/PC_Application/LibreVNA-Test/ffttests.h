@@ -14,6 +14,9 @@ private slots:
     void fftAndIfft();
     void ifftAndFft();
     void fftAndIfftWithShift();
+    void compareWithDFT();
+    void benchmarkRadix2();
+    void benchmarkBluestein();
 };
 
 #endif // FFTTESTS_H
@@ -0,0 +1,307 @@
+#include "fileiotests.h"
+
+#include "touchstone.h"
+#include "csv.h"
+
+#include <QTemporaryDir>
+
+#include <random>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+using namespace std;
+
+FileIOTests::FileIOTests()
+{
+
+}
+
+static Touchstone randomTouchstone(unsigned int ports, unsigned int points, unsigned int seed = 1)
+{
+    mt19937 gen(seed);
+    uniform_real_distribution<double> dist(-1.0, 1.0);
+    Touchstone t(ports);
+    for(unsigned int i=0;i<points;i++) {
+        Touchstone::Datapoint p;
+        p.frequency = 1000000.0 + i * 1000000.0;
+        for(unsigned int j=0;j<ports*ports;j++) {
+            p.S.push_back(complex<double>(dist(gen), dist(gen)));
+        }
+        t.AddDatapoint(p);
+    }
+    return t;
+}
+
+static void writeFile(QString filename, string content)
+{
+    ofstream file(filename.toStdString(), ios::binary);
+    file << content;
+}
+
+// Line based parsing with a string stream for every line, as done by the previous Touchstone implementation.
+// Only used as a reference for the benchmark (supports RI format in GHz only)
+static unsigned int streamParse(string filename, unsigned int ports)
+{
+    ifstream file(filename);
+    string line;
+    unsigned int points = 0;
+    unsigned int values = 0;
+    vector<complex<double>> S;
+    while(getline(file, line)) {
+        if(line.empty() || line[0] == '#' || line[0] == '!') {
+            continue;
+        }
+        istringstream iss(line);
+        if(values == 0) {
+            double frequency;
+            iss >> frequency;
+            S.clear();
+        }
+        double real, imag;
+        while(iss >> real >> imag) {
+            S.push_back(complex<double>(real, imag));
+            values++;
+        }
+        if(values >= ports * ports) {
+            values = 0;
+            points++;
+        }
+    }
+    return points;
+}
+
+// Formatted stream output of every value, as done by the previous Touchstone implementation.
+// Only used as a reference for the benchmark (4 ports, RI format in GHz)
+static void streamWrite(string filename, Touchstone &t)
+{
+    ofstream file(filename);
+    file << fixed << setprecision(12);
+    for(unsigned int i=0;i<t.points();i++) {
+        file << t.frequency(i) / 1e9;
+        for(unsigned int j=0;j<16;j++) {
+            file << " " << t.parameter(i, j).real() << " " << t.parameter(i, j).imag();
+            if(j % 4 == 3) {
+                file << "\n";
+            }
+        }
+    }
+}
+
+// Splits every line into a QStringList, as done by the previous CSV implementation.
+// Only used as a reference for the benchmark, returns the number of rows
+static unsigned int splitParse(QString filename, char sep)
+{
+    ifstream file(filename.toStdString());
+    string line;
+    unsigned int rows = 0;
+    vector<double> values;
+    while(getline(file, line)) {
+        auto stringList = QString::fromStdString(line).split(sep);
+        values.clear();
+        for(auto &s : stringList) {
+            values.push_back(s.toDouble());
+        }
+        rows++;
+    }
+    // the first line is the header
+    return rows - 1;
+}
+
+void FileIOTests::touchstoneRoundTrip()
+{
+    QTemporaryDir dir;
+    for(unsigned int ports=1;ports<=6;ports++) {
+        auto t = randomTouchstone(ports, 101, ports);
+        for(auto format : {Touchstone::Format::RealImaginary, Touchstone::Format::MagnitudeAngle, Touchstone::Format::DBAngle}) {
+            auto filename = dir.filePath("roundtrip");
+            t.toFile(filename, Touchstone::Scale::MHz, format);
+            auto read = Touchstone::fromFile(filename.toStdString() + ".s" + to_string(ports) + "p");
+            QCOMPARE(read.ports(), ports);
+            QCOMPARE(read.points(), t.points());
+            for(unsigned int i=0;i<t.points();i++) {
+                QVERIFY(abs(read.frequency(i) - t.frequency(i)) < 1e-3);
+                for(unsigned int j=0;j<ports*ports;j++) {
+                    QVERIFY(abs(read.parameter(i, j) - t.parameter(i, j)) < 1e-9);
+                }
+            }
+        }
+    }
+}
+
+void FileIOTests::touchstoneParsing()
+{
+    QTemporaryDir dir;
+    // comments, empty lines, windows line endings, explicit signs and unsorted points
+    auto filename = dir.filePath("test.s2p");
+    writeFile(filename, "! comment\r\n"
+                        "   # mhz s ma r 75 ! options\r\n"
+                        "\r\n"
+                        "2 1 0 +0.5 90 0.25 -90 1e-1 180\r\n"
+                        "1\t1 0 0.5 90 0.25 -90 0.1 180 ! first point\r\n");
+    auto t = Touchstone::fromFile(filename.toStdString());
+    QCOMPARE(t.ports(), 2U);
+    QCOMPARE(t.points(), 2U);
+    QCOMPARE(t.getReferenceImpedance(), 75.0);
+    QCOMPARE(t.frequency(0), 1000000.0);
+    QCOMPARE(t.frequency(1), 2000000.0);
+    for(unsigned int i=0;i<t.points();i++) {
+        auto p = t.point(i);
+        QVERIFY(abs(p.S[0] - complex<double>(1.0, 0.0)) < 1e-12);
+        // touchstone order is S11 S21 S12 S22
+        QVERIFY(abs(p.S[2] - complex<double>(0.0, 0.5)) < 1e-12);
+        QVERIFY(abs(p.S[1] - complex<double>(0.0, -0.25)) < 1e-12);
+        QVERIFY(abs(p.S[3] - complex<double>(-0.1, 0.0)) < 1e-12);
+    }
+
+    // 3 port matrix with frequency on a separate line, dB format
+    filename = dir.filePath("test.s3p");
+    writeFile(filename, "# GHZ S DB R 50\n"
+                        "1.5\n"
+                        "0 0 -20 0 -40 0\n"
+                        "-6.020599913 0 0 0 0 0\n"
+                        "0 0 0 0 0 0\n");
+    t = Touchstone::fromFile(filename.toStdString());
+    QCOMPARE(t.points(), 1U);
+    QCOMPARE(t.frequency(0), 1500000000.0);
+    QVERIFY(abs(t.parameter(0, 1) - 0.1) < 1e-12);
+    QVERIFY(abs(t.parameter(0, 2) - 0.01) < 1e-12);
+    QVERIFY(abs(t.parameter(0, 3) - 0.5) < 1e-9);
+}
+
+void FileIOTests::touchstoneInvalid()
+{
+    QTemporaryDir dir;
+    auto filename = dir.filePath("test.s2p");
+    auto expectFailure = [&](string content) {
+        writeFile(filename, content);
+        QVERIFY_EXCEPTION_THROWN(Touchstone::fromFile(filename.toStdString()), std::exception);
+    };
+    expectFailure("1 0 0 0 0 0 0 0 0\n# GHZ S RI R 50\n");
+    expectFailure("# GHZ S RI R 50\n# GHZ S RI R 50\n");
+    expectFailure("# GHZ Z RI R 50\n");
+    expectFailure("# GHZ S RI R 50\n1 0 0 0 0 0 0 0 x\n");
+    expectFailure("# GHZ S RI R 50\n1 0 0 0 0 0 0 0 0,5\n");
+    expectFailure("# GHZ S RI R 50\n1 0 0 0 0 0 0 0\n");
+    expectFailure("# GHZ S RI R 50\n1 0 0 0 0 0 0 0 0 0 0\n");
+    expectFailure("# GHZ S RI R 50\n1 0 0 0 0\n2 0 0 0 0 0 0 0 0\n");
+    QVERIFY_EXCEPTION_THROWN(Touchstone::fromFile(dir.filePath("missing.s2p").toStdString()), std::exception);
+    QVERIFY_EXCEPTION_THROWN(Touchstone::fromFile(dir.filePath("test.txt").toStdString()), std::exception);
+}
+
+void FileIOTests::csvRoundTrip()
+{
+    QTemporaryDir dir;
+    CSV csv;
+    vector<double> x, y;
+    for(unsigned int i=0;i<1000;i++) {
+        x.push_back(1000000.0 + i * 12345.678);
+        y.push_back(sin(i * 0.1) * 1e-3);
+    }
+    csv.addColumn("x", x);
+    csv.addColumn("y", y);
+    auto filename = dir.filePath("test.csv");
+    csv.toFile(filename);
+    auto read = CSV::fromFile(filename);
+    QCOMPARE(read.columns(), 2U);
+    QCOMPARE(read.getHeader(1), QString("y"));
+    auto readX = read.getColumn("x");
+    auto readY = read.getColumn("y");
+    QVERIFY(readX.size() == x.size());
+    QVERIFY(readY.size() == y.size());
+    for(unsigned int i=0;i<x.size();i++) {
+        QVERIFY(abs(readX[i] - x[i]) <= abs(x[i]) * 1e-9);
+        QVERIFY(abs(readY[i] - y[i]) <= abs(y[i]) * 1e-9);
+    }
+
+    // missing and invalid values are read as zero
+    writeFile(filename, "a;b;c\r\n1;2;3\r\n4;x\r\n\r\n 5 ; 6 ;7\r\n");
+    read = CSV::fromFile(filename, ';');
+    QCOMPARE(read.columns(), 3U);
+    QVERIFY(read.getColumn(0) == vector<double>({1, 4, 0, 5}));
+    QVERIFY(read.getColumn(1) == vector<double>({2, 0, 0, 6}));
+    QVERIFY(read.getColumn(2) == vector<double>({3, 0, 0, 7}));
+}
+
+void FileIOTests::benchmarkTouchstoneRead()
+{
+    constexpr unsigned int points = 20000;
+    QTemporaryDir dir;
+    auto filename = dir.filePath("benchmark");
+    randomTouchstone(4, points).toFile(filename);
+    filename += ".s4p";
+    QBENCHMARK {
+        QCOMPARE(Touchstone::fromFile(filename.toStdString()).points(), points);
+    }
+}
+
+void FileIOTests::benchmarkTouchstoneReadStream()
+{
+    constexpr unsigned int points = 20000;
+    QTemporaryDir dir;
+    auto filename = dir.filePath("benchmark");
+    randomTouchstone(4, points).toFile(filename);
+    filename += ".s4p";
+    QBENCHMARK {
+        QCOMPARE(streamParse(filename.toStdString(), 4), points);
+    }
+}
+
+void FileIOTests::benchmarkTouchstoneWrite()
+{
+    auto t = randomTouchstone(4, 20000);
+    QTemporaryDir dir;
+    auto filename = dir.filePath("benchmark");
+    QBENCHMARK {
+        t.toFile(filename);
+    }
+}
+
+void FileIOTests::benchmarkTouchstoneWriteStream()
+{
+    auto t = randomTouchstone(4, 20000);
+    QTemporaryDir dir;
+    auto filename = dir.filePath("benchmark.s4p").toStdString();
+    QBENCHMARK {
+        streamWrite(filename, t);
+    }
+}
+
+void FileIOTests::benchmarkCSVRead()
+{
+    constexpr unsigned int rows = 100000;
+    CSV csv;
+    vector<double> column(rows);
+    for(unsigned int c=0;c<8;c++) {
+        for(unsigned int i=0;i<rows;i++) {
+            column[i] = sin(i * 0.01 + c) * 1e3;
+        }
+        csv.addColumn("column"+QString::number(c), column);
+    }
+    QTemporaryDir dir;
+    auto filename = dir.filePath("benchmark.csv");
+    csv.toFile(filename);
+    QBENCHMARK {
+        auto c = CSV::fromFile(filename);
+        QCOMPARE(c.getColumn(7).size(), (size_t) rows);
+    }
+}
+
+void FileIOTests::benchmarkCSVReadSplit()
+{
+    constexpr unsigned int rows = 100000;
+    CSV csv;
+    vector<double> column(rows);
+    for(unsigned int c=0;c<8;c++) {
+        for(unsigned int i=0;i<rows;i++) {
+            column[i] = sin(i * 0.01 + c) * 1e3;
+        }
+        csv.addColumn("column"+QString::number(c), column);
+    }
+    QTemporaryDir dir;
+    auto filename = dir.filePath("benchmark.csv");
+    csv.toFile(filename);
+    QBENCHMARK {
+        QCOMPARE(splitParse(filename, ','), rows);
+    }
+}
@@ -0,0 +1,25 @@
+#ifndef FILEIOTESTS_H
+#define FILEIOTESTS_H
+
+#include <QtTest>
+
+class FileIOTests : public QObject
+{
+    Q_OBJECT
+public:
+    FileIOTests();
+
+private slots:
+    void touchstoneRoundTrip();
+    void touchstoneParsing();
+    void touchstoneInvalid();
+    void csvRoundTrip();
+    void benchmarkTouchstoneRead();
+    void benchmarkTouchstoneReadStream();
+    void benchmarkTouchstoneWrite();
+    void benchmarkTouchstoneWriteStream();
+    void benchmarkCSVRead();
+    void benchmarkCSVReadSplit();
+};
+
+#endif // FILEIOTESTS_H
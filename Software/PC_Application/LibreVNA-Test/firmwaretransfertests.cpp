@@ -0,0 +1,489 @@
+#include "firmwaretransfertests.h"
+
+#include "Device/LibreVNA/firmwareuploader.h"
+#include "../../VNA_embedded/Application/Communication/FirmwareTransfer.hpp"
+
+#include <map>
+#include <vector>
+#include <random>
+#include <functional>
+#include <algorithm>
+#include <cstring>
+
+#include <QBuffer>
+
+using namespace std;
+
+namespace {
+
+// Stand-in for the external flash of the device, behaves like Flash::write(): only complete pages can be written,
+// programming can only clear bits and the written data is verified
+class FlashStandIn {
+public:
+    FlashStandIn() : memory(size, 0xFF), failAddress(UINT32_MAX), failures(0), writes(0) {}
+
+    bool write(uint32_t address, uint16_t length, void *src) {
+        if(address % pageSize != 0 || length % pageSize != 0 || address + length > size) {
+            return false;
+        }
+        writes++;
+        if(address == failAddress && failures > 0) {
+            // nothing programmed
+            failures--;
+            return false;
+        }
+        auto data = (const uint8_t*) src;
+        for(unsigned int i=0;i<length;i++) {
+            memory[address + i] &= data[i];
+        }
+        return memcmp(&memory[address], src, length) == 0;
+    }
+
+    static constexpr uint32_t size = 1048576;
+    static constexpr uint32_t pageSize = 256;
+    vector<uint8_t> memory;
+    // the next writes to this address fail
+    uint32_t failAddress;
+    unsigned int failures;
+    unsigned int writes;
+};
+
+/*
+ * Discrete event simulation of a firmware update. The device side handles the packets like App.cpp (using
+ * FirmwareTransfer for the windowed transfer), the host side is the FirmwareUploader used by FirmwareUpdateDialog. All
+ * packets are encoded and decoded with the protocol functions. Times are in seconds.
+ */
+class Simulation {
+public:
+    Simulation(bool supportsWindow, double latency, double writeTime, double bytesPerSecond);
+    ~Simulation();
+
+    // Erases the flash and transfers the image, returns false if the host aborted the update
+    bool update(const vector<uint8_t> &image, unsigned int requestedWindow);
+
+    FlashStandIn flash;
+    FirmwareTransfer transfer;
+    // the chunk with this address is lost once (e.g. due to a CRC error)
+    uint32_t dropAddress;
+    // number of FirmwareTransfer requests whose answers (Ack and FirmwareTransfer) are lost
+    unsigned int dropNegotiationAnswers;
+    // set if a chunk could not be queued on the device
+    bool queueOverflow;
+
+    // results of the last update
+    bool windowed;
+    unsigned int window;
+    unsigned int retransmissions;
+    unsigned int maxInFlight;
+    unsigned int negotiations;
+    double duration;
+
+private:
+    friend bool writeChunk(uint32_t address, uint16_t length, void *src);
+    friend bool sendAnswer(const Protocol::PacketInfo &packet);
+
+    void at(double time, function<void()> event) {
+        events.emplace(time, event);
+    }
+    void toDevice(const Protocol::PacketInfo &p);
+    void toHost(const Protocol::PacketInfo &p, double time);
+    void deviceReceive(const Protocol::PacketInfo &p);
+    void hostReceive(const Protocol::PacketInfo &p);
+
+    enum class State {
+        Transferring,
+        Complete,
+        Aborted,
+    };
+
+    bool supportsWindow;
+    double latency;
+    double writeTime;
+    double bytesPerSecond;
+
+    multimap<double, function<void()>> events;
+    double now;
+    // host to device direction is busy with a transmission until this time
+    double linkBusy;
+    // time on the device while it is writing to the flash
+    double deviceTime;
+    double deviceBusy;
+
+    FirmwareUploader *uploader;
+    State state;
+    unsigned int timerGeneration;
+};
+
+Simulation *active = nullptr;
+
+bool writeChunk(uint32_t address, uint16_t length, void *src) {
+    active->deviceTime += active->writeTime;
+    return active->flash.write(address, length, src);
+}
+
+bool sendAnswer(const Protocol::PacketInfo &packet) {
+    active->toHost(packet, active->deviceTime);
+    return true;
+}
+
+Simulation::Simulation(bool supportsWindow, double latency, double writeTime, double bytesPerSecond)
+    : transfer(writeChunk, sendAnswer),
+      dropAddress(UINT32_MAX),
+      dropNegotiationAnswers(0),
+      queueOverflow(false),
+      supportsWindow(supportsWindow),
+      latency(latency),
+      writeTime(writeTime),
+      bytesPerSecond(bytesPerSecond),
+      uploader(nullptr)
+{
+    active = this;
+}
+
+Simulation::~Simulation()
+{
+    active = nullptr;
+}
+
+bool Simulation::update(const vector<uint8_t> &image, unsigned int requestedWindow)
+{
+    events.clear();
+    now = linkBusy = deviceTime = deviceBusy = 0.0;
+    maxInFlight = 0;
+    negotiations = 0;
+    duration = 0.0;
+    timerGeneration = 0;
+
+    // ClearFlash
+    fill(flash.memory.begin(), flash.memory.end(), 0xFF);
+    flash.writes = 0;
+    transfer.reset();
+
+    QByteArray data((const char*) image.data(), image.size());
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    FirmwareUploader u(&buffer, requestedWindow);
+    uploader = &u;
+    QObject::connect(&u, &FirmwareUploader::sendPacket, [=](const Protocol::PacketInfo &p, bool) {
+        if(p.type == Protocol::PacketType::FirmwarePacket) {
+            maxInFlight = max(maxInFlight, (uploader->getSentBytes() + PacketConstants::FW_CHUNK_SIZE - uploader->getTransferredBytes()) / PacketConstants::FW_CHUNK_SIZE);
+        }
+        toDevice(p);
+    });
+    QObject::connect(&u, &FirmwareUploader::startTimer, [=](unsigned int ms) {
+        auto generation = ++timerGeneration;
+        at(now + ms / 1000.0, [=](){
+            if(generation == timerGeneration) {
+                // not restarted in the meantime
+                uploader->timeout();
+            }
+        });
+    });
+    QObject::connect(&u, &FirmwareUploader::completed, [=](){
+        state = State::Complete;
+        duration = now;
+    });
+    QObject::connect(&u, &FirmwareUploader::failed, [=](QString){
+        state = State::Aborted;
+    });
+    state = State::Transferring;
+    u.start();
+
+    while(!events.empty() && state == State::Transferring) {
+        auto e = events.begin();
+        now = e->first;
+        auto event = e->second;
+        events.erase(e);
+        event();
+    }
+    windowed = u.isWindowed();
+    window = u.getWindow();
+    retransmissions = u.getRetransmissions();
+    uploader = nullptr;
+    events.clear();
+    return state == State::Complete;
+}
+
+void Simulation::toDevice(const Protocol::PacketInfo &p)
+{
+    uint8_t buffer[1024];
+    auto len = Protocol::EncodePacket(p, buffer, sizeof(buffer));
+    vector<uint8_t> frame(buffer, buffer + len);
+    linkBusy = max(now, linkBusy) + len / bytesPerSecond;
+    at(linkBusy + latency, [=]() mutable {
+        Protocol::PacketInfo received;
+        Protocol::DecodeBuffer(frame.data(), frame.size(), &received);
+        deviceReceive(received);
+    });
+}
+
+void Simulation::toHost(const Protocol::PacketInfo &p, double time)
+{
+    uint8_t buffer[1024];
+    auto len = Protocol::EncodePacket(p, buffer, sizeof(buffer));
+    vector<uint8_t> frame(buffer, buffer + len);
+    at(time + latency, [=]() mutable {
+        Protocol::PacketInfo received;
+        Protocol::DecodeBuffer(frame.data(), frame.size(), &received);
+        hostReceive(received);
+    });
+}
+
+void Simulation::deviceReceive(const Protocol::PacketInfo &p)
+{
+    auto answer = [=](Protocol::PacketType type, double time) {
+        Protocol::PacketInfo a;
+        a.type = type;
+        toHost(a, time);
+    };
+    switch(p.type) {
+    case Protocol::PacketType::FirmwareTransfer: {
+        negotiations++;
+        bool drop = dropNegotiationAnswers > 0;
+        if(drop) {
+            dropNegotiationAnswers--;
+        }
+        if(!supportsWindow) {
+            // older firmware does not know this packet
+            answer(Protocol::PacketType::Nack, now);
+        } else {
+            auto window = transfer.negotiate(p.firmwareTransfer.window);
+            if(!drop) {
+                answer(Protocol::PacketType::Ack, now);
+                Protocol::PacketInfo a;
+                a.type = Protocol::PacketType::FirmwareTransfer;
+                a.firmwareTransfer.window = window;
+                toHost(a, now);
+            }
+        }
+    }
+        break;
+    case Protocol::PacketType::FirmwarePacket:
+        if(transfer.isWindowed()) {
+            // received in the interrupt, written by the application task
+            if(p.firmware.address == dropAddress) {
+                dropAddress = UINT32_MAX;
+                break;
+            }
+            if(!transfer.add(p.firmware)) {
+                queueOverflow = true;
+            }
+            at(max(now, deviceBusy), [=](){
+                deviceTime = max(now, deviceBusy);
+                transfer.process();
+                deviceBusy = deviceTime;
+            });
+        } else {
+            // written and acknowledged one at a time
+            deviceTime = max(now, deviceBusy);
+            auto c = p.firmware;
+            bool success = writeChunk(c.address, sizeof(c.data), c.data);
+            deviceBusy = deviceTime;
+            answer(success ? Protocol::PacketType::Ack : Protocol::PacketType::Nack, deviceTime);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void Simulation::hostReceive(const Protocol::PacketInfo &p)
+{
+    if(!uploader) {
+        return;
+    }
+    switch(p.type) {
+    case Protocol::PacketType::Ack:
+        uploader->receivedAck();
+        break;
+    case Protocol::PacketType::Nack:
+        uploader->receivedNack();
+        break;
+    default:
+        uploader->receivedPacket(p);
+        break;
+    }
+}
+
+vector<uint8_t> createImage(unsigned int size)
+{
+    mt19937 gen(size);
+    uniform_int_distribution<int> dist(0, 255);
+    vector<uint8_t> image(size);
+    for(auto &b : image) {
+        b = dist(gen);
+    }
+    return image;
+}
+
+bool written(const Simulation &sim, const vector<uint8_t> &image)
+{
+    return equal(image.begin(), image.end(), sim.flash.memory.begin());
+}
+
+}
+
+FirmwareTransferTests::FirmwareTransferTests()
+{
+
+}
+
+void FirmwareTransferTests::negotiation()
+{
+    static vector<Protocol::PacketInfo> answers;
+    answers.clear();
+    FirmwareTransfer t([](uint32_t, uint16_t, void*) {
+        return true;
+    }, [](const Protocol::PacketInfo &p) {
+        answers.push_back(p);
+        return true;
+    });
+    QVERIFY(!t.isWindowed());
+    QCOMPARE(t.negotiate(16), FirmwareTransfer::MaxWindow);
+    QVERIFY(t.isWindowed());
+    QCOMPARE(t.negotiate(2), (uint8_t) 2);
+    QCOMPARE(t.negotiate(0), (uint8_t) 1);
+    t.reset();
+    QVERIFY(!t.isWindowed());
+
+    // the queue holds MaxWindow chunks until they are processed
+    t.negotiate(FirmwareTransfer::MaxWindow);
+    Protocol::FirmwarePacket chunk;
+    memset(&chunk, 0, sizeof(chunk));
+    for(unsigned int i=0;i<FirmwareTransfer::MaxWindow;i++) {
+        chunk.address = i * PacketConstants::FW_CHUNK_SIZE;
+        QVERIFY(t.add(chunk));
+    }
+    QVERIFY(!t.add(chunk));
+    t.process();
+    QCOMPARE(answers.size(), (size_t) FirmwareTransfer::MaxWindow);
+    for(unsigned int i=0;i<answers.size();i++) {
+        QVERIFY(answers[i].type == Protocol::PacketType::FirmwareAck);
+        uint32_t address = answers[i].firmwareAck.nextAddress;
+        QCOMPARE(address, (uint32_t) (i + 1) * PacketConstants::FW_CHUNK_SIZE);
+    }
+    auto next = t.getNextAddress();
+
+    // a gap is only reported once, a retransmitted chunk is acknowledged again
+    answers.clear();
+    chunk.address = next + PacketConstants::FW_CHUNK_SIZE;
+    t.add(chunk);
+    chunk.address = next + 2 * PacketConstants::FW_CHUNK_SIZE;
+    t.add(chunk);
+    chunk.address = 0;
+    t.add(chunk);
+    t.process();
+    QCOMPARE(answers.size(), (size_t) 2);
+    QVERIFY(answers[0].type == Protocol::PacketType::FirmwareNack);
+    QVERIFY(answers[0].firmwareAck.nextAddress == next);
+    QVERIFY(answers[1].type == Protocol::PacketType::FirmwareAck);
+    QVERIFY(answers[1].firmwareAck.nextAddress == next);
+    QCOMPARE(t.getNextAddress(), next);
+}
+
+void FirmwareTransferTests::legacyDevice()
+{
+    // older firmware rejects the negotiation, chunks are transferred one at a time
+    auto image = createImage(64 * PacketConstants::FW_CHUNK_SIZE);
+    Simulation sim(false, 0.0005, 0.001, 1000000);
+    QVERIFY(sim.update(image, 16));
+    QVERIFY(!sim.windowed);
+    QCOMPARE(sim.maxInFlight, 1U);
+    QVERIFY(written(sim, image));
+    QCOMPARE(sim.flash.writes, 64U);
+}
+
+void FirmwareTransferTests::windowed()
+{
+    auto image = createImage(64 * PacketConstants::FW_CHUNK_SIZE);
+    Simulation sim(true, 0.0005, 0.001, 1000000);
+    QVERIFY(sim.update(image, 16));
+    QVERIFY(sim.windowed);
+    QCOMPARE(sim.window, (unsigned int) FirmwareTransfer::MaxWindow);
+    QCOMPARE(sim.maxInFlight, (unsigned int) FirmwareTransfer::MaxWindow);
+    QVERIFY(!sim.queueOverflow);
+    QCOMPARE(sim.retransmissions, 0U);
+    QVERIFY(written(sim, image));
+    QCOMPARE(sim.flash.writes, 64U);
+
+    // the same simulation also works with a smaller window
+    QVERIFY(sim.update(image, 3));
+    QCOMPARE(sim.maxInFlight, 3U);
+    QVERIFY(written(sim, image));
+}
+
+void FirmwareTransferTests::droppedChunks()
+{
+    auto image = createImage(64 * PacketConstants::FW_CHUNK_SIZE);
+    Simulation sim(true, 0.0005, 0.001, 1000000);
+    // detected by the device when the next chunk arrives
+    sim.dropAddress = 10 * PacketConstants::FW_CHUNK_SIZE;
+    QVERIFY(sim.update(image, 16));
+    QCOMPARE(sim.retransmissions, 1U);
+    QVERIFY(written(sim, image));
+    QCOMPARE(sim.flash.writes, 64U);
+
+    // the last chunk is not followed by anything else, the host retransmits after the timeout
+    sim.dropAddress = 63 * PacketConstants::FW_CHUNK_SIZE;
+    QVERIFY(sim.update(image, 16));
+    QCOMPARE(sim.retransmissions, 1U);
+    QVERIFY(sim.duration > 1.0);
+    QVERIFY(written(sim, image));
+}
+
+void FirmwareTransferTests::lostNegotiation()
+{
+    auto image = createImage(64 * PacketConstants::FW_CHUNK_SIZE);
+    Simulation sim(true, 0.0005, 0.001, 1000000);
+    // the request is repeated after the timeout
+    sim.dropNegotiationAnswers = 1;
+    QVERIFY(sim.update(image, 16));
+    QCOMPARE(sim.negotiations, 2U);
+    QVERIFY(sim.windowed);
+    QCOMPARE(sim.window, (unsigned int) FirmwareTransfer::MaxWindow);
+    QVERIFY(written(sim, image));
+
+    // the host gives up on the negotiation while the device switched to the windowed transfer. The FirmwareAck answers
+    // are accepted in the transfer of one chunk at a time
+    sim.dropNegotiationAnswers = 100;
+    QVERIFY(sim.update(image, 16));
+    QVERIFY(sim.windowed);
+    QCOMPARE(sim.window, 1U);
+    QCOMPARE(sim.maxInFlight, 1U);
+    QCOMPARE(sim.retransmissions, 0U);
+    QVERIFY(written(sim, image));
+    QCOMPARE(sim.flash.writes, 64U);
+}
+
+void FirmwareTransferTests::writeFailures()
+{
+    auto image = createImage(64 * PacketConstants::FW_CHUNK_SIZE);
+    Simulation sim(true, 0.0005, 0.001, 1000000);
+    // failed write is retried
+    sim.flash.failAddress = 20 * PacketConstants::FW_CHUNK_SIZE;
+    sim.flash.failures = 2;
+    QVERIFY(sim.update(image, 16));
+    QCOMPARE(sim.retransmissions, 2U);
+    QVERIFY(written(sim, image));
+
+    // the host gives up if the chunk can not be written
+    sim.flash.failures = 100;
+    QVERIFY(!sim.update(image, 16));
+}
+
+void FirmwareTransferTests::transferTime()
+{
+    // typical firmware file size, page program and verify take about 1ms on the device
+    auto image = createImage(480 * 1024);
+    constexpr double writeTime = 0.001;
+    // latency of USB and Ethernet
+    for(auto latency : {0.0005, 0.005}) {
+        Simulation legacy(false, latency, writeTime, 1000000);
+        QVERIFY(legacy.update(image, 16));
+        QVERIFY(written(legacy, image));
+        Simulation windowed(true, latency, writeTime, 1000000);
+        QVERIFY(windowed.update(image, 16));
+        QVERIFY(written(windowed, image));
+        QVERIFY(windowed.duration < legacy.duration);
+    }
+}
@@ -0,0 +1,22 @@
+#ifndef FIRMWARETRANSFERTESTS_H
+#define FIRMWARETRANSFERTESTS_H
+
+#include <QtTest>
+
+class FirmwareTransferTests : public QObject
+{
+    Q_OBJECT
+public:
+    FirmwareTransferTests();
+
+private slots:
+    void negotiation();
+    void legacyDevice();
+    void windowed();
+    void droppedChunks();
+    void lostNegotiation();
+    void writeFailures();
+    void transferTime();
+};
+
+#endif // FIRMWARETRANSFERTESTS_H
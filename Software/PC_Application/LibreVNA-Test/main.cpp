@@ -2,6 +2,24 @@
 #include "portextensiontests.h"
 #include "parametertests.h"
 #include "ffttests.h"
+#include "crctests.h"
+#include "datapointpooltests.h"
+#include "calibrationkerneltests.h"
+#include "polylinedecimatortests.h"
+#include "medianfiltertests.h"
+#include "compiledexpressiontests.h"
+#include "calibrationcomputetests.h"
+#include "binarycontainertests.h"
+#include "fileiotests.h"
+#include "devicepacketlogtests.h"
+#include "streambuffertests.h"
+#include "averagingtests.h"
+#include "firmwaretransfertests.h"
+#include "compoundmergebuffertests.h"
+#include "datapointdecodertests.h"
+#include "timedomaintests.h"
+#include "measurementblocktests.h"
+#include "tracewaterfalltests.h"
 
 #include <QtTest>
 
@@ -14,6 +32,24 @@ int main(int argc, char *argv[])
     status |= QTest::qExec(new PortExtensionTests, argc, argv);
     status |= QTest::qExec(new ParameterTests, argc, argv);
     status |= QTest::qExec(new fftTests, argc, argv);
+    status |= QTest::qExec(new CRCTests, argc, argv);
+    status |= QTest::qExec(new DatapointPoolTests, argc, argv);
+    status |= QTest::qExec(new CalibrationKernelTests, argc, argv);
+    status |= QTest::qExec(new PolylineDecimatorTests, argc, argv);
+    status |= QTest::qExec(new MedianFilterTests, argc, argv);
+    status |= QTest::qExec(new CompiledExpressionTests, argc, argv);
+    status |= QTest::qExec(new CalibrationComputeTests, argc, argv);
+    status |= QTest::qExec(new BinaryContainerTests, argc, argv);
+    status |= QTest::qExec(new FileIOTests, argc, argv);
+    status |= QTest::qExec(new DevicePacketLogTests, argc, argv);
+    status |= QTest::qExec(new StreamBufferTests, argc, argv);
+    status |= QTest::qExec(new AveragingTests, argc, argv);
+    status |= QTest::qExec(new FirmwareTransferTests, argc, argv);
+    status |= QTest::qExec(new CompoundMergeBufferTests, argc, argv);
+    status |= QTest::qExec(new DatapointDecoderTests, argc, argv);
+    status |= QTest::qExec(new TimeDomainTests, argc, argv);
+    status |= QTest::qExec(new MeasurementBlockTests, argc, argv);
+    status |= QTest::qExec(new TraceWaterfallTests, argc, argv);
 
     return status;
 }
@@ -0,0 +1,146 @@
+#include "measurementblocktests.h"
+
+#include "Device/measurementblock.h"
+
+#include <stdexcept>
+
+using namespace std;
+
+MeasurementBlockTests::MeasurementBlockTests()
+{
+
+}
+
+void MeasurementBlockTests::layoutIndex()
+{
+    auto layout = MeasurementLayout::get({"S11", "S21", "RawPort1Stage0", "S12", "S22"});
+    QCOMPARE(layout->size(), 5U);
+    for(unsigned int i=0;i<layout->size();i++) {
+        QCOMPARE(layout->index(layout->name(i)), (int) i);
+    }
+    QCOMPARE(layout->index("S33"), -1);
+    QCOMPARE(layout->index(""), -1);
+    QCOMPARE(layout->indexS(1, 1), 0);
+    QCOMPARE(layout->indexS(2, 1), 1);
+    QCOMPARE(layout->indexS(1, 2), 3);
+    QCOMPARE(layout->indexS(2, 2), 4);
+    QCOMPARE(layout->indexS(3, 1), -1);
+    // port numbers start at one and are limited by the lookup table
+    QCOMPARE(layout->indexS(0, 1), -1);
+    QCOMPARE(layout->indexS(1, MeasurementLayout::maxPorts + 1), -1);
+    QCOMPARE(layout->receivingPort(1), 2U);
+    QCOMPARE(layout->sourcePort(1), 1U);
+    QCOMPARE(layout->receivingPort(2), 0U);
+    QCOMPARE(layout->sourcePort(2), 0U);
+
+    unsigned int rcv, src;
+    QVERIFY(MeasurementLayout::parseSparam("S34", rcv, src));
+    QCOMPARE(rcv, 3U);
+    QCOMPARE(src, 4U);
+    QVERIFY(!MeasurementLayout::parseSparam("S01", rcv, src));
+    QVERIFY(!MeasurementLayout::parseSparam("S1", rcv, src));
+    QVERIFY(!MeasurementLayout::parseSparam("S123", rcv, src));
+    QVERIFY(!MeasurementLayout::parseSparam("T11", rcv, src));
+}
+
+void MeasurementBlockTests::sharedLayout()
+{
+    QStringList names = {"S11", "S21", "S12", "S22"};
+    auto layout = MeasurementLayout::get(names);
+    QVERIFY(MeasurementLayout::get(names) == layout);
+    // different order is a different layout
+    QVERIFY(MeasurementLayout::get({"S11", "S12", "S21", "S22"}) != layout);
+
+    MeasurementBlock a(layout), b(layout);
+    QVERIFY(a.getLayout() == b.getLayout());
+    a.value(1) = complex<double>(1.0, 2.0);
+    b.value(1) = complex<double>(3.0, 4.0);
+    QCOMPARE(a.value(1), complex<double>(1.0, 2.0));
+    QCOMPARE(b.value(1), complex<double>(3.0, 4.0));
+
+    // blocks built up by name end up with the same layout
+    MeasurementBlock c, d;
+    for(auto &n : names) {
+        c[n] = 1.0;
+        d[n] = 2.0;
+    }
+    QVERIFY(c.getLayout() == layout);
+    QVERIFY(d.getLayout() == layout);
+    QCOMPARE(c.value(3), complex<double>(1.0));
+    QCOMPARE(d.value(3), complex<double>(2.0));
+
+    // setting a new layout resets the values
+    a.setLayout(layout);
+    QCOMPARE(a.value(1), complex<double>(0.0));
+}
+
+void MeasurementBlockTests::insertAndErase()
+{
+    MeasurementBlock m;
+    QVERIFY(m.empty());
+    QCOMPARE(m.count("S11"), 0U);
+    QVERIFY_EXCEPTION_THROWN(m.at("S11"), std::out_of_range);
+
+    m["S11"] = complex<double>(1.0, 1.0);
+    m["S21"] = complex<double>(2.0, 2.0);
+    m["S12"] = complex<double>(3.0, 3.0);
+    QCOMPARE(m.size(), 3U);
+    QCOMPARE(m.count("S21"), 1U);
+    QCOMPARE(m.at("S12"), complex<double>(3.0, 3.0));
+    QCOMPARE(m.indexS(1, 2), 2);
+    // existing parameter keeps its index
+    m["S21"] = complex<double>(4.0, 4.0);
+    QCOMPARE(m.size(), 3U);
+    QCOMPARE(m.value(1), complex<double>(4.0, 4.0));
+
+    // values behind the erased parameter move forward
+    m.erase("S21");
+    QCOMPARE(m.size(), 2U);
+    QCOMPARE(m.count("S21"), 0U);
+    QCOMPARE(m.indexS(2, 1), -1);
+    QCOMPARE(m.indexS(1, 2), 1);
+    QCOMPARE(m.at("S11"), complex<double>(1.0, 1.0));
+    QCOMPARE(m.at("S12"), complex<double>(3.0, 3.0));
+    QVERIFY(m.getLayout() == MeasurementLayout::get({"S11", "S12"}));
+
+    // erasing a parameter that is not included does nothing
+    auto layout = m.getLayout();
+    m.erase("S22");
+    QVERIFY(m.getLayout() == layout);
+    QCOMPARE(m.at("S12"), complex<double>(3.0, 3.0));
+
+    m.erase("S11");
+    m.erase("S12");
+    QVERIFY(m.empty());
+    m["S22"] = 5.0;
+    m.clear();
+    QVERIFY(m.empty());
+    QCOMPARE(m.count("S22"), 0U);
+}
+
+void MeasurementBlockTests::overflow()
+{
+    // 5-port measurement does not fit into the inline storage
+    MeasurementBlock m;
+    for(unsigned int src=1;src<=5;src++) {
+        for(unsigned int rcv=1;rcv<=5;rcv++) {
+            m["S"+QString::number(rcv)+QString::number(src)] = complex<double>(rcv, src);
+        }
+    }
+    QCOMPARE(m.size(), 25U);
+    for(unsigned int src=1;src<=5;src++) {
+        for(unsigned int rcv=1;rcv<=5;rcv++) {
+            auto i = m.indexS(rcv, src);
+            QCOMPARE(i, (int) ((src - 1) * 5 + rcv - 1));
+            QCOMPARE(m.value(i), complex<double>(rcv, src));
+        }
+    }
+    // back to inline storage
+    for(unsigned int rcv=1;rcv<=5;rcv++) {
+        m.erase("S"+QString::number(rcv)+"5");
+        m.erase("S5"+QString::number(rcv));
+    }
+    QCOMPARE(m.size(), 16U);
+    QCOMPARE(m.at("S44"), complex<double>(4.0, 4.0));
+    QCOMPARE(m.at("S31"), complex<double>(3.0, 1.0));
+}
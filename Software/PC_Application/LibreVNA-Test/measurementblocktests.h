@@ -0,0 +1,19 @@
+#ifndef MEASUREMENTBLOCKTESTS_H
+#define MEASUREMENTBLOCKTESTS_H
+
+#include <QtTest>
+
+class MeasurementBlockTests : public QObject
+{
+    Q_OBJECT
+public:
+    MeasurementBlockTests();
+
+private slots:
+    void layoutIndex();
+    void sharedLayout();
+    void insertAndErase();
+    void overflow();
+};
+
+#endif // MEASUREMENTBLOCKTESTS_H
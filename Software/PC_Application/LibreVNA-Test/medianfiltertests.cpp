@@ -0,0 +1,129 @@
+#include "medianfiltertests.h"
+
+#include "Traces/Math/medianfilter.h"
+
+#include <random>
+#include <algorithm>
+
+using namespace std;
+using Math::MedianFilter;
+
+MedianFilterTests::MedianFilterTests()
+{
+
+}
+
+// random samples, rounded to create samples with identical sorting keys
+static vector<TraceMath::Data> randomSamples(unsigned int size, unsigned int seed = 1)
+{
+    mt19937 gen(seed);
+    uniform_int_distribution<int> dist(-20, 20);
+    vector<TraceMath::Data> samples(size);
+    for(unsigned int i=0;i<size;i++) {
+        samples[i].x = 1000000.0 + i * 1000.0;
+        samples[i].y = complex<double>(dist(gen) / 4.0, dist(gen) / 4.0);
+    }
+    return samples;
+}
+
+static double sortKey(complex<double> y, MedianFilter::Order order)
+{
+    switch(order) {
+    case MedianFilter::Order::AbsoluteValue: return abs(y);
+    case MedianFilter::Order::Phase: return arg(y);
+    case MedianFilter::Order::Real: return real(y);
+    case MedianFilter::Order::Imag: return imag(y);
+    default: return 0.0;
+    }
+}
+
+// sorts the complete kernel for every output sample
+static vector<TraceMath::Data> referenceFilter(const vector<TraceMath::Data> &input, unsigned int kernelSize, MedianFilter::Order order)
+{
+    vector<TraceMath::Data> output(input.size());
+    int kernelOffset = (kernelSize - 1) / 2;
+    for(int out=0;out<(int) input.size();out++) {
+        // samples with the same key are sorted by their position in the kernel
+        vector<pair<double, int>> kernel;
+        for(int position=out-kernelOffset;position<out-kernelOffset+(int) kernelSize;position++) {
+            auto index = clamp(position, 0, (int) input.size() - 1);
+            kernel.push_back({sortKey(input[index].y, order), position});
+        }
+        sort(kernel.begin(), kernel.end());
+        output[out].x = input[out].x;
+        output[out].y = input[clamp(kernel[kernelOffset].second, 0, (int) input.size() - 1)].y;
+    }
+    return output;
+}
+
+static bool equal(const vector<TraceMath::Data> &v1, const vector<TraceMath::Data> &v2)
+{
+    if(v1.size() != v2.size()) {
+        return false;
+    }
+    for(unsigned int i=0;i<v1.size();i++) {
+        if(v1[i].x != v2[i].x || v1[i].y != v2[i].y) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void MedianFilterTests::compareWithSort()
+{
+    const vector<MedianFilter::Order> orders = {MedianFilter::Order::AbsoluteValue, MedianFilter::Order::Phase,
+                                                MedianFilter::Order::Real, MedianFilter::Order::Imag};
+    for(auto size : {1U, 2U, 5U, 100U, 3000U}) {
+        auto input = randomSamples(size, size);
+        for(auto kernelSize : {1U, 3U, 4U, 7U, 51U}) {
+            for(auto order : orders) {
+                vector<TraceMath::Data> output(size);
+                MedianFilter::filter(input.data(), input.size(), output.data(), 0, input.size(), kernelSize, order);
+                QVERIFY2(equal(output, referenceFilter(input, kernelSize, order)),
+                         qPrintable("size "+QString::number(size)+", kernel "+QString::number(kernelSize)+", order "+QString::number((int) order)));
+            }
+        }
+    }
+}
+
+void MedianFilterTests::partialRange()
+{
+    auto input = randomSamples(500);
+    auto expected = referenceFilter(input, 9, MedianFilter::Order::AbsoluteValue);
+    vector<TraceMath::Data> output(input.size());
+    MedianFilter::filter(input.data(), input.size(), output.data(), 200, 300, 9, MedianFilter::Order::AbsoluteValue);
+    for(unsigned int i=0;i<output.size();i++) {
+        if(i >= 200 && i < 300) {
+            QVERIFY(output[i].x == expected[i].x && output[i].y == expected[i].y);
+        } else {
+            // samples outside of the range must not be touched
+            QVERIFY(output[i].x == 0 && output[i].y == 0.0);
+        }
+    }
+}
+
+void MedianFilterTests::nanSamples()
+{
+    auto input = randomSamples(200);
+    for(unsigned int i=50;i<60;i++) {
+        input[i].y = complex<double>(numeric_limits<double>::quiet_NaN(), 0);
+    }
+    vector<TraceMath::Data> output(input.size());
+    MedianFilter::filter(input.data(), input.size(), output.data(), 0, input.size(), 5, MedianFilter::Order::Real);
+    // samples with enough valid neighbours are not affected
+    auto expected = referenceFilter(input, 5, MedianFilter::Order::Real);
+    QVERIFY(output[10].y == expected[10].y);
+    QVERIFY(output[150].y == expected[150].y);
+    QVERIFY(isnan(output[55].y.real()));
+}
+
+void MedianFilterTests::benchmarkFilter()
+{
+    const unsigned int points = 100000;
+    const unsigned int kernelSize = 301;
+    auto input = randomSamples(points);
+    vector<TraceMath::Data> output(points);
+    QBENCHMARK {
+        MedianFilter::filter(input.data(), input.size(), output.data(), 0, input.size(), kernelSize, MedianFilter::Order::AbsoluteValue);
+    }
+}
@@ -0,0 +1,19 @@
+#ifndef MEDIANFILTERTESTS_H
+#define MEDIANFILTERTESTS_H
+
+#include <QtTest>
+
+class MedianFilterTests : public QObject
+{
+    Q_OBJECT
+public:
+    MedianFilterTests();
+
+private slots:
+    void compareWithSort();
+    void partialRange();
+    void nanSamples();
+    void benchmarkFilter();
+};
+
+#endif // MEDIANFILTERTESTS_H
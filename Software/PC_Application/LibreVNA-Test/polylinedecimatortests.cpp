@@ -0,0 +1,115 @@
+#include "polylinedecimatortests.h"
+
+#include "Traces/polylinedecimator.h"
+
+#include <QImage>
+#include <QPainter>
+
+#include <random>
+#include <map>
+
+using namespace std;
+
+PolylineDecimatorTests::PolylineDecimatorTests()
+{
+
+}
+
+// noisy trace in pixel coordinates, similar to a 64k point sweep on a 600 pixel wide graph
+static vector<QPointF> syntheticTrace(unsigned int points, double width = 600, double height = 400)
+{
+    mt19937 gen(1);
+    normal_distribution<double> noise(0.0, height / 20);
+    vector<QPointF> trace(points);
+    for(unsigned int i=0;i<points;i++) {
+        auto x = 10 + i * width / points;
+        auto y = height / 2 + height / 4 * sin(x / 50) + noise(gen);
+        trace[i] = QPointF(x, y);
+    }
+    return trace;
+}
+
+void PolylineDecimatorTests::envelope()
+{
+    auto trace = syntheticTrace(20000);
+    PolylineDecimator d;
+    for(unsigned int i=1;i<trace.size();i++) {
+        d.addSegment(trace[i-1], trace[i]);
+    }
+    d.finish();
+    QCOMPARE(d.getPolylines().size(), (size_t) 1);
+    auto &line = d.getPolylines()[0];
+    QCOMPARE(line.front(), trace.front());
+    QCOMPARE(line.back(), trace.back());
+
+    // every pixel column has to cover the same vertical range as the full resolution trace
+    auto columnRanges = [](const QPolygonF &points) {
+        map<int, pair<double, double>> ranges;
+        for(auto p : points) {
+            int column = floor(p.x());
+            if(!ranges.count(column)) {
+                ranges[column] = {p.y(), p.y()};
+            } else {
+                ranges[column].first = min(ranges[column].first, p.y());
+                ranges[column].second = max(ranges[column].second, p.y());
+            }
+        }
+        return ranges;
+    };
+    auto expected = columnRanges(QPolygonF(QVector<QPointF>(trace.begin(), trace.end())));
+    auto decimated = columnRanges(line);
+    QCOMPARE(decimated, expected);
+    QVERIFY(line.size() <= (int) expected.size() * 4);
+}
+
+void PolylineDecimatorTests::gaps()
+{
+    PolylineDecimator d;
+    d.addSegment(QPointF(0, 0), QPointF(1, 1));
+    d.addSegment(QPointF(1, 1), QPointF(2, 0));
+    // not connected to the previous segment
+    d.addSegment(QPointF(5, 0), QPointF(6, 1));
+    // zero length segment is dropped
+    d.addSegment(QPointF(8, 8), QPointF(8, 8));
+    d.finish();
+    QCOMPARE(d.getPolylines().size(), (size_t) 2);
+    QCOMPARE((int) d.getPolylines()[0].size(), 3);
+    QCOMPARE((int) d.getPolylines()[1].size(), 2);
+    QCOMPARE(d.getPoints(), 5U);
+}
+
+static void benchmarkPaint(bool decimate)
+{
+    constexpr unsigned int points = 65536;
+    auto trace = syntheticTrace(points);
+    QImage image(620, 420, QImage::Format_ARGB32_Premultiplied);
+    QPainter p(&image);
+    auto pen = QPen(Qt::yellow, 1);
+    pen.setCosmetic(true);
+    p.setPen(pen);
+    QBENCHMARK {
+        image.fill(Qt::black);
+        if(decimate) {
+            PolylineDecimator d;
+            for(unsigned int i=1;i<trace.size();i++) {
+                d.addSegment(trace[i-1], trace[i]);
+            }
+            d.finish();
+            d.draw(p);
+        } else {
+            for(unsigned int i=1;i<trace.size();i++) {
+                p.drawLine(trace[i-1], trace[i]);
+            }
+        }
+    }
+}
+
+void PolylineDecimatorTests::benchmarkPaintSegments()
+{
+    benchmarkPaint(false);
+}
+
+void PolylineDecimatorTests::benchmarkPaintDecimated()
+{
+    benchmarkPaint(true);
+}
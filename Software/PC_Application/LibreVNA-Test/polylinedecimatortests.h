@@ -0,0 +1,19 @@
+#ifndef POLYLINEDECIMATORTESTS_H
+#define POLYLINEDECIMATORTESTS_H
+
+#include <QtTest>
+
+class PolylineDecimatorTests : public QObject
+{
+    Q_OBJECT
+public:
+    PolylineDecimatorTests();
+
+private slots:
+    void envelope();
+    void gaps();
+    void benchmarkPaintSegments();
+    void benchmarkPaintDecimated();
+};
+
+#endif // POLYLINEDECIMATORTESTS_H
@@ -0,0 +1,208 @@
+#include "streambuffertests.h"
+
+#include "Util/streambuffer.h"
+#include "Device/LibreVNA/librevnatcpdriver.h"
+#include "Device/LibreVNA/datapointpool.h"
+
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QDeadlineTimer>
+
+#include <vector>
+#include <random>
+#include <limits>
+
+using namespace std;
+
+// Creates a capture of the data a 2-port device sends during a sweep: mostly datapoints with a few other packets and
+// some garbage bytes in between
+static QByteArray capture(unsigned int points, unsigned int &packets) {
+    QByteArray ret;
+    Protocol::PacketInfo p;
+    Protocol::VNADatapoint<32> d;
+    uint8_t buf[512];
+    packets = 0;
+    for(unsigned int i=0;i<points;i++) {
+        d.clear();
+        d.pointNum = i % 65536;
+        d.frequency = 1000000 + i * 1000;
+        for(int stage=0;stage<2;stage++) {
+            for(int port=0;port<2;port++) {
+                d.addValue(0.1 * i, -0.2 * i, stage, 0x01 << port);
+                d.addValue(0.3 * i, 0.4 * i, stage, (0x01 << port) | (int) Protocol::Source::Reference);
+            }
+        }
+        p.type = Protocol::PacketType::VNADatapoint;
+        p.VNAdatapoint = &d;
+        ret.append((const char*) buf, Protocol::EncodePacket(p, buf, sizeof(buf)));
+        packets++;
+        if(i % 1000 == 999) {
+            p.type = Protocol::PacketType::DeviceStatus;
+            memset(&p.status, 0, sizeof(p.status));
+            ret.append((const char*) buf, Protocol::EncodePacket(p, buf, sizeof(buf)));
+            packets++;
+            ret.append("garbage");
+        }
+    }
+    return ret;
+}
+
+StreamBufferTests::StreamBufferTests()
+{
+
+}
+
+void StreamBufferTests::removeAndAppend()
+{
+    StreamBuffer b;
+    QCOMPARE(b.getReceived(), 0);
+    b.append(QByteArray("0123456789"));
+    QCOMPARE(b.getReceived(), 10);
+    b.removeBytes(3);
+    QCOMPARE(b.getReceived(), 7);
+    QCOMPARE(b.getBuffer()[0], (uint8_t) '3');
+    b.removeBytes(2);
+    QCOMPARE(b.getBuffer()[0], (uint8_t) '5');
+    // remaining bytes stay in front of appended data
+    b.append(QByteArray("abc"));
+    QCOMPARE(b.getReceived(), 8);
+    QCOMPARE(QByteArray((const char*) b.getBuffer(), b.getReceived()), QByteArray("56789abc"));
+    b.removeBytes(8);
+    QCOMPARE(b.getReceived(), 0);
+    b.append(QByteArray("x"));
+    QCOMPARE(b.getBuffer()[0], (uint8_t) 'x');
+    b.clear();
+    QCOMPARE(b.getReceived(), 0);
+}
+
+void StreamBufferTests::splitPackets()
+{
+    unsigned int packets;
+    auto data = capture(500, packets);
+    QTcpServer server;
+    LibreVNATCPDriver driver;
+    int received = 0;
+    // connected before the receive path of the driver, sees the data before it is read
+    connect(&driver.dataSocket, &QTcpSocket::readyRead, [&](){
+        received += driver.dataSocket.bytesAvailable();
+    });
+    auto device = connectDriver(server, driver);
+    QVERIFY(device);
+    unsigned int decoded = 0;
+    unsigned int lastPointNum = 0;
+    countPackets(driver, decoded, lastPointNum);
+    // deliver the data in chunks of random size, packets are split at arbitrary positions
+    mt19937 gen(1);
+    uniform_int_distribution<int> chunkSize(1, 2000);
+    for(int pos=0;pos<data.size();) {
+        auto len = min(chunkSize(gen), (int) data.size() - pos);
+        device->write(data.constData() + pos, len);
+        QVERIFY(device->waitForBytesWritten(5000));
+        pos += len;
+        while(received < pos) {
+            QVERIFY(driver.dataSocket.waitForReadyRead(5000));
+        }
+    }
+    QCOMPARE(decoded, packets);
+    QCOMPARE(lastPointNum, 499U);
+    QCOMPARE(driver.dataBuffer.getReceived(), 0);
+}
+
+void StreamBufferTests::tcpLoopback()
+{
+    // ~5MB in reads of arbitrary size
+    unsigned int packets;
+    auto data = capture(17000, packets);
+    QTcpServer server;
+    LibreVNATCPDriver driver;
+    auto device = connectDriver(server, driver);
+    QVERIFY(device);
+    unsigned int decoded = 0;
+    unsigned int lastPointNum = 0;
+    countPackets(driver, decoded, lastPointNum);
+    device->write(data);
+    QTRY_COMPARE_WITH_TIMEOUT(decoded, packets, 30000);
+    QCOMPARE(lastPointNum, 16999U);
+    QCOMPARE(driver.dataBuffer.getReceived(), 0);
+}
+
+// Number of datapoints per benchmark iteration (~1MB)
+static constexpr unsigned int benchmarkPoints = 3400;
+
+void StreamBufferTests::benchmarkTcpReceive()
+{
+    unsigned int packets;
+    auto data = capture(benchmarkPoints, packets);
+    QTcpServer server;
+    LibreVNATCPDriver driver;
+    auto device = connectDriver(server, driver);
+    QVERIFY(device);
+    unsigned int decoded = 0;
+    unsigned int lastPointNum = 0;
+    countPackets(driver, decoded, lastPointNum);
+    QBENCHMARK {
+        decoded = 0;
+        device->write(data);
+        QDeadlineTimer deadline(30000);
+        while(decoded < packets && !deadline.hasExpired()) {
+            QCoreApplication::processEvents(QEventLoop::AllEvents, 100);
+        }
+    }
+    QCOMPARE(decoded, packets);
+}
+
+void StreamBufferTests::benchmarkRemovePerPacket()
+{
+    // the previous implementation of LibreVNATCPDriver::ReceivedData(): every packet is removed from the front of a
+    // QByteArray. Decodes the capture of benchmarkTcpReceive() in a single read
+    unsigned int packets;
+    auto data = capture(benchmarkPoints, packets);
+    auto storage = DatapointPool::get();
+    unsigned int decoded = 0;
+    QBENCHMARK {
+        auto read = data;
+        decoded = 0;
+        Protocol::PacketInfo packet;
+        uint16_t handled_len;
+        do {
+            uint16_t len = min((int) read.size(), (int) numeric_limits<uint16_t>::max());
+            handled_len = Protocol::DecodeBuffer((uint8_t*) read.data(), len, &packet, storage.get());
+            read.remove(0, handled_len);
+            if(packet.type != Protocol::PacketType::None) {
+                decoded++;
+            }
+        } while(handled_len > 0);
+    }
+    QCOMPARE(decoded, packets);
+}
+
+QTcpSocket *StreamBufferTests::connectDriver(QTcpServer &server, LibreVNATCPDriver &driver)
+{
+    if(!server.listen(QHostAddress::LocalHost)) {
+        return nullptr;
+    }
+    driver.dataSocket.connectToHost(QHostAddress::LocalHost, server.serverPort());
+    if(!server.waitForNewConnection(5000) || !driver.dataSocket.waitForConnected(5000)) {
+        return nullptr;
+    }
+    connect(&driver.dataSocket, &QTcpSocket::readyRead, &driver, &LibreVNATCPDriver::ReceivedData);
+    return server.nextPendingConnection();
+}
+
+void StreamBufferTests::countPackets(LibreVNATCPDriver &driver, unsigned int &packets, unsigned int &lastPointNum)
+{
+    connect(&driver, &LibreVNADriver::receivedDatapoints, [&](const std::vector<Protocol::PacketInfo> &datapoints){
+        for(auto &p : datapoints) {
+            // returns the datapoint to the pool
+            auto d = DatapointPool::adopt(p.VNAdatapoint);
+            lastPointNum = d->pointNum;
+            packets++;
+        }
+    });
+    connect(&driver, &LibreVNADriver::receivedPacket, [&](const Protocol::PacketInfo &p){
+        // the garbage bytes and the end of the received data are passed on as well
+        if(p.type != Protocol::PacketType::None) {
+            packets++;
+        }
+    });
+}
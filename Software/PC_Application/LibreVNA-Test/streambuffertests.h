@@ -0,0 +1,31 @@
+#ifndef STREAMBUFFERTESTS_H
+#define STREAMBUFFERTESTS_H
+
+#include <QtTest>
+
+class QTcpServer;
+class QTcpSocket;
+class LibreVNATCPDriver;
+
+class StreamBufferTests : public QObject
+{
+    Q_OBJECT
+public:
+    StreamBufferTests();
+
+private slots:
+    void removeAndAppend();
+    void splitPackets();
+    void tcpLoopback();
+    void benchmarkTcpReceive();
+    void benchmarkRemovePerPacket();
+
+private:
+    // Connects the data socket of the driver to the server and decodes received data with the receive path of the
+    // driver. Returns the socket on the server side, it stands in for the device
+    QTcpSocket *connectDriver(QTcpServer &server, LibreVNATCPDriver &driver);
+    // Counts the packets the driver passes on
+    void countPackets(LibreVNATCPDriver &driver, unsigned int &packets, unsigned int &lastPointNum);
+};
+
+#endif // STREAMBUFFERTESTS_H
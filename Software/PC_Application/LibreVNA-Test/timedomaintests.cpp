@@ -0,0 +1,70 @@
+#include "timedomaintests.h"
+
+#include "Traces/trace.h"
+#include "Traces/Math/tdr.h"
+#include "Traces/Math/dft.h"
+#include "preferences.h"
+
+#include <complex>
+
+using namespace std;
+
+TimeDomainTests::TimeDomainTests()
+{
+
+}
+
+// trace with data that does not change anymore (e.g. loaded from a file)
+static void fillStaticTrace(Trace &t)
+{
+    for(unsigned int i=0;i<101;i++) {
+        Trace::Data d;
+        d.x = 1000000.0 + i * 1000000.0;
+        d.y = polar(0.5, -0.1 * i);
+        t.addData(d, TraceMath::DataType::Frequency);
+    }
+}
+
+void TimeDomainTests::initTestCase()
+{
+    // do not wait between calculations
+    Preferences::getInstance().Acquisition.limitDFT = false;
+}
+
+void TimeDomainTests::toggleTDR()
+{
+    Trace t;
+    fillStaticTrace(t);
+    auto tdr = new Math::TDR();
+    t.addMathOperation(tdr);
+    QTRY_VERIFY(tdr->numSamples() > 0);
+    auto samples = tdr->numSamples();
+
+    // the input data is unchanged while the operation is disabled, it still has to be calculated again
+    t.enableMathOperation(1, false);
+    QCOMPARE(tdr->numSamples(), 0U);
+    t.enableMathOperation(1, true);
+    QTRY_COMPARE(tdr->numSamples(), samples);
+}
+
+void TimeDomainTests::toggleDFT()
+{
+    Trace t;
+    fillStaticTrace(t);
+    auto tdr = new Math::TDR();
+    auto dft = new Math::DFT();
+    t.addMathOperations({tdr, dft});
+    QTRY_VERIFY(dft->numSamples() > 0);
+    auto samples = dft->numSamples();
+
+    t.enableMathOperation(2, false);
+    QCOMPARE(dft->numSamples(), 0U);
+    t.enableMathOperation(2, true);
+    QTRY_COMPARE(dft->numSamples(), samples);
+
+    // disabling the TDR changes the input type of the DFT to invalid and back
+    t.enableMathOperation(1, false);
+    QCOMPARE(dft->numSamples(), 0U);
+    t.enableMathOperation(1, true);
+    QTRY_COMPARE(dft->numSamples(), samples);
+}
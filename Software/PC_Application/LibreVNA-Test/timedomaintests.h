@@ -0,0 +1,18 @@
+#ifndef TIMEDOMAINTESTS_H
+#define TIMEDOMAINTESTS_H
+
+#include <QtTest>
+
+class TimeDomainTests : public QObject
+{
+    Q_OBJECT
+public:
+    TimeDomainTests();
+
+private slots:
+    void initTestCase();
+    void toggleTDR();
+    void toggleDFT();
+};
+
+#endif // TIMEDOMAINTESTS_H
@@ -0,0 +1,84 @@
+#include "tracewaterfalltests.h"
+
+#include "Traces/tracewaterfall.h"
+#include "Traces/tracemodel.h"
+
+#include <complex>
+
+using namespace std;
+
+TraceWaterfallTests::TraceWaterfallTests()
+{
+
+}
+
+void TraceWaterfallTests::cachedImage()
+{
+    TraceModel model;
+    TraceWaterfall w(model);
+    addSweep(w, 0.0);
+    QRect plotRect(60, 10, 500, 300);
+    update(w, plotRect);
+    QVERIFY(w.image.pixel(250, 0) != qRgba(0, 0, 0, 0));
+
+    // without any changes, the image is not redrawn
+    w.image.fill(Qt::red);
+    update(w, plotRect);
+    QCOMPARE(w.image.pixel(250, 0), QColor(Qt::red).rgba());
+
+    // a new sweep is drawn into the existing image
+    addSweep(w, 1.0);
+    update(w, plotRect);
+    QVERIFY(w.image.pixel(250, 0) != QColor(Qt::red).rgba());
+    QVERIFY(w.image.pixel(250, 1) != QColor(Qt::red).rgba());
+}
+
+void TraceWaterfallTests::moveLeftMargin()
+{
+    TraceModel model;
+    TraceWaterfall w(model);
+    addSweep(w, 0.0);
+    addSweep(w, 1.0);
+    QRect plotRect(60, 10, 500, 300);
+    update(w, plotRect);
+    w.image.fill(Qt::red);
+
+    // only the left margin changes (e.g. the secondary Y axis of the XY plots is enabled), size stays the same
+    plotRect.moveLeft(83);
+    update(w, plotRect);
+    QCOMPARE(w.image.size(), QSize(501, 301));
+
+    // the image has to match a waterfall that was drawn at the new position right away
+    TraceWaterfall reference(model);
+    addSweep(reference, 0.0);
+    addSweep(reference, 1.0);
+    update(reference, plotRect);
+    QCOMPARE(w.image, reference.image);
+}
+
+void TraceWaterfallTests::update(TraceWaterfall &w, const QRect &plotRect)
+{
+    w.plotAreaTop = plotRect.y();
+    w.plotAreaLeft = plotRect.x();
+    w.plotAreaWidth = plotRect.width();
+    w.plotAreaBottom = plotRect.y()+plotRect.height();
+    w.updateImage(plotRect);
+}
+
+void TraceWaterfallTests::addSweep(TraceWaterfall &w, double phase)
+{
+    if(w.data.empty()) {
+        w.xAxis.set(XAxis::Type::Frequency, false, false, 1000000, 1000000000, 10, false);
+        w.yAxis.set(YAxis::Type::Magnitude, false, false, -40, 0, 10, false);
+    }
+    // samples are not aligned to the pixels of the plot area
+    vector<Trace::Data> sweep;
+    for(unsigned int i=0;i<333;i++) {
+        Trace::Data d;
+        d.x = 1000000.0 + i * 3000000.0;
+        d.y = polar(0.5 + 0.4 * sin(i * 0.1 + phase), 0.0);
+        sweep.push_back(d);
+    }
+    w.data.push_back(sweep);
+    w.sweepsAdded++;
+}
@@ -0,0 +1,24 @@
+#ifndef TRACEWATERFALLTESTS_H
+#define TRACEWATERFALLTESTS_H
+
+#include <QtTest>
+
+class TraceWaterfall;
+
+class TraceWaterfallTests : public QObject
+{
+    Q_OBJECT
+public:
+    TraceWaterfallTests();
+
+private slots:
+    void cachedImage();
+    void moveLeftMargin();
+
+private:
+    // sets the plot area as done by TraceWaterfall::draw() and updates the image
+    static void update(TraceWaterfall &w, const QRect &plotRect);
+    static void addSweep(TraceWaterfall &w, double phase);
+};
+
+#endif // TRACEWATERFALLTESTS_H
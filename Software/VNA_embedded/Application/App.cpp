@@ -34,18 +34,35 @@ static bool sweepActive;
 // has MCU controllable flash chip, firmware update supported
 #define HAS_FLASH
 #include "Firmware.hpp"
+#include "FirmwareTransfer.hpp"
+
+static bool WriteFirmwareChunk(uint32_t address, uint16_t length, void *src) {
+	return HWHAL::flash.write(address, length, src);
+}
+
+static FirmwareTransfer firmwareTransfer(WriteFirmwareChunk, Communication::Send);
 #endif
 
 extern ADC_HandleTypeDef hadc1;
 
 #define FLAG_USB_PACKET			0x01
 #define FLAG_TRIGGER_OUT_ISR	0x02
+#define FLAG_FIRMWARE_CHUNK		0x04
 
 static bool lastReportedTrigger;
 
 static void USBPacketReceived(const Protocol::PacketInfo &p) {
-	recv_packet = p;
 	BaseType_t woken = false;
+#ifdef HAS_FLASH
+	if(p.type == Protocol::PacketType::FirmwarePacket && firmwareTransfer.isWindowed()) {
+		// several chunks may arrive before the first one is written, queue them instead of overwriting recv_packet
+		firmwareTransfer.add(p.firmware);
+		xTaskNotifyFromISR(handle, FLAG_FIRMWARE_CHUNK, eSetBits, &woken);
+		portYIELD_FROM_ISR(woken);
+		return;
+	}
+#endif
+	recv_packet = p;
 	xTaskNotifyFromISR(handle, FLAG_USB_PACKET, eSetBits, &woken);
 	portYIELD_FROM_ISR(woken);
 }
@@ -58,6 +75,7 @@ static void TriggerOutISR() {
 
 inline void App_Init() {
 	STM::Init();
+	Protocol::SetCRCFunction(STM::CRC32);
 	Delay::Init();
 	HAL_ADCEx_Calibration_Start(&hadc1, ADC_SINGLE_ENDED);
 	handle = xTaskGetCurrentTaskHandle();
@@ -203,6 +221,8 @@ inline void App_Process() {
 					HW::SetMode(HW::Mode::Idle);
 					sweepActive = false;
 					LOG_DEBUG("Erasing FLASH in preparation for firmware update...");
+					// a new update transfers one chunk at a time until the windowed transfer is requested
+					firmwareTransfer.reset();
 					if(HWHAL::flash.eraseRange(0, Firmware::maxSize)) {
 						LOG_DEBUG("...FLASH erased")
 						Communication::SendWithoutPayload(Protocol::PacketType::Ack);
@@ -220,6 +240,15 @@ inline void App_Process() {
 						Communication::SendWithoutPayload(Protocol::PacketType::Nack);
 					}
 					break;
+				case Protocol::PacketType::FirmwareTransfer: {
+					Communication::SendWithoutPayload(Protocol::PacketType::Ack);
+					Protocol::PacketInfo p;
+					p.type = Protocol::PacketType::FirmwareTransfer;
+					p.firmwareTransfer.window = firmwareTransfer.negotiate(recv_packet.firmwareTransfer.window);
+					LOG_INFO("Windowed firmware transfer with %u chunks in flight", p.firmwareTransfer.window);
+					Communication::Send(p);
+				}
+					break;
 				case Protocol::PacketType::PerformFirmwareUpdate: {
 					LOG_INFO("Firmware update process triggered");
 					auto fw_info = Firmware::GetFlashContentInfo();
@@ -300,6 +329,11 @@ inline void App_Process() {
 					break;
 				}
 			}
+#ifdef HAS_FLASH
+			if(notification & FLAG_FIRMWARE_CHUNK) {
+				firmwareTransfer.process();
+			}
+#endif
 			if(notification & FLAG_TRIGGER_OUT_ISR) {
 				// trigger output (from FPGA) changed level
 				bool set = Trigger::GetOutput();
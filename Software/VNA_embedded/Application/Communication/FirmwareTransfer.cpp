@@ -0,0 +1,71 @@
+#include "FirmwareTransfer.hpp"
+
+FirmwareTransfer::FirmwareTransfer(WriteFunction write, SendFunction send)
+	: write(write), send(send) {
+	static_assert((MaxWindow & (MaxWindow - 1)) == 0, "MaxWindow must be a power of two");
+	reset();
+}
+
+void FirmwareTransfer::reset() {
+	windowed = false;
+	nextAddress = 0;
+	nackSent = false;
+	writeIndex = 0;
+	readIndex = 0;
+}
+
+uint8_t FirmwareTransfer::negotiate(uint8_t window) {
+	reset();
+	if(window > MaxWindow) {
+		window = MaxWindow;
+	} else if(window == 0) {
+		window = 1;
+	}
+	windowed = true;
+	return window;
+}
+
+bool FirmwareTransfer::add(const Protocol::FirmwarePacket &chunk) {
+	auto w = writeIndex.load(std::memory_order_relaxed);
+	if((uint8_t) (w - readIndex.load(std::memory_order_acquire)) >= MaxWindow) {
+		// queue full, the gap is detected when the next chunk is processed
+		return false;
+	}
+	queue[w % MaxWindow] = chunk;
+	writeIndex.store(w + 1, std::memory_order_release);
+	return true;
+}
+
+void FirmwareTransfer::process() {
+	auto r = readIndex.load(std::memory_order_relaxed);
+	while(r != writeIndex.load(std::memory_order_acquire)) {
+		auto &chunk = queue[r % MaxWindow];
+		if(chunk.address == nextAddress) {
+			// the next chunk or the start of a retransmission
+			nackSent = false;
+			if(write(chunk.address, sizeof(chunk.data), chunk.data)) {
+				nextAddress += sizeof(chunk.data);
+				answer(Protocol::PacketType::FirmwareAck);
+			} else {
+				nackSent = true;
+				answer(Protocol::PacketType::FirmwareNack);
+			}
+		} else if(chunk.address < nextAddress) {
+			// retransmission of a chunk that has already been written
+			answer(Protocol::PacketType::FirmwareAck);
+		} else if(!nackSent) {
+			// at least one chunk is missing. Only requested once, all following chunks are retransmitted anyway
+			nackSent = true;
+			answer(Protocol::PacketType::FirmwareNack);
+		}
+		r++;
+		readIndex.store(r, std::memory_order_release);
+	}
+}
+
+void FirmwareTransfer::answer(Protocol::PacketType type) {
+	Protocol::PacketInfo p;
+	p.type = type;
+	p.firmwareAck.nextAddress = nextAddress;
+	send(p);
+}
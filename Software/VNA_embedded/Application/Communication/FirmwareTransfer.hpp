@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Protocol.hpp"
+
+#include <atomic>
+
+/*
+ * Receiving side of the windowed firmware transfer.
+ *
+ * Without negotiation, every FirmwarePacket is acknowledged before the next one is sent (handled by the application).
+ * Once the windowed transfer has been negotiated, the host keeps up to a window of FirmwarePackets in flight. They are
+ * queued from the interrupt context and written to the flash by the application task. Every written chunk is answered
+ * with a cumulative FirmwareAck. A chunk that does not continue at the acknowledged address (because a previous one has
+ * been dropped) or can not be written is answered with a FirmwareNack, the host then retransmits from that address on.
+ *
+ * Independent of the hardware: the flash write and packet transmission are passed in as functions.
+ */
+class FirmwareTransfer {
+public:
+	// Maximum number of chunks in flight, limited by the RAM used for the queue. Must be a power of two
+	static constexpr uint8_t MaxWindow = 8;
+
+	using WriteFunction = bool(*)(uint32_t address, uint16_t length, void *src);
+	using SendFunction = bool(*)(const Protocol::PacketInfo &packet);
+
+	FirmwareTransfer(WriteFunction write, SendFunction send);
+
+	// Returns to the transfer of one chunk at a time. Called when the flash is erased for a new update
+	void reset();
+	// Switches to the windowed transfer, returns the used window (at most the requested one)
+	uint8_t negotiate(uint8_t window);
+	bool isWindowed() const {
+		return windowed;
+	}
+	// Queues a received chunk. Called from the interrupt context, returns false if the queue is full (chunk dropped)
+	bool add(const Protocol::FirmwarePacket &chunk);
+	// Writes all queued chunks to the flash and sends the answers. Called from the application task
+	void process();
+
+	// All firmware data below this address has been written
+	uint32_t getNextAddress() const {
+		return nextAddress;
+	}
+
+private:
+	void answer(Protocol::PacketType type);
+
+	WriteFunction write;
+	SendFunction send;
+	bool windowed;
+	uint32_t nextAddress;
+	// a FirmwareNack has been sent and the retransmission has not started yet
+	bool nackSent;
+
+	Protocol::FirmwarePacket queue[MaxWindow];
+	// free running indices (single producer/single consumer), the queue is full when they are MaxWindow apart
+	std::atomic<uint8_t> writeIndex;
+	std::atomic<uint8_t> readIndex;
+};
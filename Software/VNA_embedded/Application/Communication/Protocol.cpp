@@ -12,20 +12,70 @@
  */
 
 #define CRC32_POLYGON 0xEDB88320
-uint32_t Protocol::CRC32(uint32_t crc, const void *data, uint32_t len) {
-	uint8_t *u8buf = (uint8_t*) data;
-	int k;
+
+namespace {
+
+// Lookup tables for slice-by-8 CRC calculation, created at compile time.
+// table[0] is the classic bytewise table, table[n] advances the CRC of a byte by n additional zero bytes
+struct CRCTables {
+	uint32_t table[8][256];
+	constexpr CRCTables() : table() {
+		for(uint32_t i=0;i<256;i++) {
+			uint32_t crc = i;
+			for(int k=0;k<8;k++) {
+				crc = crc & 1 ? (crc >> 1) ^ CRC32_POLYGON : crc >> 1;
+			}
+			table[0][i] = crc;
+		}
+		for(uint32_t i=0;i<256;i++) {
+			for(int n=1;n<8;n++) {
+				table[n][i] = (table[n-1][i] >> 8) ^ table[0][table[n-1][i] & 0xFF];
+			}
+		}
+	}
+};
+
+constexpr CRCTables crcTables;
+
+Protocol::CRCFunction crcFunction = nullptr;
+
+}
+
+uint32_t Protocol::CRC32Software(uint32_t crc, const void *data, uint32_t len) {
+	auto t = crcTables.table;
+	const uint8_t *u8buf = (const uint8_t*) data;
 
 	crc = ~crc;
+	// process eight bytes per iteration (assumes little endian byte order)
+	while (len >= 8) {
+		uint32_t one, two;
+		memcpy(&one, u8buf, 4);
+		memcpy(&two, u8buf + 4, 4);
+		one ^= crc;
+		crc = t[7][one & 0xFF] ^ t[6][(one >> 8) & 0xFF] ^ t[5][(one >> 16) & 0xFF] ^ t[4][one >> 24]
+			^ t[3][two & 0xFF] ^ t[2][(two >> 8) & 0xFF] ^ t[1][(two >> 16) & 0xFF] ^ t[0][two >> 24];
+		u8buf += 8;
+		len -= 8;
+	}
+	// remaining bytes
 	while (len--) {
-		crc ^= *u8buf++;
-		for (k = 0; k < 8; k++)
-			crc = crc & 1 ? (crc >> 1) ^ CRC32_POLYGON : crc >> 1;
+		crc = (crc >> 8) ^ t[0][(crc ^ *u8buf++) & 0xFF];
 	}
 	return ~crc;
 }
 
-uint16_t Protocol::DecodeBuffer(uint8_t *buf, uint16_t len, PacketInfo *info) {
+uint32_t Protocol::CRC32(uint32_t crc, const void *data, uint32_t len) {
+	if(crcFunction) {
+		return crcFunction(crc, data, len);
+	}
+	return CRC32Software(crc, data, len);
+}
+
+void Protocol::SetCRCFunction(CRCFunction f) {
+	crcFunction = f;
+}
+
+uint16_t Protocol::DecodeBuffer(uint8_t *buf, uint16_t len, PacketInfo *info, VNADatapoint<32> *datapointStorage) {
     if (!info || !len) {
         info->type = PacketType::None;
 		return 0;
@@ -66,7 +116,8 @@ uint16_t Protocol::DecodeBuffer(uint8_t *buf, uint16_t len, PacketInfo *info) {
 	/* The complete frame has been received, check checksum */
 	auto type = (PacketType) data[PCKT_TYPE_OFFSET];
     uint32_t crc = (uint32_t) data[length-4] | ((uint32_t) data[length-3] << 8) | ((uint32_t) data[length-2] << 16) | ((uint32_t) data[length-1] << 24);
-	if(type != PacketType::VNADatapoint) {
+	// Datapoints from older firmware versions have the CRC set to zero, accept them without checking
+	if(type != PacketType::VNADatapoint || crc != 0x00000000) {
 		uint32_t compare = CRC32(0, data, length - PCKT_CRC_LEN);
 		if(crc != compare) {
 			// CRC mismatch, remove header
@@ -74,18 +125,14 @@ uint16_t Protocol::DecodeBuffer(uint8_t *buf, uint16_t len, PacketInfo *info) {
 			info->type = PacketType::None;
 			return data - buf;
 		}
+	}
+	if(type != PacketType::VNADatapoint) {
 		// Valid packet, copy packet type and payload
 		memcpy(info, &data[PCKT_TYPE_OFFSET], length - 7);
 	} else {
-		// Datapoint has the CRC set to zero
-		if(crc != 0x00000000) {
-			data += 1;
-			info->type = PacketType::None;
-			return data - buf;
-		}
 		// Create the datapoint
 		info->type = (PacketType) data[PCKT_TYPE_OFFSET];
-		info->VNAdatapoint = new VNADatapoint<32>;
+		info->VNAdatapoint = datapointStorage ? datapointStorage : new VNADatapoint<32>;
 		info->VNAdatapoint->decode(&data[PCKT_PAYLOAD_OFFSET], length - PCKT_EXCL_PAYLOAD_LEN);
 	}
 
@@ -110,6 +157,9 @@ uint16_t Protocol::EncodePacket(const PacketInfo &packet, uint8_t *dest, uint16_
     case PacketType::ReceiverCalPoint: payload_size = sizeof(packet.amplitudePoint); break;
     case PacketType::FrequencyCorrection: payload_size = sizeof(packet.frequencyCorrection); break;
     case PacketType::DeviceConfiguration: payload_size = sizeof(packet.deviceConfig); break;
+    case PacketType::FirmwareTransfer: payload_size = sizeof(packet.firmwareTransfer); break;
+    case PacketType::FirmwareAck:
+    case PacketType::FirmwareNack: payload_size = sizeof(packet.firmwareAck); break;
     case PacketType::Ack:
     case PacketType::PerformFirmwareUpdate:
     case PacketType::ClearFlash:
@@ -141,19 +191,15 @@ uint16_t Protocol::EncodePacket(const PacketInfo &packet, uint8_t *dest, uint16_
 	uint16_t overall_size = payload_size + PCKT_EXCL_PAYLOAD_LEN;
 	memcpy(&dest[PCKT_LENGTH_OFFSET], &overall_size, PCKT_LENGTH_LEN);
 	// Further encoding uses a special case for VNADatapoint packettype
-	uint32_t crc = 0x00000000;
 	if(packet.type == PacketType::VNADatapoint) {
-		// CRC calculation takes about 18us which is the bulk of the time required to encode and transmit a datapoint.
-		// Skip CRC for data points to optimize throughput
 		dest[PCKT_TYPE_OFFSET] = (uint8_t) packet.type;
 		packet.VNAdatapoint->encode(&dest[PCKT_PAYLOAD_OFFSET], destsize - PCKT_EXCL_PAYLOAD_LEN);
-		crc = 0x00000000;
 	} else {
 		// Copy rest of the packet
 		memcpy(&dest[PCKT_TYPE_OFFSET], &packet, payload_size + PCKT_TYPE_LEN); // one additional byte for the packet type
-		// Calculate the CRC
-		crc = CRC32(0, dest, overall_size - PCKT_CRC_LEN);
 	}
+	// Calculate the CRC (table driven, fast enough to protect datapoints as well)
+	uint32_t crc = CRC32(0, dest, overall_size - PCKT_CRC_LEN);
 	memcpy(&dest[overall_size - PCKT_CRC_LEN], &crc, PCKT_CRC_LEN);
 	return overall_size;
 }
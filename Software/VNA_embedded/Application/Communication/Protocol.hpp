@@ -10,7 +10,7 @@ using namespace PacketConstants;
 
 namespace Protocol {
 
-static constexpr uint16_t Version = 13;
+static constexpr uint16_t Version = 14;
 
 #pragma pack(push, 1)
 
@@ -78,7 +78,8 @@ public:
         memcpy(descr_values, buffer, num_values);
 	}
 
-	std::complex<double> getValue(uint8_t stage, uint8_t port, bool reference) {
+	// Returns the position of the value for the given stage and port (-1 if not contained)
+	int findValue(uint8_t stage, uint8_t port, bool reference) const {
 		uint8_t sourceMask = 0;
 		sourceMask |= 0x01 << port;
 		if(reference) {
@@ -91,9 +92,26 @@ public:
 			if((descr_values[i] & sourceMask) != sourceMask) {
 				continue;
 			}
-			return std::complex<double>(real_values[i], imag_values[i]);
+			return i;
+		}
+		return -1;
+	}
+	std::complex<double> getValue(uint8_t stage, uint8_t port, bool reference) {
+		auto i = findValue(stage, port, reference);
+		if(i < 0) {
+			return std::numeric_limits<std::complex<double>>::quiet_NaN();
 		}
-		return std::numeric_limits<std::complex<double>>::quiet_NaN();
+		return std::complex<double>(real_values[i], imag_values[i]);
+	}
+	// Returns true if both datapoints contain values for the same stages/ports in the same order
+	bool sameDescriptors(const VNADatapoint &other) const {
+		return num_values == other.num_values && memcmp(descr_values, other.descr_values, num_values) == 0;
+	}
+	float getReal(unsigned int index) const {
+		return real_values[index];
+	}
+	float getImag(unsigned int index) const {
+		return imag_values[index];
 	}
 
     class Value {
@@ -417,6 +435,20 @@ using FirmwarePacket = struct _firmwarePacket {
     uint8_t data[FW_CHUNK_SIZE];
 };
 
+// Requests the windowed firmware transfer (several FirmwarePackets in flight), sent after ClearFlash.
+// The device answers with the window it supports. Devices without support answer with a Nack
+using FirmwareTransfer = struct _firmwareTransfer {
+	// number of FirmwarePackets that may be sent without waiting for an acknowledgement
+	uint8_t window;
+};
+
+// Answer to a FirmwarePacket in the windowed transfer, used by FirmwareAck and FirmwareNack.
+// Acknowledgements are cumulative: all firmware data below nextAddress has been written. A FirmwareNack
+// requests retransmission of all data starting at nextAddress
+using FirmwareAck = struct _firmwareAck {
+	uint32_t nextAddress;
+};
+
 using AmplitudeCorrectionPoint = struct _amplitudecorrectionpoint {
 	uint8_t totalPoints;
 	uint8_t pointNum;
@@ -489,7 +521,10 @@ enum class PacketType : uint8_t {
 	ClearTrigger = 29,
 	StopStatusUpdates = 30,
 	StartStatusUpdates = 31,
-	InitiateSweep = 32
+	InitiateSweep = 32,
+	FirmwareTransfer = 33,
+	FirmwareAck = 34,
+	FirmwareNack = 35,
 };
 
 using PacketInfo = struct _packetinfo {
@@ -503,6 +538,8 @@ using PacketInfo = struct _packetinfo {
         DeviceInfo info;
         ManualControl manual;
         FirmwarePacket firmware;
+        FirmwareTransfer firmwareTransfer;
+        FirmwareAck firmwareAck;
         ManualStatus manualStatus;
         SpectrumAnalyzerSettings spectrumSettings;
         SpectrumAnalyzerResult spectrumResult;
@@ -511,7 +548,7 @@ using PacketInfo = struct _packetinfo {
         DeviceConfig deviceConfig;
         /*
          * When encoding: Pointer may go invalid after call to EncodePacket
-         * When decoding: VNADatapoint is created on heap by DecodeBuffer, freeing is up to the caller
+         * When decoding: VNADatapoint is either the storage passed to DecodeBuffer or created on heap by DecodeBuffer, freeing is up to the caller
          */
         VNADatapoint<32> *VNAdatapoint;
 	};
@@ -519,8 +556,18 @@ using PacketInfo = struct _packetinfo {
 
 #pragma pack(pop)
 
+// CRC32 (reflected, polynomial 0x04C11DB7), crc is the result of a previous call or 0 for a new calculation.
+// Uses the function set with SetCRCFunction() if available, CRC32Software() otherwise
 uint32_t CRC32(uint32_t crc, const void *data, uint32_t len);
-uint16_t DecodeBuffer(uint8_t *buf, uint16_t len, PacketInfo *info);
+// Table driven (slice-by-8) implementation, always available
+uint32_t CRC32Software(uint32_t crc, const void *data, uint32_t len);
+// Optional replacement for the software CRC, e.g. using a CRC peripheral. Must produce the same result as
+// CRC32Software() and be safe to call from every context that encodes packets. Pass nullptr to use the software CRC
+using CRCFunction = uint32_t(*)(uint32_t crc, const void *data, uint32_t len);
+void SetCRCFunction(CRCFunction f);
+// Decodes the first packet in buf. A VNADatapoint is decoded into datapointStorage if available,
+// otherwise it is created on the heap (freeing is up to the caller)
+uint16_t DecodeBuffer(uint8_t *buf, uint16_t len, PacketInfo *info, VNADatapoint<32> *datapointStorage = nullptr);
 uint16_t EncodePacket(const PacketInfo &packet, uint8_t *dest, uint16_t destsize);
 
 }
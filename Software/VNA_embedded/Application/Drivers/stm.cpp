@@ -24,6 +24,24 @@ void STM::Init() {
 	read_index = write_index = 0;
 	HAL_NVIC_SetPriority(COMP4_IRQn, 6, 0);
 	HAL_NVIC_EnableIRQ(COMP4_IRQn);
+	__HAL_RCC_CRC_CLK_ENABLE();
+}
+
+uint32_t STM::CRC32(uint32_t crc, const void *data, uint32_t len) {
+	auto u8buf = (const uint8_t*) data;
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	// The peripheral calculates the non-reflected CRC. With reversed input bytes and reversed output it
+	// matches the reflected CRC32, the internal state is the bit-reversed state of the reflected algorithm
+	CRC->POL = 0x04C11DB7;
+	CRC->INIT = __RBIT(~crc);
+	CRC->CR = CRC_CR_REV_OUT | CRC_CR_REV_IN_0 | CRC_CR_RESET;
+	while(len--) {
+		*(__IO uint8_t*) &CRC->DR = *u8buf++;
+	}
+	crc = ~CRC->DR;
+	__set_PRIMASK(primask);
+	return crc;
 }
 
 bool STM::DispatchToInterrupt(void (*cb)(void)) {
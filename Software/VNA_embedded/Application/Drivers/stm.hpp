@@ -14,6 +14,10 @@ void Init();
 // to a lower priority interrupt. The passed function can then handle the FreeRTOS function call
 bool DispatchToInterrupt(void (*cb)(void));
 
+// CRC32 (same result as Protocol::CRC32Software) calculated by the CRC peripheral. Interrupts are
+// disabled during the calculation, the peripheral can be used from any context
+uint32_t CRC32(uint32_t crc, const void *data, uint32_t len);
+
 static inline bool InInterrupt() {
 	return (SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk) != 0;
 }